@@ -0,0 +1,222 @@
+#include "net.h"
+#include "coroutine/Hook.h"
+#include "splog.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <iostream>
+#include <netinet/in.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace lim_webserver;
+
+/**
+ * @brief 只统计连接数的服务器，连接在handleClient返回后关闭
+ */
+class CountServer : public TcpServer
+{
+public:
+    CountServer(Scheduler *worker, Scheduler *accepter) : TcpServer(worker, accepter) {}
+
+    uint16_t port() { return std::static_pointer_cast<IPAddress>(m_socket_vec[0]->localAddress())->getPort(); }
+
+    std::atomic<uint64_t> handled{0};
+    int holdMs = 0; // 每个连接占用的时长，用于制造并发连接
+
+protected:
+    void handleClient(Socket::ptr client) override
+    {
+        ++handled;
+        if (holdMs)
+        {
+            usleep(holdMs * 1000);
+        }
+    }
+};
+
+/**
+ * @brief 客户端线程循环建立连接并以RST关闭，避免TIME_WAIT耗尽端口
+ */
+static void ConnectLoop(uint16_t port, std::atomic<bool> &stop, std::atomic<uint64_t> &connected)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct linger lg = {1, 0};
+    uint64_t local = 0;
+    while (!stop.load(std::memory_order_relaxed))
+    {
+        // 直接使用原生函数，客户端不经过协程hook
+        int fd = socket_f(AF_INET, SOCK_STREAM, 0);
+        setsockopt_f(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        if (connect_f(fd, (sockaddr *)&addr, sizeof(addr)) == 0)
+        {
+            ++local;
+        }
+        close_f(fd);
+    }
+    connected += local;
+}
+
+/**
+ * @brief 以指定模式启动服务器，多个客户端线程持续建连，统计每秒处理的连接数
+ */
+static void connect_rate_bench(const char *name, bool reuseport, int processors, int clients)
+{
+    Scheduler *worker = Scheduler::CreateNetScheduler();
+    worker->setName(reuseport ? "reuseport" : "classic");
+    worker->startInNewThread(processors);
+    Scheduler *accepter = worker;
+    if (!reuseport)
+    {
+        accepter = Scheduler::CreateNetScheduler();
+        accepter->setName("accepter");
+        accepter->startInNewThread(1);
+    }
+
+    CountServer *server = new CountServer(worker, accepter);
+    server->setReusePort(reuseport);
+    if (!server->bind(IPv4Address::Create("127.0.0.1", 0)))
+    {
+        std::cout << name << ": bind失败" << std::endl;
+        return;
+    }
+    server->start();
+    uint16_t port = server->port();
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> connected{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < clients; ++i)
+    {
+        threads.emplace_back([&]()
+                             { ConnectLoop(port, stop, connected); });
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    stop = true;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    // 等待在途连接处理完
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::cout << name << "\t处理器" << processors << "\t客户端" << clients << "\t建连" << connected << "\t处理" << server->handled
+              << "\t" << server->handled / cost.count() << "连接/s" << std::endl;
+    server->stop();
+    if (accepter != worker)
+    {
+        accepter->stop();
+    }
+    worker->stop();
+}
+
+/**
+ * @brief 单个客户端线程用非阻塞connect按目标速率发起连接，建连完成后以RST关闭
+ */
+static void StormClient(uint16_t port, long rate, int seconds, uint64_t &connected, uint64_t &failed)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct linger lg = {1, 0};
+    const long max_inflight = 4096;
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event events[256];
+    long issued = 0, inflight = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::seconds(seconds);
+    for (auto now = start; now < end || inflight > 0; now = std::chrono::steady_clock::now())
+    {
+        long due = now < end ? std::chrono::duration<double>(now - start).count() * rate - issued : 0;
+        for (; due > 0 && inflight < max_inflight; --due, ++issued)
+        {
+            int fd = socket_f(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            setsockopt_f(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+            if (connect_f(fd, (sockaddr *)&addr, sizeof(addr)) != 0 && errno != EINPROGRESS)
+            {
+                ++failed;
+                close_f(fd);
+                continue;
+            }
+            epoll_event ev{};
+            ev.events = EPOLLOUT;
+            ev.data.fd = fd;
+            epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+            ++inflight;
+        }
+        int n = epoll_wait(epfd, events, 256, 1);
+        for (int i = 0; i < n; ++i)
+        {
+            int fd = events[i].data.fd, err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt_f(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            err ? ++failed : ++connected;
+            close_f(fd);
+            --inflight;
+        }
+    }
+    close_f(epfd);
+}
+
+/**
+ * @brief 连接风暴：客户端按目标速率建连，统计服务器实际接受、处理与拒绝的连接数
+ *
+ * @param batch     每次唤醒最多接受的连接数，1相当于逐个accept
+ * @param max_conns 最大并发连接数，配合hold_ms触发拒绝
+ */
+static void accept_storm_bench(const char *name, int processors, long rate, uint64_t batch, uint64_t max_conns, int hold_ms)
+{
+    Configer::Lookup<uint64_t>("tcp_server.accept_batch")->setValue(batch);
+    Scheduler *worker = Scheduler::CreateNetScheduler();
+    worker->setName("storm");
+    worker->startInNewThread(processors);
+    Scheduler *accepter = Scheduler::CreateNetScheduler();
+    accepter->setName("accepter");
+    accepter->startInNewThread(1);
+
+    CountServer *server = new CountServer(worker, accepter);
+    server->holdMs = hold_ms;
+    server->setMaxConnections(max_conns);
+    if (!server->bind(IPv4Address::Create("127.0.0.1", 0)))
+    {
+        std::cout << name << ": bind失败" << std::endl;
+        return;
+    }
+    server->start();
+
+    uint64_t connected = 0, failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    StormClient(server->port(), rate, 2, connected, failed);
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200 + hold_ms));
+    uint64_t accepted = server->handled + server->getRejectedCount();
+    std::cout << name << "\t目标" << rate << "/s\t建连" << connected << "\t失败" << failed << "\t接受" << accepted << "\t拒绝"
+              << server->getRejectedCount() << "\t" << accepted / cost.count() << "连接/s" << std::endl;
+    server->stop();
+    accepter->stop();
+    worker->stop();
+}
+
+int main(int argc, char **argv)
+{
+    int processors = argc > 1 ? std::stoi(argv[1]) : std::thread::hardware_concurrency();
+    int clients = argc > 2 ? std::stoi(argv[2]) : 4;
+    LOG_ROOT()->setLevel(LogLevel::ERROR);
+    LOG_SYS()->setLevel(LogLevel::WARN);
+    connect_rate_bench("单accept协程", false, processors, clients);
+    connect_rate_bench("SO_REUSEPORT", true, processors, clients);
+    long rate = argc > 3 ? std::stol(argv[3]) : 100000;
+    accept_storm_bench("风暴/逐个accept", processors, rate, 1, 0, 0);
+    accept_storm_bench("风暴/批量accept", processors, rate, 64, 0, 0);
+    accept_storm_bench("风暴/上限256", processors, rate, 64, 256, 50);
+    return 0;
+}
@@ -0,0 +1,368 @@
+#include "net/ByteArray.h"
+
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+#include <string>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace lim_webserver;
+
+// 统计全进程的堆分配次数，用于观察收发路径上的分配数
+static std::atomic<size_t> g_alloc_count{0};
+
+void *operator new(size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static double Since(std::chrono::high_resolution_clock::time_point start)
+{
+    std::chrono::duration<double> cost = std::chrono::high_resolution_clock::now() - start;
+    return cost.count();
+}
+
+static void PrintRate(const char *name, size_t bytes, double cost)
+{
+    std::cout << name << "：" << bytes / 1024 / 1024 << "MB，耗时" << cost << "s，" << bytes / cost / 1e9 << "GB/s" << std::endl;
+}
+
+void stream_bench()
+{
+    // 按报文大小分段写入再读出，模拟收包后解析
+    const size_t chunk = 1500;
+    const size_t total = 256 * 1024 * 1024;
+    const size_t rounds = 4;
+    std::string in(chunk, 'x');
+    std::string out(chunk, 0);
+    ByteArray::ptr ba = ByteArray::Create();
+
+    double write_cost = 0, read_cost = 0;
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t n = 0; n + chunk <= total; n += chunk)
+        {
+            ba->write(in.data(), chunk);
+        }
+        write_cost += Since(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        while (ba->getReadSize() >= chunk)
+        {
+            ba->read(&out[0], chunk);
+        }
+        read_cost += Since(start);
+        ba->clear();
+    }
+    if (out != in)
+    {
+        std::cout << "stream_bench: 数据不一致" << std::endl;
+    }
+    std::cout << "流式读写(" << chunk << "B分段)" << std::endl;
+    PrintRate("写入", total * rounds, write_cost);
+    PrintRate("读取", total * rounds, read_cost);
+    std::cout << std::endl;
+}
+
+void varint_bench()
+{
+    // 混合长度的取值，编码后1~5字节不等
+    const size_t count = 10000000;
+    std::vector<uint32_t> values(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i] = (uint32_t)(i * 2654435761u) >> (i % 32);
+    }
+    ByteArray::ptr ba = ByteArray::Create();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        ba->writeUint32(values[i]);
+    }
+    double encode_cost = Since(start);
+    size_t bytes = ba->getReadSize();
+
+    uint64_t sum = 0, expect = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        sum += ba->readUint32();
+    }
+    double decode_cost = Since(start);
+    for (size_t i = 0; i < count; ++i)
+    {
+        expect += values[i];
+    }
+    if (sum != expect)
+    {
+        std::cout << "varint_bench: 数据不一致" << std::endl;
+    }
+
+    std::cout << "Varint32(" << count << "个，编码后" << bytes / 1024 / 1024 << "MB)" << std::endl;
+    std::cout << "编码：" << count / encode_cost / 1e6 << "M个/s，" << bytes / encode_cost / 1e9 << "GB/s" << std::endl;
+    std::cout << "解码：" << count / decode_cost / 1e6 << "M个/s，" << bytes / decode_cost / 1e9 << "GB/s" << std::endl;
+    std::cout << std::endl;
+}
+
+// 改造前的逐字节编解码，作为对照
+static void ScalarWriteUint64(ByteArray::ptr ba, uint64_t value)
+{
+    uint8_t tmp[10];
+    uint8_t i = 0;
+    while (value >= 0x80)
+    {
+        tmp[i++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    tmp[i++] = value;
+    ba->write(tmp, i);
+}
+
+static uint64_t ScalarReadUint64(ByteArray::ptr ba)
+{
+    uint64_t result = 0;
+    for (int i = 0; i < 64; i += 7)
+    {
+        uint8_t b = ba->readFuint8();
+        result |= ((uint64_t)(b & 0x7f)) << i;
+        if (b < 0x80)
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+template <class T>
+void varint_array_bench(const char *name, const std::vector<T> &values)
+{
+    const size_t count = values.size();
+    std::vector<T> out(count);
+    ByteArray::ptr ba = ByteArray::Create();
+    auto check = [&](const char *path)
+    {
+        if (out != values)
+        {
+            std::cout << name << " " << path << ": 数据不一致" << std::endl;
+        }
+        std::fill(out.begin(), out.end(), 0);
+        ba->clear();
+    };
+    auto print = [&](const char *path, double encode_cost, double decode_cost)
+    {
+        std::cout << path << "\t编码：" << count / encode_cost / 1e6 << "M个/s\t解码：" << count / decode_cost / 1e6 << "M个/s" << std::endl;
+    };
+
+    std::cout << name << "(" << count << "个)" << std::endl;
+    // 逐字节
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        ScalarWriteUint64(ba, values[i]);
+    }
+    double encode_cost = Since(start);
+    size_t bytes = ba->getReadSize();
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[i] = ScalarReadUint64(ba);
+    }
+    double decode_cost = Since(start);
+    check("scalar");
+    print("逐字节", encode_cost, decode_cost);
+
+    // 逐个调用
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        sizeof(T) == sizeof(uint32_t) ? ba->writeUint32(values[i]) : ba->writeUint64(values[i]);
+    }
+    encode_cost = Since(start);
+    if (ba->getReadSize() != bytes)
+    {
+        std::cout << name << ": 编码长度不一致" << std::endl;
+    }
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[i] = sizeof(T) == sizeof(uint32_t) ? ba->readUint32() : ba->readUint64();
+    }
+    decode_cost = Since(start);
+    check("single");
+    print("逐个调用", encode_cost, decode_cost);
+
+    // 批量
+    start = std::chrono::high_resolution_clock::now();
+    if (sizeof(T) == sizeof(uint32_t))
+    {
+        ba->writeUint32Array((const uint32_t *)values.data(), count);
+    }
+    else
+    {
+        ba->writeUint64Array((const uint64_t *)values.data(), count);
+    }
+    encode_cost = Since(start);
+    start = std::chrono::high_resolution_clock::now();
+    if (sizeof(T) == sizeof(uint32_t))
+    {
+        ba->readUint32Array((uint32_t *)out.data(), count);
+    }
+    else
+    {
+        ba->readUint64Array((uint64_t *)out.data(), count);
+    }
+    decode_cost = Since(start);
+    check("array");
+    print("批量", encode_cost, decode_cost);
+    std::cout << "编码后" << bytes / 1024 << "KB，平均" << (double)bytes / count << "字节/个" << std::endl;
+    std::cout << std::endl;
+}
+
+void varint_arrays_bench()
+{
+    const size_t count = 1000000;
+    std::mt19937_64 rng(42);
+    // 随机位宽，覆盖各种编码长度
+    std::vector<uint32_t> u32(count);
+    std::vector<uint64_t> u64(count);
+    std::vector<uint32_t> small(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        u32[i] = (uint32_t)rng() >> (rng() % 32);
+        u64[i] = rng() >> (rng() % 64);
+        small[i] = rng() % 128;
+    }
+    varint_array_bench("Varint32随机位宽", u32);
+    varint_array_bench("Varint64随机位宽", u64);
+    varint_array_bench("Varint32小于128", small);
+
+    // zigzag往返，含边界值
+    std::vector<int32_t> s32 = {0, -1, 1, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()};
+    std::vector<int64_t> s64 = {0, -1, 1, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()};
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        s32.push_back((int32_t)rng() >> (rng() % 32));
+        s64.push_back((int64_t)rng() >> (rng() % 64));
+    }
+    ByteArray::ptr ba = ByteArray::Create(64);
+    ba->writeInt32Array(s32.data(), s32.size());
+    ba->writeInt64Array(s64.data(), s64.size());
+    std::vector<int32_t> r32(s32.size());
+    std::vector<int64_t> r64(s64.size());
+    for (size_t i = 0; i < 5; ++i)
+    {
+        r32[i] = ba->readInt32();
+    }
+    ba->readInt32Array(r32.data() + 5, r32.size() - 5);
+    ba->readInt64Array(r64.data(), r64.size());
+    std::cout << "zigzag往返" << (r32 == s32 && r64 == s64 && ba->getReadSize() == 0 ? "一致" : "不一致") << std::endl;
+    std::cout << std::endl;
+}
+
+void pool_bench()
+{
+    // 每轮写入16K后清空，节点在BlockPool与ByteArray之间往返
+    const size_t rounds = 1000000;
+    const size_t size = 16 * 1024;
+    std::string in(size, 'x');
+    ByteArray::ptr ba = ByteArray::Create();
+    ba->write(in.data(), size);
+    ba->clear();
+
+    BlockPool::Stats before = BlockPool::GetStats();
+    size_t allocs = g_alloc_count.load();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        ba->write(in.data(), size);
+        ba->clear();
+    }
+    double cost = Since(start);
+    allocs = g_alloc_count.load() - allocs;
+    BlockPool::Stats after = BlockPool::GetStats();
+
+    std::cout << "内存块复用(写入" << size / 1024 << "K后清空)" << std::endl;
+    std::cout << "每轮耗时：" << cost * 1e9 / rounds << "ns，每轮堆分配：" << (double)allocs / rounds << "次" << std::endl;
+    std::cout << "BlockPool命中：" << after.hits - before.hits << "，未命中：" << after.misses - before.misses
+              << "，当前缓存：" << after.cachedBytes / 1024 << "KB" << std::endl;
+    std::cout << std::endl;
+}
+
+void iovec_bench()
+{
+    // 通过管道走一遍readv收包、writev回写的路径
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return;
+    }
+    int null_fd = open("/dev/null", O_WRONLY);
+    const size_t rounds = 1000000;
+    const size_t packet = 1400;
+    std::string in(packet, 'x');
+    ByteArray::ptr ba = ByteArray::Create();
+
+    size_t allocs = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        if (::write(fds[1], in.data(), packet) != (ssize_t)packet)
+        {
+            break;
+        }
+        size_t before = g_alloc_count.load(std::memory_order_relaxed);
+        size_t count = 0;
+        iovec *iovs = ba->getWriteIovecs(4096, count);
+        ssize_t rt = ::readv(fds[0], iovs, count);
+        if (rt > 0)
+        {
+            ba->addWritePosition(rt);
+        }
+        iovs = ba->getReadIovecs(ba->getReadSize(), count);
+        rt = ::writev(null_fd, iovs, count);
+        if (rt > 0)
+        {
+            ba->addReadPosition(rt);
+        }
+        if (i > 0)
+        {
+            allocs += g_alloc_count.load(std::memory_order_relaxed) - before;
+        }
+        ba->clear();
+    }
+    double cost = Since(start);
+    close(fds[0]);
+    close(fds[1]);
+    close(null_fd);
+
+    std::cout << "readv/writev收发(" << packet << "B报文，含管道写入)" << std::endl;
+    std::cout << "每包耗时：" << cost * 1e9 / rounds << "ns，每包堆分配：" << (double)allocs / rounds << "次" << std::endl;
+    std::cout << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    stream_bench();
+    varint_bench();
+    varint_arrays_bench();
+    pool_bench();
+    iovec_bench();
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "coroutine.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+using namespace lim_webserver;
+
+static const int ROUNDS = 200000;
+
+static void PrintLatency(const char *name, std::chrono::high_resolution_clock::time_point start)
+{
+    std::chrono::duration<double> cost = std::chrono::high_resolution_clock::now() - start;
+    std::cout << name << "\t" << ROUNDS << "次往返，耗时" << cost.count() << "s，每次往返" << cost.count() * 1e9 / ROUNDS << "ns" << std::endl;
+}
+
+/**
+ * @brief 两个协程经两条Channel互相传递计数
+ */
+void channel_pingpong(const char *name, int threads)
+{
+    Scheduler *scheduler = Scheduler::Create();
+    scheduler->setName(name);
+    Channel<int>::ptr ping = Channel<int>::Create(1);
+    Channel<int>::ptr pong = Channel<int>::Create(1);
+    Semaphore done;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    scheduler->createTask([&]()
+                          {
+                              int value = 0;
+                              for (int i = 0; i < ROUNDS; ++i)
+                              {
+                                  ping->send(i);
+                                  pong->recv(value);
+                              }
+                              done.notify(); });
+    scheduler->createTask([&]()
+                          {
+                              int value;
+                              while (ping->recv(value))
+                              {
+                                  pong->send(value);
+                              } });
+    scheduler->startInNewThread(threads);
+    done.wait();
+    PrintLatency(name, start);
+
+    // 在普通线程中关闭通道，接收方协程随之退出
+    ping->close();
+    scheduler->stop();
+}
+
+/**
+ * @brief 两个普通线程经两条Channel互相传递计数，等待走futex
+ */
+void channel_thread_pingpong()
+{
+    Channel<int> ping(1), pong(1);
+    auto start = std::chrono::high_resolution_clock::now();
+    std::thread peer([&]()
+                     {
+                         int value;
+                         while (ping.recv(value))
+                         {
+                             pong.send(value);
+                         } });
+    int value = 0;
+    for (int i = 0; i < ROUNDS; ++i)
+    {
+        ping.send(i);
+        pong.recv(value);
+    }
+    PrintLatency("线程Channel", start);
+    ping.close();
+    peer.join();
+}
+
+/**
+ * @brief 对照：两个线程用std::mutex与std::condition_variable往返
+ */
+void std_thread_pingpong()
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    int turn = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    std::thread peer([&]()
+                     {
+                         for (int i = 0; i < ROUNDS; ++i)
+                         {
+                             std::unique_lock<std::mutex> lock(mutex);
+                             cond.wait(lock, [&]()
+                                       { return turn == 1; });
+                             turn = 0;
+                             cond.notify_one();
+                         } });
+    for (int i = 0; i < ROUNDS; ++i)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        turn = 1;
+        cond.notify_one();
+        cond.wait(lock, [&]()
+                  { return turn == 0; });
+    }
+    PrintLatency("std线程", start);
+    peer.join();
+}
+
+int main(int argc, char **argv)
+{
+    channel_pingpong("协程Channel(单线程)", 1);
+    channel_pingpong("协程Channel(双线程)", 2);
+    channel_thread_pingpong();
+    std_thread_pingpong();
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "net/http/HttpCompress.h"
+#include "splog.h"
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <time.h>
+#include <vector>
+
+using namespace lim_webserver;
+using namespace lim_webserver::http;
+
+static double ThreadCpuUS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * @brief 生成接近真实接口返回的JSON数组
+ */
+static std::string MakeJson(size_t size)
+{
+    static const char *NAMES[] = {"alice", "bob", "carol", "dave", "erin", "frank", "grace", "heidi"};
+    static const char *TAGS[] = {"\"admin\"", "\"beta\"", "\"vip\"", "\"new\"", "\"cn\"", "\"us\""};
+    std::mt19937 rng(42);
+    std::string json = "[";
+    for (int id = 1; json.size() < size; ++id)
+    {
+        json += "{\"id\":" + std::to_string(id) + ",\"name\":\"" + NAMES[rng() % 8] + std::to_string(rng() % 1000) +
+                "\",\"score\":" + std::to_string(rng() % 100000 / 100.0) + ",\"active\":" + (rng() % 2 ? "true" : "false") + ",\"tags\":[" +
+                TAGS[rng() % 6] + "," + TAGS[rng() % 6] + "],\"updated\":\"2024-0" + std::to_string(1 + rng() % 9) + "-1" + std::to_string(rng() % 10) +
+                "T12:00:00Z\"},";
+    }
+    json.back() = ']';
+    return json;
+}
+
+/**
+ * @brief 生成HTML页面
+ */
+static std::string MakeHtml(size_t size)
+{
+    std::mt19937 rng(7);
+    std::string html = "<!DOCTYPE html><html><head><title>list</title></head><body><table>\n";
+    while (html.size() < size)
+    {
+        html += "  <tr class=\"row\"><td><a href=\"/item/" + std::to_string(rng() % 100000) + "\">item " + std::to_string(rng() % 100000) +
+                "</a></td><td>" + std::to_string(rng() % 1000) + "</td></tr>\n";
+    }
+    return html + "</table></body></html>";
+}
+
+struct Payload
+{
+    const char *name;
+    std::string body;
+};
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? std::stoi(argv[1]) : 200;
+    LOG_SYS()->setLevel(LogLevel::ERROR);
+
+    std::vector<Payload> payloads = {{"json 2KB", MakeJson(2 * 1024)},
+                                     {"json 64KB", MakeJson(64 * 1024)},
+                                     {"html 16KB", MakeHtml(16 * 1024)}};
+    std::vector<ContentCoding> codings = {ContentCoding::GZIP, ContentCoding::DEFLATE};
+    if (IsContentCodingSupported(ContentCoding::BR))
+    {
+        codings.push_back(ContentCoding::BR);
+    }
+
+    std::cout << "每次请求都压缩(级别6)：CPU为单线程耗时" << std::endl;
+    std::cout << std::fixed;
+    for (auto &p : payloads)
+    {
+        for (ContentCoding coding : codings)
+        {
+            std::string out;
+            double start = ThreadCpuUS();
+            for (int i = 0; i < rounds; ++i)
+            {
+                Compress(coding, 6, p.body, out);
+            }
+            double us = (ThreadCpuUS() - start) / rounds;
+            std::cout << std::left << std::setw(11) << p.name << std::setw(8) << ContentCodingToString(coding) << std::right << std::setw(7)
+                      << p.body.size() << " -> " << std::setw(6) << out.size() << " 字节  节省 " << std::setprecision(1) << std::setw(5)
+                      << 100.0 * (p.body.size() - out.size()) / p.body.size() << "%  CPU " << std::setw(7) << us << " us/次  " << std::setprecision(0)
+                      << std::setw(5) << p.body.size() / us << " MB/s" << std::endl;
+        }
+    }
+
+    // 分块发送：每4KB调用一次flush，对端可立即解出已收到的部分，代价是压缩率
+    std::cout << std::endl << "流式压缩json 64KB，每4KB flush一次" << std::endl;
+    const std::string &json = payloads[1].body;
+    for (ContentCoding coding : codings)
+    {
+        std::string out;
+        double start = ThreadCpuUS();
+        for (int i = 0; i < rounds; ++i)
+        {
+            out.clear();
+            StreamCompressor stream(coding, 6);
+            for (size_t pos = 0; pos < json.size(); pos += 4096)
+            {
+                stream.update(json.data() + pos, std::min<size_t>(4096, json.size() - pos), out);
+                stream.flush(out);
+            }
+            stream.finish(out);
+        }
+        double us = (ThreadCpuUS() - start) / rounds;
+        std::cout << std::left << std::setw(8) << ContentCodingToString(coding) << std::right << std::setw(7) << json.size() << " -> " << std::setw(6)
+                  << out.size() << " 字节  CPU " << std::setprecision(1) << std::setw(7) << us << " us/次" << std::endl;
+    }
+
+    // 经HttpCompressor处理同一个热点响应：不可缓存时每次压缩，可缓存时只压缩一次
+    std::cout << std::endl << "HttpCompressor处理 " << rounds * 10 << " 个json 64KB响应，Accept-Encoding: gzip" << std::endl;
+    for (bool cacheable : {false, true})
+    {
+        HttpCompressor compressor;
+        compressor.setEnabled(true);
+        compressor.setLevel(6);
+        compressor.cache().setCapacity(16 * 1024 * 1024);
+        size_t raw = 0, sent = 0;
+        double start = ThreadCpuUS();
+        for (int i = 0; i < rounds * 10; ++i)
+        {
+            HttpRequest::ptr req(new HttpRequest);
+            req->setPath("/api/users");
+            req->setHeader("Accept-Encoding", "gzip");
+            HttpResponse::ptr rsp(new HttpResponse);
+            rsp->setHeader("Content-Type", "application/json");
+            if (cacheable)
+            {
+                rsp->setHeader("Cache-Control", "public, max-age=60");
+            }
+            rsp->setBody(json);
+            raw += rsp->body().size();
+            compressor.compress(req, rsp);
+            sent += rsp->body().size();
+        }
+        double us = (ThreadCpuUS() - start) / (rounds * 10);
+        std::cout << (cacheable ? "可缓存    " : "不可缓存  ") << std::right << "CPU " << std::setprecision(1) << std::setw(7) << us
+                  << " us/请求  发送 " << std::setprecision(0) << std::setw(6) << sent / 1024 << " KB / 原始 " << raw / 1024 << " KB  缓存条目 "
+                  << compressor.cache().count() << std::endl;
+    }
+    return 0;
+}
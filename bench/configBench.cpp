@@ -0,0 +1,106 @@
+#include "base/Configer.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lim_webserver;
+
+/**
+ * @brief 改造前的读取方式：读锁保护下按值返回，作为对照
+ */
+template <class T>
+class LockedVar
+{
+public:
+    explicit LockedVar(const T &val) : m_val(val) {}
+
+    T getValue()
+    {
+        RWMutex::ReadLock lock(m_mutex);
+        return m_val;
+    }
+
+private:
+    T m_val;
+    RWMutex m_mutex;
+};
+
+static uint64_t Touch(uint64_t v) { return v; }
+static uint64_t Touch(const std::vector<std::string> &v) { return v.size() + v[0].size(); }
+
+/**
+ * @brief 多线程反复读取配置，read返回每次读取得到的值
+ */
+template <class Read>
+void read_bench(const char *name, size_t thr_num, size_t ops_per_thr, Read read)
+{
+    std::vector<std::thread> threads;
+    std::atomic<uint64_t> sink{0};
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < thr_num; ++i)
+    {
+        threads.emplace_back([&]()
+                             {
+                                 uint64_t local = 0;
+                                 for (size_t n = 0; n < ops_per_thr; ++n)
+                                 {
+                                     local += Touch(read());
+                                 }
+                                 sink += local; });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    std::chrono::duration<double> cost = std::chrono::high_resolution_clock::now() - start;
+    std::cout << name << "\t线程" << thr_num << "\t耗时" << cost.count() << "s\t"
+              << thr_num * ops_per_thr / cost.count() / 1e6 << "M次/s" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t thr_num = argc > 1 ? std::stoul(argv[1]) : 32;
+    const size_t total_ops = 8000000;
+    size_t ops = total_ops / thr_num;
+    std::cout << "CPU核数：" << std::thread::hardware_concurrency() << std::endl;
+
+    LockedVar<uint64_t> locked_int(4096);
+    auto int_var = ConfigerVar<uint64_t>::Create("bench.int", 4096);
+    read_bench("uint64 读锁拷贝", thr_num, ops, [&]()
+               { return locked_int.getValue(); });
+    read_bench("uint64 快照get", thr_num, ops, [&]()
+               { return int_var->get(); });
+
+    std::vector<std::string> hosts;
+    for (int i = 0; i < 16; ++i)
+    {
+        hosts.push_back("backend-" + std::to_string(i) + ".example.com:8080");
+    }
+    LockedVar<std::vector<std::string>> locked_vec(hosts);
+    auto vec_var = ConfigerVar<std::vector<std::string>>::Create("bench.vec", hosts);
+    read_bench("vector 读锁拷贝", thr_num, ops / 8, [&]()
+               { return locked_vec.getValue(); });
+    read_bench("vector getValue", thr_num, ops / 8, [&]()
+               { return vec_var->getValue(); });
+    read_bench("vector getSnapshot", thr_num, ops, [&]()
+               { return Touch(*vec_var->getSnapshot()); });
+
+    // 读者运行期间写者持续发布新版本，读者应始终看到完整的快照
+    std::atomic<bool> stop{false};
+    std::thread writer([&]()
+                       {
+                           uint64_t v = 0;
+                           while (!stop)
+                           {
+                               int_var->setValue(++v);
+                               std::this_thread::sleep_for(std::chrono::microseconds(100));
+                           } });
+    read_bench("uint64 写者并发get", thr_num, ops, [&]()
+               { return int_var->get(); });
+    stop = true;
+    writer.join();
+    return 0;
+}
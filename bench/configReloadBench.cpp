@@ -0,0 +1,138 @@
+#include "net.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lim_webserver;
+
+static auto g_hosts = Configer::Lookup("reload.hosts", std::vector<std::string>(), "backend hosts");
+static auto g_timeout = Configer::Lookup("reload.timeout", 1000, "backend timeout");
+
+static const char *CONFIG_FILE = "config_reload_bench.yaml";
+
+/**
+ * @brief 先写临时文件再rename，与编辑器和配置下发工具的做法一致
+ */
+static void WriteConfig(int timeout)
+{
+    std::string tmp = std::string(CONFIG_FILE) + ".tmp";
+    {
+        std::ofstream ofs(tmp);
+        ofs << "reload:\n  timeout: " << timeout << "\n  hosts:\n";
+        for (int i = 0; i < 64; ++i)
+        {
+            ofs << "    - backend-" << i << ".example.com:8080\n";
+        }
+    }
+    std::rename(tmp.c_str(), CONFIG_FILE);
+}
+
+/**
+ * @brief 模拟请求处理线程：每次读取配置并做少量计算，记录每次处理的耗时
+ */
+static void RequestLoop(std::atomic<bool> &stop, std::vector<uint32_t> &latencies)
+{
+    latencies.clear();
+    volatile uint64_t sink = 0;
+    while (!stop.load(std::memory_order_relaxed))
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto hosts_snapshot = g_hosts->getSnapshot();
+        const std::vector<std::string> &hosts = *hosts_snapshot;
+        uint64_t h = g_timeout->get();
+        for (int k = 0; k < 8; ++k)
+        {
+            h = h * 31 + hosts[(h + k) % hosts.size()].size();
+        }
+        sink = sink + h;
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+static void Report(const char *name, std::vector<std::vector<uint32_t>> &samples)
+{
+    std::vector<uint32_t> all;
+    for (auto &s : samples)
+    {
+        all.insert(all.end(), s.begin(), s.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto at = [&](double q)
+    { return all[std::min(all.size() - 1, (size_t)(q * all.size()))]; };
+    std::cout << name << "\t请求" << all.size() << "\tp50=" << at(0.5) << "ns\tp99=" << at(0.99) << "ns\tp99.9=" << at(0.999)
+              << "ns\tmax=" << all.back() << "ns" << std::endl;
+}
+
+/**
+ * @brief 请求线程持续运行一段时间，reload为true时期间不断改写配置文件
+ */
+static void Phase(const char *name, int thr_num, bool reload)
+{
+    std::atomic<bool> stop{false};
+    std::vector<std::vector<uint32_t>> samples(thr_num);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thr_num; ++i)
+    {
+        samples[i].reserve(1 << 22);
+        threads.emplace_back([&, i]()
+                             { RequestLoop(stop, samples[i]); });
+    }
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    int timeout = 1000;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        if (reload)
+        {
+            WriteConfig(++timeout);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stop = true;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    Report(name, samples);
+}
+
+int main(int argc, char **argv)
+{
+    int thr_num = argc > 1 ? std::stoi(argv[1]) : 4;
+    LOG_ROOT()->setLevel(LogLevel::WARN);
+    LOG_SYS()->setLevel(LogLevel::WARN);
+
+    int timeout_changes = 0, hosts_changes = 0;
+    g_timeout->addListener([&](const int &, const int &)
+                           { ++timeout_changes; });
+    g_hosts->addListener([&](const std::vector<std::string> &, const std::vector<std::string> &)
+                         { ++hosts_changes; });
+
+    WriteConfig(1000);
+    Scheduler *scheduler = Scheduler::CreateNetScheduler();
+    scheduler->setName("watcher");
+    ConfigWatcher::ptr watcher = ConfigWatcher::Create(scheduler);
+    watcher->watch(CONFIG_FILE);
+    watcher->start();
+    scheduler->startInNewThread(1);
+    hosts_changes = 0;
+    timeout_changes = 0;
+
+    Phase("无重载", thr_num, false);
+    Phase("持续重载", thr_num, true);
+    // 等待最后一次改写被加载
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::cout << "加载次数" << watcher->getReloadCount() << "\ttimeout通知" << timeout_changes << "次\thosts通知" << hosts_changes
+              << "次\t当前timeout=" << g_timeout->get() << std::endl;
+    watcher->stop();
+    scheduler->stop();
+    std::remove(CONFIG_FILE);
+    return 0;
+}
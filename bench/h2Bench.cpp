@@ -0,0 +1,321 @@
+#include "net.h"
+#include "net/http/Http2Session.h"
+#include "net/http/HttpServer.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace lim_webserver;
+using namespace lim_webserver::http;
+
+/**
+ * @brief 开启长连接的HttpServer，暴露实际监听的端口
+ */
+class BenchServer : public HttpServer
+{
+public:
+    BenchServer(Scheduler *worker, Scheduler *accepter) : HttpServer(true, worker, accepter) {}
+
+    uint16_t port() { return std::static_pointer_cast<IPAddress>(m_socket_vec[0]->localAddress())->getPort(); }
+};
+
+/**
+ * @brief 单个场景的结果
+ */
+struct BenchResult
+{
+    uint64_t requests = 0;
+    double rps = 0;
+    double p50 = 0, p99 = 0; // 单位：微秒
+};
+
+static uint64_t NowNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ul + ts.tv_nsec;
+}
+
+static BenchResult Summarize(std::vector<uint64_t> &samples, double seconds)
+{
+    BenchResult result;
+    result.requests = samples.size();
+    if (samples.empty())
+    {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    result.rps = samples.size() / seconds;
+    result.p50 = samples[samples.size() / 2] / 1000.0;
+    result.p99 = samples[std::min(samples.size() - 1, (size_t)(samples.size() * 0.99))] / 1000.0;
+    return result;
+}
+
+static void AppendFrame(std::string &out, Http2FrameType type, uint8_t flags, uint32_t stream_id, const std::string &payload)
+{
+    uint8_t head[Http2FrameHeader::SIZE];
+    Http2FrameHeader h;
+    h.length = payload.size();
+    h.type = type;
+    h.flags = flags;
+    h.stream_id = stream_id;
+    h.encode(head);
+    out.append((const char *)head, sizeof(head));
+    out += payload;
+}
+
+static std::string U32(uint32_t v)
+{
+    std::string s(4, '\0');
+    s[0] = v >> 24;
+    s[1] = v >> 16;
+    s[2] = v >> 8;
+    s[3] = v;
+    return s;
+}
+
+/**
+ * @brief 压测用的最小h2客户端：一个连接上保持concurrency个流在途，每收完一个响应就在新流上补发一个请求
+ *
+ * @details 同一次recv中完成的响应所补发的请求合并为一次send，窗口按已收字节批量归还
+ */
+static void H2Client(Address::ptr addr, int concurrency, double seconds, std::vector<uint64_t> &samples, std::atomic<bool> &finished)
+{
+    Socket::ptr sock = Socket::CreateTCP(addr);
+    if (!sock->connect(addr))
+    {
+        std::cout << "连接失败" << std::endl;
+        finished = true;
+        return;
+    }
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    HeaderList request = {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", addr->toString()}};
+    std::unordered_map<uint32_t, uint64_t> inflight;
+    uint32_t next_id = 1;
+    uint64_t end = NowNS() + (uint64_t)(seconds * 1e9);
+
+    std::string out(HTTP2_PREFACE, HTTP2_PREFACE_SIZE);
+    AppendFrame(out, Http2FrameType::SETTINGS, 0, 0, std::string("\x00\x04", 2) + U32(1u << 30));
+    AppendFrame(out, Http2FrameType::WINDOW_UPDATE, 0, 0, U32((1u << 30) - 65535));
+    auto issue = [&]()
+    {
+        std::string block;
+        encoder.encode(request, block);
+        AppendFrame(out, Http2FrameType::HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, next_id, block);
+        inflight[next_id] = NowNS();
+        next_id += 2;
+    };
+    for (int i = 0; i < concurrency; ++i)
+    {
+        issue();
+    }
+
+    std::string buf;
+    size_t pos = 0;
+    uint64_t consumed = 0;
+    std::vector<char> data(256 * 1024);
+    while (!inflight.empty())
+    {
+        if (!out.empty())
+        {
+            if (sock->send(out.data(), out.size()) != (int)out.size())
+            {
+                break;
+            }
+            out.clear();
+        }
+        int n = sock->recv(&data[0], data.size());
+        if (n <= 0)
+        {
+            break;
+        }
+        buf.append(&data[0], n);
+        while (buf.size() - pos >= Http2FrameHeader::SIZE)
+        {
+            Http2FrameHeader h;
+            h.decode((const uint8_t *)&buf[pos]);
+            if (buf.size() - pos < Http2FrameHeader::SIZE + h.length)
+            {
+                break;
+            }
+            const uint8_t *payload = (const uint8_t *)&buf[pos + Http2FrameHeader::SIZE];
+            pos += Http2FrameHeader::SIZE + h.length;
+            bool complete = false;
+            if (h.type == Http2FrameType::HEADERS)
+            {
+                // 必须解码以保持动态表同步
+                HeaderList headers;
+                decoder.decode(payload, h.length, headers);
+                complete = h.flags & HTTP2_FLAG_END_STREAM;
+            }
+            else if (h.type == Http2FrameType::DATA)
+            {
+                consumed += h.length;
+                complete = h.flags & HTTP2_FLAG_END_STREAM;
+            }
+            else if (h.type == Http2FrameType::SETTINGS && !(h.flags & HTTP2_FLAG_ACK))
+            {
+                AppendFrame(out, Http2FrameType::SETTINGS, HTTP2_FLAG_ACK, 0, "");
+            }
+            if (complete)
+            {
+                auto it = inflight.find(h.stream_id);
+                if (it != inflight.end())
+                {
+                    uint64_t now = NowNS();
+                    samples.push_back(now - it->second);
+                    inflight.erase(it);
+                    if (now < end)
+                    {
+                        issue();
+                    }
+                }
+            }
+        }
+        buf.erase(0, pos);
+        pos = 0;
+        if (consumed >= (1u << 28))
+        {
+            AppendFrame(out, Http2FrameType::WINDOW_UPDATE, 0, 0, U32(consumed));
+            consumed = 0;
+        }
+    }
+    sock->close();
+    finished = true;
+}
+
+/**
+ * @brief 读取一个完整的HTTP/1.1响应
+ */
+static bool RecvResponse(Socket::ptr sock, std::string &buf)
+{
+    buf.clear();
+    size_t header_end = std::string::npos;
+    size_t total = std::string::npos;
+    char data[4096];
+    while (total == std::string::npos || buf.size() < total)
+    {
+        int n = sock->recv(data, sizeof(data));
+        if (n <= 0)
+        {
+            return false;
+        }
+        buf.append(data, n);
+        if (header_end == std::string::npos && (header_end = buf.find("\r\n\r\n")) != std::string::npos)
+        {
+            size_t pos = buf.find("content-length:");
+            if (pos == std::string::npos || pos > header_end)
+            {
+                return false;
+            }
+            total = header_end + 4 + strtoul(buf.c_str() + pos + 15, nullptr, 10);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief HTTP/1.1长连接：每个连接同一时刻只有一个请求在途
+ */
+static void H1Client(Address::ptr addr, double seconds, std::vector<uint64_t> &samples, std::atomic<int> &running)
+{
+    Socket::ptr sock = Socket::CreateTCP(addr);
+    if (sock->connect(addr))
+    {
+        std::string request = "GET / HTTP/1.1\r\nHost: " + addr->toString() + "\r\nConnection: keep-alive\r\n\r\n";
+        std::string buf;
+        uint64_t end = NowNS() + (uint64_t)(seconds * 1e9);
+        uint64_t now;
+        while ((now = NowNS()) < end)
+        {
+            if (sock->send(request.data(), request.size()) <= 0 || !RecvResponse(sock, buf))
+            {
+                break;
+            }
+            samples.push_back(NowNS() - now);
+        }
+        sock->close();
+    }
+    --running;
+}
+
+static BenchResult RunH2(Scheduler *client_sched, Address::ptr addr, int concurrency, double seconds)
+{
+    std::vector<uint64_t> samples;
+    std::atomic<bool> finished{false};
+    client_sched->createTask([&]() { H2Client(addr, concurrency, seconds, samples, finished); });
+    while (!finished)
+    {
+        usleep(10 * 1000);
+    }
+    return Summarize(samples, seconds);
+}
+
+static BenchResult RunH1(Scheduler *client_sched, Address::ptr addr, int connections, double seconds)
+{
+    std::vector<std::vector<uint64_t>> samples(connections);
+    std::atomic<int> running{connections};
+    for (int i = 0; i < connections; ++i)
+    {
+        client_sched->createTask([&, i]() { H1Client(addr, seconds, samples[i], running); });
+    }
+    while (running > 0)
+    {
+        usleep(10 * 1000);
+    }
+    std::vector<uint64_t> all;
+    for (auto &s : samples)
+    {
+        all.insert(all.end(), s.begin(), s.end());
+    }
+    return Summarize(all, seconds);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? std::stod(argv[1]) : 3;
+    LOG_ROOT()->setLevel(LogLevel::ERROR);
+    LOG_SYS()->setLevel(LogLevel::ERROR);
+
+    Scheduler *worker = Scheduler::CreateNetScheduler();
+    worker->setName("srv");
+    worker->startInNewThread(1);
+    BenchServer *server = new BenchServer(worker, worker);
+    server->setHttp2(true);
+    if (!server->bind(IPv4Address::Create("127.0.0.1", 0)))
+    {
+        std::cout << "bind失败" << std::endl;
+        return 1;
+    }
+    server->start();
+    Address::ptr addr = IPv4Address::Create("127.0.0.1", server->port());
+
+    Scheduler *client_sched = Scheduler::CreateNetScheduler();
+    client_sched->setName("cli");
+    client_sched->startInNewThread(1);
+
+    std::cout << "单线程服务端，h2为同一连接上的并发流数，h1.1为同样数量的长连接" << std::endl;
+    for (int concurrency : {1, 10, 100})
+    {
+        BenchResult h2 = RunH2(client_sched, addr, concurrency, seconds);
+        BenchResult h1 = RunH1(client_sched, addr, concurrency, seconds);
+        std::cout << std::left << std::setw(12) << ("并发 " + std::to_string(concurrency)) << std::fixed << std::setprecision(0) << "h2 " << std::setw(8)
+                  << h2.rps << " req/s  p50 " << std::setprecision(1) << std::setw(7) << h2.p50 << " us  p99 " << std::setw(7) << h2.p99
+                  << " us  |  h1.1 " << std::setprecision(0) << std::setw(8) << h1.rps << " req/s  p50 " << std::setprecision(1) << std::setw(7)
+                  << h1.p50 << " us  p99 " << std::setw(7) << h1.p99 << " us" << std::endl;
+    }
+    server->stop();
+    client_sched->stop();
+    worker->stop();
+    return 0;
+}
@@ -0,0 +1,333 @@
+#include "net.h"
+#include "net/http/HttpServer.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace lim_webserver;
+
+/**
+ * @brief 开启长连接的HttpServer，暴露实际监听的端口
+ */
+class BenchServer : public http::HttpServer
+{
+public:
+    BenchServer(Scheduler *worker, Scheduler *accepter) : http::HttpServer(true, worker, accepter) {}
+
+    uint16_t port() { return std::static_pointer_cast<IPAddress>(m_socket_vec[0]->localAddress())->getPort(); }
+};
+
+/**
+ * @brief 压测参数
+ */
+struct LoadConfig
+{
+    int connections = 64;   // 并发连接数
+    double seconds = 3;     // 每个场景的时长
+    long rate = 0;          // 开环模式的总请求速率，0为闭环
+};
+
+/**
+ * @brief 单个场景的结果
+ */
+struct LoadResult
+{
+    std::string mode;
+    long target = 0;
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    double rps = 0;
+    double p50 = 0, p99 = 0, p999 = 0, max = 0; // 单位：微秒
+    double serverCpu = 0, clientCpu = 0;       // 每请求CPU时间，单位：微秒
+};
+
+static uint64_t NowNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ul + ts.tv_nsec;
+}
+
+/**
+ * @brief 名称以prefix开头的线程累计占用的CPU时间，单位：纳秒
+ *
+ * @details 处理器线程名为"调度器名_Proc_编号"，按调度器名区分服务端与压测端
+ */
+static uint64_t ThreadCpuNS(const std::string &prefix)
+{
+    uint64_t total = 0;
+    DIR *dir = opendir("/proc/self/task");
+    if (!dir)
+    {
+        return 0;
+    }
+    while (struct dirent *entry = readdir(dir))
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        std::string base = std::string("/proc/self/task/") + entry->d_name;
+        std::string comm;
+        std::ifstream(base + "/comm") >> comm;
+        if (comm.compare(0, prefix.size(), prefix) != 0)
+        {
+            continue;
+        }
+        uint64_t run_ns = 0;
+        std::ifstream(base + "/schedstat") >> run_ns;
+        total += run_ns;
+    }
+    closedir(dir);
+    return total;
+}
+
+/**
+ * @brief 压测端：每个连接一个协程，闭环模式收到响应后立即发下一个请求，
+ *        开环模式按固定间隔发送，延迟从计划发送时刻算起以修正协同遗漏
+ */
+class LoadGenerator
+{
+public:
+    LoadGenerator(Scheduler *scheduler, Address::ptr addr) : m_scheduler(scheduler), m_addr(addr)
+    {
+        m_request = "GET / HTTP/1.1\r\nHost: " + addr->toString() + "\r\nConnection: keep-alive\r\n\r\n";
+    }
+
+    LoadResult run(const LoadConfig &config)
+    {
+        m_config = config;
+        m_samples.assign(config.connections, std::vector<uint64_t>());
+        m_errors = 0;
+        m_running = config.connections;
+        m_start = NowNS() + 10 * 1000000;
+        m_end = m_start + (uint64_t)(config.seconds * 1e9);
+
+        uint64_t server_cpu = ThreadCpuNS("srv") + ThreadCpuNS("acc");
+        uint64_t client_cpu = ThreadCpuNS("gen");
+        for (int i = 0; i < config.connections; ++i)
+        {
+            m_scheduler->createTask([this, i]() { connection(i); });
+        }
+        while (m_running.load() > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        server_cpu = ThreadCpuNS("srv") + ThreadCpuNS("acc") - server_cpu;
+        client_cpu = ThreadCpuNS("gen") - client_cpu;
+
+        LoadResult result;
+        result.mode = config.rate ? "open" : "closed";
+        result.target = config.rate;
+        result.errors = m_errors;
+        std::vector<uint64_t> all;
+        for (auto &s : m_samples)
+        {
+            all.insert(all.end(), s.begin(), s.end());
+        }
+        result.requests = all.size();
+        if (all.empty())
+        {
+            return result;
+        }
+        std::sort(all.begin(), all.end());
+        auto at = [&](double q)
+        { return all[std::min(all.size() - 1, (size_t)(q * all.size()))] / 1000.0; };
+        result.rps = all.size() / config.seconds;
+        result.p50 = at(0.5);
+        result.p99 = at(0.99);
+        result.p999 = at(0.999);
+        result.max = all.back() / 1000.0;
+        result.serverCpu = server_cpu / 1000.0 / all.size();
+        result.clientCpu = client_cpu / 1000.0 / all.size();
+        return result;
+    }
+
+private:
+    /**
+     * @brief 读取一个完整的响应，返回false表示连接出错
+     */
+    bool recvResponse(Socket::ptr sock, std::string &buf)
+    {
+        buf.clear();
+        size_t header_end = std::string::npos;
+        size_t total = std::string::npos;
+        char data[4096];
+        while (total == std::string::npos || buf.size() < total)
+        {
+            int n = sock->recv(data, sizeof(data));
+            if (n <= 0)
+            {
+                return false;
+            }
+            buf.append(data, n);
+            if (header_end == std::string::npos && (header_end = buf.find("\r\n\r\n")) != std::string::npos)
+            {
+                size_t pos = buf.find("content-length:");
+                if (pos == std::string::npos || pos > header_end)
+                {
+                    return false;
+                }
+                total = header_end + 4 + strtoul(buf.c_str() + pos + 15, nullptr, 10);
+            }
+        }
+        return true;
+    }
+
+    void connection(int idx)
+    {
+        std::vector<uint64_t> &samples = m_samples[idx];
+        Socket::ptr sock = Socket::CreateTCP(m_addr);
+        if (!sock->connect(m_addr))
+        {
+            ++m_errors;
+            --m_running;
+            return;
+        }
+        // 开环模式下每个连接承担总速率的1/connections，起始时刻错开
+        uint64_t interval = m_config.rate ? 1000000000ul * m_config.connections / m_config.rate : 0;
+        uint64_t intended = m_start + (interval ? interval * idx / m_config.connections : 0);
+        std::string buf;
+        while (true)
+        {
+            uint64_t now = NowNS();
+            if (interval)
+            {
+                // 服务端跟不上时积压的计划请求不再补发
+                if (intended >= m_end || now >= m_end)
+                {
+                    break;
+                }
+                // 定时器为毫秒精度，不足1毫秒时直接发送
+                if (intended > now + 1000000)
+                {
+                    usleep((intended - now) / 1000);
+                    now = NowNS();
+                }
+            }
+            else
+            {
+                if (now >= m_end)
+                {
+                    break;
+                }
+                intended = now;
+            }
+            // 落后于计划时从计划时刻算起，排队等待的时间计入延迟；提前不足1毫秒时从实际发送时刻算起
+            uint64_t begin = std::min(intended, now);
+            if (sock->send(m_request.c_str(), m_request.size()) != (int)m_request.size() || !recvResponse(sock, buf))
+            {
+                ++m_errors;
+                break;
+            }
+            samples.push_back(NowNS() - begin);
+            intended += interval;
+        }
+        sock->close();
+        --m_running;
+    }
+
+private:
+    Scheduler *m_scheduler;
+    Address::ptr m_addr;
+    std::string m_request;
+    LoadConfig m_config;
+    uint64_t m_start = 0;
+    uint64_t m_end = 0;
+    std::vector<std::vector<uint64_t>> m_samples;
+    std::atomic<uint64_t> m_errors{0};
+    std::atomic<int> m_running{0};
+};
+
+static void PrintResult(const LoadResult &r)
+{
+    std::cout << std::fixed << std::setprecision(1) << r.mode << "\t目标" << r.target << "/s\t请求" << r.requests << "\t错误" << r.errors
+              << "\t" << r.rps << "req/s\tp50=" << r.p50 << "us\tp99=" << r.p99 << "us\tp999=" << r.p999 << "us\tmax=" << r.max
+              << "us\t服务端" << std::setprecision(2) << r.serverCpu << "us/req\t压测端" << r.clientCpu << "us/req" << std::endl;
+}
+
+/**
+ * @brief 固定字段顺序与格式的JSON，便于在提交之间直接diff
+ */
+static std::string ToJson(const LoadConfig &config, int server_threads, const std::vector<LoadResult> &results)
+{
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(1);
+    os << "{\n  \"bench\": \"httpBench\",\n  \"server_threads\": " << server_threads << ",\n  \"connections\": " << config.connections
+       << ",\n  \"seconds\": " << config.seconds << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const LoadResult &r = results[i];
+        os << "    {\"mode\": \"" << r.mode << "\", \"target_rps\": " << r.target << ", \"requests\": " << r.requests
+           << ", \"errors\": " << r.errors << ", \"rps\": " << r.rps << ", \"p50_us\": " << r.p50 << ", \"p99_us\": " << r.p99
+           << ", \"p999_us\": " << r.p999 << ", \"max_us\": " << r.max << std::setprecision(3) << ", \"server_cpu_us_per_req\": "
+           << r.serverCpu << ", \"client_cpu_us_per_req\": " << r.clientCpu << std::setprecision(1) << "}"
+           << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    os << "  ]\n}\n";
+    return os.str();
+}
+
+/**
+ * @brief 用法：httpBench [连接数] [服务端线程数] [每场景秒数] [开环速率,0为闭环速率的一半] [JSON输出路径]
+ */
+int main(int argc, char **argv)
+{
+    LoadConfig config;
+    config.connections = argc > 1 ? std::stoi(argv[1]) : 64;
+    int server_threads = argc > 2 ? std::stoi(argv[2]) : 1;
+    config.seconds = argc > 3 ? std::stod(argv[3]) : 3;
+    long rate = argc > 4 ? std::stol(argv[4]) : 0;
+    std::string json_path = argc > 5 ? argv[5] : "httpBench.json";
+    LOG_ROOT()->setLevel(LogLevel::ERROR);
+    LOG_SYS()->setLevel(LogLevel::ERROR);
+
+    Scheduler *worker = Scheduler::CreateNetScheduler();
+    worker->setName("srv");
+    worker->startInNewThread(server_threads);
+    Scheduler *accepter = Scheduler::CreateNetScheduler();
+    accepter->setName("acc");
+    accepter->startInNewThread(1);
+    BenchServer *server = new BenchServer(worker, accepter);
+    if (!server->bind(IPv4Address::Create("127.0.0.1", 0)))
+    {
+        std::cout << "bind失败" << std::endl;
+        return 1;
+    }
+    server->start();
+
+    Scheduler *gen = Scheduler::CreateNetScheduler();
+    gen->setName("gen");
+    gen->startInNewThread(1);
+    LoadGenerator generator(gen, IPv4Address::Create("127.0.0.1", server->port()));
+
+    std::vector<LoadResult> results;
+    LoadConfig closed = config;
+    results.push_back(generator.run(closed));
+    PrintResult(results.back());
+
+    LoadConfig open = config;
+    open.rate = rate ? rate : std::max<long>(results.back().rps / 2, 1);
+    results.push_back(generator.run(open));
+    PrintResult(results.back());
+
+    std::ofstream(json_path) << ToJson(config, server_threads, results);
+    std::cout << "结果已写入 " << json_path << std::endl;
+    server->stop();
+    gen->stop();
+    accepter->stop();
+    worker->stop();
+    return 0;
+}
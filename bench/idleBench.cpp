@@ -0,0 +1,219 @@
+#include "net.h"
+#include "coroutine/Hook.h"
+#include "splog.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <iostream>
+#include <netinet/in.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace lim_webserver;
+
+static const size_t MSG_SIZE = 64;
+
+/**
+ * @brief 回显服务器，classic为true时改用SO_RCVTIMEO，每次读等待创建一个定时器
+ */
+class EchoServer : public TcpServer
+{
+public:
+    EchoServer(Scheduler *worker, Scheduler *accepter, bool classic) : TcpServer(worker, accepter), m_classic(classic) {}
+
+    uint16_t port() { return std::static_pointer_cast<IPAddress>(m_socket_vec[0]->localAddress())->getPort(); }
+
+    std::atomic<uint64_t> timeouts{0};
+
+protected:
+    void handleClient(Socket::ptr client) override
+    {
+        if (m_classic)
+        {
+            client->setIdleTimeout(0);
+            client->setRecvTimeout(m_recvTimeout);
+        }
+        char buf[MSG_SIZE];
+        while (true)
+        {
+            int n = client->recv(buf, sizeof(buf));
+            if (n <= 0)
+            {
+                if (n < 0 && errno == ETIMEDOUT)
+                {
+                    ++timeouts;
+                }
+                break;
+            }
+            if (client->send(buf, n) != n)
+            {
+                break;
+            }
+        }
+        client->close();
+    }
+
+private:
+    bool m_classic;
+};
+
+/**
+ * @brief 客户端：epoll管理全部连接，每个连接收到回显后立即发送下一条
+ */
+class PingClient
+{
+public:
+    PingClient(uint16_t port, int conns)
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        m_epfd = epoll_create1(EPOLL_CLOEXEC);
+        for (int i = 0; i < conns; ++i)
+        {
+            int fd = socket_f(AF_INET, SOCK_STREAM, 0);
+            if (connect_f(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+            {
+                close_f(fd);
+                continue;
+            }
+            fcntl_f(fd, F_SETFL, fcntl_f(fd, F_GETFL, 0) | O_NONBLOCK);
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &ev);
+            m_fds.push_back(fd);
+        }
+    }
+
+    ~PingClient()
+    {
+        for (int fd : m_fds)
+        {
+            close_f(fd);
+        }
+        close_f(m_epfd);
+    }
+
+    /**
+     * @brief 持续收发seconds秒，返回往返次数
+     */
+    uint64_t pingpong(double seconds)
+    {
+        char msg[MSG_SIZE] = {0};
+        for (int fd : m_fds)
+        {
+            send_f(fd, msg, sizeof(msg), MSG_NOSIGNAL);
+        }
+        uint64_t rounds = 0;
+        bool sending = true;
+        size_t inflight = m_fds.size();
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        epoll_event events[256];
+        while (inflight > 0)
+        {
+            if (sending && std::chrono::steady_clock::now() >= end)
+            {
+                sending = false;
+            }
+            int n = epoll_wait(m_epfd, events, 256, 100);
+            for (int i = 0; i < n; ++i)
+            {
+                char buf[MSG_SIZE];
+                int fd = events[i].data.fd;
+                ssize_t r = recv_f(fd, buf, sizeof(buf), 0);
+                if (r <= 0)
+                {
+                    continue;
+                }
+                ++rounds;
+                if (sending)
+                {
+                    send_f(fd, buf, r, MSG_NOSIGNAL);
+                }
+                else
+                {
+                    --inflight;
+                }
+            }
+        }
+        return rounds;
+    }
+
+    /**
+     * @brief 统计已被服务器关闭的连接数
+     */
+    size_t closedByPeer()
+    {
+        size_t closed = 0;
+        for (int fd : m_fds)
+        {
+            char c;
+            if (recv_f(fd, &c, 1, MSG_DONTWAIT) == 0)
+            {
+                ++closed;
+            }
+        }
+        return closed;
+    }
+
+private:
+    int m_epfd;
+    std::vector<int> m_fds;
+};
+
+/**
+ * @brief 大量长连接持续往返，比较逐次读等待创建定时器与空闲链表两种超时方式的吞吐；
+ *        之后停止发送，验证空闲连接在超时后被清扫关闭
+ */
+static void idle_bench(const char *name, bool classic, int conns, uint64_t timeout_ms)
+{
+    Configer::Lookup<uint64_t>("tcp_server.read_timeout")->setValue(timeout_ms);
+    Scheduler *worker = Scheduler::CreateNetScheduler();
+    worker->setName(classic ? "classic" : "idle");
+    worker->startInNewThread(1);
+    Scheduler *accepter = Scheduler::CreateNetScheduler();
+    accepter->setName("accepter");
+    accepter->startInNewThread(1);
+
+    EchoServer *server = new EchoServer(worker, accepter, classic);
+    if (!server->bind(IPv4Address::Create("127.0.0.1", 0)))
+    {
+        std::cout << name << ": bind失败" << std::endl;
+        accepter->stop();
+        worker->stop();
+        return;
+    }
+    server->start();
+
+    PingClient client(server->port(), conns);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t rounds = client.pingpong(2);
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::cout << name << "\t连接" << conns << "\t往返" << rounds << "\t" << rounds / cost.count() << "次/s\t空闲"
+              << server->getIdleConnectionCount() << "\t活跃" << server->getActiveConnectionCount() << std::endl;
+
+    // 停止发送，超时加上一个清扫周期后应全部被关闭
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms + 1500));
+    std::cout << name << "\t静默" << timeout_ms + 1500 << "ms后\t服务器超时" << server->timeouts << "\t客户端收到关闭" << client.closedByPeer()
+              << "\t空闲" << server->getIdleConnectionCount() << std::endl;
+    server->stop();
+    accepter->stop();
+    worker->stop();
+}
+
+int main(int argc, char **argv)
+{
+    int conns = argc > 1 ? std::stoi(argv[1]) : 2000;
+    LOG_ROOT()->setLevel(LogLevel::ERROR);
+    LOG_SYS()->setLevel(LogLevel::WARN);
+    idle_bench("空闲链表", false, conns, 1000);
+    idle_bench("SO_RCVTIMEO定时器", true, conns, 1000);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "base/Mutex.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace lim_webserver;
+
+/**
+ * @brief 改造前的pthread_spin包装，作为对照
+ */
+class PthreadSpinlock : Noncopyable
+{
+public:
+    PthreadSpinlock() { pthread_spin_init(&m_mutex, 0); }
+    ~PthreadSpinlock() { pthread_spin_destroy(&m_mutex); }
+    void lock() { pthread_spin_lock(&m_mutex); }
+    void unlock() { pthread_spin_unlock(&m_mutex); }
+
+private:
+    pthread_spinlock_t m_mutex;
+};
+
+static double CpuSeconds()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/**
+ * @brief 各线程反复加锁累加计数，临界区外做少量无关计算
+ */
+template <class MutexType>
+void contention_bench(const char *name, size_t thr_num, size_t ops_per_thr)
+{
+    MutexType mutex;
+    uint64_t counter = 0;
+    std::vector<std::thread> threads;
+
+    double cpu_start = CpuSeconds();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < thr_num; ++i)
+    {
+        threads.emplace_back([&]()
+                             {
+                                 volatile uint64_t local = 0;
+                                 for (size_t n = 0; n < ops_per_thr; ++n)
+                                 {
+                                     mutex.lock();
+                                     ++counter;
+                                     mutex.unlock();
+                                     for (int k = 0; k < 32; ++k)
+                                     {
+                                         local = local + k;
+                                     }
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    std::chrono::duration<double> cost = std::chrono::high_resolution_clock::now() - start;
+    double cpu = CpuSeconds() - cpu_start;
+
+    if (counter != thr_num * ops_per_thr)
+    {
+        std::cout << name << ": 计数错误 " << counter << std::endl;
+    }
+    std::cout << name << "\t线程" << thr_num << "\t耗时" << cost.count() << "s\tCPU时间" << cpu << "s\t"
+              << counter / cost.count() / 1e6 << "M次/s" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    size_t cores = std::thread::hardware_concurrency();
+    size_t max_thr = argc > 1 ? std::stoul(argv[1]) : 2 * cores;
+    const size_t total_ops = 4000000;
+    std::cout << "CPU核数：" << cores << "，Spinlock大小：" << sizeof(Spinlock) << "字节" << std::endl;
+    for (size_t thr = 1; thr <= max_thr; ++thr)
+    {
+        size_t ops = total_ops / thr;
+        contention_bench<PthreadSpinlock>("pthread_spin", thr, ops);
+        contention_bench<Spinlock>("Spinlock", thr, ops);
+        contention_bench<Mutex>("Mutex", thr, ops);
+        std::cout << std::endl;
+    }
+    return 0;
+}
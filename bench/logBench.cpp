@@ -1,24 +1,49 @@
 #include "splog.h"
 
+#include <atomic>
+#include <functional>
+#include <new>
+
 using namespace lim_webserver;
 
-FileAppender::ptr get_appender()
+// 统计全进程的堆分配次数，用于观察每次打日志的分配数
+static std::atomic<size_t> g_alloc_count{0};
+
+void *operator new(size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+FileAppender::ptr get_appender(const std::string &name, const std::string &file, bool mmap = false, const FlushPolicy &policy = FlushPolicy())
 {
-    FileAppender::ptr fappender = AppenderFactory::newFileAppender();
-    fappender->setFile("./log/stress_log.txt");
-    fappender->setName("file_test");
+    FileAppender::ptr fappender = mmap ? AppenderFactory::newMmapFileAppender() : AppenderFactory::newFileAppender();
+    fappender->setFile(file);
+    fappender->setName(name);
     fappender->setFormatter("%m%n");
     fappender->setAppend(false);
     fappender->setLevel(LogLevel_DEBUG);
+    fappender->setFlushPolicy(policy);
     fappender->start();
     return fappender;
 }
 
-static FileAppender::ptr g_fileappender = get_appender();
+static FileAppender::ptr g_fileappender = get_appender("file_test", "./log/stress_log.txt");
+static FileAppender::ptr g_mmapappender = get_appender("mmap_test", "./log/stress_mmap_log.txt", true);
+// 64K或1s刷新一次，WARN及以上立即刷新
+static FileAppender::ptr g_batchappender = get_appender("batch_test", "./log/stress_batch_log.txt", false, FlushPolicy::Batch(64 * 1024, 1000));
 
-void bench(Logger::ptr logger, size_t thr_num, size_t msg_num, size_t msg_len)
+void bench(Logger::ptr logger, size_t thr_num, size_t msg_num, size_t msg_len, FileAppender::ptr appender = g_fileappender)
 {
-    g_fileappender->openFile();
+    appender->openFile();
     std::cout << "测试日志器:" << logger->getName() << std::endl;
     std::cout << "测试日志：" << msg_num << "条，总大小：" << (msg_num * msg_len) / 1024 << "KB" << std::endl;
     // 2.组织指定长度的日志消息
@@ -73,6 +98,128 @@ void sync_bench()
     bench(logger, 3, 1000000, 100);
     // bench(logger, 10, 1000000, 100);
 }
+
+void mmap_sync_bench()
+{
+    Logger::ptr logger = LOG_NAME("mmap_sync_logger");
+
+    logger->addAppender(g_mmapappender);
+
+    bench(logger, 1, 1000000, 100, g_mmapappender);
+    bench(logger, 3, 1000000, 100, g_mmapappender);
+}
+void batch_sync_bench()
+{
+    Logger::ptr logger = LOG_NAME("batch_sync_logger");
+
+    logger->addAppender(g_batchappender);
+
+    bench(logger, 1, 1000000, 100, g_batchappender);
+    bench(logger, 3, 1000000, 100, g_batchappender);
+}
+
+RollingFileAppender::ptr get_rolling_appender(const std::string &name, const std::string &file, CompressionType compression)
+{
+    // 每8M滚动一次，保留最近4个归档
+    SizeAndTimeBasedRollingPolicy::ptr policy = std::make_shared<SizeAndTimeBasedRollingPolicy>();
+    policy->setMaxFileSize(8 * 1024 * 1024);
+    policy->setCompression(compression);
+    policy->setMaxHistory(4);
+
+    RollingFileAppender::ptr rappender = AppenderFactory::newRollingFileAppender();
+    rappender->setFile(file);
+    rappender->setName(name);
+    rappender->setFormatter("%m%n");
+    rappender->setAppend(false);
+    rappender->setLevel(LogLevel_DEBUG);
+    rappender->setFlushPolicy(FlushPolicy::Batch(64 * 1024, 1000));
+    rappender->setRollingPolicy(policy);
+    rappender->start();
+    return rappender;
+}
+
+void rolling_bench()
+{
+    // 相同负载下对比不压缩与后台gzip压缩，滚动约12次
+    RollingFileAppender::ptr plain = get_rolling_appender("rolling_test", "./log/stress_rolling_log.txt", CompressionType::NONE);
+    RollingFileAppender::ptr gzip = get_rolling_appender("rolling_gzip_test", "./log/stress_rolling_gzip_log.txt", CompressionType::GZIP);
+
+    Logger::ptr plain_logger = LOG_NAME("rolling_logger");
+    plain_logger->addAppender(plain);
+    bench(plain_logger, 1, 1000000, 100, plain);
+
+    Logger::ptr gzip_logger = LOG_NAME("rolling_gzip_logger");
+    gzip_logger->addAppender(gzip);
+    bench(gzip_logger, 1, 1000000, 100, gzip);
+
+    LogArchiver *archiver = LogArchiver::GetInstance();
+    archiver->wait();
+    std::cout << "归档文件：" << archiver->getArchivedCount() << "个，清理：" << archiver->getRemovedCount() << "个" << std::endl;
+    std::cout << "压缩：" << archiver->getBytesIn() / 1024 << "KB -> " << archiver->getBytesOut() / 1024 << "KB" << std::endl;
+    std::cout << std::endl;
+}
+
+void alloc_bench()
+{
+    Logger::ptr logger = LOG_NAME("alloc_logger");
+    FileAppender::ptr appender = get_appender("alloc_test", "./log/stress_alloc_log.txt", false, FlushPolicy::Batch(64 * 1024, 1000));
+    appender->setFormatter("[%d] [%p] [%c] [%f:%l]%T%m%n");
+    logger->addAppender(appender);
+
+    const size_t warmup = 1000, msg_num = 1000000;
+    std::string msg(64, 'w');
+    for (size_t i = 0; i < warmup; ++i)
+    {
+        LOG_INFO(logger) << msg << i;
+    }
+    size_t before = g_alloc_count.load();
+    for (size_t i = 0; i < msg_num; ++i)
+    {
+        LOG_INFO(logger) << msg << i;
+    }
+    size_t allocs = g_alloc_count.load() - before;
+    std::cout << "测试日志器:" << logger->getName() << std::endl;
+    std::cout << "稳态堆分配：" << allocs << "次，每条日志" << static_cast<double>(allocs) / msg_num << "次" << std::endl;
+    std::cout << std::endl;
+}
+
+void sampled_bench()
+{
+    // 热点调用点上被采样/限流拦下的日志只剩原子计数的开销
+    FileAppender::ptr appender = get_appender("sampled_test", "./log/stress_sampled_log.txt", false, FlushPolicy::Batch(64 * 1024, 1000));
+    Logger::ptr logger = LOG_NAME("sampled_logger");
+    logger->addAppender(appender);
+    Logger::ptr limited = LOG_NAME("limited_logger");
+    limited->addAppender(appender);
+    limited->setRateLimit(1000, 100);
+
+    const size_t msg_num = 1000000;
+    std::string msg(99, 'w');
+    auto run = [&](const char *name, const std::function<void(size_t)> &cb)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < msg_num; ++i)
+        {
+            cb(i);
+        }
+        std::chrono::duration<double> cost = std::chrono::high_resolution_clock::now() - start;
+        std::cout << name << "：" << msg_num << "次调用，每次" << cost.count() * 1e9 / msg_num << "ns" << std::endl;
+    };
+    run("LOG_INFO", [&](size_t i)
+        { LOG_INFO(logger) << msg; });
+    run("LOG_EVERY_N(1000)", [&](size_t i)
+        { LOG_EVERY_N(logger, LogLevel_INFO, 1000) << msg; });
+    run("LOG_EVERY_MS(10)", [&](size_t i)
+        { LOG_EVERY_MS(logger, LogLevel_INFO, 10) << msg; });
+    run("LOG_FIRST_N(100)", [&](size_t i)
+        { LOG_FIRST_N(logger, LogLevel_INFO, 100) << msg; });
+    run("rate_limit(1000/s)", [&](size_t i)
+        { LOG_INFO(limited) << msg; });
+    run("LOG_TRACE(filtered)", [&](size_t i)
+        { LOG_TRACE(logger) << msg; });
+    std::cout << std::endl;
+}
+
 void async_bench()
 {
     Logger::ptr logger = LOG_NAME("async_logger");
@@ -93,6 +240,11 @@ void async_bench()
 int main()
 {
     sync_bench();
+    mmap_sync_bench();
+    batch_sync_bench();
+    alloc_bench();
+    rolling_bench();
+    sampled_bench();
     async_bench();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "net.h"
+#include "net/http/HttpServer.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace lim_webserver;
+using namespace lim_webserver::http;
+
+static std::atomic<uint64_t> g_handled{0};
+
+/**
+ * @brief 每次请求拼出约4KB的JSON，模拟查询与序列化的开销，响应可缓存60秒
+ */
+class ApiServer : public HttpServer
+{
+public:
+    ApiServer(Scheduler *worker, Scheduler *accepter) : HttpServer(true, worker, accepter) {}
+
+    uint16_t port() { return std::static_pointer_cast<IPAddress>(m_socket_vec[0]->localAddress())->getPort(); }
+
+protected:
+    void handleRequest(HttpRequest::ptr req, HttpResponse::ptr rsp) override
+    {
+        ++g_handled;
+        std::mt19937 rng(std::hash<std::string>()(req->path()));
+        std::string json = "{\"path\":\"" + req->path() + "\",\"items\":[";
+        while (json.size() < 4096)
+        {
+            json += "{\"id\":" + std::to_string(rng()) + ",\"score\":" + std::to_string(rng() % 100000 / 100.0) + "},";
+        }
+        json.back() = ']';
+        json += "}";
+        rsp->setHeader("Content-Type", "application/json");
+        rsp->setHeader("Cache-Control", "public, max-age=60");
+        rsp->setBody(json);
+    }
+};
+
+static uint64_t NowNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ul + ts.tv_nsec;
+}
+
+/**
+ * @brief 读取一个完整的HTTP/1.1响应
+ */
+static bool RecvResponse(Socket::ptr sock, std::string &buf)
+{
+    buf.clear();
+    size_t header_end = std::string::npos;
+    size_t total = std::string::npos;
+    char data[16384];
+    while (total == std::string::npos || buf.size() < total)
+    {
+        int n = sock->recv(data, sizeof(data));
+        if (n <= 0)
+        {
+            return false;
+        }
+        buf.append(data, n);
+        if (header_end == std::string::npos && (header_end = buf.find("\r\n\r\n")) != std::string::npos)
+        {
+            size_t pos = buf.find("content-length:");
+            if (pos == std::string::npos || pos > header_end)
+            {
+                return false;
+            }
+            total = header_end + 4 + strtoul(buf.c_str() + pos + 15, nullptr, 10);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 按Zipf分布(s=1)生成路径编号，少数路径占大部分请求
+ */
+class Zipf
+{
+public:
+    Zipf(size_t n) : m_cdf(n), m_rng(2024)
+    {
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            sum += 1.0 / (i + 1);
+            m_cdf[i] = sum;
+        }
+        for (double &v : m_cdf)
+        {
+            v /= sum;
+        }
+    }
+
+    size_t next() { return std::lower_bound(m_cdf.begin(), m_cdf.end(), m_dist(m_rng)) - m_cdf.begin(); }
+
+private:
+    std::vector<double> m_cdf;
+    std::mt19937 m_rng;
+    std::uniform_real_distribution<double> m_dist;
+};
+
+/**
+ * @brief 长连接上逐个发出请求，keys为1时总是请求同一路径
+ */
+static void ApiClient(Address::ptr addr, size_t keys, double seconds, uint64_t &requests, std::atomic<int> &running)
+{
+    Socket::ptr sock = Socket::CreateTCP(addr);
+    if (sock->connect(addr))
+    {
+        Zipf zipf(keys);
+        std::string buf;
+        uint64_t end = NowNS() + (uint64_t)(seconds * 1e9);
+        while (NowNS() < end)
+        {
+            std::string request = "GET /api/item/" + std::to_string(zipf.next()) + " HTTP/1.1\r\nHost: bench\r\nConnection: keep-alive\r\n\r\n";
+            if (sock->send(request.data(), request.size()) <= 0 || !RecvResponse(sock, buf))
+            {
+                break;
+            }
+            ++requests;
+        }
+        sock->close();
+    }
+    --running;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? std::stod(argv[1]) : 2;
+    const int connections = 8;
+    LOG_ROOT()->setLevel(LogLevel::ERROR);
+    LOG_SYS()->setLevel(LogLevel::ERROR);
+
+    Scheduler *worker = Scheduler::CreateNetScheduler();
+    worker->setName("srv");
+    worker->startInNewThread(1);
+    Scheduler *client_sched = Scheduler::CreateNetScheduler();
+    client_sched->setName("cli");
+    client_sched->startInNewThread(1);
+
+    struct Case
+    {
+        const char *name;
+        size_t capacity; // 0为不缓存
+        size_t keys;
+    };
+    std::vector<Case> cases = {{"不缓存，单一路径", 0, 1},
+                               {"缓存，单一路径", 64 << 20, 1},
+                               {"不缓存，Zipf 10000路径", 0, 10000},
+                               {"缓存64MB，Zipf 10000路径", 64 << 20, 10000},
+                               {"缓存4MB，Zipf 10000路径", 4 << 20, 10000},
+                               {"缓存1MB，Zipf 10000路径", 1 << 20, 10000}};
+
+    std::cout << "单线程服务端，" << connections << "个长连接，响应约4KB" << std::endl;
+    for (auto &c : cases)
+    {
+        ApiServer *server = new ApiServer(worker, worker);
+        server->setResponseCache(c.capacity ? std::make_shared<ResponseCache>("bench", c.capacity) : nullptr);
+        if (!server->bind(IPv4Address::Create("127.0.0.1", 0)))
+        {
+            std::cout << "bind失败" << std::endl;
+            return 1;
+        }
+        server->start();
+        Address::ptr addr = IPv4Address::Create("127.0.0.1", server->port());
+
+        g_handled = 0;
+        std::vector<uint64_t> requests(connections, 0);
+        std::atomic<int> running{connections};
+        for (int i = 0; i < connections; ++i)
+        {
+            client_sched->createTask([&, i]() { ApiClient(addr, c.keys, seconds, requests[i], running); });
+        }
+        while (running > 0)
+        {
+            usleep(10 * 1000);
+        }
+        uint64_t total = 0;
+        for (uint64_t n : requests)
+        {
+            total += n;
+        }
+        double hit_rate = total ? 100.0 * (total - std::min<uint64_t>(g_handled, total)) / total : 0;
+        std::cout << std::left << std::setw(36) << c.name << std::right << std::fixed << std::setprecision(0) << std::setw(8) << total / seconds
+                  << " req/s  命中率 " << std::setprecision(1) << std::setw(5) << hit_rate << "%";
+        if (c.capacity)
+        {
+            std::cout << "  条目 " << server->getResponseCache()->count() << "  占用 " << server->getResponseCache()->size() / 1024 << " KB";
+        }
+        std::cout << std::endl;
+        server->stop();
+    }
+    client_sched->stop();
+    worker->stop();
+    return 0;
+}
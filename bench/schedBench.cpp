@@ -0,0 +1,302 @@
+#include "coroutine.h"
+#include "base/LFQueue.h"
+#include "base/Metrics.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lim_webserver;
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief 输出一行结果，列固定为：用例 线程数 操作数 耗时(s) 每次操作(ns) 吞吐(Mops/s)
+ */
+static void Report(const char *name, int threads, uint64_t ops, Clock::time_point start)
+{
+    double cost = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("%-14s\t%d\t%lu\t%.4f\t%.1f\t%.3f\n", name, threads, (unsigned long)ops, cost, cost * 1e9 / ops, ops / cost / 1e6);
+    fflush(stdout);
+}
+
+static void Wait(std::atomic<uint64_t> &counter, uint64_t target)
+{
+    while (counter.load(std::memory_order_acquire) < target)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+/**
+ * @brief 创建空任务，统计从第一次createTask到全部运行完的速率
+ */
+static void spawn_bench(int threads)
+{
+    const uint64_t count = 200000;
+    Scheduler *scheduler = Scheduler::Create();
+    scheduler->setName("spawn");
+    scheduler->startInNewThread(threads);
+    std::atomic<uint64_t> done{0};
+    auto start = Clock::now();
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        scheduler->createTask([&done]() { done.fetch_add(1, std::memory_order_release); });
+    }
+    Wait(done, count);
+    Report("spawn", threads, count, start);
+    scheduler->stop();
+}
+
+/**
+ * @brief 每个处理器上两个协程交替CoYield，统计一次让出并切回的耗时
+ */
+static void yield_bench(int threads)
+{
+    const uint64_t rounds = 500000;
+    Scheduler *scheduler = Scheduler::Create();
+    scheduler->setName("yield");
+    scheduler->startInNewThread(threads);
+    std::atomic<uint64_t> done{0};
+    auto start = Clock::now();
+    for (int i = 0; i < threads * 2; ++i)
+    {
+        scheduler->createTask([&done, rounds]()
+                              {
+                                  for (uint64_t r = 0; r < rounds; ++r)
+                                  {
+                                      Processor::CoYield();
+                                  }
+                                  done.fetch_add(1, std::memory_order_release); },
+                              i / 2);
+    }
+    Wait(done, threads * 2);
+    Report("yield", threads, rounds * threads * 2, start);
+    scheduler->stop();
+}
+
+/**
+ * @brief 两个协程互相Task::wake后CoHold，cross为true时分处两个处理器，统计单向唤醒到恢复运行的耗时
+ */
+static void wake_bench(bool cross)
+{
+    const uint64_t rounds = cross ? 100000 : 500000;
+    int threads = cross ? 2 : 1;
+    Scheduler *scheduler = Scheduler::Create();
+    scheduler->setName("wake");
+    scheduler->startInNewThread(threads);
+    std::atomic<Task *> tasks[2] = {{nullptr}, {nullptr}};
+    std::atomic<uint64_t> done{0};
+    Clock::time_point start;
+    for (int i = 0; i < 2; ++i)
+    {
+        scheduler->createTask([&, i]()
+                              {
+                                  tasks[i] = Processor::GetCurrentTask();
+                                  if (i == 1)
+                                  {
+                                      // 等待0号发起第一次唤醒
+                                      Processor::CoHold();
+                                  }
+                                  else
+                                  {
+                                      // 只唤醒已挂起的任务，唤醒仍在就绪队列中的任务会使其被重复调度
+                                      while (!tasks[1].load() || tasks[1].load()->state() != TaskState::HOLD)
+                                      {
+                                          Processor::CoYield();
+                                      }
+                                      start = Clock::now();
+                                  }
+                                  Task *peer = tasks[1 - i];
+                                  for (uint64_t r = 0; r < rounds; ++r)
+                                  {
+                                      peer->wake();
+                                      if (i == 0 || r + 1 < rounds)
+                                      {
+                                          Processor::CoHold();
+                                      }
+                                  }
+                                  done.fetch_add(1, std::memory_order_release); },
+                              cross ? i : 0);
+    }
+    Wait(done, 2);
+    Report(cross ? "wake_cross" : "wake_local", threads, rounds * 2, start);
+    scheduler->stop();
+}
+
+/**
+ * @brief 多个线程各自添加定时器后立即取消
+ */
+static void timer_arm_cancel_bench(int threads)
+{
+    const uint64_t count = 100000;
+    TimerManager *manager = TimerManager::GetInstance();
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([manager, count]()
+                             {
+                                 for (uint64_t i = 0; i < count; ++i)
+                                 {
+                                     Timer::ptr timer = manager->addTimer(60 * 1000, []() {});
+                                     timer->cancel();
+                                 } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    Report("timer_cancel", threads, count * threads, start);
+}
+
+/**
+ * @brief 多个线程各自添加1ms定时器，统计全部回调执行完的吞吐
+ */
+static void timer_fire_bench(int threads)
+{
+    const uint64_t count = 50000;
+    TimerManager *manager = TimerManager::GetInstance();
+    std::atomic<uint64_t> fired{0};
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([manager, count, &fired]()
+                             {
+                                 for (uint64_t i = 0; i < count; ++i)
+                                 {
+                                     manager->addTimer(1, [&fired]() { fired.fetch_add(1, std::memory_order_release); });
+                                 } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    Wait(fired, count * threads);
+    Report("timer_fire", threads, count * threads, start);
+}
+
+/**
+ * @brief 多个生产者入队，一个消费者出队，与处理器新任务队列的用法一致
+ */
+static void lfqueue_bench(int producers)
+{
+    const uint64_t count = 500000;
+    LFQueue<uint64_t> queue;
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < producers; ++t)
+    {
+        workers.emplace_back([&queue, count]()
+                             {
+                                 for (uint64_t i = 0; i < count; ++i)
+                                 {
+                                     queue.enqueue(i);
+                                 } });
+    }
+    uint64_t received = 0, value;
+    while (received < count * producers)
+    {
+        if (queue.dequeue(value))
+        {
+            ++received;
+        }
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    Report("lfqueue_mpsc", producers, count * producers, start);
+}
+
+/**
+ * @brief 多个线程同时累加同一个计数器与直方图，验证分片写入的开销
+ */
+static void metrics_bench(int threads)
+{
+    const uint64_t count = 2000000;
+    MetricCounter *counter = MetricsRegistry::GetInstance()->counter("bench_counter_total", "schedBench counter");
+    MetricHistogram *histogram = MetricsRegistry::GetInstance()->histogram("bench_histogram", "schedBench histogram", {}, 1, MetricsRegistry::CountBounds());
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([counter, count]()
+                             {
+                                 for (uint64_t i = 0; i < count; ++i)
+                                 {
+                                     counter->inc();
+                                 } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    Report("metric_inc", threads, count * threads, start);
+
+    workers.clear();
+    start = Clock::now();
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([histogram, count]()
+                             {
+                                 for (uint64_t i = 0; i < count; ++i)
+                                 {
+                                     histogram->record(i & 1023);
+                                 } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    Report("metric_record", threads, count * threads, start);
+}
+
+/**
+ * @brief 用法：schedBench [最大线程数]，线程数从1起按2倍递增
+ */
+int main(int argc, char **argv)
+{
+    LOG_SYS()->setLevel(LogLevel::ERROR);
+    int max_threads = argc > 1 ? std::stoi(argv[1]) : std::max(2u, std::thread::hardware_concurrency());
+    std::vector<int> thread_counts;
+    for (int t = 1; t <= max_threads; t *= 2)
+    {
+        thread_counts.push_back(t);
+    }
+
+    printf("case\tthreads\tops\tseconds\tns_per_op\tmops\n");
+    for (int t : thread_counts)
+    {
+        spawn_bench(t);
+    }
+    for (int t : thread_counts)
+    {
+        yield_bench(t);
+    }
+    wake_bench(false);
+    wake_bench(true);
+    for (int t : thread_counts)
+    {
+        timer_arm_cancel_bench(t);
+    }
+    for (int t : thread_counts)
+    {
+        timer_fire_bench(t);
+    }
+    for (int t : thread_counts)
+    {
+        lfqueue_bench(t);
+    }
+    for (int t : thread_counts)
+    {
+        metrics_bench(t);
+    }
+    return 0;
+}
@@ -0,0 +1,255 @@
+#include "net.h"
+#include "splog.h"
+
+#include <atomic>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace lim_webserver;
+
+static const size_t BULK_SIZE = 256 * 1024 * 1024;
+static const size_t CHUNK_SIZE = 256 * 1024;
+
+static int g_file = -1;                       // sendfile的数据源
+static std::atomic<bool> g_ktls_engaged{false}; // 服务端是否有连接由内核接管了发送
+
+/**
+ * @brief 每个连接先完成TLS握手，再按单字节命令应答：
+ *        'q' 回复2字节，'b' 经send发送BULK_SIZE字节，'f' 经sendfile发送同样大小的文件
+ */
+class TlsServer : public TcpServer
+{
+public:
+    TlsServer(Scheduler *worker, Scheduler *accepter) : TcpServer(worker, accepter) {}
+
+    uint16_t port() { return std::static_pointer_cast<IPAddress>(m_socket_vec[0]->localAddress())->getPort(); }
+
+protected:
+    void handleClient(Socket::ptr client) override
+    {
+        SslSocketStream::ptr tls = std::make_shared<SslSocketStream>(client, m_sslCtx);
+        if (!tls->handshake())
+        {
+            tls->close();
+            return;
+        }
+        if (tls->isKtlsSend())
+        {
+            g_ktls_engaged = true;
+        }
+        std::vector<char> chunk(CHUNK_SIZE, 'x');
+        char cmd;
+        while (tls->resv(&cmd, 1) == 1)
+        {
+            if (cmd == 'q')
+            {
+                tls->send("ok", 2);
+            }
+            else if (cmd == 'b')
+            {
+                for (size_t sent = 0; sent < BULK_SIZE; sent += CHUNK_SIZE)
+                {
+                    if (tls->send(&chunk[0], CHUNK_SIZE) <= 0)
+                    {
+                        break;
+                    }
+                }
+            }
+            else if (cmd == 'f')
+            {
+                tls->sendfile(g_file, 0, BULK_SIZE);
+            }
+        }
+        tls->close();
+    }
+};
+
+static uint64_t NowNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ul + ts.tv_nsec;
+}
+
+/**
+ * @brief 握手结果
+ */
+struct HandshakeResult
+{
+    double rate = 0;     // 每秒完成的握手数
+    uint64_t reused = 0; // 恢复了会话的握手数
+    uint64_t total = 0;
+};
+
+/**
+ * @brief 反复建立连接、握手并完成一次问答；resume时用上一次连接的会话恢复
+ */
+static void HandshakeClient(Address::ptr addr, SslContext::ptr ctx, bool resume, double seconds, HandshakeResult &result)
+{
+    SslSocketStream::SessionPtr session;
+    uint64_t start = NowNS();
+    uint64_t end = start + (uint64_t)(seconds * 1e9);
+    while (NowNS() < end)
+    {
+        Socket::ptr sock = Socket::CreateTCP(addr);
+        if (!sock->connect(addr))
+        {
+            break;
+        }
+        SslSocketStream tls(sock, ctx);
+        if (resume)
+        {
+            tls.setSession(session);
+        }
+        char reply[2];
+        if (!tls.handshake() || tls.send("q", 1) != 1 || tls.resv(reply, sizeof(reply)) != 2)
+        {
+            break;
+        }
+        ++result.total;
+        if (tls.isSessionReused())
+        {
+            ++result.reused;
+        }
+        if (resume && (!session || !tls.isSessionReused()))
+        {
+            // TLS 1.3的票据随应答之后到达，读完应答后才能取到
+            session = tls.getSession();
+        }
+        tls.close();
+    }
+    result.rate = result.total / ((NowNS() - start) / 1e9);
+}
+
+/**
+ * @brief 请求一次批量数据并全部读完
+ *
+ * @return 吞吐量，单位：MB/s
+ */
+static double BulkClient(Address::ptr addr, SslContext::ptr ctx, char cmd)
+{
+    Socket::ptr sock = Socket::CreateTCP(addr);
+    if (!sock->connect(addr))
+    {
+        return 0;
+    }
+    SslSocketStream tls(sock, ctx);
+    if (!tls.handshake())
+    {
+        return 0;
+    }
+    std::vector<char> buffer(CHUNK_SIZE);
+    uint64_t start = NowNS();
+    tls.send(&cmd, 1);
+    size_t received = 0;
+    while (received < BULK_SIZE)
+    {
+        int n = tls.resv(&buffer[0], buffer.size());
+        if (n <= 0)
+        {
+            break;
+        }
+        received += n;
+    }
+    double seconds = (NowNS() - start) / 1e9;
+    tls.close();
+    return received == BULK_SIZE ? BULK_SIZE / 1048576.0 / seconds : 0;
+}
+
+template <class F>
+static void RunOn(Scheduler *sched, F f)
+{
+    std::atomic<bool> finished{false};
+    sched->createTask(
+        [&]()
+        {
+            f();
+            finished = true;
+        });
+    while (!finished)
+    {
+        usleep(10 * 1000);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? std::stod(argv[1]) : 2;
+    LOG_ROOT()->setLevel(LogLevel::ERROR);
+    LOG_SYS()->setLevel(LogLevel::ERROR);
+
+    char path[] = "/tmp/tls_bench_XXXXXX";
+    g_file = mkstemp(path);
+    unlink(path);
+    std::vector<char> chunk(CHUNK_SIZE, 'x');
+    for (size_t written = 0; written < BULK_SIZE; written += CHUNK_SIZE)
+    {
+        if (write(g_file, &chunk[0], CHUNK_SIZE) != (ssize_t)CHUNK_SIZE)
+        {
+            std::cout << "写临时文件失败" << std::endl;
+            return 1;
+        }
+    }
+
+    Scheduler *worker = Scheduler::CreateNetScheduler();
+    worker->setName("srv");
+    worker->startInNewThread(1);
+    Scheduler *client_sched = Scheduler::CreateNetScheduler();
+    client_sched->setName("cli");
+    client_sched->startInNewThread(1);
+
+    std::cout << "回环地址，自签名P-256证书，单线程服务端；批量传输 " << BULK_SIZE / 1048576 << " MB" << std::endl;
+    // 两组各用一个服务器，互不影响
+    bool engaged = false;
+    for (bool ktls : {false, true})
+    {
+        SslContext::ptr server_ctx = SslContext::CreateSelfSigned();
+        SslContext::ptr client_ctx = SslContext::CreateClient();
+        if (!server_ctx || !client_ctx)
+        {
+            std::cout << "创建TLS上下文失败" << std::endl;
+            return 1;
+        }
+        server_ctx->setKtls(ktls);
+        client_ctx->setKtls(ktls);
+        g_ktls_engaged = false;
+
+        TlsServer *server = new TlsServer(worker, worker);
+        server->setSslContext(server_ctx);
+        if (!server->bind(IPv4Address::Create("127.0.0.1", 0), true))
+        {
+            std::cout << "bind失败" << std::endl;
+            return 1;
+        }
+        server->start();
+        Address::ptr addr = IPv4Address::Create("127.0.0.1", server->port());
+
+        HandshakeResult full, resumed;
+        double bulk_send = 0, bulk_sendfile = 0;
+        RunOn(client_sched, [&]() { HandshakeClient(addr, client_ctx, false, seconds, full); });
+        RunOn(client_sched, [&]() { HandshakeClient(addr, client_ctx, true, seconds, resumed); });
+        RunOn(client_sched, [&]() { bulk_send = BulkClient(addr, client_ctx, 'b'); });
+        RunOn(client_sched, [&]() { bulk_sendfile = BulkClient(addr, client_ctx, 'f'); });
+        engaged = engaged || g_ktls_engaged;
+
+        std::cout << std::left << std::setw(10) << (ktls ? "kTLS开" : "kTLS关") << "内核接管发送 " << (g_ktls_engaged ? "是" : "否") << std::endl;
+        std::cout << std::fixed << std::setprecision(0) << "  完整握手 " << std::setw(8) << full.rate << " 次/s" << "  票据恢复 " << std::setw(8)
+                  << resumed.rate << " 次/s (恢复 " << resumed.reused << "/" << resumed.total << ")" << std::endl;
+        std::cout << "  send     " << std::setw(8) << bulk_send << " MB/s" << "  sendfile " << std::setw(8) << bulk_sendfile << " MB/s" << std::endl;
+        server->stop();
+    }
+    if (!engaged)
+    {
+        std::cout << "注：内核未加载tls模块(/proc/sys/net/ipv4/tcp_available_ulp中没有tls)时kTLS无法生效，两组结果都走用户态记录层" << std::endl;
+    }
+    client_sched->stop();
+    worker->stop();
+    close(g_file);
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "net.h"
+#include "net/http/WSServer.h"
+#include "splog.h"
+
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace lim_webserver;
+using namespace lim_webserver::http;
+
+/**
+ * @brief 暴露实际监听端口的WSServer
+ */
+class BenchServer : public WSServer
+{
+public:
+    BenchServer(Scheduler *worker, Scheduler *accepter) : WSServer(worker, accepter) {}
+
+    uint16_t port() { return std::static_pointer_cast<IPAddress>(m_socket_vec[0]->localAddress())->getPort(); }
+};
+
+static uint64_t NowNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ul + ts.tv_nsec;
+}
+
+/**
+ * @brief 去掩码内核与逐字节实现的吞吐对比
+ */
+static void mask_bench()
+{
+    const uint8_t key[4] = {0x12, 0x34, 0x56, 0x78};
+    for (size_t size : {64, 1024, 64 * 1024})
+    {
+        std::string buf(size, 'a');
+        size_t rounds = (256ul << 20) / size;
+        uint64_t start = NowNS();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            WSMask(&buf[0], size, key, r);
+        }
+        double simd = (double)rounds * size / (NowNS() - start);
+
+        start = NowNS();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            volatile uint8_t *p = (volatile uint8_t *)&buf[0];
+            for (size_t i = 0; i < size; ++i)
+            {
+                p[i] ^= key[(i + r) & 3];
+            }
+        }
+        double scalar = (double)rounds * size / (NowNS() - start);
+        std::cout << std::left << std::setw(24) << ("mask_" + std::to_string(size) + "B") << std::fixed << std::setprecision(2) << simd
+                  << " GB/s  (逐字节 " << scalar << " GB/s)" << std::endl;
+    }
+}
+
+/**
+ * @brief 广播扇出：clients个连接，服务端反复广播小消息，统计各客户端实际收到的消息数
+ *
+ * @details 广播方按未送达的消息数限流，保证发送队列不溢出，结果为不丢消息时的持续吞吐
+ */
+static void fanout_bench(BenchServer *server, Scheduler *client_sched, int clients, double seconds, size_t payload)
+{
+    Address::ptr addr = IPv4Address::Create("127.0.0.1", server->port());
+    std::atomic<uint64_t> received{0};
+    std::atomic<int> connected{0};
+    std::atomic<bool> stop{false};
+    for (int i = 0; i < clients; ++i)
+    {
+        client_sched->createTask(
+            [&, addr]()
+            {
+                WSSession::ptr session = WSSession::Connect(addr, "/fanout");
+                if (!session)
+                {
+                    std::cout << "连接失败" << std::endl;
+                    return;
+                }
+                ++connected;
+                uint64_t local = 0;
+                while (!stop)
+                {
+                    WSMessage::ptr msg = session->recvMessage();
+                    if (!msg)
+                    {
+                        break;
+                    }
+                    // 批量累加，避免所有客户端争用同一计数器
+                    if (++local == 256)
+                    {
+                        received.fetch_add(local, std::memory_order_relaxed);
+                        local = 0;
+                    }
+                }
+                received.fetch_add(local, std::memory_order_relaxed);
+                session->close();
+            });
+    }
+    while (connected < clients || (int)server->getSessionCount() < clients)
+    {
+        usleep(10 * 1000);
+    }
+
+    std::string data(payload, 'x');
+    WSFrame::ptr frame = WSFrame::Create(WSOpcode::BINARY, data);
+    uint64_t sent = 0;
+    uint64_t start = NowNS();
+    uint64_t end = start + (uint64_t)(seconds * 1e9);
+    uint64_t window = (uint64_t)clients * 1024;
+    while (NowNS() < end)
+    {
+        if (sent - received.load(std::memory_order_relaxed) >= window)
+        {
+            sched_yield();
+            continue;
+        }
+        // 同一帧对象广播给所有会话，每轮只编码一次
+        sent += server->broadcast(frame);
+    }
+    double elapsed = (NowNS() - start) / 1e9;
+    uint64_t delivered = received.load();
+    stop = true;
+
+    std::cout << std::left << std::setw(24) << ("fanout_" + std::to_string(clients) + "x" + std::to_string(payload) + "B") << std::fixed
+              << std::setprecision(0) << delivered / elapsed << " msg/s  (广播 " << sent / clients / elapsed << " 次/s)"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int clients = argc > 1 ? std::stoi(argv[1]) : 100;
+    double seconds = argc > 2 ? std::stod(argv[2]) : 3;
+    int server_threads = argc > 3 ? std::stoi(argv[3]) : 1;
+    int client_threads = argc > 4 ? std::stoi(argv[4]) : 1;
+    LOG_ROOT()->setLevel(LogLevel::ERROR);
+    LOG_SYS()->setLevel(LogLevel::ERROR);
+
+    mask_bench();
+
+    Scheduler *worker = Scheduler::CreateNetScheduler();
+    worker->setName("srv");
+    worker->startInNewThread(server_threads);
+    BenchServer *server = new BenchServer(worker, worker);
+    if (!server->bind(IPv4Address::Create("127.0.0.1", 0)))
+    {
+        std::cout << "bind失败" << std::endl;
+        return 1;
+    }
+    server->start();
+
+    Scheduler *client_sched = Scheduler::CreateNetScheduler();
+    client_sched->setName("cli");
+    client_sched->startInNewThread(client_threads);
+
+    fanout_bench(server, client_sched, clients, seconds, 32);
+    server->stop();
+    client_sched->stop();
+    worker->stop();
+    return 0;
+}
@@ -34,8 +34,13 @@ void add_asyncLogger()
 int main(int argc, char *argv[])
 {
     lim_webserver::LogLevel level = LogLevel_TRACE;
-
-    if (argc == 2)
+    // -c <file> 加载配置文件，文件中config.hot_reload为true时修改后自动重新加载
+    std::string config_file;
+    if (argc == 3 && std::string(argv[1]) == "-c")
+    {
+        config_file = argv[2];
+    }
+    else if (argc == 2)
     {
         level = LogLevel_DEBUG;
     }
@@ -47,6 +52,10 @@ int main(int argc, char *argv[])
     
 
     accept_sched->setName("accepter");
+    if (!config_file.empty() && !ConfigWatcher::Load(config_file, accept_sched))
+    {
+        return 1;
+    }
     accept_sched->createTask(&run);
     accept_sched->start();
     return 0;
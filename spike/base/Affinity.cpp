@@ -0,0 +1,260 @@
+#include "Affinity.h"
+#include "Configer.h"
+#include "Mutex.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <set>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lim_webserver
+{
+    using SchedulerCpuMap = std::unordered_map<std::string, std::string>;
+
+    static ConfigerVar<SchedulerCpuMap>::ptr GetSchedulerConfig()
+    {
+        static ConfigerVar<SchedulerCpuMap>::ptr s_config =
+            Configer::Lookup("affinity.schedulers", SchedulerCpuMap(), "scheduler name to cpu list of its processors");
+        return s_config;
+    }
+
+    static ConfigerVar<std::string>::ptr GetHousekeepingConfig()
+    {
+        static ConfigerVar<std::string>::ptr s_config =
+            Configer::Lookup("affinity.housekeeping", std::string(), "cpu list of timer and log threads");
+        return s_config;
+    }
+
+    // 静态初始化时注册配置项，使其能被LoadFromYaml加载；函数内静态变量保证其他静态对象初始化时也可使用
+    static struct _AffinityConfigIniter
+    {
+        _AffinityConfigIniter()
+        {
+            GetSchedulerConfig();
+            GetHousekeepingConfig();
+        }
+    } s_affinity_config_initer;
+
+    std::vector<int> CpuAffinity::Parse(const std::string &list)
+    {
+        std::vector<int> cpus;
+        size_t begin = 0;
+        while (begin <= list.size())
+        {
+            size_t end = list.find(',', begin);
+            if (end == std::string::npos)
+            {
+                end = list.size();
+            }
+            std::string item = StringUtil::Trim(list.substr(begin, end - begin));
+            begin = end + 1;
+            if (item.empty())
+            {
+                continue;
+            }
+            char *tail = nullptr;
+            long first = strtol(item.c_str(), &tail, 10);
+            long last = first;
+            if (*tail == '-')
+            {
+                last = strtol(tail + 1, &tail, 10);
+            }
+            if (*tail != '\0' || first < 0 || last < first || last >= CPU_SETSIZE)
+            {
+                continue;
+            }
+            for (long cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return cpus;
+    }
+
+    std::string CpuAffinity::ToString(const std::vector<int> &cpus)
+    {
+        std::string str;
+        for (size_t i = 0; i < cpus.size();)
+        {
+            size_t j = i;
+            while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+            {
+                ++j;
+            }
+            if (!str.empty())
+            {
+                str += ",";
+            }
+            str += std::to_string(cpus[i]);
+            if (j > i)
+            {
+                str += "-" + std::to_string(cpus[j]);
+            }
+            i = j + 1;
+        }
+        return str;
+    }
+
+    bool CpuAffinity::Bind(const std::vector<int> &cpus, pid_t tid)
+    {
+        if (cpus.empty())
+        {
+            return false;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+        {
+            CPU_SET(cpu, &set);
+        }
+        return sched_setaffinity(tid, sizeof(set), &set) == 0;
+    }
+
+    bool CpuAffinity::PreferNode(int node)
+    {
+        if (node < 0 || node >= (int)(sizeof(unsigned long) * 8))
+        {
+            return false;
+        }
+        unsigned long mask = 1UL << node;
+        return syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8) == 0;
+    }
+
+    int CpuAffinity::NodeOfCpu(int cpu)
+    {
+        std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        DIR *dir = opendir(path.c_str());
+        if (!dir)
+        {
+            return -1;
+        }
+        int node = -1;
+        while (struct dirent *entry = readdir(dir))
+        {
+            if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(entry->d_name[4]))
+            {
+                node = atoi(entry->d_name + 4);
+                break;
+            }
+        }
+        closedir(dir);
+        return node;
+    }
+
+    int CpuAffinity::NumNodes()
+    {
+        DIR *dir = opendir("/sys/devices/system/node");
+        if (!dir)
+        {
+            return 1;
+        }
+        int count = 0;
+        while (struct dirent *entry = readdir(dir))
+        {
+            if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(entry->d_name[4]))
+            {
+                ++count;
+            }
+        }
+        closedir(dir);
+        return count > 0 ? count : 1;
+    }
+
+    std::vector<int> CpuAffinity::SchedulerCpus(const std::string &name)
+    {
+        const SchedulerCpuMap &config = GetSchedulerConfig()->get();
+        auto it = config.find(name);
+        return it == config.end() ? std::vector<int>() : Parse(it->second);
+    }
+
+    std::vector<int> CpuAffinity::HousekeepingCpus() { return Parse(GetHousekeepingConfig()->get()); }
+
+    namespace
+    {
+        /**
+         * @brief 已登记的辅助线程
+         */
+        struct HousekeepingRegistry
+        {
+            HousekeepingRegistry()
+            {
+                // 配置变化时把所有辅助线程迁移到新的CPU集合
+                GetHousekeepingConfig()->addListener([this](const std::string &old_val, const std::string &new_val)
+                                                     {
+                                                         std::vector<int> cpus = CpuAffinity::Parse(new_val);
+                                                         if (cpus.empty())
+                                                         {
+                                                             cpus = AllCpus();
+                                                         }
+                                                         Mutex::Lock lock(mutex);
+                                                         for (pid_t tid : tids)
+                                                         {
+                                                             CpuAffinity::Bind(cpus, tid);
+                                                         } });
+            }
+
+            static std::vector<int> AllCpus()
+            {
+                std::vector<int> cpus;
+                long count = sysconf(_SC_NPROCESSORS_CONF);
+                for (long i = 0; i < count && i < CPU_SETSIZE; ++i)
+                {
+                    cpus.push_back(i);
+                }
+                return cpus;
+            }
+
+            Mutex mutex;
+            std::set<pid_t> tids;
+        };
+
+        HousekeepingRegistry &GetHousekeepingRegistry()
+        {
+            // 不析构，辅助线程可能在静态对象析构之后才退出
+            static HousekeepingRegistry *s_registry = new HousekeepingRegistry();
+            return *s_registry;
+        }
+
+        /**
+         * @brief 线程退出时注销
+         */
+        struct HousekeepingGuard
+        {
+            ~HousekeepingGuard()
+            {
+                if (tid)
+                {
+                    HousekeepingRegistry &registry = GetHousekeepingRegistry();
+                    Mutex::Lock lock(registry.mutex);
+                    registry.tids.erase(tid);
+                }
+            }
+
+            pid_t tid = 0;
+        };
+    } // namespace
+
+    void CpuAffinity::RegisterHousekeeping()
+    {
+        static thread_local HousekeepingGuard t_guard;
+        if (t_guard.tid)
+        {
+            return;
+        }
+        t_guard.tid = syscall(SYS_gettid);
+        HousekeepingRegistry &registry = GetHousekeepingRegistry();
+        {
+            Mutex::Lock lock(registry.mutex);
+            registry.tids.insert(t_guard.tid);
+        }
+        Bind(HousekeepingCpus());
+    }
+
+} // namespace lim_webserver
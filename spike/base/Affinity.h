@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace lim_webserver
+{
+    /**
+     * @brief CPU亲和性与NUMA放置
+     *
+     * @details 配置项：
+     *      affinity.schedulers     {调度器名: CPU列表}，调度器的第i个处理器线程独占列表中第i个CPU(循环使用)
+     *      affinity.housekeeping   CPU列表，定时器、异步日志等辅助线程只在这些CPU上运行
+     *      CPU列表格式同内核cpulist，如"0-3,8,10-11"，为空表示不绑定。
+     *
+     *      绑定后线程优先在所在NUMA节点上分配内存，协程栈与队列节点在处理器线程中首次访问，
+     *      因而落在本地节点上。
+     */
+    class CpuAffinity
+    {
+    public:
+        /**
+         * @brief 解析CPU列表，非法的部分被忽略
+         */
+        static std::vector<int> Parse(const std::string &list);
+
+        /**
+         * @brief CPU列表转换为字符串，相邻的CPU合并为区间
+         */
+        static std::string ToString(const std::vector<int> &cpus);
+
+        /**
+         * @brief 将线程绑定到指定CPU集合
+         *
+         * @param tid 线程ID，0表示当前线程
+         */
+        static bool Bind(const std::vector<int> &cpus, pid_t tid = 0);
+
+        /**
+         * @brief 当前线程优先在node上分配内存
+         */
+        static bool PreferNode(int node);
+
+        /**
+         * @brief CPU所在的NUMA节点，无法确定时返回-1
+         */
+        static int NodeOfCpu(int cpu);
+
+        /**
+         * @brief NUMA节点数量
+         */
+        static int NumNodes();
+
+        /**
+         * @brief 配置中调度器name的处理器CPU列表
+         */
+        static std::vector<int> SchedulerCpus(const std::string &name);
+
+        /**
+         * @brief 配置中辅助线程的CPU列表
+         */
+        static std::vector<int> HousekeepingCpus();
+
+        /**
+         * @brief 将当前线程登记为辅助线程并按配置绑定，配置变化时重新绑定，线程退出时自动注销
+         */
+        static void RegisterHousekeeping();
+    };
+
+} // namespace lim_webserver
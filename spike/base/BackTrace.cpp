@@ -1,5 +1,6 @@
 #include <execinfo.h>
 #include <cxxabi.h>
+#include <string.h>
 
 #include "BackTrace.h"
 #include "splog.h"
@@ -17,7 +18,6 @@ namespace lim_webserver
         if (1 == sscanf(str, "%*[^(]%*[^_]%255[^)+]", &rt[0]))
         {
             char *v = abi::__cxa_demangle(&rt[0], nullptr, &size, &status);
-            std::cout << "1 " << rt <<std::endl;
             if (v)
             {
                 std::string result(v);
@@ -27,6 +27,8 @@ namespace lim_webserver
         }
         if (1 == sscanf(str, "%255s", &rt[0]))
         {
+            // 去掉预留缓冲区中未写入的部分
+            rt.resize(strlen(rt.c_str()));
             return rt;
         }
         return str;
@@ -59,6 +61,25 @@ namespace lim_webserver
         free(array);
     }
 
+    void BackTraceSymbols(const std::vector<void *> &addrs, std::vector<std::string> &out)
+    {
+        if (addrs.empty())
+        {
+            return;
+        }
+        char **strings = backtrace_symbols(addrs.data(), addrs.size());
+        if (strings == NULL)
+        {
+            LOG_ERROR(g_logger) << "backtrace_symbols error";
+            return;
+        }
+        for (size_t i = 0; i < addrs.size(); ++i)
+        {
+            out.emplace_back(demangle(strings[i]));
+        }
+        free(strings);
+    }
+
     std::string BackTraceToString(int size, int skip)
     {
         // 收集函数调用栈
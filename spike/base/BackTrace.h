@@ -30,4 +30,12 @@ namespace lim_webserver
      * @return       格式化的字符串，表示调用栈。
      */
     std::string BackTraceToString(int size=64, int skip=0);
+
+    /**
+     * @brief 将一组代码地址转换为函数名，取不到符号的地址保留模块名与偏移。
+     *
+     * @param addrs 代码地址，可来自其他线程或协程的栈。
+     * @param out   用于存储转换结果的向量，与addrs一一对应。
+     */
+    void BackTraceSymbols(const std::vector<void *> &addrs, std::vector<std::string> &out);
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "BlockPool.h"
+
+#include <stdlib.h>
+#include <new>
+
+namespace lim_webserver
+{
+    namespace
+    {
+        struct FreeBlock
+        {
+            FreeBlock *next;
+        };
+
+        struct ThreadCache;
+
+        static thread_local ThreadCache *t_cache = nullptr;
+        static thread_local bool t_exited = false;
+
+        struct ThreadCache
+        {
+            FreeBlock *heads[BlockPool::CLASS_COUNT] = {};
+            size_t counts[BlockPool::CLASS_COUNT] = {};
+            BlockPool::Stats stats;
+
+            void trim()
+            {
+                for (size_t i = 0; i < BlockPool::CLASS_COUNT; ++i)
+                {
+                    while (heads[i])
+                    {
+                        FreeBlock *block = heads[i];
+                        heads[i] = block->next;
+                        free(block);
+                    }
+                    counts[i] = 0;
+                }
+                stats.cachedBytes = 0;
+            }
+
+            ~ThreadCache()
+            {
+                trim();
+                // 线程退出后(如thread_local析构顺序靠后的对象)仍可能释放块，此后直接交还free
+                t_cache = nullptr;
+                t_exited = true;
+            }
+        };
+
+        static ThreadCache *GetCache()
+        {
+            if (__builtin_expect(t_cache != nullptr, 1))
+            {
+                return t_cache;
+            }
+            if (t_exited)
+            {
+                return nullptr;
+            }
+            static thread_local ThreadCache cache;
+            t_cache = &cache;
+            return t_cache;
+        }
+
+        /**
+         * @brief 计算size所属的分级，超出最大分级返回CLASS_COUNT
+         */
+        static inline size_t ClassIndex(size_t size)
+        {
+            if (size <= (1ul << BlockPool::MIN_SHIFT))
+            {
+                return 0;
+            }
+            size_t shift = 64 - __builtin_clzl(size - 1);
+            return shift > BlockPool::MAX_SHIFT ? BlockPool::CLASS_COUNT : shift - BlockPool::MIN_SHIFT;
+        }
+
+        static inline size_t ClassCapacity(size_t index)
+        {
+            size_t count = BlockPool::MAX_CACHE_BYTES >> (index + BlockPool::MIN_SHIFT);
+            return count < BlockPool::MIN_CACHE_COUNT ? BlockPool::MIN_CACHE_COUNT : count;
+        }
+    } // namespace
+
+    void *BlockPool::Alloc(size_t size)
+    {
+        size_t index = ClassIndex(size);
+        ThreadCache *cache = index < CLASS_COUNT ? GetCache() : nullptr;
+        if (cache && cache->heads[index])
+        {
+            FreeBlock *block = cache->heads[index];
+            cache->heads[index] = block->next;
+            --cache->counts[index];
+            ++cache->stats.hits;
+            cache->stats.cachedBytes -= 1ul << (index + MIN_SHIFT);
+            return block;
+        }
+        if (cache)
+        {
+            ++cache->stats.misses;
+        }
+        void *ptr = malloc(index < CLASS_COUNT ? 1ul << (index + MIN_SHIFT) : size);
+        if (!ptr)
+        {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void BlockPool::Dealloc(void *ptr, size_t size)
+    {
+        if (!ptr)
+        {
+            return;
+        }
+        size_t index = ClassIndex(size);
+        ThreadCache *cache = index < CLASS_COUNT ? GetCache() : nullptr;
+        if (cache && cache->counts[index] < ClassCapacity(index))
+        {
+            FreeBlock *block = static_cast<FreeBlock *>(ptr);
+            block->next = cache->heads[index];
+            cache->heads[index] = block;
+            ++cache->counts[index];
+            cache->stats.cachedBytes += 1ul << (index + MIN_SHIFT);
+            return;
+        }
+        free(ptr);
+    }
+
+    size_t BlockPool::BlockSize(size_t size)
+    {
+        size_t index = ClassIndex(size);
+        return index < CLASS_COUNT ? 1ul << (index + MIN_SHIFT) : size;
+    }
+
+    BlockPool::Stats BlockPool::GetStats()
+    {
+        ThreadCache *cache = GetCache();
+        return cache ? cache->stats : Stats();
+    }
+
+    void BlockPool::Trim()
+    {
+        ThreadCache *cache = GetCache();
+        if (cache)
+        {
+            cache->trim();
+        }
+    }
+
+} // namespace lim_webserver
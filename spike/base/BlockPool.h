@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace lim_webserver
+{
+    /**
+     * @brief 按尺寸分级的线程本地内存块池
+     *
+     * @details 块大小按2的幂分级(64B~1MB)，每个线程每级维护一条空闲链表，链表节点复用空闲块的首8字节。
+     *          申请与释放不加锁；在A线程申请、B线程释放的块归入B线程的缓存。
+     *          每级缓存有上限，超出部分与超过1MB的申请直接交还malloc/free。
+     *          线程退出时缓存的块全部释放，之后该线程的申请释放直接走malloc/free。
+     */
+    class BlockPool
+    {
+    public:
+        static const size_t MIN_SHIFT = 6;                     // 最小块64B
+        static const size_t MAX_SHIFT = 20;                    // 最大块1MB
+        static const size_t CLASS_COUNT = MAX_SHIFT - MIN_SHIFT + 1;
+        static const size_t MAX_CACHE_BYTES = 1024 * 1024;     // 每级缓存的字节上限
+        static const size_t MIN_CACHE_COUNT = 4;               // 每级至少可缓存的块数
+
+        /**
+         * @brief 线程本地统计
+         */
+        struct Stats
+        {
+            uint64_t hits = 0;        // 命中缓存的申请数
+            uint64_t misses = 0;      // 走malloc的申请数
+            uint64_t cachedBytes = 0; // 当前缓存的字节数
+        };
+
+    public:
+        /**
+         * @brief 申请至少size字节的内存块
+         */
+        static void *Alloc(size_t size);
+
+        /**
+         * @brief 释放内存块，size须与申请时一致
+         */
+        static void Dealloc(void *ptr, size_t size);
+
+        /**
+         * @brief size所在分级的实际块大小，超出最大分级时原样返回
+         */
+        static size_t BlockSize(size_t size);
+
+        /**
+         * @brief 获取当前线程的统计
+         */
+        static Stats GetStats();
+
+        /**
+         * @brief 释放当前线程缓存的所有块
+         */
+        static void Trim();
+    };
+
+} // namespace lim_webserver
@@ -2,6 +2,7 @@
 
 #include "Mutex.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <sstream>
@@ -10,6 +11,7 @@
 #include <yaml-cpp/yaml.h>
 #include <unordered_set>
 #include <iostream>
+#include <vector>
 
 
 namespace lim_webserver
@@ -26,7 +28,7 @@ namespace lim_webserver
          * @param description 配置参数描述
          */
         ConfigerVarBase(const std::string &name, const std::string &description = "")
-            : m_name(name), m_description(description) {}
+            : m_name(name), m_description(description), m_index(s_next_index.fetch_add(1, std::memory_order_relaxed)) {}
         virtual ~ConfigerVarBase() {}
 
         /**
@@ -47,9 +49,44 @@ namespace lim_webserver
          */
         virtual bool fromString(const std::string &val) = 0;
 
+    protected:
+        /**
+         * @brief 线程本地缓存的值副本
+         * @details 缓存的是本线程拷贝出的值而不是共享快照，旧快照被替换后即可释放
+         */
+        struct LocalCopy
+        {
+            uint64_t version = 0;       // 副本对应的版本号，0表示未缓存
+            std::shared_ptr<void> value; // 本线程的值副本，类型擦除后的shared_ptr<T>
+        };
+
+        /**
+         * @brief 获得当前线程中本配置项的缓存槽
+         */
+        LocalCopy &localCopy() const
+        {
+            static thread_local std::vector<LocalCopy> t_copies;
+            if (m_index >= t_copies.size())
+            {
+                t_copies.resize(m_index + 1);
+            }
+            return t_copies[m_index];
+        }
+
+        /**
+         * @brief 生成全局唯一且递增的版本号
+         * @details 版本号全局唯一，配置项析构后其缓存槽即使残留也不会被误认为有效
+         */
+        static uint64_t NextVersion() { return s_next_version.fetch_add(1, std::memory_order_relaxed); }
+
     protected:
         std::string m_name;
         std::string m_description;
+        const size_t m_index; // 配置项序号，用于定位线程本地缓存槽
+
+    private:
+        static inline std::atomic<size_t> s_next_index{0};
+        static inline std::atomic<uint64_t> s_next_version{1};
     };
 
     /**
@@ -71,6 +108,27 @@ namespace lim_webserver
         }
     };
 
+    /**
+     * @brief 类型转换模板类偏特化(YAML String 转换成 bool)
+     *
+     * @note boost::lexical_cast 只接受0与1，这里同时接受YAML的true/false、yes/no、on/off
+     */
+    template <>
+    class LexicalCast<std::string, bool>
+    {
+    public:
+        bool operator()(const std::string &source)
+        {
+            YAML::Node node = YAML::Load(source);
+            bool value;
+            if (YAML::convert<bool>::decode(node, value))
+            {
+                return value;
+            }
+            return boost::lexical_cast<bool>(source);
+        }
+    };
+
     /**
      * @brief 类型转换模板类偏特化(YAML String 转换成 std::vector<T>)
      */
@@ -269,6 +327,7 @@ namespace lim_webserver
         using ptr = std::shared_ptr<ConfigerVar>;
         using RWMutexType = RWMutex;
         using onChangeCallBack = std::function<void(const T &old_val, const T &new_val)>;
+        using Snapshot = std::shared_ptr<const T>;
         static ptr Create(const std::string &name, const T &default_val, const std::string &description = "")
         {
             return std::make_shared<ConfigerVar>(name, default_val, description);
@@ -282,37 +341,64 @@ namespace lim_webserver
          * @param description 参数的描述
          */
         ConfigerVar(const std::string &name, const T &default_val, const std::string &description = "")
-            : ConfigerVarBase(name, description), m_val(default_val) {}
+            : ConfigerVarBase(name, description), m_snapshot(std::make_shared<const T>(default_val)), m_version(NextVersion()) {}
 
         /**
          * @brief 获取当前参数的值
+         * @details 值以不可变快照发布，写者替换整个快照(RCU)。读者不加锁：
+         *          每个线程缓存一份值副本，版本号未变时直接从副本拷贝，
+         *          只有配置变更后的第一次读取才会重新加载快照。
+         *          返回值归调用者所有，可以跨越协程切换与线程迁移持有。
+         * @note 返回值的拷贝，容器类型的热路径请使用getSnapshot
          */
-        T getValue()
+        T get() const
         {
-            RWMutexType::ReadLock lock(m_mutex);
-            return m_val;
+            LocalCopy &local = localCopy();
+            uint64_t version = m_version.load(std::memory_order_acquire);
+            if (local.version != version)
+            {
+                Snapshot snapshot = std::atomic_load_explicit(&m_snapshot, std::memory_order_acquire);
+                if (local.value)
+                {
+                    *std::static_pointer_cast<T>(local.value) = *snapshot;
+                }
+                else
+                {
+                    local.value = std::make_shared<T>(*snapshot);
+                }
+                local.version = version;
+            }
+            return *std::static_pointer_cast<T>(local.value);
         }
 
+        /**
+         * @brief 获取当前参数的快照，不拷贝值，可长期持有，不受后续配置变更影响
+         */
+        Snapshot getSnapshot() const { return std::atomic_load_explicit(&m_snapshot, std::memory_order_acquire); }
+
+        /**
+         * @brief 获取当前参数的值，同get
+         */
+        T getValue() const { return get(); }
+
         /**
          * @brief 设置当前参数的值
-         * @details 如果参数的值有发生变化,则通知对应的注册回调函数
+         * @details 如果参数的值有发生变化,先通知对应的注册回调函数,再发布新的快照
          */
         void setValue(const T v)
         {
+            RWMutexType::WriteLock lock(m_mutex);
+            Snapshot old_val = std::atomic_load_explicit(&m_snapshot, std::memory_order_acquire);
+            if (v == *old_val)
             {
-                RWMutexType::ReadLock lock(m_mutex);
-                if (v == m_val)
-                {
-                    return;
-                }
-                for (auto &i : m_callback_map)
-                {
-
-                    i.second(m_val, v);
-                }
+                return;
             }
-            RWMutexType::WriteLock lock(m_mutex);
-            m_val = v;
+            for (auto &i : m_callback_map)
+            {
+                i.second(*old_val, v);
+            }
+            std::atomic_store_explicit(&m_snapshot, Snapshot(std::make_shared<const T>(std::move(v))), std::memory_order_release);
+            m_version.store(NextVersion(), std::memory_order_release);
         }
 
         /**
@@ -392,9 +478,10 @@ namespace lim_webserver
         }
 
     private:
-        T m_val;
+        Snapshot m_snapshot;                                           // 当前值的快照，通过atomic_load/atomic_store访问
+        std::atomic<uint64_t> m_version;                               // 快照版本号，发布快照后更新
         std::unordered_map<uint64_t, onChangeCallBack> m_callback_map; // 变更回调函数
-        RWMutexType m_mutex;
+        RWMutexType m_mutex;                                           // 保护回调函数并串行化写者
     };
 
     /**
@@ -1,104 +1,108 @@
+#pragma once
+
 #include <atomic>
 
 namespace lim_webserver
 {
-
+    /**
+     * @brief 多生产者单消费者无锁队列
+     *
+     * @details 带哨兵节点的链表：生产者交换尾指针后再把前驱链接到新节点，消费者只读写头指针，
+     *          两端互不竞争。生产者交换尾指针与链接前驱之间的瞬间，消费者会暂时看不到该元素，
+     *          但元素不会丢失，入队完成后即可取出。
+     *          enqueue可在任意线程调用；dequeue、concatenate、empty只能由唯一的消费者线程调用。
+     */
     template <typename T> class LFQueue
     {
     public:
-        LFQueue() {}
+        LFQueue()
+        {
+            Node *stub = new Node();
+            m_head = stub;
+            m_tail.store(stub, std::memory_order_relaxed);
+        }
 
         ~LFQueue()
         {
-            Node *current = head_.load();
+            Node *current = m_head;
             while (current)
             {
                 Node *to_delete = current;
-                current = current->next_;
+                current = current->next_.load(std::memory_order_relaxed);
                 delete to_delete;
             }
         }
 
         void enqueue(const T &value)
         {
-            Node *new_node = new Node(value);
-            Node *old_tail = tail_.exchange(new_node, std::memory_order_acq_rel);
-            if (old_tail)
-            {
-                old_tail->next_ = new_node;
-            }
-            else
-            {
-                head_.store(new_node);
-            }
+            Node *node = new Node();
+            node->data_ = value;
+            push(node);
         }
 
         bool dequeue(T &value)
         {
-            Node *old_head = head_.load(std::memory_order_relaxed);
-            while (old_head && !head_.compare_exchange_weak(old_head, old_head->next_, std::memory_order_acquire, std::memory_order_relaxed))
+            Node *node = pop();
+            if (!node)
             {
-                // CAS失败时，继续尝试
-            }
-            if (old_head)
-            {
-                value = old_head->data_;
-                if (!old_head->next_)
-                {
-                    tail_.exchange(nullptr);
-                }
-                delete old_head;
-
-                return true;
+                return false;
             }
-            tail_.exchange(nullptr);
-            return false;
+            value = node->data_;
+            delete node;
+            return true;
         }
 
+        /**
+         * @brief 把other中当前可见的元素全部移到本队列尾部，节点直接转移不重新分配
+         *
+         * @details 调用线程须同时是other的消费者；本队列此时不能有其他生产者
+         */
         bool concatenate(LFQueue<T> &other)
         {
-            Node *otherHead = other.head_.exchange(nullptr, std::memory_order_acq_rel);
-
-            if (otherHead != nullptr)
-            {
-                Node *prevTail = tail_.exchange(otherHead, std::memory_order_acq_rel);
-
-                // 有尾则接上
-                if (prevTail != nullptr)
-                {
-                    prevTail->next_ = otherHead;
-                }
-                else // 无尾则为新的
-                {
-                    head_.store(otherHead, std::memory_order_release);
-                }
-
-                // Update tail to the tail of the other queue
-                tail_.store(other.tail_.exchange(nullptr, std::memory_order_acquire), std::memory_order_release);
-                return true;
-            }
-            else
+            bool moved = false;
+            while (Node *node = other.pop())
             {
-                return false;
+                push(node);
+                moved = true;
             }
+            return moved;
         }
 
-        bool empty()
-        {
-            return head_==nullptr;
-        }
+        bool empty() const { return m_head->next_.load(std::memory_order_acquire) == nullptr; }
 
     private:
         struct Node
         {
-            T data_;
-            Node *next_ = nullptr;
-
-            Node(const T &data) : data_(data) {}
+            T data_{};
+            std::atomic<Node *> next_{nullptr};
         };
 
-        std::atomic<Node *> head_{nullptr};
-        std::atomic<Node *> tail_{nullptr};
+        void push(Node *node)
+        {
+            node->next_.store(nullptr, std::memory_order_relaxed);
+            Node *prev = m_tail.exchange(node, std::memory_order_acq_rel);
+            prev->next_.store(node, std::memory_order_release);
+        }
+
+        /**
+         * @brief 取出队首元素，返回的节点携带该元素，原哨兵由下一个节点接任
+         */
+        Node *pop()
+        {
+            Node *head = m_head;
+            Node *next = head->next_.load(std::memory_order_acquire);
+            if (!next)
+            {
+                return nullptr;
+            }
+            head->data_ = next->data_;
+            m_head = next;
+            return head;
+        }
+
+    private:
+        Node *m_head;                // 哨兵节点，只由消费者访问
+        std::atomic<Node *> m_tail;  // 最后入队的节点
     };
 
-} // namespace lim_webserver
\ No newline at end of file
+} // namespace lim_webserver
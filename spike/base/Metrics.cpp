@@ -0,0 +1,271 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <stdio.h>
+
+namespace lim_webserver
+{
+    static std::atomic<size_t> s_metric_slot{0};
+
+    size_t NextMetricSlot() { return s_metric_slot.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief 输出一行样本，labels与extra都可为空
+     */
+    static void AppendSample(std::string &out, const std::string &name, const std::string &labels, const std::string &extra, double value)
+    {
+        out += name;
+        if (!labels.empty() || !extra.empty())
+        {
+            out += '{';
+            out += labels;
+            if (!labels.empty() && !extra.empty())
+            {
+                out += ',';
+            }
+            out += extra;
+            out += '}';
+        }
+        char buf[32];
+        snprintf(buf, sizeof(buf), " %.10g\n", value);
+        out += buf;
+    }
+
+    uint64_t MetricCounter::value() const
+    {
+        uint64_t total = 0;
+        for (const Cell &cell : m_cells)
+        {
+            total += cell.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void MetricCounter::render(std::string &out, const std::string &name, const std::string &labels) const
+    {
+        AppendSample(out, name, labels, "", value() * m_scale);
+    }
+
+    int64_t MetricGauge::value() const
+    {
+        if (m_func)
+        {
+            return m_func();
+        }
+        int64_t total = 0;
+        for (const Cell &cell : m_cells)
+        {
+            total += cell.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void MetricGauge::render(std::string &out, const std::string &name, const std::string &labels) const
+    {
+        AppendSample(out, name, labels, "", value());
+    }
+
+    uint64_t MetricHistogram::BucketMax(size_t idx)
+    {
+        if (idx < LINEAR)
+        {
+            return idx;
+        }
+        if (idx >= BUCKETS - 1)
+        {
+            return UINT64_MAX;
+        }
+        size_t exp = ((idx - LINEAR) >> SUB_BITS) + 4;
+        uint64_t sub = (idx - LINEAR) & ((1 << SUB_BITS) - 1);
+        uint64_t width = 1ul << (exp - SUB_BITS);
+        return (((1ul << SUB_BITS) + sub) << (exp - SUB_BITS)) + width - 1;
+    }
+
+    uint64_t MetricHistogram::snapshot(std::vector<uint64_t> &buckets, uint64_t &sum) const
+    {
+        buckets.assign(BUCKETS, 0);
+        sum = 0;
+        uint64_t count = 0;
+        for (const Shard &shard : m_shards)
+        {
+            for (size_t i = 0; i < BUCKETS; ++i)
+            {
+                uint64_t n = shard.buckets[i].load(std::memory_order_relaxed);
+                buckets[i] += n;
+                count += n;
+            }
+            sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    uint64_t MetricHistogram::count() const
+    {
+        std::vector<uint64_t> buckets;
+        uint64_t sum;
+        return snapshot(buckets, sum);
+    }
+
+    uint64_t MetricHistogram::quantile(double q) const
+    {
+        std::vector<uint64_t> buckets;
+        uint64_t sum;
+        uint64_t count = snapshot(buckets, sum);
+        if (count == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * count + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                return BucketMax(i);
+            }
+        }
+        return BucketMax(BUCKETS - 1);
+    }
+
+    void MetricHistogram::render(std::string &out, const std::string &name, const std::string &labels) const
+    {
+        std::vector<uint64_t> buckets;
+        uint64_t sum;
+        uint64_t count = snapshot(buckets, sum);
+
+        // 桶内最大值不超过边界的桶计入该边界，跨边界的桶计入下一个边界
+        size_t idx = 0;
+        uint64_t cumulative = 0;
+        char le[48];
+        for (double bound : m_bounds)
+        {
+            while (idx < BUCKETS && BucketMax(idx) * m_scale <= bound)
+            {
+                cumulative += buckets[idx++];
+            }
+            snprintf(le, sizeof(le), "le=\"%.10g\"", bound);
+            AppendSample(out, name + "_bucket", labels, le, cumulative);
+        }
+        AppendSample(out, name + "_bucket", labels, "le=\"+Inf\"", count);
+        AppendSample(out, name + "_sum", labels, "", sum * m_scale);
+        AppendSample(out, name + "_count", labels, "", count);
+    }
+
+    MetricsRegistry *MetricsRegistry::GetInstance()
+    {
+        static MetricsRegistry *ins = new MetricsRegistry();
+        return ins;
+    }
+
+    MetricCounter *MetricsRegistry::counter(const std::string &name, const std::string &help, const MetricLabels &labels, double scale)
+    {
+        return static_cast<MetricCounter *>(lookup(name, help, MetricType::COUNTER, labels, [scale]() { return new MetricCounter(scale); }));
+    }
+
+    MetricGauge *MetricsRegistry::gauge(const std::string &name, const std::string &help, const MetricLabels &labels)
+    {
+        return static_cast<MetricGauge *>(lookup(name, help, MetricType::GAUGE, labels, []() { return new MetricGauge(); }));
+    }
+
+    MetricGauge *MetricsRegistry::gauge(const std::string &name, const std::string &help, const MetricLabels &labels, std::function<int64_t()> func)
+    {
+        MetricGauge *gauge = static_cast<MetricGauge *>(lookup(name, help, MetricType::GAUGE, labels, [func]() { return new MetricGauge(func); }));
+        MutexType::Lock lock(m_mutex);
+        gauge->setFunc(func);
+        return gauge;
+    }
+
+    MetricHistogram *MetricsRegistry::histogram(const std::string &name, const std::string &help, const MetricLabels &labels, double scale,
+                                                const std::vector<double> &bounds)
+    {
+        return static_cast<MetricHistogram *>(
+            lookup(name, help, MetricType::HISTOGRAM, labels, [scale, &bounds]() { return new MetricHistogram(scale, bounds); }));
+    }
+
+    std::string MetricsRegistry::toPrometheus()
+    {
+        static const char *TYPE_NAMES[] = {"counter", "gauge", "histogram"};
+        std::string out;
+        MutexType::Lock lock(m_mutex);
+        for (auto &family : m_families)
+        {
+            out += "# HELP " + family.first + " " + family.second.help + "\n";
+            out += "# TYPE " + family.first + " " + TYPE_NAMES[(int)family.second.type] + "\n";
+            for (auto &series : family.second.series)
+            {
+                series.second->render(out, family.first, series.first);
+            }
+        }
+        return out;
+    }
+
+    const std::vector<double> &MetricsRegistry::LatencyBounds()
+    {
+        static const std::vector<double> bounds = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                                                   0.05,   0.1,     0.25,   0.5,   1,      2.5,   5,     10};
+        return bounds;
+    }
+
+    const std::vector<double> &MetricsRegistry::CountBounds()
+    {
+        static const std::vector<double> bounds = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+        return bounds;
+    }
+
+    Metric *MetricsRegistry::lookup(const std::string &name, const std::string &help, MetricType type, const MetricLabels &labels,
+                                    const std::function<Metric *()> &create)
+    {
+        std::string key = FormatLabels(labels);
+        MutexType::Lock lock(m_mutex);
+        auto it = m_families.find(name);
+        if (it == m_families.end())
+        {
+            it = m_families.emplace(name, Family{help, type, {}}).first;
+        }
+        else if (it->second.type != type)
+        {
+            throw std::logic_error("metric " + name + " registered with another type");
+        }
+        std::unique_ptr<Metric> &metric = it->second.series[key];
+        if (!metric)
+        {
+            metric.reset(create());
+        }
+        return metric.get();
+    }
+
+    std::string MetricsRegistry::FormatLabels(const MetricLabels &labels)
+    {
+        std::string out;
+        for (auto &label : labels)
+        {
+            if (!out.empty())
+            {
+                out += ',';
+            }
+            out += label.first + "=\"";
+            for (char c : label.second)
+            {
+                switch (c)
+                {
+                case '\\':
+                    out += "\\\\";
+                    break;
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\n':
+                    out += "\\n";
+                    break;
+                default:
+                    out += c;
+                }
+            }
+            out += '"';
+        }
+        return out;
+    }
+
+} // namespace lim_webserver
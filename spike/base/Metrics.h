@@ -0,0 +1,276 @@
+#pragma once
+
+#include "base/Mutex.h"
+#include "base/Noncopyable.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <time.h>
+#include <utility>
+#include <vector>
+
+namespace lim_webserver
+{
+    /**
+     * @brief 指标标签，按给定顺序输出
+     */
+    using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+    /**
+     * @brief 当前线程写入的分片下标，线程首次写指标时按顺序分配
+     */
+    size_t NextMetricSlot();
+
+    inline size_t MetricSlot()
+    {
+        static thread_local size_t slot = NextMetricSlot();
+        return slot;
+    }
+
+    /**
+     * @brief 单调时钟，单位：纳秒，供各模块计算耗时
+     */
+    inline uint64_t MetricNowNS()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000ul + ts.tv_nsec;
+    }
+
+    /**
+     * @brief 指标基类，只在注册与输出时用到虚函数，写入路径不经过虚调用
+     */
+    class Metric : public Noncopyable
+    {
+    public:
+        virtual ~Metric() {}
+
+        /**
+         * @brief 按Prometheus文本格式输出该序列
+         *
+         * @param out    输出
+         * @param name   指标名
+         * @param labels 已格式化的标签，不含花括号，可为空
+         */
+        virtual void render(std::string &out, const std::string &name, const std::string &labels) const = 0;
+    };
+
+    /**
+     * @brief 单调递增计数器
+     *
+     * @details 每个线程写自己的分片(独占缓存行)，inc只有一次无竞争的原子加，读取时汇总全部分片。
+     *          线程数多于分片数时会有线程共用分片，结果仍然正确，只是多了缓存行争用。
+     */
+    class MetricCounter : public Metric
+    {
+    public:
+        static const size_t SHARDS = 32;
+
+        explicit MetricCounter(double scale = 1) : m_scale(scale) {}
+
+        inline void inc(uint64_t n = 1) { m_cells[MetricSlot() % SHARDS].value.fetch_add(n, std::memory_order_relaxed); }
+
+        uint64_t value() const;
+
+        void render(std::string &out, const std::string &name, const std::string &labels) const override;
+
+    private:
+        struct alignas(64) Cell
+        {
+            std::atomic<uint64_t> value{0};
+        };
+        Cell m_cells[SHARDS];
+        double m_scale; // 输出时乘上的系数，用于把记录单位换算为基本单位
+    };
+
+    /**
+     * @brief 可增可减的瞬时值，设置了取值函数时输出取值函数的结果
+     *
+     * @details 取值函数在输出时调用，它引用的对象需长于注册表存活
+     */
+    class MetricGauge : public Metric
+    {
+    public:
+        static const size_t SHARDS = 32;
+
+        MetricGauge() {}
+        explicit MetricGauge(std::function<int64_t()> func) : m_func(func) {}
+
+        inline void add(int64_t n) { m_cells[MetricSlot() % SHARDS].value.fetch_add(n, std::memory_order_relaxed); }
+
+        inline void sub(int64_t n) { add(-n); }
+
+        int64_t value() const;
+
+        /**
+         * @brief 替换取值函数，只在注册表的锁内调用
+         */
+        inline void setFunc(std::function<int64_t()> func) { m_func = func; }
+
+        void render(std::string &out, const std::string &name, const std::string &labels) const override;
+
+    private:
+        struct alignas(64) Cell
+        {
+            std::atomic<int64_t> value{0};
+        };
+        Cell m_cells[SHARDS];
+        std::function<int64_t()> m_func;
+    };
+
+    /**
+     * @brief HDR风格的对数-线性直方图
+     *
+     * @details 小于16的值各占一个桶，之后每个2的幂区间再均分为8个桶，相对误差不超过12.5%，
+     *          只覆盖到2^44，更大的值计入最后一个桶。record只有求桶下标的几条位运算和两次原子加，
+     *          各线程写自己的分片，读取时汇总。输出时按注册给定的边界折算成Prometheus的累积桶。
+     */
+    class MetricHistogram : public Metric
+    {
+    public:
+        static const size_t SHARDS = 8;
+        static const size_t SUB_BITS = 3;
+        static const size_t LINEAR = 16;
+        static const size_t MAX_EXP = 44;
+        static const size_t BUCKETS = LINEAR + (MAX_EXP - 4) * (1 << SUB_BITS);
+
+        /**
+         * @param scale  输出时把记录单位换算为基本单位的系数，例如记录微秒时为1e-6
+         * @param bounds 输出的累积桶上界，单位为换算后的基本单位，升序
+         */
+        MetricHistogram(double scale, const std::vector<double> &bounds) : m_scale(scale), m_bounds(bounds) {}
+
+        inline void record(uint64_t value)
+        {
+            Shard &shard = m_shards[MetricSlot() % SHARDS];
+            shard.buckets[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+            shard.sum.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 汇总全部分片
+         *
+         * @param buckets 各桶的计数
+         * @param sum     记录值之和
+         * @return uint64_t 记录次数
+         */
+        uint64_t snapshot(std::vector<uint64_t> &buckets, uint64_t &sum) const;
+
+        uint64_t count() const;
+
+        /**
+         * @brief 分位数，返回所在桶的上界(记录单位)
+         *
+         * @param q 0到1之间
+         */
+        uint64_t quantile(double q) const;
+
+        void render(std::string &out, const std::string &name, const std::string &labels) const override;
+
+        static inline size_t BucketOf(uint64_t value)
+        {
+            if (value < LINEAR)
+            {
+                return value;
+            }
+            size_t exp = 63 - __builtin_clzll(value);
+            if (exp >= MAX_EXP)
+            {
+                return BUCKETS - 1;
+            }
+            size_t sub = (value >> (exp - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+            return LINEAR + ((exp - 4) << SUB_BITS) + sub;
+        }
+
+        /**
+         * @brief 桶内最大的值
+         */
+        static uint64_t BucketMax(size_t idx);
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<uint64_t> buckets[BUCKETS] = {};
+            std::atomic<uint64_t> sum{0};
+        };
+        Shard m_shards[SHARDS];
+        double m_scale;
+        std::vector<double> m_bounds;
+    };
+
+    /**
+     * @brief 指标注册表
+     *
+     * @details 以指标名加标签区分序列，重复注册返回同一对象，对象在进程内不释放，可长期持有裸指针。
+     *          注册在锁内完成，调用方应在初始化时取得指针，写入路径不查表。
+     */
+    class MetricsRegistry : Noncopyable
+    {
+    public:
+        using MutexType = Mutex;
+
+        /**
+         * @brief 进程退出时不析构，处理器等后台线程在静态析构期间仍可能写入指标
+         */
+        static MetricsRegistry *GetInstance();
+
+        MetricCounter *counter(const std::string &name, const std::string &help, const MetricLabels &labels = {}, double scale = 1);
+
+        MetricGauge *gauge(const std::string &name, const std::string &help, const MetricLabels &labels = {});
+
+        /**
+         * @brief 注册输出时求值的瞬时值，同名同标签重复注册时替换取值函数
+         */
+        MetricGauge *gauge(const std::string &name, const std::string &help, const MetricLabels &labels, std::function<int64_t()> func);
+
+        MetricHistogram *histogram(const std::string &name, const std::string &help, const MetricLabels &labels, double scale,
+                                   const std::vector<double> &bounds);
+
+        /**
+         * @brief 按指标名与标签排序输出Prometheus文本格式
+         */
+        std::string toPrometheus();
+
+        /**
+         * @brief 延迟类直方图的默认边界，单位：秒
+         */
+        static const std::vector<double> &LatencyBounds();
+
+        /**
+         * @brief 数量类直方图的默认边界，1到1024按2倍递增
+         */
+        static const std::vector<double> &CountBounds();
+
+    private:
+        enum class MetricType
+        {
+            COUNTER,
+            GAUGE,
+            HISTOGRAM
+        };
+
+        struct Family
+        {
+            std::string help;
+            MetricType type;
+            std::map<std::string, std::unique_ptr<Metric>> series; // 已格式化的标签 -> 序列
+        };
+
+        /**
+         * @brief 取得同名同标签的序列，不存在时调用create创建
+         */
+        Metric *lookup(const std::string &name, const std::string &help, MetricType type, const MetricLabels &labels,
+                       const std::function<Metric *()> &create);
+
+        static std::string FormatLabels(const MetricLabels &labels);
+
+    private:
+        std::map<std::string, Family> m_families;
+        MutexType m_mutex;
+    };
+
+} // namespace lim_webserver
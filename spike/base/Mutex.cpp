@@ -0,0 +1,66 @@
+#include "Mutex.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lim_webserver
+{
+    static inline void CpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+
+    static const int SPIN_ROUNDS = 16;  // 自旋轮数
+    static const int MAX_BACKOFF = 64; // 单轮最多pause次数
+
+    /**
+     * @brief 单核机器上持有者不可能同时运行，自旋没有意义
+     */
+    static bool ShouldSpin()
+    {
+        static const bool s_spin = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+        return s_spin;
+    }
+
+    void Spinlock::lockSlow()
+    {
+        if (ShouldSpin())
+        {
+            int backoff = 1;
+            for (int round = 0; round < SPIN_ROUNDS; ++round)
+            {
+                // 只读等待，锁空闲时再尝试抢占
+                if (m_state.load(std::memory_order_relaxed) == UNLOCKED)
+                {
+                    uint32_t expected = UNLOCKED;
+                    if (m_state.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+                    {
+                        return;
+                    }
+                }
+                for (int i = 0; i < backoff; ++i)
+                {
+                    CpuRelax();
+                }
+                backoff = backoff < MAX_BACKOFF ? backoff * 2 : MAX_BACKOFF;
+            }
+        }
+
+        // 标记为有等待者后睡眠，被唤醒时同样以CONTENDED抢占，保证解锁者会继续唤醒其余等待者
+        while (m_state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED)
+        {
+            syscall(SYS_futex, &m_state, FUTEX_WAIT_PRIVATE, CONTENDED, nullptr, nullptr, 0);
+        }
+    }
+
+    void Spinlock::wake()
+    {
+        syscall(SYS_futex, &m_state, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+
+} // namespace lim_webserver
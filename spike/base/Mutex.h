@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <pthread.h>
 #include <semaphore.h>
@@ -281,33 +282,67 @@ namespace lim_webserver
     };
 
     /**
-     * @brief 自旋锁
+     * @brief 自适应自旋锁
+     *
+     * @details TTAS实现：先只读等待锁空闲再CAS抢占，等待期间以pause指数退避，避免反复写同一缓存行。
+     *          自旋超过预算(或单核机器上)后转入futex睡眠，持有者被抢占时等待者不再空转。
+     *          锁本身只占4字节，不做缓存行对齐；多线程竞争的分片等数组元素由所在结构体自行按缓存行对齐。
      */
     class Spinlock : Noncopyable
     {
     public:
         using Lock = ScopedLock<Spinlock>;
 
+        Spinlock() {}
+        ~Spinlock() {}
+
         /**
-         * @brief 构造函数，初始化自旋锁
+         * @brief 加锁操作
          */
-        Spinlock() { pthread_spin_init(&m_mutex, 0); }
+        void lock()
+        {
+            uint32_t expected = UNLOCKED;
+            if (!m_state.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                lockSlow();
+            }
+        }
         /**
-         * @brief 析构函数，销毁自旋锁
+         * @brief 解锁操作，有睡眠的等待者时唤醒一个
          */
-        ~Spinlock() { pthread_spin_destroy(&m_mutex); }
+        void unlock()
+        {
+            if (m_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED)
+            {
+                wake();
+            }
+        }
+        /**
+         * @brief 尝试加锁，成功返回true，不会睡眠，可在信号处理中使用
+         */
+        bool trylock()
+        {
+            uint32_t expected = UNLOCKED;
+            return m_state.load(std::memory_order_relaxed) == UNLOCKED &&
+                   m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+        }
 
+    private:
         /**
-         * @brief 加锁操作
+         * @brief 竞争时的自旋与睡眠
          */
-        void lock() { pthread_spin_lock(&m_mutex); }
+        void lockSlow();
+
         /**
-         * @brief 解锁操作
+         * @brief 唤醒一个睡眠的等待者
          */
-        void unlock() { pthread_spin_unlock(&m_mutex); }
+        void wake();
 
-    private:
-        pthread_spinlock_t m_mutex; // 自旋锁
+        static const uint32_t UNLOCKED = 0;  // 空闲
+        static const uint32_t LOCKED = 1;    // 已加锁，无睡眠等待者
+        static const uint32_t CONTENDED = 2; // 已加锁，可能有睡眠等待者
+
+        std::atomic<uint32_t> m_state{UNLOCKED}; // 锁状态
     };
 
     class ConditionVariable : Noncopyable
@@ -0,0 +1,254 @@
+#include "Trace.h"
+#include "base/Configer.h"
+#include "base/Mutex.h"
+#include "base/Thread.h"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace lim_webserver
+{
+    static ConfigerVar<bool>::ptr g_trace_enable = Configer::Lookup("trace.enable", false, "record per request latency traces for new connections");
+
+    static ConfigerVar<uint32_t>::ptr g_trace_ring_size =
+        Configer::Lookup<uint32_t>("trace.ring_size", 256, "finished request traces kept per thread, allocated on first use");
+
+    static std::atomic<uint64_t> s_trace_id{0};
+
+    static thread_local RequestTrace *t_trace = nullptr;
+
+    /**
+     * @brief 标定基准，进程启动时记录一次TSC与单调时钟
+     */
+    struct TraceAnchor
+    {
+        uint64_t tsc = TraceNow();
+        uint64_t ns = MetricNowNS();
+    };
+    static TraceAnchor s_anchor;
+
+    /**
+     * @brief 每纳秒的打点时钟周期数，距基准不足10ms时先等到10ms，保证标定精度
+     */
+    static double TicksPerNS()
+    {
+#if defined(__x86_64__)
+        uint64_t ns = MetricNowNS();
+        uint64_t tsc = TraceNow();
+        while (ns - s_anchor.ns < 10000000)
+        {
+            ns = MetricNowNS();
+            tsc = TraceNow();
+        }
+        return (double)(tsc - s_anchor.tsc) / (ns - s_anchor.ns);
+#else
+        return 1;
+#endif
+    }
+
+    /**
+     * @brief 每个线程一个的环形缓冲区
+     *
+     * @details 只有所属线程写入，每个槽位用序号做seqlock：写前置为奇数，写完置为偶数，
+     *          导出线程复制后序号不变且为偶数才采用，写入路径没有锁
+     */
+    struct TraceRing
+    {
+        struct Slot
+        {
+            std::atomic<uint32_t> seq{0};
+            RequestTrace::Record record;
+        };
+
+        TraceRing(size_t n, pid_t t) : slots(new Slot[n]), size(n), tid(t) {}
+
+        std::unique_ptr<Slot[]> slots;
+        size_t size;
+        pid_t tid;
+        uint64_t next = 0; // 只由所属线程访问
+    };
+
+    // 环形缓冲区随线程创建，进程内不释放，导出时线程可能已经退出
+    static Mutex s_rings_mutex;
+    static std::vector<TraceRing *> s_rings;
+
+    static TraceRing *LocalRing()
+    {
+        static thread_local TraceRing *ring = nullptr;
+        if (!ring)
+        {
+            ring = new TraceRing(std::max<uint32_t>(g_trace_ring_size->get(), 1), Thread::GetThreadId());
+            Mutex::Lock lock(s_rings_mutex);
+            s_rings.push_back(ring);
+        }
+        return ring;
+    }
+
+    RequestTrace::RequestTrace() { m_record.id = ++s_trace_id; }
+
+    void RequestTrace::finish()
+    {
+        TraceRing *ring = LocalRing();
+        TraceRing::Slot &slot = ring->slots[ring->next++ % ring->size];
+        uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        // 只复制已记录的打点
+        slot.record.id = m_record.id;
+        slot.record.count = m_record.count;
+        slot.record.overflow = m_record.overflow;
+        memcpy(slot.record.events, m_record.events, m_record.count * sizeof(Event));
+        slot.seq.store(seq + 2, std::memory_order_release);
+
+        m_record.id = ++s_trace_id;
+        m_record.count = 0;
+        m_record.overflow = 0;
+        add(TracePoint::BEGIN);
+    }
+
+    RequestTrace *RequestTrace::Current() { return t_trace; }
+
+    void RequestTrace::SetCurrent(RequestTrace *trace) { t_trace = trace; }
+
+    bool RequestTrace::Enabled() { return g_trace_enable->get(); }
+
+    /**
+     * @brief 以结束的打点命名两次打点之间的区间，挂起之后的区间为IO等待
+     */
+    static const char *SpanName(TracePoint prev, TracePoint cur)
+    {
+        if (prev == TracePoint::PARK)
+        {
+            return "io_wait";
+        }
+        switch (cur)
+        {
+        case TracePoint::FIRST_RUN:
+            return "sched_delay";
+        case TracePoint::PARK:
+            return "run";
+        case TracePoint::PARSED:
+            return "parse";
+        case TracePoint::HANDLED:
+            return "handler";
+        case TracePoint::SENT:
+            return "send";
+        default:
+            return "run";
+        }
+    }
+
+    static const char *PointName(TracePoint point)
+    {
+        static const char *NAMES[] = {"accept", "begin", "first_run", "park", "wake", "parsed", "handled", "sent"};
+        return NAMES[(int)point];
+    }
+
+    std::string RequestTrace::ExportChrome(uint64_t min_us, size_t limit)
+    {
+        struct Finished
+        {
+            Record record;
+            pid_t tid;
+            size_t start; // 请求开始的打点下标
+            uint64_t duration;
+        };
+
+        std::vector<TraceRing *> rings;
+        {
+            Mutex::Lock lock(s_rings_mutex);
+            rings = s_rings;
+        }
+
+        double ticks_per_us = TicksPerNS() * 1000;
+        std::vector<Finished> found;
+        for (TraceRing *ring : rings)
+        {
+            for (size_t i = 0; i < ring->size; ++i)
+            {
+                TraceRing::Slot &slot = ring->slots[i];
+                uint32_t seq = slot.seq.load(std::memory_order_acquire);
+                if (seq == 0 || (seq & 1))
+                {
+                    continue;
+                }
+                Finished item;
+                item.record.id = slot.record.id;
+                item.record.count = std::min<uint32_t>(slot.record.count, MAX_EVENTS);
+                item.record.overflow = slot.record.overflow;
+                memcpy(item.record.events, slot.record.events, item.record.count * sizeof(Event));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.seq.load(std::memory_order_relaxed) != seq || item.record.count < 2)
+                {
+                    continue;
+                }
+                // 长连接上等待下一个请求的空闲时间不计入耗时，请求从数据到达时算起
+                const Event *events = item.record.events;
+                item.start = 0;
+                if (item.record.count > 3 && events[0].point == TracePoint::BEGIN && events[1].point == TracePoint::PARK &&
+                    events[2].point == TracePoint::WAKE)
+                {
+                    item.start = 2;
+                }
+                item.duration = (uint64_t)((events[item.record.count - 1].tsc - events[item.start].tsc) / ticks_per_us);
+                if (item.duration < min_us)
+                {
+                    continue;
+                }
+                item.tid = ring->tid;
+                found.push_back(item);
+            }
+        }
+        std::sort(found.begin(), found.end(), [](const Finished &a, const Finished &b) { return a.duration > b.duration; });
+        if (found.size() > limit)
+        {
+            found.resize(limit);
+        }
+
+        // 每个请求单独一行(tid取请求ID)，区间为X事件，打点为线程内的瞬时事件
+        std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        char buf[256];
+        bool first = true;
+        auto append = [&](int len)
+        {
+            if (!first)
+            {
+                out += ',';
+            }
+            first = false;
+            out.append(buf, std::min<int>(len, sizeof(buf) - 1));
+        };
+        auto ts = [&](uint64_t tsc) { return (double)(int64_t)(tsc - s_anchor.tsc) / ticks_per_us; };
+        for (const Finished &item : found)
+        {
+            const Record &record = item.record;
+            const Event *events = record.events;
+            uint64_t id = record.id;
+            append(snprintf(buf, sizeof(buf),
+                            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu64 ",\"args\":{\"name\":\"request %" PRIu64 " (thread %d)\"}}", id, id,
+                            (int)item.tid));
+            append(snprintf(buf, sizeof(buf),
+                            "{\"name\":\"request\",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"thread\":%d,\"dropped\":%u}}",
+                            id, ts(events[item.start].tsc), (double)item.duration, (int)item.tid, record.overflow));
+            for (size_t i = 0; i < record.count; ++i)
+            {
+                append(snprintf(buf, sizeof(buf), "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f,\"args\":{\"arg\":%d}}",
+                                PointName(events[i].point), id, ts(events[i].tsc), events[i].arg));
+                if (i == 0)
+                {
+                    continue;
+                }
+                const char *name = i <= item.start ? "keepalive_idle" : SpanName(events[i - 1].point, events[i].point);
+                append(snprintf(buf, sizeof(buf), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f,\"dur\":%.3f}", name, id,
+                                ts(events[i - 1].tsc), (double)(int64_t)(events[i].tsc - events[i - 1].tsc) / ticks_per_us));
+            }
+        }
+        out += "]}\n";
+        return out;
+    }
+
+} // namespace lim_webserver
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "base/Metrics.h"
+
+#include <stdint.h>
+#include <string>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace lim_webserver
+{
+    /**
+     * @brief 请求链路上的打点位置
+     */
+    enum class TracePoint : uint8_t
+    {
+        ACCEPT,    // 连接被accept
+        BEGIN,     // 长连接上开始等待下一个请求
+        FIRST_RUN, // 处理连接的任务首次被处理器运行
+        PARK,      // 因IO未就绪挂起
+        WAKE,      // IO就绪后恢复运行
+        PARSED,    // 请求解析完成
+        HANDLED,   // 处理函数返回
+        SENT       // 响应发送完成
+    };
+
+    /**
+     * @brief 打点时钟，x86_64上为TSC，其他平台为单调时钟的纳秒
+     *
+     * @details 读TSC只需十几个周期，导出时再按单调时钟标定换算，要求CPU支持不变TSC(constant_tsc)
+     */
+    inline uint64_t TraceNow()
+    {
+#if defined(__x86_64__)
+        return __rdtsc();
+#else
+        return MetricNowNS();
+#endif
+    }
+
+    /**
+     * @brief 单个请求的链路追踪
+     *
+     * @details 连接被accept时创建，随处理连接的任务调度，打点只写入对象内的定长数组，不加锁也不分配内存。
+     *          响应发送完成后finish把打点复制进本线程的环形缓冲区，同一连接上的下一个请求复用该对象。
+     *          环形缓冲区写满后覆盖最旧的记录，导出时按耗时筛选慢请求。
+     */
+    class RequestTrace
+    {
+    public:
+        static const size_t MAX_EVENTS = 32;
+
+        struct Event
+        {
+            uint64_t tsc;     // 打点时刻
+            TracePoint point; // 打点位置
+            int32_t arg;      // 附加参数，如句柄，-1为无
+        };
+
+        /**
+         * @brief 一个请求的打点记录，环形缓冲区中保存的即是它
+         */
+        struct Record
+        {
+            uint64_t id = 0;            // 请求ID
+            uint32_t count = 0;         // 已记录的打点数
+            uint32_t overflow = 0;      // 超出容量未记录的打点数
+            Event events[MAX_EVENTS];   // 打点
+        };
+
+        RequestTrace();
+
+        /**
+         * @brief 打点，超出MAX_EVENTS后只计数
+         */
+        inline void add(TracePoint point, int32_t arg = -1)
+        {
+            if (m_record.count < MAX_EVENTS)
+            {
+                m_record.events[m_record.count++] = {TraceNow(), point, arg};
+            }
+            else
+            {
+                ++m_record.overflow;
+            }
+        }
+
+        /**
+         * @brief 由处理器在每次切入任务前调用，只在首次运行时打点
+         */
+        inline void onRun()
+        {
+            if (!m_ran)
+            {
+                m_ran = true;
+                add(TracePoint::FIRST_RUN);
+            }
+        }
+
+        /**
+         * @brief 请求结束，写入本线程的环形缓冲区后重置，开始记录同一连接上的下一个请求
+         */
+        void finish();
+
+        inline uint64_t id() const { return m_record.id; }
+
+        /**
+         * @brief 当前线程正在运行的任务所带的追踪，不在被追踪的任务中时为nullptr
+         */
+        static RequestTrace *Current();
+
+        /**
+         * @brief 由处理器在切入与切出任务时设置
+         */
+        static void SetCurrent(RequestTrace *trace);
+
+        /**
+         * @brief 是否为新连接开启追踪，读取配置trace.enable
+         */
+        static bool Enabled();
+
+        /**
+         * @brief 以Chrome trace-event JSON格式导出各线程环形缓冲区中的慢请求，可在chrome://tracing或Perfetto中打开
+         *
+         * @param min_us 请求耗时下限，单位：微秒
+         * @param limit  最多导出的请求数，按耗时从大到小选取
+         */
+        static std::string ExportChrome(uint64_t min_us, size_t limit);
+
+    private:
+        Record m_record;    // 当前请求的打点
+        bool m_ran = false; // 任务是否已运行过
+    };
+
+} // namespace lim_webserver
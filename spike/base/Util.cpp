@@ -1,7 +1,11 @@
 #include "Util.h"
 
+#include <ctype.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <string.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
 
 namespace lim_webserver
 {
@@ -203,4 +207,68 @@ namespace lim_webserver
         setlocale(LC_ALL, str_locale.c_str());
         return wstr_result;
     }
+
+    std::string StringUtil::Base64Encode(const void *data, size_t len)
+    {
+        std::string out((len + 2) / 3 * 4, '\0');
+        int n = EVP_EncodeBlock((unsigned char *)&out[0], (const unsigned char *)data, (int)len);
+        out.resize(n);
+        return out;
+    }
+
+    bool StringUtil::Base64Decode(const std::string &str, std::string &out)
+    {
+        out.clear();
+        // EVP_DecodeBlock只认标准字母表且要求补齐到4的倍数，先把URL安全字符换回并补上填充
+        std::string in;
+        in.reserve(str.size() + 3);
+        for (char c : str)
+        {
+            if (c == '=')
+            {
+                break;
+            }
+            if (c == '-')
+            {
+                c = '+';
+            }
+            else if (c == '_')
+            {
+                c = '/';
+            }
+            else if (!isalnum((unsigned char)c) && c != '+' && c != '/')
+            {
+                return false;
+            }
+            in += c;
+        }
+        if (in.size() % 4 == 1)
+        {
+            // 多出的6位凑不成一个字节
+            in.pop_back();
+        }
+        size_t pad = (4 - in.size() % 4) % 4;
+        in.append(pad, '=');
+        if (in.empty())
+        {
+            return true;
+        }
+        out.resize(in.size() / 4 * 3);
+        int n = EVP_DecodeBlock((unsigned char *)&out[0], (const unsigned char *)in.data(), (int)in.size());
+        if (n < 0)
+        {
+            out.clear();
+            return false;
+        }
+        // EVP_DecodeBlock把填充也算作0字节输出
+        out.resize(n - pad);
+        return true;
+    }
+
+    std::string StringUtil::Sha1(const std::string &data)
+    {
+        unsigned char md[SHA_DIGEST_LENGTH];
+        SHA1((const unsigned char *)data.data(), data.size(), md);
+        return std::string((const char *)md, SHA_DIGEST_LENGTH);
+    }
 } // namespace lim_webserver
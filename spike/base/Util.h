@@ -21,6 +21,24 @@ namespace lim_webserver
 
         static std::string WStringToString(const std::wstring &ws);
         static std::wstring StringToWString(const std::string &s);
+
+        /**
+         * @brief 标准Base64编码(带填充)，基于OpenSSL EVP_EncodeBlock
+         */
+        static std::string Base64Encode(const void *data, size_t len);
+        static std::string Base64Encode(const std::string &data) { return Base64Encode(data.data(), data.size()); }
+
+        /**
+         * @brief Base64解码，同时接受标准与URL安全字母表，填充可省略
+         *
+         * @return false 含非法字符
+         */
+        static bool Base64Decode(const std::string &str, std::string &out);
+
+        /**
+         * @brief SHA-1摘要(OpenSSL SHA1)，返回20字节的原始摘要
+         */
+        static std::string Sha1(const std::string &data);
     };
 
 } // namespace lim_webserver
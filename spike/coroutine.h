@@ -1,3 +1,5 @@
+#include "coroutine/Channel.h"
+#include "coroutine/CoSync.h"
 #include "coroutine/Syntex.h"
 #include "coroutine/Timer.h"
 
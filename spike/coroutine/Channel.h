@@ -0,0 +1,152 @@
+#pragma once
+
+#include "base/Noncopyable.h"
+#include "coroutine/CoSync.h"
+
+#include <memory>
+#include <vector>
+
+namespace lim_webserver
+{
+    /**
+     * @brief 有界通道，用于协程之间传递数据
+     *
+     * @details 满时send挂起发送方，空时recv挂起接收方，不阻塞工作线程。
+     *          缓冲区为预分配的环形数组，收发不产生分配，T需可默认构造与移动赋值。
+     *          close后send失败，recv取完剩余数据后失败。
+     */
+    template <class T>
+    class Channel : Noncopyable
+    {
+    public:
+        using ptr = std::shared_ptr<Channel>;
+
+        static ptr Create(size_t capacity = 1) { return std::make_shared<Channel>(capacity); }
+
+    public:
+        explicit Channel(size_t capacity = 1) : m_buffer(capacity > 0 ? capacity : 1) {}
+
+        /**
+         * @brief 发送数据，通道满时等待
+         *
+         * @return false 通道已关闭
+         */
+        bool send(T value)
+        {
+            CoMutex::Lock lock(m_mutex);
+            m_notFull.wait(m_mutex, [this]()
+                           { return m_closed || m_size < m_buffer.size(); });
+            if (m_closed)
+            {
+                return false;
+            }
+            push(std::move(value));
+            lock.unlock();
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief 尝试发送数据，通道满或已关闭时返回false
+         */
+        bool trySend(T value)
+        {
+            CoMutex::Lock lock(m_mutex);
+            if (m_closed || m_size == m_buffer.size())
+            {
+                return false;
+            }
+            push(std::move(value));
+            lock.unlock();
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief 接收数据，通道空时等待
+         *
+         * @return false 通道已关闭且没有剩余数据
+         */
+        bool recv(T &value)
+        {
+            CoMutex::Lock lock(m_mutex);
+            m_notEmpty.wait(m_mutex, [this]()
+                            { return m_closed || m_size > 0; });
+            if (m_size == 0)
+            {
+                return false;
+            }
+            pop(value);
+            lock.unlock();
+            m_notFull.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief 尝试接收数据，通道空时返回false
+         */
+        bool tryRecv(T &value)
+        {
+            CoMutex::Lock lock(m_mutex);
+            if (m_size == 0)
+            {
+                return false;
+            }
+            pop(value);
+            lock.unlock();
+            m_notFull.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief 关闭通道并唤醒所有等待者
+         */
+        void close()
+        {
+            {
+                CoMutex::Lock lock(m_mutex);
+                m_closed = true;
+            }
+            m_notEmpty.notify_all();
+            m_notFull.notify_all();
+        }
+
+        bool isClosed()
+        {
+            CoMutex::Lock lock(m_mutex);
+            return m_closed;
+        }
+
+        size_t size()
+        {
+            CoMutex::Lock lock(m_mutex);
+            return m_size;
+        }
+
+        inline size_t capacity() const { return m_buffer.size(); }
+
+    private:
+        void push(T &&value)
+        {
+            m_buffer[(m_head + m_size) % m_buffer.size()] = std::move(value);
+            ++m_size;
+        }
+
+        void pop(T &value)
+        {
+            value = std::move(m_buffer[m_head]);
+            m_head = (m_head + 1) % m_buffer.size();
+            --m_size;
+        }
+
+    private:
+        CoMutex m_mutex;         // 保护缓冲区
+        CoCondVar m_notEmpty;    // 等待数据的接收方
+        CoCondVar m_notFull;     // 等待空位的发送方
+        std::vector<T> m_buffer; // 环形缓冲区
+        size_t m_head = 0;       // 队首下标
+        size_t m_size = 0;       // 数据个数
+        bool m_closed = false;   // 是否已关闭
+    };
+
+} // namespace lim_webserver
@@ -0,0 +1,213 @@
+#include "CoSync.h"
+
+#include "coroutine/Processor.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lim_webserver
+{
+    void CoWaitQueue::push(Waiter *waiter)
+    {
+        waiter->next = nullptr;
+        if (m_tail)
+        {
+            m_tail->next = waiter;
+        }
+        else
+        {
+            m_head = waiter;
+        }
+        m_tail = waiter;
+    }
+
+    CoWaitQueue::Waiter *CoWaitQueue::pop()
+    {
+        Waiter *waiter = m_head;
+        if (waiter)
+        {
+            m_head = waiter->next;
+            if (!m_head)
+            {
+                m_tail = nullptr;
+            }
+        }
+        return waiter;
+    }
+
+    CoWaitQueue::Waiter *CoWaitQueue::popAll()
+    {
+        Waiter *waiter = m_head;
+        m_head = m_tail = nullptr;
+        return waiter;
+    }
+
+    void CoWaitQueue::Park(Waiter &waiter)
+    {
+        if (waiter.task)
+        {
+            // 唤醒可能早于挂起发生，此时Task已在Processor的队列中，切出后会被重新调度
+            waiter.task->setWaitReason("cosync");
+            Processor::CoHold();
+            return;
+        }
+        while (waiter.signaled.load(std::memory_order_acquire) == 0)
+        {
+            syscall(SYS_futex, &waiter.signaled, FUTEX_WAIT_PRIVATE, 0, nullptr, nullptr, 0);
+        }
+    }
+
+    void CoWaitQueue::Unpark(Waiter *waiter)
+    {
+        if (waiter->task)
+        {
+            waiter->task->wake();
+            return;
+        }
+        // 置位后等待者可能立即返回，之后的唤醒只作用于一个地址，不再访问waiter
+        std::atomic<uint32_t> *signaled = &waiter->signaled;
+        signaled->store(1, std::memory_order_release);
+        syscall(SYS_futex, signaled, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+
+    void CoMutex::lockSlow()
+    {
+        CoWaitQueue::Waiter waiter;
+        waiter.task = Processor::GetCurrentTask();
+        {
+            Spinlock::Lock lock(m_waitLock);
+            uint32_t state = m_state.load(std::memory_order_relaxed);
+            while (true)
+            {
+                // 持有等待队列锁时锁已释放，说明没有等待者，直接获取
+                if (state == UNLOCKED)
+                {
+                    if (m_state.compare_exchange_weak(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+                    {
+                        return;
+                    }
+                    continue;
+                }
+                // 标记有等待者，使持有者解锁时走交接流程
+                if (state == CONTENDED || m_state.compare_exchange_weak(state, CONTENDED, std::memory_order_relaxed, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            m_waiters.push(&waiter);
+        }
+        // 被唤醒时锁已交给当前等待者
+        CoWaitQueue::Park(waiter);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+
+    void CoMutex::unlockSlow()
+    {
+        CoWaitQueue::Waiter *waiter;
+        {
+            Spinlock::Lock lock(m_waitLock);
+            waiter = m_waiters.pop();
+            if (!waiter)
+            {
+                m_state.store(UNLOCKED, std::memory_order_release);
+                return;
+            }
+            // 锁不释放，直接交给队首的等待者
+            m_state.store(m_waiters.empty() ? LOCKED : CONTENDED, std::memory_order_release);
+        }
+        CoWaitQueue::Unpark(waiter);
+    }
+
+    void CoCondVar::wait(CoMutex &mutex)
+    {
+        CoWaitQueue::Waiter waiter;
+        waiter.task = Processor::GetCurrentTask();
+        {
+            Spinlock::Lock lock(m_waitLock);
+            m_waiters.push(&waiter);
+        }
+        mutex.unlock();
+        CoWaitQueue::Park(waiter);
+        mutex.lock();
+    }
+
+    void CoCondVar::notify_one()
+    {
+        CoWaitQueue::Waiter *waiter;
+        {
+            Spinlock::Lock lock(m_waitLock);
+            waiter = m_waiters.pop();
+        }
+        if (waiter)
+        {
+            CoWaitQueue::Unpark(waiter);
+        }
+    }
+
+    void CoCondVar::notify_all()
+    {
+        CoWaitQueue::Waiter *waiter;
+        {
+            Spinlock::Lock lock(m_waitLock);
+            waiter = m_waiters.popAll();
+        }
+        while (waiter)
+        {
+            // 唤醒后waiter可能失效，先取出下一个
+            CoWaitQueue::Waiter *next = waiter->next;
+            CoWaitQueue::Unpark(waiter);
+            waiter = next;
+        }
+    }
+
+    bool CoSemaphore::trywait()
+    {
+        uint32_t count = m_count.load(std::memory_order_relaxed);
+        while (count > 0)
+        {
+            if (m_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void CoSemaphore::wait()
+    {
+        if (trywait())
+        {
+            return;
+        }
+        CoWaitQueue::Waiter waiter;
+        waiter.task = Processor::GetCurrentTask();
+        {
+            Spinlock::Lock lock(m_waitLock);
+            if (trywait())
+            {
+                return;
+            }
+            m_waiters.push(&waiter);
+        }
+        // 被唤醒时计数已交给当前等待者
+        CoWaitQueue::Park(waiter);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+
+    void CoSemaphore::notify()
+    {
+        CoWaitQueue::Waiter *waiter;
+        {
+            Spinlock::Lock lock(m_waitLock);
+            waiter = m_waiters.pop();
+            if (!waiter)
+            {
+                m_count.fetch_add(1, std::memory_order_release);
+                return;
+            }
+        }
+        CoWaitQueue::Unpark(waiter);
+    }
+
+} // namespace lim_webserver
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "base/Mutex.h"
+#include "base/Noncopyable.h"
+#include "coroutine/Task.h"
+
+#include <atomic>
+#include <functional>
+
+namespace lim_webserver
+{
+    /**
+     * @brief 协程同步原语的等待队列
+     *
+     * @details 在协程中等待时挂起当前Task(Processor::CoHold)，由唤醒方通过Task::wake重新入队，
+     *          工作线程可以继续执行其他协程；不在协程中(普通线程)时退化为futex等待。
+     *          队列本身由调用方持有的自旋锁保护。
+     */
+    class CoWaitQueue : Noncopyable
+    {
+    public:
+        /**
+         * @brief 等待者，位于等待方的栈上
+         */
+        struct Waiter
+        {
+            Task *task = nullptr;               // 等待的协程，普通线程为空
+            std::atomic<uint32_t> signaled{0};  // 普通线程等待用的futex字
+            Waiter *next = nullptr;             // 队列中的下一个等待者
+        };
+
+    public:
+        inline bool empty() const { return m_head == nullptr; }
+
+        /**
+         * @brief 加入队尾
+         */
+        void push(Waiter *waiter);
+
+        /**
+         * @brief 取出队首，队列为空时返回nullptr
+         */
+        Waiter *pop();
+
+        /**
+         * @brief 取出全部等待者
+         */
+        Waiter *popAll();
+
+        /**
+         * @brief 挂起直到被Unpark，调用前须已释放保护队列的锁
+         */
+        static void Park(Waiter &waiter);
+
+        /**
+         * @brief 唤醒等待者，调用后waiter可能随时失效
+         */
+        static void Unpark(Waiter *waiter);
+
+    private:
+        Waiter *m_head = nullptr; // 队首
+        Waiter *m_tail = nullptr; // 队尾
+    };
+
+    /**
+     * @brief 协程互斥锁
+     *
+     * @details 无竞争时只有一次CAS；竞争时挂起当前协程，解锁时把锁直接交给队首的等待者。
+     */
+    class CoMutex : Noncopyable
+    {
+    public:
+        using Lock = ScopedLock<CoMutex>;
+
+        void lock()
+        {
+            uint32_t expected = UNLOCKED;
+            if (!m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                lockSlow();
+            }
+        }
+
+        void unlock()
+        {
+            uint32_t expected = LOCKED;
+            if (!m_state.compare_exchange_strong(expected, UNLOCKED, std::memory_order_release, std::memory_order_relaxed))
+            {
+                unlockSlow();
+            }
+        }
+
+        bool trylock()
+        {
+            uint32_t expected = UNLOCKED;
+            return m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+    private:
+        void lockSlow();
+        void unlockSlow();
+
+        static const uint32_t UNLOCKED = 0;  // 空闲
+        static const uint32_t LOCKED = 1;    // 已加锁，无等待者
+        static const uint32_t CONTENDED = 2; // 已加锁，有等待者
+
+        std::atomic<uint32_t> m_state{UNLOCKED}; // 锁状态
+        Spinlock m_waitLock;                     // 保护等待队列
+        CoWaitQueue m_waiters;                   // 等待队列
+    };
+
+    /**
+     * @brief 协程条件变量，配合CoMutex使用
+     */
+    class CoCondVar : Noncopyable
+    {
+    public:
+        /**
+         * @brief 释放mutex并挂起，被唤醒后重新加锁
+         */
+        void wait(CoMutex &mutex);
+
+        /**
+         * @brief 等待直到条件成立
+         */
+        void wait(CoMutex &mutex, const std::function<bool()> &condition)
+        {
+            while (!condition())
+            {
+                wait(mutex);
+            }
+        }
+
+        void notify_one();
+
+        void notify_all();
+
+    private:
+        Spinlock m_waitLock;   // 保护等待队列
+        CoWaitQueue m_waiters; // 等待队列
+    };
+
+    /**
+     * @brief 协程信号量
+     *
+     * @details 有余量时wait只做一次CAS；post时有等待者则把计数直接交给队首的等待者。
+     */
+    class CoSemaphore : Noncopyable
+    {
+    public:
+        explicit CoSemaphore(uint32_t count = 0) : m_count(count) {}
+
+        /**
+         * @brief 等待正在进行的notify退出临界区，wait返回后即可销毁
+         */
+        ~CoSemaphore() { Spinlock::Lock lock(m_waitLock); }
+
+        void wait();
+
+        bool trywait();
+
+        void notify();
+
+        inline uint32_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint32_t> m_count; // 剩余计数
+        Spinlock m_waitLock;           // 保护等待队列
+        CoWaitQueue m_waiters;         // 等待队列
+    };
+
+} // namespace lim_webserver
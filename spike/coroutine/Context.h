@@ -34,6 +34,23 @@ namespace lim_webserver
 
         inline void swapOut() { swapcontext(&m_context, &getTlsContext()); }
 
+#if defined(__x86_64__)
+        /**
+         * @brief 切出时保存的指令指针，只在上下文未运行时有意义
+         */
+        inline uintptr_t savedPC() const { return m_context.uc_mcontext.gregs[REG_RIP]; }
+
+        /**
+         * @brief 切出时保存的栈指针，只在上下文未运行时有意义
+         */
+        inline uintptr_t savedSP() const { return m_context.uc_mcontext.gregs[REG_RSP]; }
+#endif
+
+        /**
+         * @brief 栈的最高地址(栈底)
+         */
+        inline uintptr_t stackTop() const { return (uintptr_t)m_stack + m_stacksize; }
+
     private:
         void *m_stack = nullptr; // 栈
         ucontext_t m_context;    // 上下文
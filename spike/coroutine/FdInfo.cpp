@@ -1,5 +1,6 @@
 #include "FdInfo.h"
 #include "Hook.h"
+#include "net/IdleManager.h"
 #include "splog.h"
 
 #include <sys/stat.h>
@@ -36,7 +37,13 @@ namespace lim_webserver
         }
     }
 
-    FdInfo::~FdInfo() {}
+    FdInfo::~FdInfo()
+    {
+        if (m_idleOwner)
+        {
+            m_idleOwner->remove(this);
+        }
+    }
 
     void FdInfo::close()
     {
@@ -44,6 +51,15 @@ namespace lim_webserver
         LOG_DEBUG(g_logger) << "Close FdInfo(fd = " << m_fd << ")";
     }
 
+    void FdInfo::setIdleTimeout(uint64_t ms)
+    {
+        m_idleTimeout = ms;
+        if (ms == 0 && m_idleOwner)
+        {
+            m_idleOwner->remove(this);
+        }
+    }
+
     void FdInfo::setSocketTimeout(int type, uint64_t ms)
     {
         switch (type)
@@ -10,8 +10,12 @@
 
 namespace lim_webserver
 {
+    class IdleManager;
+
     class FdInfo : public IoChannel
     {
+        friend IdleManager;
+
     public:
         using ptr = std::shared_ptr<FdInfo>;
         static ptr Create(int fd) { return std::make_shared<FdInfo>(fd); }
@@ -59,6 +63,24 @@ namespace lim_webserver
          */
         inline void setTcpConnectTimeout(uint64_t ms) { m_tcpConnectTimeout = ms; }
 
+        /**
+         * @brief 设置空闲超时(毫秒)，非0时读等待交由所在事件循环的IdleManager管理，不再创建定时器，
+         *        设为0时立即退出管理
+         */
+        void setIdleTimeout(uint64_t ms);
+
+        inline uint64_t getIdleTimeout() const { return m_idleTimeout; }
+
+        /**
+         * @brief 本次读等待是否因空闲超时被唤醒
+         */
+        inline bool isIdleExpired() const { return m_idleExpired; }
+
+        /**
+         * @brief 所属的空闲连接管理器，未开始读等待时为空
+         */
+        inline IdleManager *getIdleOwner() const { return m_idleOwner; }
+
     private:
         bool m_isSocket : 1;
         bool m_sysNonblock : 1;
@@ -66,6 +88,14 @@ namespace lim_webserver
         uint64_t m_recvTimeout = -1;       // 接受超时
         uint64_t m_sendTimeout = -1;       // 发送超时
         uint64_t m_tcpConnectTimeout = -1; // TCP连接超时
+        uint64_t m_idleTimeout = 0;        // 空闲超时，0为不受管理
+        uint64_t m_idleSince = 0;          // 开始等待读的时间
+        uint64_t m_idleRegistered = 0;     // 登记在IdleManager中的空闲超时
+        FdInfo *m_idlePrev = nullptr;      // 空闲链表前驱
+        FdInfo *m_idleNext = nullptr;      // 空闲链表后继
+        IdleManager *m_idleOwner = nullptr;
+        bool m_idleLinked = false;         // 是否在空闲链表中
+        bool m_idleExpired = false;        // 空闲超时标记
     };
 
     class FdManager : public Singleton<FdManager>
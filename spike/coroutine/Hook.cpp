@@ -23,6 +23,7 @@ namespace lim_webserver
     F(socket)                                                                                                                                                  \
     F(connect)                                                                                                                                                 \
     F(accept)                                                                                                                                                  \
+    F(accept4)                                                                                                                                                 \
     F(read)                                                                                                                                                    \
     F(readv)                                                                                                                                                   \
     F(recv)                                                                                                                                                    \
@@ -59,19 +60,15 @@ namespace lim_webserver
 #undef LOAD_HOOK_FUN
         is_inited = true;
     }
-    static uint64_t s_connect_timeout = -1;
     struct _HookIniter
     {
         _HookIniter()
         {
             hook_init();
-            s_connect_timeout = g_tcp_connect_timeout->getValue();
-
             g_tcp_connect_timeout->addListener(
                 [](const int &old_value, const int &new_value)
                 {
                     LOG_INFO(g_logger) << "tcp connect timeout changed from " << old_value << " to " << new_value;
-                    s_connect_timeout = new_value;
                 });
         }
     };
@@ -100,6 +97,8 @@ static ssize_t do_io(int fd, OriginFun fun, const char *hook_fun_name, uint32_t
     // 获取超时时间
     uint64_t to = fdInfo->getSocketTimeout(timeout_so);
     lim_webserver::Timer::ptr timer;
+    // 设置了空闲超时的连接，读等待由事件循环每秒统一清扫，不再逐次创建定时器
+    bool idle_managed = event == lim_webserver::READ && fdInfo->getIdleTimeout() != 0;
 
     // 重试IO 操作(一般循环一次)
     while (true)
@@ -130,7 +129,7 @@ static ssize_t do_io(int fd, OriginFun fun, const char *hook_fun_name, uint32_t
         bool expired = false;
 
         // 若设置了超时时间，则创建一个条件定时器来处理超时事件
-        if (to != (uint64_t)-1)
+        if (!idle_managed && to != (uint64_t)-1)
         {
             // 超时则触发回调
             timer = lim_webserver::TimerManager::GetInstance()->addTimer(to,
@@ -145,15 +144,38 @@ static ssize_t do_io(int fd, OriginFun fun, const char *hook_fun_name, uint32_t
         // 添加该协程事件，即后续内容
         fdInfo->addEvent((lim_webserver::IoEvent)event);
         loop->updateChannel(fdInfo);
+        if (idle_managed)
+        {
+            loop->idleManager().beginWait(fdInfo.get());
+        }
 
         LOG_TRACE(g_logger) << "task(" << task->id() << ") hook " << hook_fun_name << " hold.";
+        task->setWaitReason(hook_fun_name, fd);
+        lim_webserver::RequestTrace *trace = lim_webserver::RequestTrace::Current();
+        if (trace)
+        {
+            trace->add(lim_webserver::TracePoint::PARK, fd);
+        }
         lim_webserver::Processor::CoHold();
+        if (trace)
+        {
+            trace->add(lim_webserver::TracePoint::WAKE, fd);
+        }
         LOG_TRACE(g_logger) << "task(" << task->id() << ") hook " << hook_fun_name << " wake.";
         if (timer)
         {
             LOG_TRACE(g_logger) << "cancel timer";
             timer->cancel();
         }
+        if (idle_managed)
+        {
+            if (fdInfo->isIdleExpired())
+            {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            loop->idleManager().endWait(fdInfo.get());
+        }
         // 如果定时器信息为超时，则表明事件超时，设置错误码为超时并返回 -1
         if (expired)
         {
@@ -181,6 +203,7 @@ extern "C"
         // 获取当前task设定当前processor在一定时间后唤醒对应task
         lim_webserver::TimerManager::GetInstance()->addTimer(seconds * 1000, [task] { task->wake(); });
         // 阻塞当前协程
+        task->setWaitReason("sleep", seconds * 1000);
         lim_webserver::Processor::CoHold();
 
         return 0;
@@ -196,6 +219,7 @@ extern "C"
         LOG_TRACE(g_logger) << "task(" << task->id() << ") hook usleep(usec = " << usec << ") in coroutine.";
 
         lim_webserver::TimerManager::GetInstance()->addTimer(usec / 1000, [task] { task->wake(); });
+        task->setWaitReason("usleep", usec / 1000);
         lim_webserver::Processor::CoHold();
         return 0;
     }
@@ -213,6 +237,7 @@ extern "C"
 
         lim_webserver::TimerManager::GetInstance()->addTimer(timeout_ms, [task] { task->wake(); });
 
+        task->setWaitReason("nanosleep", timeout_ms);
         lim_webserver::Processor::CoHold();
 
         return 0;
@@ -295,7 +320,6 @@ extern "C"
         lim_webserver::Timer::ptr timer;
         uint64_t timeout_ms = fdInfo->getTcpConnectTimeout();
         lim_webserver::EventLoop *loop = reinterpret_cast<lim_webserver::EventLoop *>(lim_webserver::Processor::GetCurrentProcessor());
-        std::cout << loop << std::endl;
         bool expired = false;
         // 如果设置了连接超时时间 timeout_ms  不等于 (uint64_t)-1
         if (timeout_ms != (uint64_t)-1)
@@ -313,6 +337,7 @@ extern "C"
         // 添加读事件监听
         fdInfo->addEvent(lim_webserver::WRITE);
         loop->updateChannel(fdInfo);
+        task->setWaitReason("connect", sockfd);
         lim_webserver::Processor::CoHold();
 
         // 协程被唤醒
@@ -353,6 +378,16 @@ extern "C"
         return fd;
     }
 
+    int accept4(int s, struct sockaddr *addr, socklen_t *addrlen, int flags)
+    {
+        int fd = do_io(s, accept4_f, "accept4", lim_webserver::READ, SO_RCVTIMEO, addr, addrlen, flags);
+        if (fd >= 0)
+        {
+            lim_webserver::FdManager::GetInstance()->create(fd);
+        }
+        return fd;
+    }
+
     ssize_t readv(int fd, const struct iovec *iov, int iovcnt) { return do_io(fd, readv_f, "readv", lim_webserver::READ, SO_RCVTIMEO, iov, iovcnt); }
 
     ssize_t recv(int sockfd, void *buf, size_t len, int flags) { return do_io(sockfd, recv_f, "recv", lim_webserver::READ, SO_RCVTIMEO, buf, len, flags); }
@@ -383,8 +418,13 @@ extern "C"
         if (fdInfo)
         {
             fdInfo->clearEvent();
+            if (lim_webserver::IdleManager *owner = fdInfo->getIdleOwner())
+            {
+                owner->remove(fdInfo.get());
+            }
             lim_webserver::EventLoop *loop = reinterpret_cast<lim_webserver::EventLoop *>(lim_webserver::Processor::GetCurrentProcessor());
-            if (loop->hasChannel(fdInfo))
+            // 不在事件循环线程中关闭时没有需要移除的通道
+            if (loop && loop->hasChannel(fdInfo))
             {
                 loop->removeChannel(fdInfo);
             }
@@ -1,11 +1,14 @@
 #include "Processor.h"
 #include "Hook.h"
 #include "Scheduler.h"
+#include "base/Affinity.h"
+#include "splog.h"
 
 #include <iostream>
 
 namespace lim_webserver
 {
+    static Logger::ptr g_logger = LOG_SYS();
 
     Processor *&Processor::GetCurrentProcessor()
     {
@@ -52,6 +55,10 @@ namespace lim_webserver
     {
         Task *task = GetCurrentTask();
         assert(task);
+        if (!task->waitKind())
+        {
+            task->setWaitReason("hold");
+        }
         task->hold();
     }
 
@@ -59,6 +66,7 @@ namespace lim_webserver
 
     void Processor::addTask(Task *&task)
     {
+        m_queued.fetch_add(1, std::memory_order_relaxed);
         m_newQueue.enqueue(task);
         tickle();
     }
@@ -83,6 +91,10 @@ namespace lim_webserver
             {
             }
         }
+        if (m_curTask)
+        {
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+        }
     }
 
     void Processor::wakeupTask(Task *task) { addTask(task); }
@@ -136,9 +148,45 @@ namespace lim_webserver
         return !m_scheduler->m_started;
     }
 
+    void Processor::bindCpu()
+    {
+        std::vector<int> cpus = CpuAffinity::SchedulerCpus(m_scheduler->m_name);
+        if (cpus.empty())
+        {
+            return;
+        }
+        // 每个处理器独占一个CPU，处理器多于CPU时循环使用
+        int cpu = cpus[m_id % cpus.size()];
+        if (!CpuAffinity::Bind({cpu}))
+        {
+            LOG_WARN(g_logger) << m_scheduler->m_name << "_Proc_" << m_id << " bind cpu " << cpu << " failed, errno=" << errno;
+            return;
+        }
+        int node = CpuAffinity::NodeOfCpu(cpu);
+        if (CpuAffinity::NumNodes() > 1)
+        {
+            CpuAffinity::PreferNode(node);
+        }
+        LOG_INFO(g_logger) << m_scheduler->m_name << "_Proc_" << m_id << " bound to cpu " << cpu << " node " << node;
+    }
+
+    void Processor::initMetrics(const MetricLabels &labels)
+    {
+        MetricsRegistry *registry = MetricsRegistry::GetInstance();
+        m_switchCounter = registry->counter("spnet_processor_switches_total", "Task switches performed by the processor", labels);
+        m_wakeupCounter = registry->counter("spnet_processor_wakeups_total", "Times the processor woke up from idle", labels);
+        m_idleTimeCounter = registry->counter("spnet_processor_idle_seconds_total", "Time the processor spent idle", labels, 1e-9);
+        m_taskLifetime = registry->histogram("spnet_task_lifetime_seconds", "Time from task creation to termination", labels, 1e-6,
+                                             MetricsRegistry::LatencyBounds());
+        registry->gauge("spnet_processor_runqueue_depth", "Tasks waiting to run on the processor", labels,
+                        [this]() { return m_queued.load(std::memory_order_relaxed); });
+    }
+
     void Processor::run()
     {
         GetCurrentProcessor() = this;
+        bindCpu();
+        initMetrics({{"scheduler", m_scheduler->m_name}, {"processor", std::to_string(m_id)}});
         while (!stopping())
         {
             getNextTask(true);
@@ -146,7 +194,10 @@ namespace lim_webserver
             {
                 garbageCollection();
                 // 执行空闲任务
+                uint64_t idle_start = MetricNowNS();
                 idle();
+                m_idleTimeCounter->inc(MetricNowNS() - idle_start);
+                m_wakeupCounter->inc();
                 // 回到了工作状态，说明调度了新任务到队列中
                 m_runableQueue.concatenate(m_newQueue);
                 continue;
@@ -156,20 +207,31 @@ namespace lim_webserver
             while (m_curTask && !stopping())
             {
                 m_curTask->setProcessor(this);
-                ++m_switchCount;
+                m_switchCounter->inc();
+                m_curTask->m_state = TaskState::EXEC;
+                m_curTask->setWaitReason(nullptr);
+                RequestTrace *trace = m_curTask->trace();
+                if (trace)
+                {
+                    trace->onRun();
+                }
+                RequestTrace::SetCurrent(trace);
                 m_curTask->swapIn();
+                RequestTrace::SetCurrent(nullptr);
 
                 // 此时回到了Processor中
                 // 若为ready态则重新加入调度队列
                 switch (m_curTask->state())
                 {
                 case TaskState::READY:
+                    m_queued.fetch_add(1, std::memory_order_relaxed);
                     m_runableQueue.enqueue(m_curTask);
                     break;
                 case TaskState::HOLD:
                     break;
                 case TaskState::TERM:
                 default:
+                    m_taskLifetime->record((MetricNowNS() - m_curTask->createTime()) / 1000);
                     if (m_garbageList.size() > 16)
                     {
                         garbageCollection();
@@ -2,6 +2,7 @@
 
 #include "Task.h"
 #include "base/LFQueue.h"
+#include "base/Metrics.h"
 #include "base/Mutex.h"
 #include "base/Noncopyable.h"
 #include "base/Thread.h"
@@ -57,6 +58,13 @@ namespace lim_webserver
          */
         inline Scheduler *getScheduler() { return m_scheduler; }
 
+        /**
+         * @brief 获得该Processor在调度器中的编号
+         *
+         * @return int
+         */
+        inline int getId() const { return m_id; }
+
         /**
          * @brief 唤醒等待队列中的任务
          *
@@ -100,7 +108,20 @@ namespace lim_webserver
          */
         void run();
 
+        /**
+         * @brief 注册本处理器的指标，在处理器线程开始调度前调用
+         *
+         * @param labels 调度器名与处理器编号
+         */
+        virtual void initMetrics(const MetricLabels &labels);
+
     private:
+        /**
+         * @brief 按affinity.schedulers配置将当前线程绑定到CPU，并优先在其NUMA节点上分配内存
+         *
+         */
+        void bindCpu();
+
         /**
          * @brief 当前Processor的task主动让出线程并重新入队
          *
@@ -157,8 +178,13 @@ namespace lim_webserver
         std::list<Task *> m_garbageList;     // 待回收队列
         volatile bool m_activated = true;    // 激活标志位
         Thread::ptr m_thread;                // 绑定线程
-        volatile uint64_t m_switchCount = 0; // 调度次数
         int m_addNewRemain;                  // 每轮调度可添加新任务次数
+        std::atomic<int64_t> m_queued{0};    // 等待运行的任务数
+
+        MetricCounter *m_switchCounter = nullptr;   // 调度次数
+        MetricCounter *m_wakeupCounter = nullptr;   // 从空闲中醒来的次数
+        MetricCounter *m_idleTimeCounter = nullptr; // 空闲时长，单位：纳秒
+        MetricHistogram *m_taskLifetime = nullptr;  // 任务从创建到结束的时长，单位：微秒
 
         MutexType m_mutex;
         ConditionVariable m_cond;
@@ -0,0 +1,347 @@
+#include "Profiler.h"
+#include "base/BackTrace.h"
+#include "base/Configer.h"
+#include "base/Metrics.h"
+#include "coroutine/Processor.h"
+#include "coroutine/Scheduler.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <execinfo.h>
+#include <link.h>
+#include <map>
+#include <signal.h>
+#include <sstream>
+#include <string.h>
+#include <sys/time.h>
+#include <unordered_map>
+
+namespace lim_webserver
+{
+    static Logger::ptr g_logger = LOG_SYS();
+
+    static ConfigerVar<uint32_t>::ptr g_profiler_max_samples =
+        Configer::Lookup<uint32_t>("profiler.max_samples", 20000, "sample buffer size of the SIGPROF profiler, allocated on first start");
+
+    static const char *StateToString(TaskState state)
+    {
+        switch (state)
+        {
+        case TaskState::READY:
+            return "READY";
+        case TaskState::EXEC:
+            return "EXEC";
+        case TaskState::HOLD:
+            return "HOLD";
+        case TaskState::EXCEPT:
+            return "EXCEPT";
+        case TaskState::TERM:
+            return "TERM";
+        default:
+            return "UNKNOWN";
+        }
+    }
+
+#if defined(__x86_64__)
+    using TextRanges = std::vector<std::pair<uintptr_t, uintptr_t>>;
+
+    /**
+     * @brief 收集已加载模块的可执行段
+     */
+    static TextRanges CollectTextRanges()
+    {
+        TextRanges ranges;
+        dl_iterate_phdr(
+            [](struct dl_phdr_info *info, size_t, void *data)
+            {
+                TextRanges *out = static_cast<TextRanges *>(data);
+                for (int i = 0; i < info->dlpi_phnum; ++i)
+                {
+                    const ElfW(Phdr) &phdr = info->dlpi_phdr[i];
+                    if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X))
+                    {
+                        uintptr_t begin = info->dlpi_addr + phdr.p_vaddr;
+                        out->emplace_back(begin, begin + phdr.p_memsz);
+                    }
+                }
+                return 0;
+            },
+            &ranges);
+        return ranges;
+    }
+
+    /**
+     * @brief addr是否像返回地址：位于可执行段内，且紧邻其前的是一条call指令
+     */
+    static bool IsReturnAddress(const TextRanges &ranges, uintptr_t addr)
+    {
+        for (auto &range : ranges)
+        {
+            if (addr < range.first + 7 || addr > range.second)
+            {
+                continue;
+            }
+            const uint8_t *p = (const uint8_t *)addr;
+            // call rel32
+            if (p[-5] == 0xE8)
+            {
+                return true;
+            }
+            // call r/m64，按ModRM长度检查：寄存器、[reg+disp8]、[rip/reg+disp32]、带SIB的形式
+            for (int len = 2; len <= 7; ++len)
+            {
+                if (p[-len] == 0xFF && ((p[-len + 1] >> 3) & 7) == 2)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        return false;
+    }
+
+    // 每个任务最多复制的栈字节数，从挂起时的栈指针算起，最内层的调用帧都在其中
+    static const size_t MAX_STACK_COPY = 32 * 1024;
+
+    /**
+     * @brief 从挂起任务栈的副本中扫描返回地址
+     */
+    static void ScanTaskStack(const TextRanges &ranges, uintptr_t pc, const std::string &stack, int max_frames, std::vector<void *> &pcs)
+    {
+        pcs.push_back((void *)pc);
+        for (size_t p = 0; p + sizeof(uintptr_t) <= stack.size() && (int)pcs.size() < max_frames; p += sizeof(uintptr_t))
+        {
+            uintptr_t value;
+            memcpy(&value, stack.data() + p, sizeof(value));
+            if (IsReturnAddress(ranges, value))
+            {
+                pcs.push_back((void *)value);
+            }
+        }
+    }
+#endif
+
+    /**
+     * @brief 转储时在分片锁内复制的任务信息
+     */
+    struct TaskSnapshot
+    {
+        uint64_t id;
+        TaskState state;
+        const char *waitKind;
+        int64_t waitArg;
+        Processor *processor;
+        uint64_t createTime;
+        uintptr_t pc;      // 挂起时的指令地址
+        std::string stack; // 挂起时栈指针以上的栈内容
+    };
+
+    std::string TaskDumper::Dump(int max_frames)
+    {
+        // 锁内只复制状态与栈内容，格式化、扫描与符号化都在锁外进行，不阻塞任务的创建与结束
+        std::vector<TaskSnapshot> snapshots;
+        Task::ForEachLive(
+            [&](Task *task)
+            {
+                snapshots.push_back({task->id(), task->state(), task->waitKind(), task->waitArg(), task->getProcessor(), task->createTime(), 0, ""});
+#if defined(__x86_64__)
+                // 运行中的任务栈在不断变化，不复制
+                if (task->state() != TaskState::EXEC)
+                {
+                    const Context &context = task->context();
+                    uintptr_t sp = context.savedSP() & ~(uintptr_t)7;
+                    uintptr_t top = context.stackTop();
+                    TaskSnapshot &snapshot = snapshots.back();
+                    snapshot.pc = context.savedPC();
+                    if (sp < top)
+                    {
+                        snapshot.stack.assign((const char *)sp, std::min<size_t>(top - sp, MAX_STACK_COPY));
+                    }
+                }
+#endif
+            });
+
+        std::stringstream ss;
+#if defined(__x86_64__)
+        TextRanges ranges = CollectTextRanges();
+#endif
+        uint64_t now = MetricNowNS();
+        std::sort(snapshots.begin(), snapshots.end(), [](const TaskSnapshot &a, const TaskSnapshot &b) { return a.id > b.id; });
+        for (const TaskSnapshot &snapshot : snapshots)
+        {
+            ss << "task " << snapshot.id << " state=" << StateToString(snapshot.state);
+            if (snapshot.waitKind)
+            {
+                ss << " wait=" << snapshot.waitKind;
+                if (snapshot.waitArg >= 0)
+                {
+                    ss << "(" << snapshot.waitArg << ")";
+                }
+            }
+            if (snapshot.processor)
+            {
+                ss << " processor=" << snapshot.processor->getScheduler()->name() << "_Proc_" << snapshot.processor->getId();
+            }
+            ss << " age=" << (now - snapshot.createTime) / 1000000 << "ms\n";
+
+#if defined(__x86_64__)
+            if (snapshot.pc)
+            {
+                std::vector<void *> pcs;
+                std::vector<std::string> symbols;
+                ScanTaskStack(ranges, snapshot.pc, snapshot.stack, max_frames, pcs);
+                BackTraceSymbols(pcs, symbols);
+                for (size_t i = 0; i < symbols.size(); ++i)
+                {
+                    ss << "    #" << i << " " << symbols[i] << "\n";
+                }
+            }
+#endif
+        }
+        return "live tasks: " + std::to_string(snapshots.size()) + "\n" + ss.str();
+    }
+
+    // 采样缓冲区只分配一次且不释放，停止后迟到的信号写入时不会访问已释放的内存
+    static SamplingProfiler::Sample *s_samples = nullptr;
+    static size_t s_allocated = 0;
+    static std::atomic<size_t> s_capacity{0};
+    static std::atomic<size_t> s_next{0};
+
+    void SamplingProfiler::OnSignal(int sig)
+    {
+        int saved_errno = errno;
+        size_t idx = s_next.fetch_add(1, std::memory_order_relaxed);
+        if (idx < s_capacity.load(std::memory_order_acquire))
+        {
+            Sample &sample = s_samples[idx];
+            Task *task = Processor::GetCurrentTask();
+            sample.task = task ? task->id() : 0;
+            sample.depth = backtrace(sample.pcs, MAX_DEPTH);
+            sample.ready.store(true, std::memory_order_release);
+        }
+        errno = saved_errno;
+    }
+
+    bool SamplingProfiler::start(int hz)
+    {
+        if (hz <= 0 || hz > 10000)
+        {
+            return false;
+        }
+        MutexType::Lock lock(m_mutex);
+        if (m_running)
+        {
+            return false;
+        }
+        if (!s_samples)
+        {
+            s_allocated = std::max<uint32_t>(g_profiler_max_samples->getValue(), 1);
+            s_samples = new Sample[s_allocated];
+            // 首次调用backtrace会加载libgcc，不能发生在信号处理函数中
+            void *warmup[1];
+            backtrace(warmup, 1);
+        }
+        for (size_t i = 0; i < s_allocated; ++i)
+        {
+            s_samples[i].ready.store(false, std::memory_order_relaxed);
+        }
+        s_next.store(0, std::memory_order_relaxed);
+        s_capacity.store(s_allocated, std::memory_order_release);
+
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = &SamplingProfiler::OnSignal;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGPROF, &sa, nullptr);
+
+        struct itimerval timer;
+        timer.it_interval.tv_sec = (1000000 / hz) / 1000000;
+        timer.it_interval.tv_usec = (1000000 / hz) % 1000000;
+        timer.it_value = timer.it_interval;
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        m_running = true;
+        LOG_INFO(g_logger) << "sampling profiler started at " << hz << "hz, buffer " << s_allocated << " samples";
+        return true;
+    }
+
+    std::string SamplingProfiler::stop(bool by_task)
+    {
+        MutexType::Lock lock(m_mutex);
+        if (!m_running)
+        {
+            return "";
+        }
+        struct itimerval timer;
+        memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        // 关闭定时器后仍可能有信号在途，先收回容量，迟到的处理函数只会递增下标
+        s_capacity.store(0, std::memory_order_release);
+        signal(SIGPROF, SIG_IGN);
+        m_running = false;
+
+        size_t taken = std::min(s_next.load(std::memory_order_relaxed), s_allocated);
+        m_dropped = s_next.load(std::memory_order_relaxed) - taken;
+
+        // 跳过处理函数自身与信号跳板两帧，其余地址去重后一次性符号化
+        const int SKIP = 2;
+        std::vector<void *> addrs;
+        std::unordered_map<void *, size_t> index;
+        for (size_t i = 0; i < taken; ++i)
+        {
+            Sample &sample = s_samples[i];
+            if (!sample.ready.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+            for (int d = SKIP; d < sample.depth; ++d)
+            {
+                if (index.emplace(sample.pcs[d], addrs.size()).second)
+                {
+                    addrs.push_back(sample.pcs[d]);
+                }
+            }
+        }
+        std::vector<std::string> symbols;
+        BackTraceSymbols(addrs, symbols);
+        if (symbols.size() != addrs.size())
+        {
+            return "";
+        }
+
+        std::map<std::string, uint64_t> folded;
+        for (size_t i = 0; i < taken; ++i)
+        {
+            Sample &sample = s_samples[i];
+            if (!sample.ready.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+            std::string stack;
+            if (by_task)
+            {
+                stack = sample.task ? "task-" + std::to_string(sample.task) : "thread";
+            }
+            for (int d = sample.depth - 1; d >= SKIP; --d)
+            {
+                if (!stack.empty())
+                {
+                    stack += ';';
+                }
+                std::string frame = symbols[index[sample.pcs[d]]];
+                std::replace(frame.begin(), frame.end(), ';', ':');
+                stack += frame;
+            }
+            ++folded[stack];
+        }
+
+        std::stringstream ss;
+        for (auto &item : folded)
+        {
+            ss << item.first << " " << item.second << "\n";
+        }
+        LOG_INFO(g_logger) << "sampling profiler stopped, " << taken << " samples, " << m_dropped << " dropped";
+        return ss.str();
+    }
+
+} // namespace lim_webserver
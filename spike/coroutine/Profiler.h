@@ -0,0 +1,90 @@
+#pragma once
+
+#include "base/Mutex.h"
+#include "base/Noncopyable.h"
+#include "base/Singleton.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace lim_webserver
+{
+    /**
+     * @brief 协程转储：列出所有未结束的任务及其挂起原因与调用栈
+     *
+     * @details 挂起任务的调用栈从切出时保存的栈指针向栈底扫描得到：在可执行段内且前一条指令为call的
+     *          字视为返回地址。编译时省略了帧指针，只能这样保守扫描，结果可能混入已返回函数残留的地址，
+     *          但最内层的若干帧是可靠的。正在运行的任务不扫描。只支持x86_64，其他平台只输出任务信息。
+     */
+    class TaskDumper
+    {
+    public:
+        /**
+         * @brief 转储所有未结束的任务
+         *
+         * @param max_frames 每个任务最多输出的栈帧数
+         */
+        static std::string Dump(int max_frames = 24);
+    };
+
+    /**
+     * @brief 基于SIGPROF的采样分析器
+     *
+     * @details setitimer(ITIMER_PROF)按进程CPU时间定期投递SIGPROF，信号落在正在消耗CPU的线程上。
+     *          信号处理函数在被中断的栈上回溯，协程运行时回溯的是协程自己的栈，因此样本按任务id与
+     *          调用点归属，不会因swapcontext而混在处理器的主栈上。样本写入预先分配的缓冲区，
+     *          处理函数内不分配内存、不加锁，缓冲区写满后丢弃并计数。
+     *          停止后输出folded格式(根在前，以分号分隔，末尾为样本数)，可直接交给flamegraph.pl。
+     */
+    class SamplingProfiler : public Singleton<SamplingProfiler>, Noncopyable
+    {
+    public:
+        using MutexType = Mutex;
+
+        static const int MAX_DEPTH = 48;
+
+        /**
+         * @brief 开始采样
+         *
+         * @param hz 每秒采样次数(按CPU时间)
+         * @return false 已在采样或参数无效
+         */
+        bool start(int hz);
+
+        /**
+         * @brief 停止采样并输出folded格式的调用栈
+         *
+         * @param by_task 为true时以"task-<id>"作为根帧区分任务，不在协程中的样本归为"thread"
+         */
+        std::string stop(bool by_task = true);
+
+        inline bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+
+        /**
+         * @brief 上次采样因缓冲区写满丢弃的样本数
+         */
+        inline uint64_t getDropped() const { return m_dropped; }
+
+        /**
+         * @brief 一次采样
+         */
+        struct Sample
+        {
+            uint64_t task;            // 任务id，0为不在协程中
+            int depth;                // 栈帧数
+            void *pcs[MAX_DEPTH];     // 栈帧地址，由内向外
+            std::atomic<bool> ready;  // 处理函数写完后置位
+        };
+
+    private:
+        static void OnSignal(int sig);
+
+    private:
+        std::atomic<bool> m_running{false};
+        uint64_t m_dropped = 0;
+        MutexType m_mutex;
+    };
+
+} // namespace lim_webserver
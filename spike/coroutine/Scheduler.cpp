@@ -1,8 +1,10 @@
 #include "Scheduler.h"
 #include "Hook.h"
+#include "base/Affinity.h"
 #include "net/EventLoop.h"
 #include "splog.h"
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
@@ -23,6 +25,7 @@ namespace lim_webserver
         Scheduler *sched = new Scheduler();
         EventLoop *loop = new EventLoop(sched, 0);
         sched->setProcessor(loop);
+        sched->m_isNet = true;
         return sched;
     }
 
@@ -33,32 +36,76 @@ namespace lim_webserver
         this->addTask(tk);
     }
 
+    void Scheduler::createTask(TaskFunc const &func, size_t idx)
+    {
+        Task *tk = new Task(func, 128 * 1024);
+        {
+            MutexType::Lock lock(m_mutex);
+            if (!m_processors.empty())
+            {
+                tk->setProcessor(m_processors[idx % m_processors.size()]);
+            }
+        }
+        this->addTask(tk);
+    }
+
+    void Scheduler::createTracedTask(TaskFunc const &func, RequestTrace *trace)
+    {
+        Task *tk = new Task(func, 128 * 1024);
+        tk->setTrace(trace);
+        this->addTask(tk);
+    }
+
+    size_t Scheduler::processorCount()
+    {
+        MutexType::Lock lock(m_mutex);
+        return m_processors.size();
+    }
+
+    Processor *Scheduler::getProcessor(size_t idx)
+    {
+        MutexType::Lock lock(m_mutex);
+        return idx < m_processors.size() ? m_processors[idx] : nullptr;
+    }
+
     void Scheduler::start(int num_threads)
     {
         if (m_started)
         {
             return;
         }
-        MutexType::Lock lock(m_mutex);
-        m_threadCounts = num_threads;
+        reportAffinity(num_threads);
+        {
+            MutexType::Lock lock(m_mutex);
+            m_threadCounts = num_threads;
 
-        // 创建主处理器
+            // 创建主处理器
 
-        m_processors.push_back(m_mainProcessor);
+            m_processors.push_back(m_mainProcessor);
 
-        // 创建从处理器
-        for (int i = 0; i < num_threads - 1; ++i)
-        {
-            newPoccessorThread();
+            // 先置启动标志，否则先创建的从处理器线程会因stopping()为真而直接退出
+            m_started = true;
+
+            // 创建从处理器
+            for (int i = 0; i < num_threads - 1; ++i)
+            {
+                newPoccessorThread();
+            }
         }
-        m_started = true;
+        m_startSem.notify();
 
+        // 主处理器运行期间不持有锁，否则其他线程无法stop
         m_mainProcessor->run();
     }
 
     void Scheduler::startInNewThread(int num_threads)
     {
+        if (m_started)
+        {
+            return;
+        }
         m_thread = Thread::Create([this, num_threads]() { this->start(num_threads); }, m_name);
+        m_startSem.wait();
     }
 
     void Scheduler::stop()
@@ -155,9 +202,35 @@ namespace lim_webserver
         }
     }
 
+    void Scheduler::reportAffinity(int num_threads)
+    {
+        std::vector<int> cpus = CpuAffinity::SchedulerCpus(m_name);
+        std::vector<int> housekeeping = CpuAffinity::HousekeepingCpus();
+        if (cpus.empty())
+        {
+            LOG_INFO(g_logger) << "scheduler " << m_name << " start " << num_threads << " processors without cpu affinity";
+            return;
+        }
+        LOG_INFO(g_logger) << "scheduler " << m_name << " start " << num_threads << " processors on cpus " << CpuAffinity::ToString(cpus)
+                           << ", housekeeping cpus " << (housekeeping.empty() ? "unset" : CpuAffinity::ToString(housekeeping))
+                           << ", numa nodes " << CpuAffinity::NumNodes();
+        if ((size_t)num_threads > cpus.size())
+        {
+            LOG_WARN(g_logger) << "scheduler " << m_name << " has more processors than cpus, processors will share cpus";
+        }
+        for (int cpu : cpus)
+        {
+            if (std::find(housekeeping.begin(), housekeeping.end(), cpu) != housekeeping.end())
+            {
+                LOG_WARN(g_logger) << "scheduler " << m_name << " cpu " << cpu << " is shared with housekeeping threads";
+            }
+        }
+    }
+
     void Scheduler::newPoccessorThread()
     {
-        auto p = new Processor(this, m_processors.size());
+        // 网络调度器的每个处理器都是事件循环，hook的IO可以在任一处理器上挂起
+        Processor *p = m_isNet ? new EventLoop(this, m_processors.size()) : new Processor(this, m_processors.size());
         p->start();
         m_processors.push_back(p);
     }
@@ -31,6 +31,33 @@ namespace lim_webserver
          */
         void createTask(TaskFunc const &func);
 
+        /**
+         * @brief 在指定处理器上创建新协程任务
+         *
+         * @param func
+         * @param idx 处理器编号，超出处理器数量时取模
+         */
+        void createTask(TaskFunc const &func, size_t idx);
+
+        /**
+         * @brief 创建带请求追踪的协程任务，处理器首次运行该任务时打点
+         *
+         * @param func
+         * @param trace 由func持有，func结束前有效
+         */
+        void createTracedTask(TaskFunc const &func, RequestTrace *trace);
+
+        /**
+         * @brief 处理器数量，调度开始后有效
+         *
+         */
+        size_t processorCount();
+
+        /**
+         * @brief 第idx个处理器，超出范围返回nullptr
+         */
+        Processor *getProcessor(size_t idx);
+
         /**
          * @brief 开始调度任务
          *
@@ -39,7 +66,7 @@ namespace lim_webserver
         void start(int num_threads = 1);
 
         /**
-         * @brief 在新线程开始调度任务
+         * @brief 在新线程开始调度任务，返回时所有处理器均已创建
          *
          * @param num_threads
          */
@@ -51,6 +78,15 @@ namespace lim_webserver
          */
         void stop();
 
+        /**
+         * @brief 是否正在调度，stop之后为false
+         */
+        bool isRunning()
+        {
+            MutexType::Lock lock(m_mutex);
+            return m_started;
+        }
+
         /**
          * @brief 设置名字
          *
@@ -79,6 +115,13 @@ namespace lim_webserver
          */
         void run();
 
+        /**
+         * @brief 启动时输出CPU绑定配置，处理器与辅助线程共用CPU时告警
+         *
+         * @param num_threads 工作线程数
+         */
+        void reportAffinity(int num_threads);
+
         /**
          * @brief 创建新的处理器
          *
@@ -91,11 +134,13 @@ namespace lim_webserver
         Processor *m_mainProcessor = nullptr;  // 主处理器
         size_t m_lastActiveIdx;                // 最后一次调度的处理器
         int m_threadId;                        // Scheduler所在线程
-        bool m_started;                        // 开始标志位
+        bool m_started = false;                // 开始标志位
+        bool m_isNet = false;                  // 是否为网络调度器，处理器均为EventLoop
         std::string m_name;                    // 名字
         Thread::ptr m_thread = nullptr;        // 绑定线程
         MutexType m_mutex;                     // 锁
         ConditionVariable m_cond;              // 条件变量
+        Semaphore m_startSem;                  // 处理器创建完毕
     };
 
 } // namespace lim_webserver
@@ -1,6 +1,8 @@
 #include "Task.h"
 
 #include "base/BackTrace.h"
+#include "base/Metrics.h"
+#include "base/Mutex.h"
 #include "coroutine/Processor.h"
 #include "splog.h"
 
@@ -13,13 +15,77 @@ namespace lim_webserver
 
     static std::atomic<uint64_t> s_task_id{0};
 
+    // 未结束任务按id分散到多个链表，创建与结束只锁所在的分片，不同处理器上的任务创建互不阻塞；只在转储时遍历
+    static const size_t LIVE_SHARDS = 64;
+
+    struct alignas(64) LiveShard
+    {
+        Spinlock mutex;
+        Task *head = nullptr;
+    };
+
+    static LiveShard &GetLiveShard(uint64_t id)
+    {
+        // 函数内静态变量，静态初始化期间创建的任务也能安全登记
+        static LiveShard s_shards[LIVE_SHARDS];
+        return s_shards[id % LIVE_SHARDS];
+    }
+
     Task::Task(TaskFunc func, size_t size)
-        : m_context((ContextFunc)&Task::StaticRun, (uintptr_t)this, size), m_callback(func), m_id(++s_task_id)
+        : m_context((ContextFunc)&Task::StaticRun, (uintptr_t)this, size), m_callback(func), m_id(++s_task_id),
+          m_createTime(MetricNowNS())
     {
+        LiveShard &shard = GetLiveShard(m_id);
+        Spinlock::Lock lock(shard.mutex);
+        m_liveNext = shard.head;
+        if (shard.head)
+        {
+            shard.head->m_livePrev = this;
+        }
+        shard.head = this;
+        m_live = true;
     }
 
     Task::~Task()
     {
+        unlinkLive();
+    }
+
+    void Task::unlinkLive()
+    {
+        LiveShard &shard = GetLiveShard(m_id);
+        Spinlock::Lock lock(shard.mutex);
+        if (!m_live)
+        {
+            return;
+        }
+        if (m_livePrev)
+        {
+            m_livePrev->m_liveNext = m_liveNext;
+        }
+        else
+        {
+            shard.head = m_liveNext;
+        }
+        if (m_liveNext)
+        {
+            m_liveNext->m_livePrev = m_livePrev;
+        }
+        m_livePrev = m_liveNext = nullptr;
+        m_live = false;
+    }
+
+    void Task::ForEachLive(const std::function<void(Task *)> &func)
+    {
+        for (size_t i = 0; i < LIVE_SHARDS; ++i)
+        {
+            LiveShard &shard = GetLiveShard(i);
+            Spinlock::Lock lock(shard.mutex);
+            for (Task *task = shard.head; task; task = task->m_liveNext)
+            {
+                func(task);
+            }
+        }
     }
 
     void Task::wake()
@@ -34,6 +100,7 @@ namespace lim_webserver
         {
             m_state = TaskState::EXEC;
             m_callback();
+            m_trace = nullptr;
             m_callback = TaskFunc();
             m_state = TaskState::TERM;
         };
@@ -45,6 +112,7 @@ namespace lim_webserver
         }
         catch (const std::exception &e)
         {
+            m_trace = nullptr;
             m_callback = TaskFunc();
             m_state = TaskState::EXCEPT;
             LOG_ERROR(g_logger) << "Task Except: " << e.what() << " task_id=" << id()
@@ -53,12 +121,14 @@ namespace lim_webserver
         }
         catch (...)
         {
+            m_trace = nullptr;
             m_callback = TaskFunc();
             m_state = TaskState::EXCEPT;
             LOG_ERROR(g_logger) << "Task Except: task_id=" << id()
                                 << "\n"
                                 << BackTraceToString();
         }
+        unlinkLive();
         swapOut();
     }
 
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <stdint.h>
 
 #include "base/Noncopyable.h"
+#include "base/Trace.h"
 #include "coroutine/Context.h"
 
 namespace lim_webserver
@@ -89,6 +92,47 @@ namespace lim_webserver
          */
         inline TaskState state() const { return m_state; }
 
+        /**
+         * @brief 获得创建时刻，单位：纳秒(单调时钟)
+         *
+         * @return uint64_t
+         */
+        inline uint64_t createTime() const { return m_createTime; }
+
+        /**
+         * @brief 记录挂起原因，供任务转储显示，恢复运行时由Processor清除
+         *
+         * @param kind 原因，需为静态字符串，如hook的函数名
+         * @param arg  附加参数，如句柄或毫秒数，-1为无
+         */
+        inline void setWaitReason(const char *kind, int64_t arg = -1)
+        {
+            m_waitKind = kind;
+            m_waitArg = arg;
+        }
+
+        inline const char *waitKind() const { return m_waitKind; }
+
+        inline int64_t waitArg() const { return m_waitArg; }
+
+        /**
+         * @brief 设置请求追踪，须在任务调度前设置，追踪对象由任务的回调持有
+         */
+        inline void setTrace(RequestTrace *trace) { m_trace = trace; }
+
+        inline RequestTrace *trace() const { return m_trace; }
+
+        /**
+         * @brief 协程上下文，供转储读取挂起时保存的寄存器与栈
+         */
+        inline const Context &context() const { return m_context; }
+
+        /**
+         * @brief 逐个分片在锁内遍历所有未结束的任务，回调中不能创建或结束任务，
+         *        持锁期间同一分片的任务创建与结束被阻塞，回调应只复制所需的数据
+         */
+        static void ForEachLive(const std::function<void(Task *)> &func);
+
     private:
         /**
          * @brief 上下文切入
@@ -116,5 +160,17 @@ namespace lim_webserver
         Context m_context;                    // 协程上下文
         Processor *m_processor = nullptr;     // 对应的执行器
         TaskFunc m_callback;                  // 回调函数
+        uint64_t m_createTime;                // 创建时刻
+        const char *m_waitKind = nullptr;     // 挂起原因
+        int64_t m_waitArg = -1;               // 挂起原因的附加参数
+        RequestTrace *m_trace = nullptr;      // 请求追踪，回调结束后失效
+        Task *m_livePrev = nullptr;           // 未结束任务链表
+        Task *m_liveNext = nullptr;
+        bool m_live = false;                  // 是否在未结束任务链表中
+
+        /**
+         * @brief 从未结束任务链表中摘除
+         */
+        void unlinkLive();
     };
 } // namespace lim_webserver
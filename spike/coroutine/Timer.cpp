@@ -1,7 +1,10 @@
 #include "coroutine/Timer.h"
+#include "base/Affinity.h"
 #include "base/TimeStamp.h"
 #include "Timer.h"
 
+#include <algorithm>
+
 namespace lim_webserver
 {
     Timer::Timer(uint64_t time, std::function<void()> callback, bool recurring, TimerManager *manager)
@@ -46,6 +49,18 @@ namespace lim_webserver
     TimerManager::TimerManager()
         : m_cond(m_mutex)
     {
+        MetricsRegistry *registry = MetricsRegistry::GetInstance();
+        m_addCounter = registry->counter("spnet_timer_added_total", "Timers added, including resets");
+        m_cancelCounter = registry->counter("spnet_timer_cancelled_total", "Timers cancelled before firing");
+        m_fireCounter = registry->counter("spnet_timer_fired_total", "Timer callbacks taken for execution");
+        m_fireLateness = registry->histogram("spnet_timer_lateness_seconds", "Delay between the scheduled and the actual firing time", {},
+                                             1e-3, MetricsRegistry::LatencyBounds());
+        registry->gauge("spnet_timer_pending", "Timers waiting to fire", {},
+                        [this]()
+                        {
+                            MutexType::Lock lock(m_mutex);
+                            return (int64_t)m_timer_set.size();
+                        });
         m_thread = Thread::Create([this]
                                   { this->run(); },
                                   "Timer");
@@ -111,6 +126,7 @@ namespace lim_webserver
         timer->m_callback = nullptr;
         auto it = m_timer_set.find(timer);
         m_timer_set.erase(it);
+        m_cancelCounter->inc();
         return true;
     }
 
@@ -217,8 +233,10 @@ namespace lim_webserver
 
         // 将回调函数提取
         callback_list.reserve(expired_timer_vec.size());
+        m_fireCounter->inc(expired_timer_vec.size());
         for (auto &timer : expired_timer_vec)
         {
+            m_fireLateness->record(now_ms - std::min(now_ms, timer->m_next));
             callback_list.push_back(timer->m_callback);
             // 若为循环定时器任务则重新添加到红黑树中
             if (timer->m_recurring)
@@ -236,6 +254,7 @@ namespace lim_webserver
 
     void TimerManager::addTimer(Timer::ptr timer)
     {
+        m_addCounter->inc();
         auto it = m_timer_set.end();
         {
             MutexType::Lock lock(m_mutex);
@@ -281,6 +300,7 @@ namespace lim_webserver
 
     void TimerManager::run()
     {
+        CpuAffinity::RegisterHousekeeping();
         while (m_started)
         {
             {
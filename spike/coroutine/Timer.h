@@ -1,5 +1,6 @@
 #pragma once
 
+#include "base/Metrics.h"
 #include "base/Singleton.h"
 #include "base/Noncopyable.h"
 #include "base/Mutex.h"
@@ -181,5 +182,10 @@ namespace lim_webserver
         Thread::ptr m_thread;                                // 工作线程
         MutexType m_mutex;
         ConditionVariable m_cond;
+
+        MetricCounter *m_addCounter;       // 添加的定时器数
+        MetricCounter *m_cancelCounter;    // 取消的定时器数
+        MetricCounter *m_fireCounter;      // 到期执行的定时器数
+        MetricHistogram *m_fireLateness;   // 实际执行晚于计划时间的毫秒数
     };
 } // namespace lim_webserver
@@ -4,4 +4,6 @@
 #include "net/Client.h"
 #include "net/ByteArray.h"
 #include "net/SocketStream.h"
+#include "net/SslSocketStream.h"
+#include "net/ConfigWatcher.h"
 #include "coroutine.h"
\ No newline at end of file
@@ -3,14 +3,19 @@
 #include "Endian.h"
 #include "splog.h"
 
+#include <algorithm>
 #include <iomanip>
+#include <limits.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace lim_webserver
 {
     static Logger::ptr g_logger = LOG_SYS();
 
     ByteArray::Node::Node(size_t s)
-        : ptr(new char[s]), next(nullptr), size(s)
+        : ptr(static_cast<char *>(BlockPool::Alloc(s))), next(nullptr), size(s)
     {
     }
 
@@ -23,7 +28,7 @@ namespace lim_webserver
     {
         if (ptr)
         {
-            delete[] ptr;
+            BlockPool::Dealloc(ptr, size);
         }
     }
 
@@ -93,38 +98,183 @@ namespace lim_webserver
 
     static uint32_t EncodeZigzag32(const int32_t &v)
     {
-        if (v < 0)
+        return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+    }
+
+    static uint64_t EncodeZigzag64(const int64_t &v)
+    {
+        return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+    }
+
+    static int32_t DecodeZigzag32(const uint32_t &v)
+    {
+        return (v >> 1) ^ -(v & 1);
+    }
+
+    static int64_t DecodeZigzag64(const uint64_t &v)
+    {
+        return (v >> 1) ^ -(v & 1);
+    }
+
+    static const size_t VARINT_SLACK = 16;                     // 编码时目标缓存须预留的字节数
+    static const uint64_t VARINT_MSBS = 0x8080808080808080ull; // 每字节的延续位
+    static const uint64_t VARINT_LOWS = 0x7f7f7f7f7f7f7f7full; // 每字节的数据位
+
+    /**
+     * @brief 计算Varint编码长度，有效位数按7位向上取整，0占1字节
+     */
+    static inline size_t VarintSize(uint64_t v)
+    {
+        return (70 - __builtin_clzll(v | 1)) / 7;
+    }
+
+    /**
+     * @brief 编码一个Varint到p，p之后至少有VARINT_SLACK字节可写
+     * @details 不超过56位的值把每7位摊到一个字节并一次置好延续位，整字写出，不随长度分支
+     */
+    static inline size_t EncodeVarint(uint8_t *p, uint64_t v)
+    {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (v < (1ull << 56))
         {
-            return ((uint32_t)(-v)) * 2 - 1;
+            size_t len = VarintSize(v);
+            uint64_t w = (v & 0x7f) | (v << 1 & 0x7f00) | (v << 2 & 0x7f0000) | (v << 3 & 0x7f000000) | (v << 4 & 0x7f00000000ull) | (v << 5 & 0x7f0000000000ull) | (v << 6 & 0x7f000000000000ull) | (v << 7 & 0x7f00000000000000ull);
+            w |= VARINT_MSBS & ((1ull << (8 * len - 8)) - 1);
+            memcpy(p, &w, sizeof(w));
+            return len;
         }
-        else
+#endif
+        size_t i = 0;
+        while (v >= 0x80)
         {
-            return v * 2;
+            p[i++] = (v & 0x7F) | 0x80;
+            v >>= 7;
         }
+        p[i++] = v;
+        return i;
     }
 
-    static uint64_t EncodeZigzag64(const int64_t &v)
+    /**
+     * @brief 按字解码p处的Varint，p之后至少有8字节可读
+     * @param[in] max 最多占用的字节数
+     * @return 编码长度，超过8字节或max时返回0
+     */
+    static inline size_t DecodeVarintWord(const uint8_t *p, size_t max, uint64_t &v)
     {
-        if (v < 0)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        uint64_t term = ~w & VARINT_MSBS;
+        if (term == 0)
         {
-            return ((uint64_t)(-v)) * 2 - 1;
+            return 0;
         }
-        else
+        size_t len = (__builtin_ctzll(term) >> 3) + 1;
+        if (len > max)
         {
-            return v * 2;
+            return 0;
         }
+        // 保留到首个结束字节为止的数据位，再把各字节的7位收拢
+        uint64_t x = w & (term ^ (term - 1)) & VARINT_LOWS;
+        v = (x & 0x7f) | (x >> 1 & 0x3f80) | (x >> 2 & 0x1fc000) | (x >> 3 & 0xfe00000) | (x >> 4 & 0x7f0000000ull) | (x >> 5 & 0x3f800000000ull) | (x >> 6 & 0x1fc0000000000ull) | (x >> 7 & 0xfe000000000000ull);
+        return len;
+#else
+        return 0;
+#endif
     }
 
-    static int32_t DecodeZigzag32(const uint32_t &v)
+    /**
+     * @brief 逐字节解码p处的Varint，读满max字节即结束
+     * @return 编码长度，到end仍未结束时返回0
+     */
+    static inline size_t DecodeVarintScalar(const uint8_t *p, const uint8_t *end, size_t max, uint64_t &v)
     {
-        return (v >> 1) ^ -(v & 1);
+        uint64_t result = 0;
+        for (size_t i = 0; i < max && p + i < end; ++i)
+        {
+            result |= (uint64_t)(p[i] & 0x7f) << (7 * i);
+            if (p[i] < 0x80 || i + 1 == max)
+            {
+                v = result;
+                return i + 1;
+            }
+        }
+        return 0;
     }
 
-    static int64_t DecodeZigzag64(const uint64_t &v)
+#if defined(__SSE2__)
+    /**
+     * @brief 载入16个值并判断是否都小于128，是则压成16个单字节
+     */
+    static inline bool PackSmall16(const uint32_t *values, __m128i &packed)
     {
-        return (v >> 1) ^ -(v & 1);
+        __m128i a = _mm_loadu_si128((const __m128i *)values);
+        __m128i b = _mm_loadu_si128((const __m128i *)(values + 4));
+        __m128i c = _mm_loadu_si128((const __m128i *)(values + 8));
+        __m128i d = _mm_loadu_si128((const __m128i *)(values + 12));
+        __m128i high = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), _mm_set1_epi32(~0x7f));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) != 0xffff)
+        {
+            return false;
+        }
+        packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        return true;
+    }
+
+    static inline bool PackSmall16(const uint64_t *values, __m128i &packed)
+    {
+        __m128i v[8];
+        __m128i all = _mm_setzero_si128();
+        for (int i = 0; i < 8; ++i)
+        {
+            v[i] = _mm_loadu_si128((const __m128i *)(values + 2 * i));
+            all = _mm_or_si128(all, v[i]);
+        }
+        __m128i high = _mm_and_si128(all, _mm_set1_epi64x(~0x7fll));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) != 0xffff)
+        {
+            return false;
+        }
+        // 取每个64位值的低32位拼成4个32位向量
+        __m128i q[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            q[i] = _mm_unpacklo_epi64(_mm_shuffle_epi32(v[2 * i], _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_epi32(v[2 * i + 1], _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+        packed = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+        return true;
+    }
+
+    /**
+     * @brief 把16个单字节Varint展开写出
+     */
+    static inline void UnpackSmall16(__m128i bytes, uint32_t *values)
+    {
+        __m128i zero = _mm_setzero_si128();
+        __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+        _mm_storeu_si128((__m128i *)values, _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(values + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(values + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i *)(values + 12), _mm_unpackhi_epi16(hi, zero));
     }
 
+    static inline void UnpackSmall16(__m128i bytes, uint64_t *values)
+    {
+        __m128i zero = _mm_setzero_si128();
+        __m128i half[2] = {_mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero)};
+        for (int i = 0; i < 2; ++i)
+        {
+            __m128i lo = _mm_unpacklo_epi16(half[i], zero);
+            __m128i hi = _mm_unpackhi_epi16(half[i], zero);
+            _mm_storeu_si128((__m128i *)(values + 8 * i), _mm_unpacklo_epi32(lo, zero));
+            _mm_storeu_si128((__m128i *)(values + 8 * i + 2), _mm_unpackhi_epi32(lo, zero));
+            _mm_storeu_si128((__m128i *)(values + 8 * i + 4), _mm_unpacklo_epi32(hi, zero));
+            _mm_storeu_si128((__m128i *)(values + 8 * i + 6), _mm_unpackhi_epi32(hi, zero));
+        }
+    }
+#endif
+
     void ByteArray::writeInt32(int32_t value)
     {
         writeUint32(EncodeZigzag32(value));
@@ -132,15 +282,7 @@ namespace lim_webserver
 
     void ByteArray::writeUint32(uint32_t value)
     {
-        uint8_t tmp[5];
-        uint8_t i = 0;
-        while (value >= 0x80)
-        {
-            tmp[i++] = (value & 0x7F) | 0x80;
-            value >>= 7;
-        }
-        tmp[i++] = value;
-        write(tmp, i);
+        writeUint64(value);
     }
 
     void ByteArray::writeInt64(int64_t value)
@@ -150,15 +292,89 @@ namespace lim_webserver
 
     void ByteArray::writeUint64(uint64_t value)
     {
-        uint8_t tmp[10];
-        uint8_t i = 0;
-        while (value >= 0x80)
+        // 当前块剩余空间足够时直接编码到块上，并给写指针留出余量使其不跨块
+        size_t npos = m_writePos.pos % m_baseSize;
+        if (m_writePos.cur->size - npos > VARINT_SLACK)
+        {
+            m_writePos.pos += EncodeVarint((uint8_t *)m_writePos.cur->ptr + npos, value);
+            return;
+        }
+        uint8_t tmp[VARINT_SLACK];
+        write(tmp, EncodeVarint(tmp, value));
+    }
+
+    template <class T>
+    void ByteArray::writeVarintArray(const T *values, size_t count)
+    {
+        // 先编码到栈上，攒满后整段写入
+        const size_t STAGE_SIZE = 4096;
+        uint8_t stage[STAGE_SIZE + VARINT_SLACK];
+        uint8_t *p = stage;
+        size_t i = 0;
+        while (i < count)
         {
-            tmp[i++] = (value & 0x7F) | 0x80;
-            value >>= 7;
+#if defined(__SSE2__)
+            __m128i packed;
+            if (count - i >= 16 && PackSmall16(values + i, packed))
+            {
+                _mm_storeu_si128((__m128i *)p, packed);
+                p += 16;
+                i += 16;
+            }
+            else
+#endif
+            {
+                p += EncodeVarint(p, values[i++]);
+            }
+            if (p - stage >= (ptrdiff_t)STAGE_SIZE)
+            {
+                write(stage, p - stage);
+                p = stage;
+            }
         }
-        tmp[i++] = value;
-        write(tmp, i);
+        write(stage, p - stage);
+    }
+
+    void ByteArray::writeInt32Array(const int32_t *values, size_t count)
+    {
+        uint32_t buf[256];
+        while (count > 0)
+        {
+            size_t n = count < 256 ? count : 256;
+            for (size_t i = 0; i < n; ++i)
+            {
+                buf[i] = EncodeZigzag32(values[i]);
+            }
+            writeVarintArray(buf, n);
+            values += n;
+            count -= n;
+        }
+    }
+
+    void ByteArray::writeUint32Array(const uint32_t *values, size_t count)
+    {
+        writeVarintArray(values, count);
+    }
+
+    void ByteArray::writeInt64Array(const int64_t *values, size_t count)
+    {
+        uint64_t buf[256];
+        while (count > 0)
+        {
+            size_t n = count < 256 ? count : 256;
+            for (size_t i = 0; i < n; ++i)
+            {
+                buf[i] = EncodeZigzag64(values[i]);
+            }
+            writeVarintArray(buf, n);
+            values += n;
+            count -= n;
+        }
+    }
+
+    void ByteArray::writeUint64Array(const uint64_t *values, size_t count)
+    {
+        writeVarintArray(values, count);
     }
 
     void ByteArray::writeFloat(float value)
@@ -259,8 +475,34 @@ namespace lim_webserver
         return DecodeZigzag32(readUint32());
     }
 
+    bool ByteArray::readVarintFast(size_t max, uint64_t &value)
+    {
+        size_t npos = m_readPos.pos % m_baseSize;
+        size_t avail = std::min<size_t>(m_readPos.cur->size - npos, getReadSize());
+        if (avail < sizeof(uint64_t))
+        {
+            return false;
+        }
+        size_t len = DecodeVarintWord((const uint8_t *)m_readPos.cur->ptr + npos, max, value);
+        if (len == 0)
+        {
+            return false;
+        }
+        m_readPos.pos += len;
+        if (npos + len == m_readPos.cur->size)
+        {
+            m_readPos.cur = m_readPos.cur->next;
+        }
+        return true;
+    }
+
     uint32_t ByteArray::readUint32()
     {
+        uint64_t value;
+        if (readVarintFast(5, value))
+        {
+            return value;
+        }
         uint32_t result = 0;
         for (int i = 0; i < 32; i += 7)
         {
@@ -285,6 +527,11 @@ namespace lim_webserver
 
     uint64_t ByteArray::readUint64()
     {
+        uint64_t value;
+        if (readVarintFast(10, value))
+        {
+            return value;
+        }
         uint64_t result = 0;
         for (int i = 0; i < 64; i += 7)
         {
@@ -302,6 +549,80 @@ namespace lim_webserver
         return result;
     }
 
+    template <class T>
+    void ByteArray::readVarintArray(T *values, size_t count)
+    {
+        const size_t max = sizeof(T) == sizeof(uint32_t) ? 5 : 10;
+        size_t n = 0;
+        while (n < count)
+        {
+            // 在当前块内连续可读的区间上直接解码，留足16字节保证整字与SIMD读取不越界
+            size_t npos = m_readPos.pos % m_baseSize;
+            size_t avail = std::min<size_t>(m_readPos.cur->size - npos, getReadSize());
+            const uint8_t *begin = (const uint8_t *)m_readPos.cur->ptr + npos;
+            const uint8_t *end = begin + avail;
+            const uint8_t *p = begin;
+            while (n < count && end - p >= 16)
+            {
+#if defined(__SSE2__)
+                __m128i bytes = _mm_loadu_si128((const __m128i *)p);
+                if (count - n >= 16 && _mm_movemask_epi8(bytes) == 0)
+                {
+                    UnpackSmall16(bytes, values + n);
+                    p += 16;
+                    n += 16;
+                    continue;
+                }
+#endif
+                uint64_t v;
+                size_t len = DecodeVarintWord(p, max, v);
+                if (len == 0)
+                {
+                    len = DecodeVarintScalar(p, end, max, v);
+                }
+                values[n++] = v;
+                p += len;
+            }
+            addReadPosition(p - begin);
+
+            // 块尾不足16字节时逐个读取，跨块的值由逐字节解码拼接
+            if (n < count)
+            {
+                values[n++] = sizeof(T) == sizeof(uint32_t) ? readUint32() : readUint64();
+            }
+        }
+    }
+
+    void ByteArray::readInt32Array(int32_t *values, size_t count)
+    {
+        uint32_t *raw = reinterpret_cast<uint32_t *>(values);
+        readVarintArray(raw, count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = DecodeZigzag32(raw[i]);
+        }
+    }
+
+    void ByteArray::readUint32Array(uint32_t *values, size_t count)
+    {
+        readVarintArray(values, count);
+    }
+
+    void ByteArray::readInt64Array(int64_t *values, size_t count)
+    {
+        uint64_t *raw = reinterpret_cast<uint64_t *>(values);
+        readVarintArray(raw, count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = DecodeZigzag64(raw[i]);
+        }
+    }
+
+    void ByteArray::readUint64Array(uint64_t *values, size_t count)
+    {
+        readVarintArray(values, count);
+    }
+
     float ByteArray::readFloat()
     {
         uint32_t v = readFuint32();
@@ -541,36 +862,28 @@ namespace lim_webserver
         }
         size_t old_cap = getCapacity();
 
-        // 若容量足够则不扩容
-        if (old_cap >= size)
+        // 写满后始终保留至少一个字节的余量，使写指针(以及追上它的读指针)跨过块边界时下一块已经存在
+        if (old_cap > size)
         {
             return;
         }
 
         // 计算需要添加的内存块数
-        size = size - old_cap;
-        size_t count = ceil(1.0 * size / m_baseSize);
+        size_t count = (size - old_cap) / m_baseSize + 1;
 
-        // 以当前写指针为起始
+        // 追加到链表末尾，写指针之后可能还有未写入的块
         Node *tmp = m_writePos.cur;
+        while (tmp->next)
+        {
+            tmp = tmp->next;
+        }
 
-        Node *first = nullptr;
         for (size_t i = 0; i < count; ++i)
         {
             tmp->next = new Node(m_baseSize);
-            if (first == nullptr)
-            {
-                first = tmp->next;
-            }
             tmp = tmp->next;
             m_capacity += m_baseSize;
         }
-
-        // 若老容量已经为空，则直接将写指针所指向的内存指向下一块
-        if (old_cap == 0)
-        {
-            m_writePos.cur = first;
-        }
     }
 
     std::string ByteArray::toString() const
@@ -603,56 +916,53 @@ namespace lim_webserver
         return ss.str();
     }
 
-    uint64_t ByteArray::getReadBuffers(std::vector<iovec> &buffers, uint64_t len) const
+    uint64_t ByteArray::FillBuffers(std::vector<iovec> &buffers, Node *cur, size_t npos, uint64_t len, size_t max_count)
     {
-        len = len > getReadSize() ? getReadSize() : len;
-        if (len == 0)
-        {
-            return 0;
-        }
-
-        uint64_t size = len;
-
-        size_t npos = m_readPos.pos % m_baseSize; // 计算当前节点内的偏移量
-        size_t ncap = m_readPos.cur->size - npos; // 计算当前节点内剩余可读数据长度
-        struct iovec iov;                         // 用于构建每个缓冲区的 iovec 结构体
-        Node *cur = m_readPos.cur;                // 当前节点指针
-
-        while (len > 0)
+        uint64_t size = 0;
+        size_t ncap = cur->size - npos; // 当前节点内剩余长度
+        struct iovec iov;
+        while (len > 0 && max_count > 0)
         {
+            iov.iov_base = cur->ptr + npos;
             if (ncap >= len)
             {
-                // 如果当前节点剩余可读数据足够满足请求
-                iov.iov_base = cur->ptr + npos; // 缓冲区的起始位置
-                iov.iov_len = len;              // 缓冲区的长度
-                len = 0;                        // 已经满足请求，结束循环
+                // 当前节点足够满足请求
+                iov.iov_len = len;
             }
             else
             {
-                // 如果当前节点剩余可读数据不足以满足请求
-                iov.iov_base = cur->ptr + npos; // 缓冲区的起始位置
-                iov.iov_len = ncap;             // 缓冲区的长度为当前节点剩余可读数据长度
-                len -= ncap;                    // 减去已经满足的长度
-                cur = cur->next;                // 移动到下一个节点
-                ncap = cur->size;               // 更新当前节点的可读数据长度
-                npos = 0;                       // 重置偏移量
+                // 当前节点不足，取完后移动到下一个节点
+                iov.iov_len = ncap;
+                cur = cur->next;
+                ncap = cur->size;
+                npos = 0;
             }
-            buffers.push_back(iov); // 将构建好的缓冲区信息添加到向量中
+            len -= iov.iov_len;
+            size += iov.iov_len;
+            buffers.push_back(iov);
+            --max_count;
         }
-        return size; // 返回实际获取的数据长度
+        return size;
     }
 
-    uint64_t ByteArray::getReadBuffers(std::vector<iovec> &buffers, uint64_t len, uint64_t position) const
+    uint64_t ByteArray::getReadBuffers(std::vector<iovec> &buffers, uint64_t len) const
     {
         len = len > getReadSize() ? getReadSize() : len;
         if (len == 0)
         {
             return 0;
         }
+        return FillBuffers(buffers, m_readPos.cur, m_readPos.pos % m_baseSize, len);
+    }
 
-        uint64_t size = len;
+    uint64_t ByteArray::getReadBuffers(std::vector<iovec> &buffers, uint64_t len, uint64_t position) const
+    {
+        len = len > getReadSize() ? getReadSize() : len;
+        if (len == 0)
+        {
+            return 0;
+        }
 
-        size_t npos = position % m_baseSize;
         size_t count = position / m_baseSize;
         Node *cur = m_root;
         while (count > 0)
@@ -660,29 +970,7 @@ namespace lim_webserver
             cur = cur->next;
             --count;
         }
-
-        size_t ncap = cur->size - npos;
-        struct iovec iov;
-        while (len > 0)
-        {
-            if (ncap >= len)
-            {
-                iov.iov_base = cur->ptr + npos;
-                iov.iov_len = len;
-                len = 0;
-            }
-            else
-            {
-                iov.iov_base = cur->ptr + npos;
-                iov.iov_len = ncap;
-                len -= ncap;
-                cur = cur->next;
-                ncap = cur->size;
-                npos = 0;
-            }
-            buffers.push_back(iov);
-        }
-        return size;
+        return FillBuffers(buffers, cur, position % m_baseSize, len);
     }
 
     uint64_t ByteArray::getWriteBuffers(std::vector<iovec> &buffers, uint64_t len)
@@ -694,33 +982,31 @@ namespace lim_webserver
 
         // 确保内存足够
         addCapacity(len);
-        uint64_t size = len;
+        return FillBuffers(buffers, m_writePos.cur, m_writePos.pos % m_baseSize, len);
+    }
 
-        size_t npos = m_writePos.pos % m_baseSize;
-        size_t ncap = m_writePos.cur->size - npos;
-        struct iovec iov;
-        Node *cur = m_writePos.cur;
-        while (len > 0)
+    iovec *ByteArray::getReadIovecs(uint64_t len, size_t &count)
+    {
+        m_iovs.clear();
+        len = len > getReadSize() ? getReadSize() : len;
+        if (len > 0)
         {
-            if (ncap >= len)
-            {
-                iov.iov_base = cur->ptr + npos;
-                iov.iov_len = len;
-                len = 0;
-            }
-            else
-            {
-                iov.iov_base = cur->ptr + npos;
-                iov.iov_len = ncap;
+            FillBuffers(m_iovs, m_readPos.cur, m_readPos.pos % m_baseSize, len, IOV_MAX);
+        }
+        count = m_iovs.size();
+        return m_iovs.data();
+    }
 
-                len -= ncap;
-                cur = cur->next;
-                ncap = cur->size;
-                npos = 0;
-            }
-            buffers.push_back(iov);
+    iovec *ByteArray::getWriteIovecs(uint64_t len, size_t &count)
+    {
+        m_iovs.clear();
+        if (len > 0)
+        {
+            addCapacity(len);
+            FillBuffers(m_iovs, m_writePos.cur, m_writePos.pos % m_baseSize, len, IOV_MAX);
         }
-        return size;
+        count = m_iovs.size();
+        return m_iovs.data();
     }
 
     void ByteArray::addWritePosition(int len)
@@ -4,6 +4,9 @@
 #include <string>
 #include <vector>
 #include <sys/socket.h>
+
+#include "base/BlockPool.h"
+
 namespace lim_webserver
 {
     class SocketStream;
@@ -20,12 +23,18 @@ namespace lim_webserver
         }
 
     public:
+        /**
+         * @brief 内存块节点，节点与数据块均从线程本地的BlockPool申请
+         */
         struct Node
         {
             Node(size_t s);
             Node();
             ~Node();
 
+            static void *operator new(size_t size) { return BlockPool::Alloc(size); }
+            static void operator delete(void *ptr, size_t size) { BlockPool::Dealloc(ptr, size); }
+
             char *ptr;   // 内存块地址指针
             Node *next;  // 下一个内存块地址
             size_t size; // 内存块大小
@@ -98,6 +107,27 @@ namespace lim_webserver
          */
         void writeUint64(uint64_t value);
 
+        /**
+         * @brief 批量写入有符号Varint32类型的数据(zigzag编码)
+         * @details 批量接口先在栈上编码再整段写入，编码按字展开并对全部小于128的分组走SIMD，与逐个写入的结果一致
+         */
+        void writeInt32Array(const int32_t *values, size_t count);
+
+        /**
+         * @brief 批量写入无符号Varint32类型的数据
+         */
+        void writeUint32Array(const uint32_t *values, size_t count);
+
+        /**
+         * @brief 批量写入有符号Varint64类型的数据(zigzag编码)
+         */
+        void writeInt64Array(const int64_t *values, size_t count);
+
+        /**
+         * @brief 批量写入无符号Varint64类型的数据
+         */
+        void writeUint64Array(const uint64_t *values, size_t count);
+
         /**
          * @brief 写入float类型的数据
          */
@@ -217,6 +247,31 @@ namespace lim_webserver
          */
         uint64_t readUint64();
 
+        /**
+         * @brief 批量读取有符号Varint32类型的数据(zigzag编码)
+         * @details 直接在内存块上解码，16字节全为单字节值时用SIMD展开，其余按字解码，跨块的值退回逐个读取
+         * @exception 如果可读数据不足count个 抛出 std::out_of_range
+         */
+        void readInt32Array(int32_t *values, size_t count);
+
+        /**
+         * @brief 批量读取无符号Varint32类型的数据
+         * @exception 如果可读数据不足count个 抛出 std::out_of_range
+         */
+        void readUint32Array(uint32_t *values, size_t count);
+
+        /**
+         * @brief 批量读取有符号Varint64类型的数据(zigzag编码)
+         * @exception 如果可读数据不足count个 抛出 std::out_of_range
+         */
+        void readInt64Array(int64_t *values, size_t count);
+
+        /**
+         * @brief 批量读取无符号Varint64类型的数据
+         * @exception 如果可读数据不足count个 抛出 std::out_of_range
+         */
+        void readUint64Array(uint64_t *values, size_t count);
+
         /**
          * @brief 读取float类型的数据
          * @pre getReadSize() >= sizeof(float)
@@ -327,6 +382,38 @@ namespace lim_webserver
          */
         size_t getSize() const { return m_writePos.pos; }
 
+        /**
+         * @brief 获取可读取的缓存，结果保存在ByteArray内部复用的iovec缓存中，不产生分配
+         * @param[in] len 读取数据的长度,如果len > getReadSize() 则 len = getReadSize()
+         * @param[out] count iovec个数，至多IOV_MAX个
+         * @return 指向内部iovec缓存，下一次获取前有效
+         * @details 配合readv/writev等使用，完成后调用addReadPosition
+         */
+        iovec *getReadIovecs(uint64_t len, size_t &count);
+
+        /**
+         * @brief 获取可写入的缓存，结果保存在ByteArray内部复用的iovec缓存中，不足时先扩容
+         * @param[in] len 写入的长度
+         * @param[out] count iovec个数，至多IOV_MAX个
+         * @return 指向内部iovec缓存，下一次获取前有效
+         * @details 配合readv/recvmsg等使用，完成后调用addWritePosition
+         */
+        iovec *getWriteIovecs(uint64_t len, size_t &count);
+
+        /**
+         * @brief 在getWriteBuffers/getWriteIovecs后使用，确定写入的内容量
+         *
+         * @param len
+         */
+        void addWritePosition(int len);
+
+        /**
+         * @brief 在getReadBuffers/getReadIovecs后使用，确定读取的内容量
+         *
+         * @param len
+         */
+        void addReadPosition(int len);
+
     private:
         /**
          * @brief 扩容ByteArray,使其可以容纳size个数据(如果原本可以可以容纳,则不扩容)
@@ -364,18 +451,30 @@ namespace lim_webserver
         uint64_t getWriteBuffers(std::vector<iovec> &buffers, uint64_t len);
 
         /**
-         * @brief 在getWriteBuffers后使用，确定写入的内容量
-         * 
-         * @param len 
+         * @brief 当前块内连续可读不少于8字节时按字解码一个Varint
+         * @param[in] max 最多占用的字节数，32位为5，64位为10
+         * @return 不满足条件时返回false，由逐字节解码处理
          */
-        void addWritePosition(int len);
+        bool readVarintFast(size_t max, uint64_t &value);
 
         /**
-         * @brief 在getReadBuffers后使用，确定写入的内容量
-         * 
-         * @param len 
+         * @brief 批量Varint编码写入的实现，T为uint32_t或uint64_t
          */
-        void addReadPosition(int len);
+        template <class T>
+        void writeVarintArray(const T *values, size_t count);
+
+        /**
+         * @brief 批量Varint解码读取的实现，T为uint32_t或uint64_t
+         */
+        template <class T>
+        void readVarintArray(T *values, size_t count);
+
+        /**
+         * @brief 从cur的npos处开始，把len长度的数据按内存块拆成iovec追加到buffers
+         * @param[in] max_count 最多追加的iovec个数
+         * @return 实际覆盖的长度
+         */
+        static uint64_t FillBuffers(std::vector<iovec> &buffers, Node *cur, size_t npos, uint64_t len, size_t max_count = ~0ul);
 
     private:
         struct pointer
@@ -392,5 +491,6 @@ namespace lim_webserver
         pointer m_readPos;  // 读指针
         size_t m_capacity;  // 当前的总容量
         Node *m_root;       // 第一个内存块指针
+        std::vector<iovec> m_iovs; // 复用的iovec缓存
     };
 } // namespace lim_webserver
@@ -0,0 +1,307 @@
+#include "ConfigWatcher.h"
+#include "base/Configer.h"
+#include "coroutine/Scheduler.h"
+#include "net/EventLoop.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace lim_webserver
+{
+    static Logger::ptr g_logger = LOG_SYS();
+
+    static ConfigerVar<bool>::ptr g_config_hot_reload =
+        Configer::Lookup("config.hot_reload", false, "watch config files loaded by ConfigWatcher::Load and reload them when they change");
+
+    // 文件写入完成或被rename替换时重新加载
+    static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+    // Load开启的共享监听器，由Shutdown释放；不使用静态对象，避免在静态析构时等待已停止的调度器
+    static Mutex s_shared_mutex;
+    static ConfigWatcher *s_shared_watcher = nullptr;
+
+    /**
+     * @brief 进程内共享的加载调度器，普通处理器，不与网络IO共用线程
+     */
+    static Scheduler *SharedReloadScheduler()
+    {
+        static Scheduler *s_scheduler = []()
+        {
+            Scheduler *scheduler = Scheduler::Create();
+            scheduler->setName("config");
+            scheduler->startInNewThread(1);
+            return scheduler;
+        }();
+        return s_scheduler;
+    }
+
+    bool ConfigWatcher::Load(const std::string &file, Scheduler *scheduler)
+    {
+        try
+        {
+            Configer::LoadFromYaml(file);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR(g_logger) << "load config " << file << " failed: " << e.what();
+            return false;
+        }
+        if (!g_config_hot_reload->getValue())
+        {
+            return true;
+        }
+        Mutex::Lock lock(s_shared_mutex);
+        if (!s_shared_watcher)
+        {
+            s_shared_watcher = new ConfigWatcher(scheduler);
+        }
+        // watch会再解析一次并记录摘要，值未变化的配置项不会再次通知
+        s_shared_watcher->watch(file);
+        s_shared_watcher->start();
+        LOG_INFO(g_logger) << "hot reload enabled for " << file;
+        return true;
+    }
+
+    void ConfigWatcher::Shutdown()
+    {
+        Mutex::Lock lock(s_shared_mutex);
+        if (s_shared_watcher)
+        {
+            delete s_shared_watcher;
+            s_shared_watcher = nullptr;
+        }
+    }
+
+    ConfigWatcher::ConfigWatcher(Scheduler *scheduler, Scheduler *worker)
+        : m_scheduler(scheduler), m_worker(worker), m_inotifyFd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    {
+        if (m_inotifyFd < 0)
+        {
+            LOG_ERROR(g_logger) << "inotify_init1 errno=" << errno << " errstr=" << strerror(errno);
+            return;
+        }
+        m_channel = IoChannel::Create(m_inotifyFd);
+    }
+
+    ConfigWatcher::~ConfigWatcher()
+    {
+        stop();
+        if (m_inotifyFd >= 0)
+        {
+            ::close(m_inotifyFd);
+        }
+    }
+
+    bool ConfigWatcher::watch(const std::string &file)
+    {
+        if (m_inotifyFd < 0 || m_stopping)
+        {
+            return false;
+        }
+
+        size_t pos = file.rfind('/');
+        std::string dir = pos == std::string::npos ? "." : (pos == 0 ? "/" : file.substr(0, pos));
+        // 监听目录而不是文件，编辑器替换文件后监听仍然有效
+        int wd = inotify_add_watch(m_inotifyFd, dir.c_str(), WATCH_MASK);
+        if (wd < 0)
+        {
+            LOG_ERROR(g_logger) << "inotify_add_watch(" << dir << ") errno=" << errno << " errstr=" << strerror(errno);
+            return false;
+        }
+        {
+            MutexType::Lock lock(m_mutex);
+            m_dirs[wd] = dir;
+            m_files.emplace(file, 0);
+        }
+        return reload(file);
+    }
+
+    void ConfigWatcher::start()
+    {
+        if (m_inotifyFd < 0 || m_started)
+        {
+            return;
+        }
+        {
+            MutexType::Lock lock(m_mutex);
+            if (m_dirs.empty())
+            {
+                LOG_WARN(g_logger) << "ConfigWatcher start without any watched file";
+                return;
+            }
+        }
+        m_started = true;
+        m_scheduler->createTask([this]()
+                                { run(); });
+    }
+
+    void ConfigWatcher::stop()
+    {
+        if (m_stopping.exchange(true))
+        {
+            return;
+        }
+        // 移除监听会产生IN_IGNORED事件，由事件循环唤醒监听协程，协程看到停止标志后退出
+        {
+            MutexType::Lock lock(m_mutex);
+            for (auto &i : m_dirs)
+            {
+                inotify_rm_watch(m_inotifyFd, i.first);
+            }
+            m_dirs.clear();
+        }
+        // 监听协程等待着本轮加载，在加载回调中等待它退出会互相等待；调度器已停止时监听协程不会再运行
+        Task *task = Processor::GetCurrentTask();
+        if (m_started && m_scheduler->isRunning() && (!task || (task != m_task.load() && task != m_reloadTask.load())))
+        {
+            m_exited.wait();
+        }
+    }
+
+    bool ConfigWatcher::reload(const std::string &file)
+    {
+        std::ifstream ifs(file);
+        if (!ifs)
+        {
+            LOG_ERROR(g_logger) << "reload config " << file << " open failed";
+            return false;
+        }
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        std::string content = ss.str();
+        size_t digest = std::hash<std::string>()(content);
+        {
+            MutexType::Lock lock(m_mutex);
+            auto it = m_files.find(file);
+            if (it != m_files.end() && it->second == digest)
+            {
+                return false;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            YAML::Node root = YAML::Load(content);
+            // 每个ConfigerVar各自比较新旧值，未变化的不会通知监听者
+            Configer::LoadFromYaml(root);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR(g_logger) << "reload config " << file << " failed, keep the old config: " << e.what();
+            return false;
+        }
+        std::chrono::duration<double, std::milli> cost = std::chrono::steady_clock::now() - start;
+
+        {
+            MutexType::Lock lock(m_mutex);
+            m_files[file] = digest;
+        }
+        ++m_reloadCount;
+        LOG_INFO(g_logger) << "reload config " << file << " cost " << cost.count() << "ms";
+        return true;
+    }
+
+    void ConfigWatcher::collect(const char *buf, size_t len, std::vector<std::string> &changed)
+    {
+        MutexType::Lock lock(m_mutex);
+        for (size_t offset = 0; offset < len;)
+        {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(buf + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+            if (!(event->mask & WATCH_MASK) || event->len == 0)
+            {
+                continue;
+            }
+            auto dir = m_dirs.find(event->wd);
+            if (dir == m_dirs.end())
+            {
+                continue;
+            }
+            std::string path = dir->second == "/" ? "/" + std::string(event->name) : dir->second + "/" + event->name;
+            if (path.compare(0, 2, "./") == 0 && m_files.count(path) == 0)
+            {
+                path = path.substr(2);
+            }
+            if (m_files.count(path) && std::find(changed.begin(), changed.end(), path) == changed.end())
+            {
+                changed.push_back(path);
+            }
+        }
+    }
+
+    void ConfigWatcher::run()
+    {
+        m_task = Processor::GetCurrentTask();
+        EventLoop *loop = dynamic_cast<EventLoop *>(Processor::GetCurrentProcessor());
+        if (!loop)
+        {
+            LOG_ERROR(g_logger) << "ConfigWatcher must run in a net scheduler";
+            m_exited.notify();
+            return;
+        }
+
+        alignas(struct inotify_event) char buf[4096];
+        std::vector<std::string> changed;
+        while (!m_stopping)
+        {
+            ssize_t n = ::read(m_inotifyFd, buf, sizeof(buf));
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno != EAGAIN)
+                {
+                    LOG_ERROR(g_logger) << "read inotify errno=" << errno << " errstr=" << strerror(errno);
+                    break;
+                }
+                // 边沿触发，已读空后挂起等待新事件
+                m_channel->addEvent(IoEvent::READ);
+                loop->updateChannel(m_channel);
+                Processor::CoHold();
+                continue;
+            }
+
+            // 一批事件中同一文件的多次改动只加载一次
+            changed.clear();
+            collect(buf, n, changed);
+            if (changed.empty())
+            {
+                continue;
+            }
+            // 解析与变更回调交给加载调度器执行，监听协程挂起等待，不阻塞本事件循环上的IO
+            CoSemaphore done;
+            Scheduler *worker = m_worker ? m_worker : SharedReloadScheduler();
+            worker->createTask([this, &changed, &done]()
+                               {
+                                   m_reloadTask = Processor::GetCurrentTask();
+                                   for (auto &file : changed)
+                                   {
+                                       if (m_stopping)
+                                       {
+                                           break;
+                                       }
+                                       reload(file);
+                                   }
+                                   m_reloadTask = nullptr;
+                                   done.notify(); });
+            done.wait();
+        }
+
+        if (loop->hasChannel(m_channel))
+        {
+            m_channel->clearEvent();
+            loop->removeChannel(m_channel);
+        }
+        m_exited.notify();
+    }
+
+} // namespace lim_webserver
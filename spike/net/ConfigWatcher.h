@@ -0,0 +1,120 @@
+#pragma once
+
+#include "base/Mutex.h"
+#include "base/Noncopyable.h"
+#include "coroutine/CoSync.h"
+#include "net/IoChannel.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lim_webserver
+{
+    class Scheduler;
+
+    /**
+     * @brief 配置文件热加载
+     *
+     * @details 在网络调度器上运行一个监听协程，通过inotify监听配置文件所在目录，
+     *          文件写入完成或被替换(编辑器常见的先写临时文件再rename)后，交给普通调度器上的协程重新解析并加载，
+     *          YAML解析与配置变更回调不占用事件循环，监听协程只挂起等待加载完成。
+     *          内容未变化的文件不会重新加载，解析失败时保留原配置；
+     *          加载时逐个ConfigerVar比较，只有值发生变化的配置项才会通知监听者。
+     *          请求处理线程通过ConfigerVar::get无锁读取配置，不受重新加载影响。
+     *
+     *          热加载需要显式开启：启动时经Load加载配置文件，config.hot_reload为true时(可在该文件中设置)
+     *          由进程内共享的监听器继续监听，停止调度器前调用Shutdown；也可以自行创建监听器并调用watch与start。
+     */
+    class ConfigWatcher : Noncopyable
+    {
+    public:
+        using ptr = std::shared_ptr<ConfigWatcher>;
+        using MutexType = Mutex;
+
+        /**
+         * @param scheduler 运行监听协程的调度器，须由Scheduler::CreateNetScheduler创建
+         * @param worker 执行重新加载的调度器，须比监听器存活更久；为空时使用进程内共享的加载调度器
+         */
+        static ptr Create(Scheduler *scheduler, Scheduler *worker = nullptr) { return std::make_shared<ConfigWatcher>(scheduler, worker); }
+
+        /**
+         * @brief 加载配置文件，config.hot_reload为true时交由进程内共享的监听器监听其变化
+         *
+         * @param scheduler 运行监听协程的网络调度器，首次开启监听时使用
+         * @return 是否加载成功
+         */
+        static bool Load(const std::string &file, Scheduler *scheduler);
+
+        /**
+         * @brief 停止并释放Load开启的共享监听器，须在停止其调度器之前调用
+         */
+        static void Shutdown();
+
+    public:
+        explicit ConfigWatcher(Scheduler *scheduler, Scheduler *worker = nullptr);
+        ~ConfigWatcher();
+
+        /**
+         * @brief 加载配置文件并监听其变化
+         *
+         * @return false 无法监听或首次加载失败；首次加载失败时仍会监听，修正文件后自动加载
+         */
+        bool watch(const std::string &file);
+
+        /**
+         * @brief 在调度器中启动监听协程
+         */
+        void start();
+
+        /**
+         * @brief 停止监听，等待监听协程退出
+         *
+         * @details 在协程中调用时只挂起当前协程，可以在监听协程所在的事件循环上调用；
+         *          在配置变更的回调里调用时不等待，监听协程在本轮加载结束后退出；
+         *          调度器已停止时监听协程不会再运行，同样不等待
+         */
+        void stop();
+
+        /**
+         * @brief 立即重新加载文件，内容未变化时跳过
+         *
+         * @return true 文件内容有变化且加载成功
+         */
+        bool reload(const std::string &file);
+
+        /**
+         * @brief 成功加载的次数，包括首次加载
+         */
+        inline uint64_t getReloadCount() const { return m_reloadCount.load(std::memory_order_relaxed); }
+
+    private:
+        /**
+         * @brief 监听协程
+         */
+        void run();
+
+        /**
+         * @brief 解析一批inotify事件，得到被改动的已监听文件
+         */
+        void collect(const char *buf, size_t len, std::vector<std::string> &changed);
+
+    private:
+        Scheduler *m_scheduler;                          // 运行监听协程的调度器
+        Scheduler *m_worker;                             // 执行重新加载的调度器
+        int m_inotifyFd;                                 // inotify句柄
+        IoChannel::ptr m_channel;                        // inotify句柄对应的channel
+        MutexType m_mutex;                               // 保护目录与文件表
+        std::unordered_map<int, std::string> m_dirs;     // 监听描述符 -> 目录
+        std::unordered_map<std::string, size_t> m_files; // 文件路径 -> 上次加载内容的摘要
+        std::atomic<bool> m_started{false};              // 监听协程是否已启动
+        std::atomic<bool> m_stopping{false};             // 是否正在停止
+        std::atomic<uint64_t> m_reloadCount{0};          // 成功加载的次数
+        std::atomic<Task *> m_task{nullptr};             // 监听协程
+        std::atomic<Task *> m_reloadTask{nullptr};       // 正在执行重新加载的协程
+        CoSemaphore m_exited;                            // 监听协程退出
+    };
+
+} // namespace lim_webserver
@@ -3,6 +3,7 @@
 #include "coroutine.h"
 #include "splog.h"
 
+#include <algorithm>
 #include <fcntl.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
@@ -51,6 +52,9 @@ namespace lim_webserver
 
     void EventLoop::idle()
     {
+        // 在poll之前清扫：此时上一轮被IO唤醒的协程都已运行过并摘下了等待标记，不会被重复唤醒
+        m_idleManager.sweep();
+
         // 若在企图休眠前接受到了调度器的通知，则不休眠
         if (m_notified)
         {
@@ -58,12 +62,24 @@ namespace lim_webserver
             return;
         }
 
-        // 进入等待状态
+        // 有受管理的连接时最多睡到下次清扫
+        int timeout = m_idleManager.nextSweepTimeout();
         m_idled = true;
-        m_poller->poll(10000);
+        m_poller->poll(timeout < 0 ? 10000 : std::min(timeout, 10000));
         m_idled = false;
     }
 
     bool EventLoop::stopping() { return Processor::stopping(); }
 
+    void EventLoop::initMetrics(const MetricLabels &labels)
+    {
+        Processor::initMetrics(labels);
+        m_poller->initMetrics(labels);
+        MetricsRegistry *registry = MetricsRegistry::GetInstance();
+        registry->gauge("spnet_eventloop_idle_connections", "Connections waiting for data under idle timeout management", labels,
+                        [this]() { return (int64_t)m_idleManager.getIdleCount(); });
+        registry->gauge("spnet_eventloop_active_connections", "Managed connections not currently waiting for data", labels,
+                        [this]() { return (int64_t)m_idleManager.getActiveCount(); });
+    }
+
 } // namespace lim_webserver
@@ -2,6 +2,7 @@
 
 #include "base/Mutex.h"
 #include "base/Singleton.h"
+#include "net/IdleManager.h"
 #include "net/IoChannel.h"
 #include "net/Poller.h"
 #include "coroutine/Processor.h"
@@ -23,6 +24,11 @@ namespace lim_webserver
 
         inline bool hasChannel(IoChannel::ptr channel) const { return m_poller->hasChannel(channel); }
 
+        /**
+         * @brief 本循环的空闲连接管理器
+         */
+        inline IdleManager &idleManager() { return m_idleManager; }
+
     protected:
         /**
          * @brief 唤醒
@@ -44,8 +50,14 @@ namespace lim_webserver
          */
         bool stopping() override;
 
+        /**
+         * @brief 在处理器指标之外注册poller与空闲连接的指标
+         */
+        void initMetrics(const MetricLabels &labels) override;
+
     private:
         Poller::ptr m_poller;  // IO模块
+        IdleManager m_idleManager{this}; // 空闲连接管理
         int m_wakeFd;
     };
 } // namespace lim_webserver
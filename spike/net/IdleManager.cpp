@@ -0,0 +1,215 @@
+#include "IdleManager.h"
+#include "EventLoop.h"
+#include "coroutine/FdInfo.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <sys/epoll.h>
+#include <time.h>
+#include <vector>
+
+namespace lim_webserver
+{
+    static Logger::ptr g_logger = LOG_SYS();
+
+    // 清扫间隔，单位：毫秒
+    static const uint64_t SWEEP_INTERVAL = 1000;
+
+    uint64_t IdleManager::NowMS()
+    {
+        // 粗粒度时钟走vDSO且不读TSC，精度为一个时钟节拍，对秒级的清扫足够
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return ts.tv_sec * 1000ul + ts.tv_nsec / 1000000;
+    }
+
+    IdleManager::IdleManager(EventLoop *loop) : m_loop(loop) {}
+
+    IdleManager::~IdleManager()
+    {
+        MutexType::Lock lock(m_mutex);
+        while (m_head)
+        {
+            m_head->m_idleOwner = nullptr;
+            unlink(m_head);
+        }
+    }
+
+    void IdleManager::link(FdInfo *info)
+    {
+        info->m_idlePrev = m_tail;
+        info->m_idleNext = nullptr;
+        if (m_tail)
+        {
+            m_tail->m_idleNext = info;
+        }
+        else
+        {
+            m_head = info;
+        }
+        m_tail = info;
+        info->m_idleLinked = true;
+        m_idleCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void IdleManager::unlink(FdInfo *info)
+    {
+        if (info->m_idlePrev)
+        {
+            info->m_idlePrev->m_idleNext = info->m_idleNext;
+        }
+        else
+        {
+            m_head = info->m_idleNext;
+        }
+        if (info->m_idleNext)
+        {
+            info->m_idleNext->m_idlePrev = info->m_idlePrev;
+        }
+        else
+        {
+            m_tail = info->m_idlePrev;
+        }
+        info->m_idlePrev = info->m_idleNext = nullptr;
+        info->m_idleLinked = false;
+        m_idleCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void IdleManager::beginWait(FdInfo *info)
+    {
+        if (info->m_idleOwner && info->m_idleOwner != this)
+        {
+            info->m_idleOwner->remove(info);
+        }
+        uint64_t now = NowMS();
+        MutexType::Lock lock(m_mutex);
+        if (!info->m_idleOwner)
+        {
+            info->m_idleOwner = this;
+            m_trackedCount.fetch_add(1, std::memory_order_relaxed);
+            addTimeout(info->m_idleTimeout);
+            info->m_idleRegistered = info->m_idleTimeout;
+        }
+        else if (info->m_idleRegistered != info->m_idleTimeout)
+        {
+            // 受管理期间改过超时
+            removeTimeout(info->m_idleRegistered);
+            addTimeout(info->m_idleTimeout);
+            info->m_idleRegistered = info->m_idleTimeout;
+        }
+        if (info->m_idleLinked)
+        {
+            unlink(info);
+        }
+        info->m_idleSince = now;
+        info->m_idleExpired = false;
+        link(info);
+    }
+
+    void IdleManager::endWait(FdInfo *info)
+    {
+        MutexType::Lock lock(m_mutex);
+        if (info->m_idleOwner == this && info->m_idleLinked)
+        {
+            unlink(info);
+        }
+    }
+
+    void IdleManager::remove(FdInfo *info)
+    {
+        MutexType::Lock lock(m_mutex);
+        if (info->m_idleOwner != this)
+        {
+            return;
+        }
+        if (info->m_idleLinked)
+        {
+            unlink(info);
+        }
+        info->m_idleOwner = nullptr;
+        m_trackedCount.fetch_sub(1, std::memory_order_relaxed);
+        removeTimeout(info->m_idleRegistered);
+    }
+
+    void IdleManager::addTimeout(uint64_t timeout)
+    {
+        ++m_timeouts[timeout];
+        m_minTimeout = m_timeouts.begin()->first;
+    }
+
+    void IdleManager::removeTimeout(uint64_t timeout)
+    {
+        auto it = m_timeouts.find(timeout);
+        if (it != m_timeouts.end() && --it->second == 0)
+        {
+            m_timeouts.erase(it);
+        }
+        m_minTimeout = m_timeouts.empty() ? UINT64_MAX : m_timeouts.begin()->first;
+    }
+
+    int IdleManager::nextSweepTimeout()
+    {
+        // 受管理的连接都在处理中(如处理函数睡眠或阻塞在写)时没有需要清扫的，开始读等待的连接在本线程登记，下一轮poll前会重新计算
+        if (m_idleCount.load(std::memory_order_relaxed) == 0)
+        {
+            return -1;
+        }
+        uint64_t now = NowMS();
+        return m_nextSweep > now ? m_nextSweep - now : 0;
+    }
+
+    void IdleManager::sweep()
+    {
+        uint64_t now = NowMS();
+        if (now < m_nextSweep)
+        {
+            return;
+        }
+        // 链表为空时同样推迟下次清扫，否则nextSweepTimeout一直为0，事件循环空转
+        m_nextSweep = now + SWEEP_INTERVAL;
+        if (m_idleCount.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+
+        // 链表按开始等待的时间有序，等待时长不足最小超时的部分无需检查
+        std::vector<int> expired;
+        {
+            MutexType::Lock lock(m_mutex);
+            FdInfo *info = m_head;
+            while (info && now - info->m_idleSince >= m_minTimeout)
+            {
+                FdInfo *next = info->m_idleNext;
+                if (now - info->m_idleSince >= info->m_idleTimeout)
+                {
+                    unlink(info);
+                    info->m_idleExpired = true;
+                    expired.push_back(info->fd());
+                }
+                info = next;
+            }
+        }
+
+        // 锁外按句柄重新取得FdInfo，期间被关闭或复用的句柄不带超时标记，直接跳过
+        for (int fd : expired)
+        {
+            FdInfo::ptr info = FdManager::GetInstance()->get(fd);
+            if (!info || !info->m_idleExpired)
+            {
+                continue;
+            }
+            info->trigger(EPOLLIN);
+            if (info->isReading())
+            {
+                info->cancelEvent(IoEvent::READ);
+                m_loop->updateChannel(info);
+            }
+        }
+        if (!expired.empty())
+        {
+            LOG_DEBUG(g_logger) << "idle sweep expired " << expired.size() << " connections, idle=" << getIdleCount()
+                                << " active=" << getActiveCount();
+        }
+    }
+
+} // namespace lim_webserver
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "base/Mutex.h"
+#include "base/Noncopyable.h"
+
+#include <atomic>
+#include <map>
+#include <stdint.h>
+
+namespace lim_webserver
+{
+    class EventLoop;
+    class FdInfo;
+
+    /**
+     * @brief 事件循环的空闲连接管理器
+     *
+     * @details 设置了空闲超时的套接字在读阻塞时按开始等待的时间挂到侵入式LRU链表尾部，唤醒后摘下，
+     *          读等待不再逐次创建和取消定时器。事件循环每秒清扫一次链表头部，等待超过空闲超时的连接
+     *          被唤醒并以ETIMEDOUT返回，由处理协程关闭会话，因此超时精度为1秒。
+     *
+     *          链表只由所属事件循环的线程修改，仅连接在其他线程析构时需要跨线程摘除，故用自旋锁保护。
+     */
+    class IdleManager : public Noncopyable
+    {
+    public:
+        using MutexType = Spinlock;
+
+        explicit IdleManager(EventLoop *loop);
+        ~IdleManager();
+
+        /**
+         * @brief 连接开始等待读，登记为空闲并移到链表尾部
+         */
+        void beginWait(FdInfo *info);
+
+        /**
+         * @brief 连接被IO事件唤醒，从链表摘下，转为活跃
+         */
+        void endWait(FdInfo *info);
+
+        /**
+         * @brief 连接关闭，不再受管理
+         */
+        void remove(FdInfo *info);
+
+        /**
+         * @brief 距上次清扫满1秒时唤醒所有等待超时的连接，在事件循环线程调用
+         */
+        void sweep();
+
+        /**
+         * @brief 下次清扫前剩余的毫秒数，没有等待读的连接时返回-1
+         */
+        int nextSweepTimeout();
+
+        /**
+         * @brief 正在等待对端数据的连接数
+         */
+        inline size_t getIdleCount() const { return m_idleCount.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief 正在处理中的连接数
+         */
+        inline size_t getActiveCount() const
+        {
+            return m_trackedCount.load(std::memory_order_relaxed) - m_idleCount.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 粗粒度的单调时钟，单位：毫秒
+         */
+        static uint64_t NowMS();
+
+    private:
+        void link(FdInfo *info);
+
+        void unlink(FdInfo *info);
+
+        /**
+         * @brief 登记或注销一个受管理连接的超时，维护最小超时，需持有锁
+         */
+        void addTimeout(uint64_t timeout);
+
+        void removeTimeout(uint64_t timeout);
+
+    private:
+        EventLoop *m_loop;
+        FdInfo *m_head = nullptr;                 // 等待最久的连接
+        FdInfo *m_tail = nullptr;                 // 最近开始等待的连接
+        uint64_t m_minTimeout = UINT64_MAX;       // 受管理连接的最小空闲超时
+        std::map<uint64_t, size_t> m_timeouts;    // 受管理连接的空闲超时及其连接数
+        uint64_t m_nextSweep = 0;                 // 下次清扫时间
+        std::atomic<size_t> m_idleCount{0};       // 链表中的连接数
+        std::atomic<size_t> m_trackedCount{0};    // 受管理的连接数
+        MutexType m_mutex;
+    };
+
+} // namespace lim_webserver
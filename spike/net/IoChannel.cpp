@@ -32,9 +32,15 @@ namespace lim_webserver
         // 读操作   紧急读操作  关闭写半部分 写操作
         if (op & (EPOLLIN | EPOLLPRI | EPOLLRDHUP | EPOLLOUT))
         {
-            if (m_task)
+            // 一次登记只唤醒一次：协程被唤醒后可能已转去等待定时器或结束，之后的事件不能再唤醒它
+            Task *task = nullptr;
             {
-                m_task->wake();
+                MutexType::Lock lock(m_mutex);
+                std::swap(task, m_task);
+            }
+            if (task)
+            {
+                task->wake();
             }
         }
     }
@@ -44,18 +50,17 @@ namespace lim_webserver
     bool IoChannel::addEvent(IoEvent event)
     {
         MutexType::Lock lock(m_mutex);
-        // 存在则跳过
-        if (m_events & event)
-        {
-            return false;
-        }
-
-        // 若在协程中则记录
+        // 若在协程中则记录，事件已存在时也要重新登记等待的协程
         Task *task = Processor::GetCurrentTask();
         if (task)
         {
             m_task = task;
         }
+        // 存在则跳过
+        if (m_events & event)
+        {
+            return false;
+        }
         m_events = m_events | event;
         return true;
     }
@@ -38,6 +38,7 @@ namespace lim_webserver
         /**
          * @brief 触发协程
          *
+         * @details 唤醒最近一次addEvent登记的协程并清除登记，一次登记只唤醒一次
          */
         void trigger(uint32_t op);
 
@@ -80,7 +81,9 @@ namespace lim_webserver
         /**
          * @brief 添加event
          *
+         * @details 在协程中调用时登记当前协程为等待者，event已存在时也会重新登记
          * @param event
+         * @return 是否新增了event
          */
         bool addEvent(IoEvent event);
 
@@ -89,6 +89,8 @@ namespace lim_webserver
         LOG_TRACE(g_logger) << "current fd total count " << m_channel_map.size();
         int n = ::epoll_wait(m_epfd, &*m_event_vec.begin(), m_event_vec.size(), ms);
         int savedErrno = errno;
+        m_waitCounter->inc();
+        m_eventsPerWait->record(n > 0 ? n : 0);
         // 若有则触发
         if (n > 0)
         {
@@ -141,6 +143,14 @@ namespace lim_webserver
         epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &event);
     }
 
+    void EpollPoller::initMetrics(const MetricLabels &labels)
+    {
+        MetricsRegistry *registry = MetricsRegistry::GetInstance();
+        m_waitCounter = registry->counter("spnet_epoll_waits_total", "Calls to epoll_wait", labels);
+        m_eventsPerWait = registry->histogram("spnet_epoll_events_per_wait", "Events returned by one epoll_wait, including the wakeup eventfd",
+                                              labels, 1, MetricsRegistry::CountBounds());
+    }
+
     void EpollPoller::update(int op, IoChannel::ptr channel)
     {
         struct epoll_event ev;
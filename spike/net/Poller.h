@@ -1,5 +1,6 @@
 #pragma once
 
+#include "base/Metrics.h"
 #include "base/Mutex.h"
 #include "base/Noncopyable.h"
 #include "net/IoChannel.h"
@@ -40,6 +41,13 @@ namespace lim_webserver
 
         virtual void bindEventFd(int fd) = 0;
 
+        /**
+         * @brief 注册指标，在所属事件循环开始poll前调用
+         *
+         * @param labels 调度器名与处理器编号
+         */
+        virtual void initMetrics(const MetricLabels &labels) {}
+
     protected:
         int m_wakefd;             // 唤醒句柄
         ChannelMap m_channel_map; // 管理的所有channel
@@ -68,6 +76,8 @@ namespace lim_webserver
 
         void bindEventFd(int fd) override;
 
+        void initMetrics(const MetricLabels &labels) override;
+
     private:
         /**
          * @brief 修改Fd的行为
@@ -82,5 +92,8 @@ namespace lim_webserver
     private:
         int m_epfd;                           // 文件句柄
         std::vector<epoll_event> m_event_vec; // epoll事件vec
+
+        MetricCounter *m_waitCounter = nullptr;    // epoll_wait次数
+        MetricHistogram *m_eventsPerWait = nullptr; // 每次epoll_wait返回的IO事件数
     };
 } // namespace lim_webserver
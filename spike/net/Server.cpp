@@ -1,38 +1,104 @@
 #include "Server.h"
+#include "base/Affinity.h"
 #include "base/Configer.h"
+#include "base/Trace.h"
+#include "coroutine/Hook.h"
 #include "splog.h"
 
+#include <linux/filter.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 namespace lim_webserver
 {
     static Logger::ptr g_logger = LOG_SYS();
 
     static ConfigerVar<uint64_t>::ptr g_tcp_server_read_timeout =
-        Configer::Lookup("tcp_server.read_timeout", (uint64_t)(60 * 1000 * 2), "tcp server read timeout");
+        Configer::Lookup("tcp_server.read_timeout", (uint64_t)(60 * 1000 * 2), "idle timeout of server connections waiting for data, swept once per second");
+
+    static ConfigerVar<bool>::ptr g_tcp_server_reuseport =
+        Configer::Lookup("tcp_server.reuseport", false, "tcp server listen with SO_REUSEPORT on every worker processor");
+
+    static ConfigerVar<bool>::ptr g_tcp_server_reuseport_cbpf =
+        Configer::Lookup("tcp_server.reuseport_cbpf", true, "steer reuseport connections to the listener of the processor on the receiving cpu");
+
+    static ConfigerVar<uint64_t>::ptr g_tcp_server_accept_batch =
+        Configer::Lookup("tcp_server.accept_batch", (uint64_t)64, "max connections accepted per wakeup of the accept task");
+
+    static ConfigerVar<uint64_t>::ptr g_tcp_server_max_connections =
+        Configer::Lookup("tcp_server.max_connections", (uint64_t)0, "max concurrent connections, 0 for unlimited");
+
+    static ConfigerVar<long>::ptr g_tcp_server_accept_rate =
+        Configer::Lookup("tcp_server.accept_rate", 0L, "max accepted connections per second, 0 for unlimited");
 
-    TcpServer::TcpServer(Scheduler *worker, Scheduler *accepter) : m_accepter(accepter), m_worker(worker), m_recvTimeout(g_tcp_server_read_timeout->getValue())
+    static ConfigerVar<long>::ptr g_tcp_server_accept_burst =
+        Configer::Lookup("tcp_server.accept_burst", 0L, "accept rate burst, 0 for the same as accept_rate");
+
+    // 句柄耗尽时accept协程的退避时间，单位：毫秒
+    static const uint64_t ACCEPT_BACKOFF = 10;
+
+    // 拒绝连接后等待对端关闭的时间(单位：毫秒)、最多丢弃的字节数与同时等待的连接数
+    static const uint64_t LINGER_TIMEOUT = 1000;
+    static const size_t LINGER_MAX_BYTES = 64 * 1024;
+    static const uint64_t LINGER_MAX_CONNECTIONS = 1024;
+
+    TcpServer::TcpServer(Scheduler *worker, Scheduler *accepter)
+        : m_accepter(accepter), m_worker(worker), m_recvTimeout(g_tcp_server_read_timeout->getValue()), m_reusePort(g_tcp_server_reuseport->get()),
+          m_acceptBatch(std::max<uint64_t>(g_tcp_server_accept_batch->get(), 1)), m_maxConnections(g_tcp_server_max_connections->get())
     {
+        m_acceptLimiter.setRate(g_tcp_server_accept_rate->get(), g_tcp_server_accept_burst->get());
     }
 
     TcpServer::~TcpServer() { stop(); }
 
+    Socket::ptr TcpServer::createListener(Address::ptr addr)
+    {
+        Socket::ptr sock = Socket::CreateTCP(addr);
+        if (m_reusePort && !sock->setOption(SOL_SOCKET, SO_REUSEPORT, 1))
+        {
+            LOG_ERROR(g_logger) << "setsockopt SO_REUSEPORT fail errno=" << errno << " errstr=" << strerror(errno);
+            return nullptr;
+        }
+        if (!sock->bind(addr))
+        {
+            LOG_ERROR(g_logger) << "bind fail errno=" << errno << " errstr=" << strerror(errno) << " addr=[" << addr->toString() << "]";
+            return nullptr;
+        }
+        if (!sock->listen())
+        {
+            LOG_ERROR(g_logger) << "listen fail errno=" << errno << " errstr=" << strerror(errno) << " addr=[" << addr->toString() << "]";
+            return nullptr;
+        }
+        return sock;
+    }
+
+    bool TcpServer::loadCertificates(const std::string &cert_file, const std::string &key_file)
+    {
+        SslContext::ptr ctx = SslContext::CreateServer(cert_file, key_file);
+        if (!ctx)
+        {
+            return false;
+        }
+        m_sslCtx = ctx;
+        return true;
+    }
+
     bool TcpServer::bind(Address::ptr addr, bool ssl)
     {
+        if (ssl && !m_sslCtx)
+        {
+            LOG_ERROR(g_logger) << "name=" << m_name << " bind ssl without certificates, call loadCertificates or setSslContext first";
+            return false;
+        }
         std::vector<Address::ptr> addrs;
         std::vector<Address::ptr> fails;
         addrs.push_back(addr);
         m_ssl = ssl;
         for (auto &addr : addrs)
         {
-            Socket::ptr sock = Socket::CreateTCP(addr);
-            if (!sock->bind(addr))
-            {
-                LOG_ERROR(g_logger) << "bind fail errno=" << errno << " errstr=" << strerror(errno) << " addr=[" << addr->toString() << "]";
-                fails.push_back(addr);
-                continue;
-            }
-            if (!sock->listen())
+            Socket::ptr sock = createListener(addr);
+            if (!sock)
             {
-                LOG_ERROR(g_logger) << "listen fail errno=" << errno << " errstr=" << strerror(errno) << " addr=[" << addr->toString() << "]";
                 fails.push_back(addr);
                 continue;
             }
@@ -47,7 +113,7 @@ namespace lim_webserver
 
         for (auto &socket : m_socket_vec)
         {
-            LOG_INFO(g_logger) << " name=" << m_name << " ssl=" << m_ssl << " server bind success: " << socket->localAddress()->toString();
+            LOG_INFO(g_logger) << " name=" << m_name << " ssl=" << m_ssl << " reuseport=" << m_reusePort << " server bind success: " << socket->localAddress()->toString();
         }
         return true;
     }
@@ -55,9 +121,70 @@ namespace lim_webserver
     void TcpServer::start()
     {
         m_started = true;
-        for (auto socket : m_socket_vec)
+        if (!m_reusePort)
         {
-            m_accepter->createTask([this, socket] { this->accept(socket); });
+            for (auto socket : m_socket_vec)
+            {
+                m_accepter->createTask([this, socket] { this->accept(socket); });
+            }
+            return;
+        }
+
+        // 每个处理器一个监听套接字，bind时创建的作为第0个
+        size_t count = std::max<size_t>(m_worker->processorCount(), 1);
+        std::vector<Socket::ptr> primaries = m_socket_vec;
+        for (auto &primary : primaries)
+        {
+            std::vector<Socket::ptr> group{primary};
+            Address::ptr addr = primary->localAddress();
+            for (size_t i = 1; i < count; ++i)
+            {
+                Socket::ptr sock = createListener(addr);
+                if (!sock)
+                {
+                    break;
+                }
+                group.push_back(sock);
+                m_socket_vec.push_back(sock);
+            }
+            if (g_tcp_server_reuseport_cbpf->get())
+            {
+                attachSteering(group);
+            }
+            // 在处理器i上accept的连接由addTask调度在同一处理器上处理
+            for (size_t i = 0; i < group.size(); ++i)
+            {
+                Socket::ptr socket = group[i];
+                m_worker->createTask([this, socket] { this->accept(socket); }, i);
+            }
+            LOG_INFO(g_logger) << " name=" << m_name << " reuseport listeners=" << group.size() << " addr=" << addr->toString();
+        }
+    }
+
+    void TcpServer::attachSteering(const std::vector<Socket::ptr> &group)
+    {
+        if (group.size() < 2)
+        {
+            return;
+        }
+        // A = 收到连接的CPU；若为某个处理器绑定的CPU则返回其编号，否则按 CPU % 监听数 分配
+        std::vector<sock_filter> code;
+        code.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)));
+        std::vector<int> cpus = CpuAffinity::SchedulerCpus(m_worker->name());
+        for (size_t i = 0; i < group.size() && !cpus.empty(); ++i)
+        {
+            code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (uint32_t)cpus[i % cpus.size()], 0, 1));
+            code.push_back(BPF_STMT(BPF_RET | BPF_K, (uint32_t)i));
+        }
+        code.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32_t)group.size()));
+        code.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+
+        sock_fprog prog;
+        prog.len = code.size();
+        prog.filter = code.data();
+        if (!group[0]->setOption(SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)))
+        {
+            LOG_WARN(g_logger) << "attach reuseport cbpf fail errno=" << errno << " errstr=" << strerror(errno) << ", fall back to hash";
         }
     }
 
@@ -68,25 +195,100 @@ namespace lim_webserver
             return;
         }
         m_started = false;
+        // 不在事件循环线程中直接close会在轮询器里留下旧通道，句柄复用时与新套接字冲突
         for (auto &socket : m_socket_vec)
         {
-            socket->close();
+            ::shutdown(socket->fd(), SHUT_RDWR);
         }
         m_socket_vec.clear();
     }
 
     void TcpServer::accept(Socket::ptr socket)
     {
+        std::vector<Socket::ptr> clients;
+        clients.reserve(m_acceptBatch);
         while (m_started)
         {
-            Socket::ptr client = socket->accept();
-            LOG_TRACE(g_logger)<<"accept client: "<<client->peerAddress()->toString();
-            if (client)
+            clients.clear();
+            if (socket->acceptBatch(clients, m_acceptBatch) < 0)
+            {
+                // 句柄耗尽时积压队列不会变空，暂停一会再试，避免空转；
+                // 只挂起accept协程，由定时器唤醒，所在处理器继续运行其他协程
+                if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+                {
+                    Task *task = Processor::GetCurrentTask();
+                    TimerManager::GetInstance()->addTimer(ACCEPT_BACKOFF, [task]() { task->wake(); });
+                    task->setWaitReason("accept backoff", ACCEPT_BACKOFF);
+                    Processor::CoHold();
+                }
+                continue;
+            }
+            for (auto &client : clients)
             {
-                client->setRecvTimeout(m_recvTimeout);
-                m_worker->createTask([this, client] { this->handleClient(client); });
+                if (!admit())
+                {
+                    m_rejected.fetch_add(1, std::memory_order_relaxed);
+                    rejectClient(client);
+                    continue;
+                }
+                LOG_TRACE(g_logger) << "accept client: " << client->peerAddress()->toString();
+                client->setIdleTimeout(m_recvTimeout);
+                auto task = [this, client]() mutable
+                {
+                    this->handleClient(client);
+                    // 先释放套接字再归还名额
+                    client.reset();
+                    m_connections.fetch_sub(1, std::memory_order_relaxed);
+                };
+                if (!RequestTrace::Enabled())
+                {
+                    m_worker->createTask(task);
+                    continue;
+                }
+                // 追踪对象由任务的回调持有，随连接结束释放
+                std::shared_ptr<RequestTrace> trace = std::make_shared<RequestTrace>();
+                trace->add(TracePoint::ACCEPT, client->fd());
+                m_worker->createTracedTask([task = std::move(task), trace]() mutable { task(); }, trace.get());
             }
         }
+        socket->close();
+    }
+
+    bool TcpServer::admit()
+    {
+        uint64_t count = m_connections.fetch_add(1, std::memory_order_relaxed);
+        if ((m_maxConnections && count >= m_maxConnections) || !m_acceptLimiter.consume())
+        {
+            m_connections.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    size_t TcpServer::getIdleConnectionCount()
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < m_worker->processorCount(); ++i)
+        {
+            if (EventLoop *loop = dynamic_cast<EventLoop *>(m_worker->getProcessor(i)))
+            {
+                count += loop->idleManager().getIdleCount();
+            }
+        }
+        return count;
+    }
+
+    size_t TcpServer::getActiveConnectionCount()
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < m_worker->processorCount(); ++i)
+        {
+            if (EventLoop *loop = dynamic_cast<EventLoop *>(m_worker->getProcessor(i)))
+            {
+                count += loop->idleManager().getActiveCount();
+            }
+        }
+        return count;
     }
 
     void TcpServer::handleClient(Socket::ptr client)
@@ -94,4 +296,43 @@ namespace lim_webserver
         LOG_INFO(g_logger) << "TcpServer handle function for client(ip = " << client->peerAddress()->toString() << ")";
     }
 
+    void TcpServer::rejectClient(Socket::ptr client)
+    {
+        LOG_EVERY_MS(g_logger, LogLevel_WARN, 1000) << "reject client " << client->peerAddress()->toString() << ", connections="
+                                                    << getConnectionCount() << " max=" << m_maxConnections;
+        lingerClose(client);
+    }
+
+    void TcpServer::lingerClose(Socket::ptr client)
+    {
+        // 接收缓冲区中留有未读数据时close会发出RST，对端可能来不及读到已发送的响应；
+        // 先丢弃已到达的数据，用原生recv，不会挂起accept协程
+        char buf[4096];
+        ssize_t n;
+        while ((n = recv_f(client->fd(), buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+        {
+        }
+        if (n == 0 || ::shutdown(client->fd(), SHUT_WR) != 0 || m_lingering.load(std::memory_order_relaxed) >= LINGER_MAX_CONNECTIONS)
+        {
+            client->close();
+            return;
+        }
+        // 已发送FIN，在worker中读尽对端随后发来的数据，对端关闭或超时后再关闭
+        m_lingering.fetch_add(1, std::memory_order_relaxed);
+        client->setIdleTimeout(LINGER_TIMEOUT);
+        m_worker->createTask(
+            [this, client]()
+            {
+                char buf[4096];
+                size_t total = 0;
+                int n;
+                while (total < LINGER_MAX_BYTES && (n = client->recv(buf, sizeof(buf))) > 0)
+                {
+                    total += n;
+                }
+                client->close();
+                m_lingering.fetch_sub(1, std::memory_order_relaxed);
+            });
+    }
+
 } // namespace lim_webserver
@@ -5,6 +5,10 @@
 #include "coroutine.h"
 #include "net/EventLoop.h"
 #include "net/Socket.h"
+#include "net/SslSocketStream.h"
+#include "splog/LogRateLimit.h"
+
+#include <atomic>
 
 #include <vector>
 
@@ -34,15 +38,96 @@ namespace lim_webserver
         TcpServer(Scheduler *worker = EventLoop::GetCurrentScheduler(), Scheduler *accepter = EventLoop::GetCurrentScheduler());
         ~TcpServer();
 
+        /**
+         * @param ssl 是否为TLS监听，须先经setSslContext或loadCertificates设置证书
+         */
         bool bind(Address::ptr addr, bool ssl = false);
 
         void start() override;
 
+        /**
+         * @brief 停止接受连接：关闭监听套接字的读写，唤醒的accept协程在所在事件循环上关闭套接字
+         */
         void stop() override;
 
+        /**
+         * @brief 设置SO_REUSEPORT模式，须在bind之前设置
+         *
+         * @details 开启后worker调度器的每个处理器各自持有一个监听套接字，
+         *          在本处理器上accept并处理连接，连接不跨线程转交，accepter调度器不再使用
+         */
+        inline void setReusePort(bool v) { m_reusePort = v; }
+
+        inline bool isReusePort() const { return m_reusePort; }
+
+        /**
+         * @brief 设置TLS监听使用的上下文
+         */
+        inline void setSslContext(SslContext::ptr ctx) { m_sslCtx = ctx; }
+
+        inline SslContext::ptr getSslContext() const { return m_sslCtx; }
+
+        /**
+         * @brief 从PEM文件加载证书链与私钥作为TLS上下文
+         */
+        bool loadCertificates(const std::string &cert_file, const std::string &key_file);
+
+        /**
+         * @brief 设置最大并发连接数，超出后新连接经rejectClient拒绝，0为不限制
+         */
+        inline void setMaxConnections(uint64_t v) { m_maxConnections = v; }
+
+        inline uint64_t getMaxConnections() const { return m_maxConnections; }
+
+        /**
+         * @brief 设置接受连接的速率限制，超出速率的连接经rejectClient拒绝
+         *
+         * @param rate  每秒接受的连接数，0为不限制
+         * @param burst 允许的突发数，0时取rate
+         */
+        inline void setAcceptRate(long rate, long burst = 0) { m_acceptLimiter.setRate(rate, burst); }
+
+        /**
+         * @brief 当前正在处理的连接数
+         */
+        inline uint64_t getConnectionCount() const { return m_connections.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief 累计被拒绝的连接数
+         */
+        inline uint64_t getRejectedCount() const { return m_rejected.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief worker调度器中等待对端数据的连接数
+         */
+        size_t getIdleConnectionCount();
+
+        /**
+         * @brief worker调度器中正在处理请求的连接数
+         */
+        size_t getActiveConnectionCount();
+
     protected:
         void accept(Socket::ptr socket);
 
+        /**
+         * @brief 判断新连接能否被接受，接受时占用一个连接名额
+         */
+        bool admit();
+
+        /**
+         * @brief 创建监听套接字并完成bind与listen
+         *
+         * @return 失败返回nullptr
+         */
+        Socket::ptr createListener(Address::ptr addr);
+
+        /**
+         * @brief 为同一地址的一组SO_REUSEPORT监听套接字挂载cBPF程序，
+         *        按新连接到达的CPU选择绑定在该CPU上的处理器的监听套接字
+         */
+        void attachSteering(const std::vector<Socket::ptr> &group);
+
         /**
          * @brief 统一的回调
          *
@@ -50,10 +135,31 @@ namespace lim_webserver
          */
         virtual void handleClient(Socket::ptr client);
 
+        /**
+         * @brief 拒绝超出限制的连接，在accept协程中执行，不得阻塞
+         *
+         * @details 默认经lingerClose关闭，对端收到FIN而不是RST；子类可以先发送协议层的拒绝响应
+         */
+        virtual void rejectClient(Socket::ptr client);
+
+        /**
+         * @brief 不读请求就关闭连接：丢弃已到达的数据并发送FIN，之后在worker中短暂读尽对端数据再关闭，
+         *        避免未读数据使close发出RST、冲掉已发送的响应，不会挂起调用方协程
+         */
+        void lingerClose(Socket::ptr client);
+
     protected:
         std::vector<Socket::ptr> m_socket_vec;
         uint64_t m_recvTimeout;
-        bool m_ssl;
+        bool m_ssl = false;
+        SslContext::ptr m_sslCtx;                   // TLS上下文，m_ssl时使用
+        bool m_reusePort;
+        size_t m_acceptBatch;                       // 每批最多接受的连接数
+        uint64_t m_maxConnections;                  // 最大并发连接数
+        TokenBucket m_acceptLimiter;                // 接受速率限制
+        std::atomic<uint64_t> m_connections{0};     // 当前连接数
+        std::atomic<uint64_t> m_rejected{0};        // 累计拒绝数
+        std::atomic<uint64_t> m_lingering{0};       // 等待对端关闭的被拒绝连接数
         Scheduler *m_worker;
         Scheduler *m_accepter;
     };
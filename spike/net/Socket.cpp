@@ -2,6 +2,9 @@
 
 #include "splog.h"
 #include "coroutine/FdInfo.h"
+#include "coroutine/Hook.h"
+
+#include <sys/uio.h>
 
 namespace lim_webserver
 {
@@ -64,6 +67,11 @@ namespace lim_webserver
         initSock();
     }
 
+    Socket::Socket(int family, int type, int protocol, int fd)
+        : m_fd(fd), m_family(family), m_type(type), m_protocol(protocol), m_isConnected(false)
+    {
+    }
+
     Socket::~Socket()
     {
         close();
@@ -107,6 +115,15 @@ namespace lim_webserver
         setOption(SOL_SOCKET, SO_RCVTIMEO, tv);
     }
 
+    void Socket::setIdleTimeout(uint64_t v)
+    {
+        FdInfo::ptr fdInfo = FdManager::GetInstance()->get(m_fd);
+        if (fdInfo)
+        {
+            fdInfo->setIdleTimeout(v);
+        }
+    }
+
     bool Socket::getOption(int level, int option, void *result, socklen_t *len)
     {
         int rt = getsockopt(m_fd, level, option, result, len);
@@ -134,14 +151,16 @@ namespace lim_webserver
 
     Socket::ptr Socket::accept()
     {
-        Socket::ptr sock = std::make_shared<Socket>(m_family, m_type, m_protocol);
         int newsock = ::accept(m_fd, nullptr, nullptr);
         if (newsock == -1)
         {
-            LOG_ERROR(g_logger) << "accept(" << m_fd << ") errno="
-                                << errno << " errstr=" << strerror(errno);
+            // 连接风暴下accept会持续失败，限制为每秒一条并汇总被抑制的条数
+            LOG_EVERY_MS(g_logger, LogLevel_ERROR, 1000) << "accept(" << m_fd << ") errno="
+                                                         << errno << " errstr=" << strerror(errno);
             return nullptr;
         }
+        // 直接接管accept得到的句柄，init失败时由析构关闭
+        Socket::ptr sock = std::make_shared<Socket>(m_family, m_type, m_protocol, newsock);
         if (sock->init(newsock))
         {
             return sock;
@@ -149,6 +168,50 @@ namespace lim_webserver
         return nullptr;
     }
 
+    int Socket::acceptBatch(std::vector<Socket::ptr> &clients, size_t max)
+    {
+        // 第一次经过hook，积压队列为空时挂起当前协程；之后直接调用原生函数，遇到EAGAIN即返回
+        int newsock = ::accept4(m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (newsock == -1)
+        {
+            // 已关闭或已被TcpServer::stop关闭读写(EINVAL)时是正常退出，不记录
+            if (m_fd != -1 && errno != EINVAL)
+            {
+                LOG_EVERY_MS(g_logger, LogLevel_ERROR, 1000) << "accept4(" << m_fd << ") errno="
+                                                             << errno << " errstr=" << strerror(errno);
+            }
+            return -1;
+        }
+        int count = 0;
+        while (newsock != -1)
+        {
+            Socket::ptr sock = std::make_shared<Socket>(m_family, m_type, m_protocol, newsock);
+            if (sock->init(newsock))
+            {
+                clients.push_back(sock);
+                ++count;
+            }
+            if ((size_t)count >= max)
+            {
+                break;
+            }
+            do
+            {
+                newsock = accept4_f(m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            } while (newsock == -1 && errno == EINTR);
+            if (newsock != -1)
+            {
+                FdManager::GetInstance()->create(newsock);
+            }
+            else if (errno != EAGAIN)
+            {
+                LOG_EVERY_MS(g_logger, LogLevel_ERROR, 1000) << "accept4(" << m_fd << ") errno="
+                                                             << errno << " errstr=" << strerror(errno);
+            }
+        }
+        return count;
+    }
+
     bool Socket::init(int sock)
     {
         FdInfo::ptr fdInfo = FdManager::GetInstance()->get(sock);
@@ -253,6 +316,11 @@ namespace lim_webserver
     {
         if (isConnected())
         {
+            // 无标志时用writev，省去msghdr的构造
+            if (flags == 0)
+            {
+                return ::writev(m_fd, buffers, length);
+            }
             msghdr msg;
             memset(&msg, 0, sizeof(msg));
             msg.msg_iov = (iovec *)buffers;
@@ -299,6 +367,11 @@ namespace lim_webserver
     {
         if (isConnected())
         {
+            // 无标志时用readv，省去msghdr的构造
+            if (flags == 0)
+            {
+                return ::readv(m_fd, buffers, length);
+            }
             msghdr msg;
             memset(&msg, 0, sizeof(msg));
             msg.msg_iov = (iovec *)buffers;
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <netinet/tcp.h>
+#include <vector>
 
 #include "Address.h"
 #include "base/Noncopyable.h"
@@ -72,6 +73,10 @@ namespace lim_webserver
 
     public:
         Socket(int family, int type, int protocol = 0);
+        /**
+         * @brief 接管已有的句柄(如accept返回的句柄)，不创建新句柄，析构时关闭
+         */
+        Socket(int family, int type, int protocol, int fd);
         ~Socket();
 
         int64_t getSendTimeout();
@@ -80,6 +85,14 @@ namespace lim_webserver
         int64_t getRecvTimeout();
         void setRecvTimeout(int64_t v);
 
+        /**
+         * @brief 设置空闲超时(毫秒)，读等待超过该时长时返回ETIMEDOUT
+         *
+         * @details 与SO_RCVTIMEO不同，不创建定时器，由所在事件循环每秒统一清扫，精度为1秒；
+         *          适合服务端保持长连接的套接字
+         */
+        void setIdleTimeout(uint64_t v);
+
         bool getOption(int level, int option, void *result, socklen_t *len);
 
         template <class T>
@@ -103,6 +116,15 @@ namespace lim_webserver
          */
         Socket::ptr accept();
 
+        /**
+         * @brief 批量接受连接：无连接时挂起等待，之后用accept4(SOCK_NONBLOCK|SOCK_CLOEXEC)取空积压队列
+         *
+         * @param clients 接受的连接追加到末尾
+         * @param max     本次最多接受的连接数
+         * @return 接受的连接数，失败返回-1并保留errno
+         */
+        int acceptBatch(std::vector<Socket::ptr> &clients, size_t max);
+
         /**
          * @brief 绑定服务器地址
          *
@@ -27,9 +27,9 @@ namespace lim_webserver
     {
         if (isConnected())
         {
-            std::vector<iovec> iovs;
-            ba->getWriteBuffers(iovs, length);
-            int rt = m_socket->recv(&iovs[0], iovs.size());
+            size_t count = 0;
+            iovec *iovs = ba->getWriteIovecs(length, count);
+            int rt = m_socket->recv(iovs, count);
             if (rt > 0)
             {
                 ba->addWritePosition(rt);
@@ -52,9 +52,9 @@ namespace lim_webserver
     {
         if (isConnected())
         {
-            std::vector<iovec> iovs;
-            ba->getReadBuffers(iovs, length);
-            int rt = m_socket->send(&iovs[0], iovs.size());
+            size_t count = 0;
+            iovec *iovs = ba->getReadIovecs(length, count);
+            int rt = m_socket->send(iovs, count);
             if(rt>0)
             {
                 ba->addReadPosition(rt);
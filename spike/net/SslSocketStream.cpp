@@ -0,0 +1,602 @@
+#include "SslSocketStream.h"
+#include "base/Configer.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits.h>
+#include <openssl/core_names.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace lim_webserver
+{
+    static Logger::ptr g_logger = LOG_SYS();
+
+    static ConfigerVar<bool>::ptr g_ssl_ktls =
+        Configer::Lookup("ssl.ktls", true, "hand the tls record layer to the kernel after handshake when both kernel and openssl support it");
+
+    static ConfigerVar<std::string>::ptr g_ssl_ticket_key_file =
+        Configer::Lookup("ssl.ticket_key_file", std::string(""), "session ticket keys shared by processes, 80 bytes per key, empty for random rotating keys");
+
+    static ConfigerVar<uint64_t>::ptr g_ssl_ticket_key_lifetime =
+        Configer::Lookup("ssl.ticket_key_lifetime", (uint64_t)3600, "rotation period in seconds of random session ticket keys");
+
+    // 未接管发送时sendfile每次读入的大小
+    static const size_t SENDFILE_CHUNK = 256 * 1024;
+
+    static void InitOpenSsl()
+    {
+        static bool inited = []()
+        {
+            OPENSSL_init_ssl(0, nullptr);
+            // socket BIO以write写句柄，无法带MSG_NOSIGNAL，对端先关闭时不能让SIGPIPE终止进程
+            signal(SIGPIPE, SIG_IGN);
+            return true;
+        }();
+        (void)inited;
+    }
+
+    /**
+     * @brief 取出并清空当前线程的OpenSSL错误队列
+     */
+    static std::string SslErrorString()
+    {
+        std::string str;
+        char buf[256];
+        unsigned long err;
+        while ((err = ERR_get_error()) != 0)
+        {
+            ERR_error_string_n(err, buf, sizeof(buf));
+            if (!str.empty())
+            {
+                str += "; ";
+            }
+            str += buf;
+        }
+        return str;
+    }
+
+    SslTicketKeys *SslTicketKeys::GetInstance()
+    {
+        static SslTicketKeys instance;
+        return &instance;
+    }
+
+    SslTicketKeys::SslTicketKeys() : m_lifetime(std::max<uint64_t>(g_ssl_ticket_key_lifetime->getValue(), 1))
+    {
+        const std::string &file = g_ssl_ticket_key_file->getValue();
+        if (!file.empty() && load(file))
+        {
+            return;
+        }
+        Key key;
+        if (generate(key))
+        {
+            m_keys.push_back(key);
+        }
+    }
+
+    bool SslTicketKeys::generate(Key &key)
+    {
+        key.created = time(nullptr);
+        return RAND_bytes(key.name, sizeof(key.name)) == 1 && RAND_bytes(key.aes, sizeof(key.aes)) == 1 && RAND_bytes(key.hmac, sizeof(key.hmac)) == 1;
+    }
+
+    bool SslTicketKeys::load(const std::string &file)
+    {
+        std::ifstream ifs(file, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        const size_t KEY_SIZE = sizeof(Key::name) + sizeof(Key::aes) + sizeof(Key::hmac);
+        if (data.empty() || data.size() % KEY_SIZE != 0)
+        {
+            LOG_ERROR(g_logger) << "invalid ssl ticket key file " << file << ", size=" << data.size() << " is not a multiple of " << KEY_SIZE;
+            return false;
+        }
+        std::vector<Key> keys(data.size() / KEY_SIZE);
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            const char *p = data.data() + i * KEY_SIZE;
+            memcpy(keys[i].name, p, sizeof(Key::name));
+            memcpy(keys[i].aes, p + sizeof(Key::name), sizeof(Key::aes));
+            memcpy(keys[i].hmac, p + sizeof(Key::name) + sizeof(Key::aes), sizeof(Key::hmac));
+            keys[i].created = time(nullptr);
+        }
+        RWMutex::WriteLock lock(m_mutex);
+        m_keys.swap(keys);
+        m_fromFile = true;
+        return true;
+    }
+
+    bool SslTicketKeys::current(Key &key)
+    {
+        time_t now = time(nullptr);
+        {
+            RWMutex::ReadLock lock(m_mutex);
+            if (!m_keys.empty() && (m_fromFile || now - m_keys[0].created < (time_t)m_lifetime))
+            {
+                key = m_keys[0];
+                return true;
+            }
+        }
+        Key fresh;
+        if (!generate(fresh))
+        {
+            return false;
+        }
+        RWMutex::WriteLock lock(m_mutex);
+        // 并发轮换时只有第一个生效
+        if (m_keys.empty() || (!m_fromFile && now - m_keys[0].created >= (time_t)m_lifetime))
+        {
+            m_keys.insert(m_keys.begin(), fresh);
+            if (m_keys.size() > 2)
+            {
+                m_keys.resize(2);
+            }
+        }
+        key = m_keys[0];
+        return true;
+    }
+
+    bool SslTicketKeys::find(const unsigned char name[16], Key &key, bool &renew)
+    {
+        RWMutex::ReadLock lock(m_mutex);
+        for (size_t i = 0; i < m_keys.size(); ++i)
+        {
+            if (memcmp(m_keys[i].name, name, sizeof(Key::name)) == 0)
+            {
+                key = m_keys[i];
+                renew = i > 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 票据加解密回调：AES-256-CBC加密，HMAC-SHA256校验
+     *
+     * @return 1 成功；2 解密成功但需续发；0 找不到密钥，退回完整握手；-1 出错
+     */
+    static int TicketKeyCallback(SSL *ssl, unsigned char key_name[16], unsigned char iv[EVP_MAX_IV_LENGTH], EVP_CIPHER_CTX *cctx, EVP_MAC_CTX *hctx,
+                                 int enc)
+    {
+        SslTicketKeys::Key key;
+        bool renew = false;
+        if (enc)
+        {
+            if (!SslTicketKeys::GetInstance()->current(key) || RAND_bytes(iv, 16) != 1)
+            {
+                return -1;
+            }
+            memcpy(key_name, key.name, sizeof(key.name));
+        }
+        else if (!SslTicketKeys::GetInstance()->find(key_name, key, renew))
+        {
+            return 0;
+        }
+        OSSL_PARAM params[3];
+        params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmac, sizeof(key.hmac));
+        params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *)"SHA256", 0);
+        params[2] = OSSL_PARAM_construct_end();
+        if (EVP_MAC_CTX_set_params(hctx, params) != 1)
+        {
+            return -1;
+        }
+        int rt = enc ? EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, key.aes, iv) : EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, key.aes, iv);
+        if (rt != 1)
+        {
+            return -1;
+        }
+        return renew ? 2 : 1;
+    }
+
+    SslContext::SslContext(SSL_CTX *ctx, bool server) : m_ctx(ctx), m_server(server)
+    {
+        SSL_CTX_set_min_proto_version(m_ctx, TLS1_2_VERSION);
+        // 对端未发送close_notify直接关闭时按正常结束处理，与明文连接的语义一致
+        SSL_CTX_set_options(m_ctx, SSL_OP_IGNORE_UNEXPECTED_EOF | SSL_OP_NO_RENEGOTIATION);
+        if (m_server)
+        {
+            // 只用无状态的票据恢复会话，多个进程共享票据密钥即可互相恢复，无需共享会话缓存
+            SSL_CTX_set_session_cache_mode(m_ctx, SSL_SESS_CACHE_OFF);
+            SSL_CTX_set_tlsext_ticket_key_evp_cb(m_ctx, TicketKeyCallback);
+            SSL_CTX_set_num_tickets(m_ctx, 1);
+        }
+        setKtls(g_ssl_ktls->getValue());
+    }
+
+    SslContext::~SslContext() { SSL_CTX_free(m_ctx); }
+
+    void SslContext::setKtls(bool v)
+    {
+        m_ktls = v;
+        if (v)
+        {
+            SSL_CTX_set_options(m_ctx, SSL_OP_ENABLE_KTLS);
+        }
+        else
+        {
+            SSL_CTX_clear_options(m_ctx, SSL_OP_ENABLE_KTLS);
+        }
+    }
+
+    SslContext::ptr SslContext::CreateServer(const std::string &cert_file, const std::string &key_file)
+    {
+        InitOpenSsl();
+        SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+        if (!ctx)
+        {
+            LOG_ERROR(g_logger) << "SSL_CTX_new fail: " << SslErrorString();
+            return nullptr;
+        }
+        if (SSL_CTX_use_certificate_chain_file(ctx, cert_file.c_str()) != 1 || SSL_CTX_use_PrivateKey_file(ctx, key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+            SSL_CTX_check_private_key(ctx) != 1)
+        {
+            LOG_ERROR(g_logger) << "load certificate " << cert_file << " and key " << key_file << " fail: " << SslErrorString();
+            SSL_CTX_free(ctx);
+            return nullptr;
+        }
+        return SslContext::ptr(new SslContext(ctx, true));
+    }
+
+    SslContext::ptr SslContext::CreateSelfSigned(const std::string &common_name)
+    {
+        InitOpenSsl();
+        SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+        EVP_PKEY *pkey = EVP_EC_gen("P-256");
+        X509 *x509 = X509_new();
+        bool ok = ctx && pkey && x509;
+        if (ok)
+        {
+            X509_set_version(x509, 2);
+            ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+            X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+            X509_gmtime_adj(X509_getm_notAfter(x509), 365 * 24 * 3600L);
+            X509_set_pubkey(x509, pkey);
+            X509_NAME *name = X509_get_subject_name(x509);
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)common_name.c_str(), -1, -1, 0);
+            X509_set_issuer_name(x509, name);
+            ok = X509_sign(x509, pkey, EVP_sha256()) > 0 && SSL_CTX_use_certificate(ctx, x509) == 1 && SSL_CTX_use_PrivateKey(ctx, pkey) == 1;
+        }
+        X509_free(x509);
+        EVP_PKEY_free(pkey);
+        if (!ok)
+        {
+            LOG_ERROR(g_logger) << "create self-signed certificate fail: " << SslErrorString();
+            SSL_CTX_free(ctx);
+            return nullptr;
+        }
+        return SslContext::ptr(new SslContext(ctx, true));
+    }
+
+    SslContext::ptr SslContext::CreateClient(bool verify, const std::string &ca_file)
+    {
+        InitOpenSsl();
+        SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+        if (!ctx)
+        {
+            LOG_ERROR(g_logger) << "SSL_CTX_new fail: " << SslErrorString();
+            return nullptr;
+        }
+        if (verify)
+        {
+            SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+            int rt = ca_file.empty() ? SSL_CTX_set_default_verify_paths(ctx) : SSL_CTX_load_verify_locations(ctx, ca_file.c_str(), nullptr);
+            if (rt != 1)
+            {
+                LOG_ERROR(g_logger) << "load ca " << ca_file << " fail: " << SslErrorString();
+                SSL_CTX_free(ctx);
+                return nullptr;
+            }
+        }
+        return SslContext::ptr(new SslContext(ctx, false));
+    }
+
+    SslSocketStream::SslSocketStream(Socket::ptr sock, SslContext::ptr ctx, bool owner) : SocketStream(sock, owner), m_ctx(ctx)
+    {
+        m_ssl = SSL_new(ctx->native());
+        if (!m_ssl)
+        {
+            LOG_ERROR(g_logger) << "SSL_new fail: " << SslErrorString();
+            return;
+        }
+        SSL_set_fd(m_ssl, sock->fd());
+        if (ctx->isServer())
+        {
+            SSL_set_accept_state(m_ssl);
+        }
+        else
+        {
+            SSL_set_connect_state(m_ssl);
+        }
+    }
+
+    SslSocketStream::~SslSocketStream()
+    {
+        if (m_ssl)
+        {
+            SSL_free(m_ssl);
+        }
+    }
+
+    bool SslSocketStream::handshake()
+    {
+        if (!m_ssl || !isConnected())
+        {
+            return false;
+        }
+        int rt;
+        do
+        {
+            ERR_clear_error();
+            rt = SSL_do_handshake(m_ssl);
+        } while (rt != 1 && retry(rt));
+        if (rt != 1)
+        {
+            int err = SSL_get_error(m_ssl, rt);
+            LOG_DEBUG(g_logger) << "ssl handshake with " << peerAddressString() << " fail, error=" << err << " errno=" << errno << " " << SslErrorString();
+            return false;
+        }
+        m_established = true;
+#ifndef OPENSSL_NO_KTLS
+        m_ktlsSend = BIO_get_ktls_send(SSL_get_wbio(m_ssl));
+        m_ktlsRecv = BIO_get_ktls_recv(SSL_get_rbio(m_ssl));
+#endif
+        LOG_DEBUG(g_logger) << "ssl handshake with " << peerAddressString() << " " << getVersion() << " " << getCipher() << " reused=" << isSessionReused()
+                            << " ktls_send=" << m_ktlsSend << " ktls_recv=" << m_ktlsRecv;
+        return true;
+    }
+
+    bool SslSocketStream::retry(int rt)
+    {
+        if (SSL_get_error(m_ssl, rt) != SSL_ERROR_WANT_READ)
+        {
+            return false;
+        }
+        // socket BIO用read读取，read未经hook，数据未到时直接返回EAGAIN；
+        // 用经hook的recv窥探一个字节，挂起协程直到可读，对端关闭时同样返回，由重试得到EOF
+        char c;
+        return m_socket->recv(&c, 1, MSG_PEEK) >= 0;
+    }
+
+    int SslSocketStream::checkResult(int rt, const char *op)
+    {
+        if (rt > 0)
+        {
+            return rt;
+        }
+        int err = SSL_get_error(m_ssl, rt);
+        if (err == SSL_ERROR_ZERO_RETURN)
+        {
+            // 对端发送了close_notify
+            return 0;
+        }
+        // 读写等待已由hook挂起协程，走到这里只可能是超时、连接出错或协议错误，之后不能再发送close_notify
+        LOG_DEBUG(g_logger) << op << " with " << peerAddressString() << " fail, error=" << err << " errno=" << errno << " " << SslErrorString();
+        m_established = false;
+        return -1;
+    }
+
+    int SslSocketStream::resv(void *buffer, size_t length)
+    {
+        if (!m_established)
+        {
+            return -1;
+        }
+        int rt;
+        do
+        {
+            ERR_clear_error();
+            rt = SSL_read(m_ssl, buffer, (int)std::min<size_t>(length, INT_MAX));
+        } while (rt <= 0 && retry(rt));
+        return checkResult(rt, "SSL_read");
+    }
+
+    int SslSocketStream::resv(ByteArray::ptr ba, size_t length)
+    {
+        size_t count = 0;
+        iovec *iovs = ba->getWriteIovecs(length, count);
+        if (!count)
+        {
+            return 0;
+        }
+        int rt = resv(iovs[0].iov_base, iovs[0].iov_len);
+        if (rt > 0)
+        {
+            ba->addWritePosition(rt);
+        }
+        return rt;
+    }
+
+    int SslSocketStream::send(const void *buffer, size_t length)
+    {
+        if (!m_established)
+        {
+            return -1;
+        }
+        if (!length)
+        {
+            return 0;
+        }
+        if (m_ktlsSend)
+        {
+            iovec iov;
+            iov.iov_base = (void *)buffer;
+            iov.iov_len = length;
+            return sendv(&iov, 1);
+        }
+        ERR_clear_error();
+        return checkResult(SSL_write(m_ssl, buffer, (int)std::min<size_t>(length, INT_MAX)), "SSL_write");
+    }
+
+    int SslSocketStream::send(ByteArray::ptr ba, size_t length)
+    {
+        size_t count = 0;
+        iovec *iovs = ba->getReadIovecs(length, count);
+        int rt = sendv(iovs, count);
+        if (rt > 0)
+        {
+            ba->addReadPosition(rt);
+        }
+        return rt;
+    }
+
+    int SslSocketStream::sendv(const iovec *iov, int count)
+    {
+        if (!m_established)
+        {
+            return -1;
+        }
+        if (m_ktlsSend)
+        {
+            // 内核负责分记录与加密，明文直接写出
+            std::vector<iovec> rest(iov, iov + count);
+            iovec *p = rest.data();
+            int total = 0;
+            while (count > 0)
+            {
+                int n = m_socket->send(p, std::min(count, IOV_MAX));
+                if (n <= 0)
+                {
+                    return n;
+                }
+                total += n;
+                while (count > 0 && (size_t)n >= p->iov_len)
+                {
+                    n -= p->iov_len;
+                    ++p;
+                    --count;
+                }
+                if (count > 0)
+                {
+                    p->iov_base = (char *)p->iov_base + n;
+                    p->iov_len -= n;
+                }
+            }
+            return total;
+        }
+        if (count == 1)
+        {
+            return send(iov[0].iov_base, iov[0].iov_len);
+        }
+        // 用户态记录层：合并为一次SSL_write，避免每段各成一个TLS记录
+        std::string buffer;
+        for (int i = 0; i < count; ++i)
+        {
+            buffer.append((const char *)iov[i].iov_base, iov[i].iov_len);
+        }
+        return send(buffer.data(), buffer.size());
+    }
+
+    int64_t SslSocketStream::sendfile(int fd, off_t offset, size_t length)
+    {
+        if (!m_established)
+        {
+            return -1;
+        }
+        std::vector<char> buffer;
+        size_t done = 0;
+        while (done < length)
+        {
+            if (m_ktlsSend)
+            {
+                ssize_t n = ::sendfile(m_socket->fd(), fd, &offset, length - done);
+                if (n > 0)
+                {
+                    done += n;
+                    continue;
+                }
+                if (n == 0)
+                {
+                    // 文件比length短
+                    break;
+                }
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno != EAGAIN)
+                {
+                    return -1;
+                }
+                // sendfile未经hook，发送缓冲区满时改用经hook的send写出一块，期间挂起协程等待可写
+            }
+            if (buffer.empty())
+            {
+                buffer.resize(SENDFILE_CHUNK);
+            }
+            ssize_t n = pread(fd, &buffer[0], std::min(SENDFILE_CHUNK, length - done), offset);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                if (n < 0)
+                {
+                    return -1;
+                }
+                break;
+            }
+            int rt = send(&buffer[0], n);
+            if (rt <= 0)
+            {
+                return -1;
+            }
+            offset += n;
+            done += n;
+        }
+        return done;
+    }
+
+    void SslSocketStream::close()
+    {
+        if (m_ssl && m_established)
+        {
+            m_established = false;
+            // 只发送close_notify，不等待对端的回应
+            ERR_clear_error();
+            SSL_shutdown(m_ssl);
+        }
+        SocketStream::close();
+    }
+
+    bool SslSocketStream::isSessionReused() const { return m_ssl && SSL_session_reused(m_ssl) == 1; }
+
+    SslSocketStream::SessionPtr SslSocketStream::getSession() const
+    {
+        SSL_SESSION *session = m_ssl ? SSL_get1_session(m_ssl) : nullptr;
+        if (!session)
+        {
+            return nullptr;
+        }
+        if (!SSL_SESSION_is_resumable(session))
+        {
+            SSL_SESSION_free(session);
+            return nullptr;
+        }
+        return SessionPtr(session, SSL_SESSION_free);
+    }
+
+    void SslSocketStream::setSession(const SessionPtr &session)
+    {
+        if (m_ssl && session)
+        {
+            SSL_set_session(m_ssl, session.get());
+        }
+    }
+
+    std::string SslSocketStream::getVersion() const { return m_ssl ? SSL_get_version(m_ssl) : ""; }
+
+    std::string SslSocketStream::getCipher() const { return m_ssl ? SSL_get_cipher_name(m_ssl) : ""; }
+
+} // namespace lim_webserver
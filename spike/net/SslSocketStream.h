@@ -0,0 +1,212 @@
+#pragma once
+
+#include "SocketStream.h"
+#include "base/Mutex.h"
+
+#include <memory>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+struct ssl_st;
+struct ssl_ctx_st;
+struct ssl_session_st;
+
+namespace lim_webserver
+{
+    /**
+     * @brief 会话票据密钥，进程内所有服务端SslContext共享
+     *
+     * @details 配置了ssl.ticket_key_file时从文件加载(每80字节一个密钥：16字节名字、32字节AES-256密钥、32字节HMAC-SHA256密钥)，
+     *          第一个用于加密，其余只用于解密，多个进程或多台机器加载同一文件即可互相恢复会话；
+     *          未配置时随机生成，每ssl.ticket_key_lifetime秒轮换一次，并保留上一个密钥用于解密。
+     *          用旧密钥解密成功的票据会被续发。
+     */
+    class SslTicketKeys
+    {
+    public:
+        struct Key
+        {
+            unsigned char name[16];
+            unsigned char aes[32];
+            unsigned char hmac[32];
+            time_t created;
+        };
+
+        static SslTicketKeys *GetInstance();
+
+        /**
+         * @brief 从文件加载密钥，替换现有密钥并停止轮换
+         */
+        bool load(const std::string &file);
+
+        /**
+         * @brief 取得加密用的当前密钥，到期时先轮换
+         */
+        bool current(Key &key);
+
+        /**
+         * @brief 按名字查找解密用的密钥
+         *
+         * @param[out] renew 是否为旧密钥，需要续发票据
+         */
+        bool find(const unsigned char name[16], Key &key, bool &renew);
+
+    private:
+        SslTicketKeys();
+
+        bool generate(Key &key);
+
+    private:
+        RWMutex m_mutex;
+        std::vector<Key> m_keys; // 第一个为当前密钥
+        bool m_fromFile = false; // 是否从文件加载，加载后不轮换
+        uint64_t m_lifetime;     // 轮换周期，单位：秒
+    };
+
+    /**
+     * @brief TLS上下文(SSL_CTX)，保存证书与握手参数，可被任意多个连接共享
+     */
+    class SslContext
+    {
+    public:
+        using ptr = std::shared_ptr<SslContext>;
+
+        /**
+         * @brief 从PEM文件加载证书链与私钥
+         *
+         * @return nullptr 加载失败或证书与私钥不匹配
+         */
+        static ptr CreateServer(const std::string &cert_file, const std::string &key_file);
+
+        /**
+         * @brief 使用临时生成的自签名证书(P-256)，用于测试与压测
+         */
+        static ptr CreateSelfSigned(const std::string &common_name = "localhost");
+
+        /**
+         * @param verify  是否校验服务端证书
+         * @param ca_file 校验用的CA文件，为空时使用系统默认路径
+         */
+        static ptr CreateClient(bool verify = false, const std::string &ca_file = "");
+
+        ~SslContext();
+
+        inline ssl_ctx_st *native() const { return m_ctx; }
+
+        inline bool isServer() const { return m_server; }
+
+        /**
+         * @brief 是否在握手后尝试把记录层交给内核(kTLS)，默认取ssl.ktls，只影响之后创建的连接
+         */
+        void setKtls(bool v);
+
+        inline bool isKtls() const { return m_ktls; }
+
+    private:
+        SslContext(ssl_ctx_st *ctx, bool server);
+
+    private:
+        ssl_ctx_st *m_ctx;
+        bool m_server;
+        bool m_ktls = false;
+    };
+
+    /**
+     * @brief TLS连接上的流
+     *
+     * @details 使用OpenSSL的socket BIO直接读写句柄，写经hook在协程中挂起；read未经hook，
+     *          数据未到时先经hook的recv等待可读再重试，握手与读写因此不阻塞线程。
+     *          握手后若内核接管了发送方向(kTLS)，send/sendv直接写明文、sendfile直接调用sendfile(2)，
+     *          由内核加密，数据不经过用户态的记录层；否则经SSL_write加密。
+     */
+    class SslSocketStream : public SocketStream
+    {
+    public:
+        using ptr = std::shared_ptr<SslSocketStream>;
+        using SessionPtr = std::shared_ptr<ssl_session_st>;
+
+        SslSocketStream(Socket::ptr sock, SslContext::ptr ctx, bool owner = true);
+
+        ~SslSocketStream();
+
+        /**
+         * @brief 完成握手：服务端等待ClientHello，客户端主动发起
+         */
+        bool handshake();
+
+        virtual int resv(void *buffer, size_t length) override;
+
+        virtual int resv(ByteArray::ptr ba, size_t length) override;
+
+        /**
+         * @brief 发送全部数据
+         *
+         * @return int 发送的字节数，<=0为失败
+         */
+        virtual int send(const void *buffer, size_t length) override;
+
+        virtual int send(ByteArray::ptr ba, size_t length) override;
+
+        /**
+         * @brief 聚集写：内核接管发送时直接writev，否则合并后一次SSL_write
+         */
+        int sendv(const iovec *iov, int count);
+
+        /**
+         * @brief 发送文件的[offset, offset+length)：内核接管发送时零拷贝sendfile，否则读入用户态后加密
+         *
+         * @return int64_t 发送的字节数，<0为失败
+         */
+        int64_t sendfile(int fd, off_t offset, size_t length);
+
+        /**
+         * @brief 发送close_notify后关闭连接
+         */
+        virtual void close() override;
+
+        inline bool isKtlsSend() const { return m_ktlsSend; }
+
+        inline bool isKtlsRecv() const { return m_ktlsRecv; }
+
+        /**
+         * @brief 本次握手是否恢复了之前的会话
+         */
+        bool isSessionReused() const;
+
+        /**
+         * @brief 客户端：取得可用于恢复的会话，TLS 1.3的票据在握手后首次读取时才到达
+         */
+        SessionPtr getSession() const;
+
+        /**
+         * @brief 客户端：握手前设置要恢复的会话
+         */
+        void setSession(const SessionPtr &session);
+
+        std::string getVersion() const;
+
+        std::string getCipher() const;
+
+    private:
+        /**
+         * @brief 操作因数据未到而失败时等待可读
+         *
+         * @return 是否应重试
+         */
+        bool retry(int rt);
+
+        /**
+         * @brief 处理SSL_read/SSL_write的返回值
+         */
+        int checkResult(int rt, const char *op);
+
+    private:
+        SslContext::ptr m_ctx;
+        ssl_st *m_ssl;
+        bool m_established = false; // 是否已完成握手
+        bool m_ktlsSend = false;    // 内核是否接管了发送方向
+        bool m_ktlsRecv = false;    // 内核是否接管了接收方向
+    };
+
+} // namespace lim_webserver
@@ -0,0 +1,542 @@
+#include "Hpack.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        // Huffman码表(RFC 7541 附录B)，下标256为EOS
+        static const uint32_t HUFFMAN_CODES[257] = {
+            0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5, 0xfffffe6, 0xfffffe7,
+            0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9, 0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec,
+            0xfffffed, 0xfffffee, 0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+            0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9, 0xffffffa, 0xffffffb,
+            0x14, 0x3f8, 0x3f9, 0xffa, 0x1ff9, 0x15, 0xf8, 0x7fa,
+            0x3fa, 0x3fb, 0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+            0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+            0x1e, 0x1f, 0x5c, 0xfb, 0x7ffc, 0x20, 0xffb, 0x3fc,
+            0x1ffa, 0x21, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+            0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+            0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72,
+            0xfc, 0x73, 0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+            0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5, 0x25, 0x26,
+            0x27, 0x6, 0x74, 0x75, 0x28, 0x29, 0x2a, 0x7,
+            0x2b, 0x76, 0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+            0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd, 0x1ffd, 0xffffffc,
+            0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8, 0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9,
+            0x3fffd6, 0x7fffda, 0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+            0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1, 0x7fffe2, 0x7fffe3,
+            0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5, 0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef,
+            0x3fffda, 0x1fffdd, 0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+            0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf, 0x7fffeb, 0x7fffec,
+            0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2, 0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef,
+            0xfffea, 0x3fffe2, 0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+            0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2, 0x3fffe8, 0x1ffffec,
+            0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde, 0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed,
+            0x7fff2, 0x1fffe3, 0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+            0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3, 0x7ffffe4, 0x7ffffe5,
+            0xfffec, 0xfffff3, 0xfffed, 0x1fffe6, 0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3,
+            0x3fffea, 0x3fffeb, 0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+            0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8, 0x7ffffe9, 0x7ffffea,
+            0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed, 0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+            0x3fffffff,
+        };
+        static const uint8_t HUFFMAN_BITS[257] = {
+            13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+            28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+            6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+            5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+            13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+            7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+            15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+            6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+            20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+            24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+            22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+            21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+            26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+            19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+            20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+            26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+            30,
+        };
+
+        /**
+         * @brief Huffman解码树，children为子节点下标，叶子的symbol为符号，非叶子为-1
+         */
+        struct HuffmanTree
+        {
+            struct Node
+            {
+                int16_t children[2] = {0, 0};
+                int16_t symbol = -1;
+            };
+
+            HuffmanTree()
+            {
+                nodes.emplace_back();
+                for (int sym = 0; sym < 257; ++sym)
+                {
+                    size_t cur = 0;
+                    for (int bit = HUFFMAN_BITS[sym] - 1; bit >= 0; --bit)
+                    {
+                        int b = (HUFFMAN_CODES[sym] >> bit) & 1;
+                        if (nodes[cur].children[b] == 0)
+                        {
+                            nodes[cur].children[b] = (int16_t)nodes.size();
+                            nodes.emplace_back();
+                        }
+                        cur = nodes[cur].children[b];
+                    }
+                    nodes[cur].symbol = (int16_t)sym;
+                }
+            }
+
+            std::vector<Node> nodes;
+        };
+
+        static const HuffmanTree &GetHuffmanTree()
+        {
+            static const HuffmanTree tree;
+            return tree;
+        }
+
+        size_t Huffman::EncodedLength(const std::string &str)
+        {
+            size_t bits = 0;
+            for (unsigned char c : str)
+            {
+                bits += HUFFMAN_BITS[c];
+            }
+            return (bits + 7) / 8;
+        }
+
+        void Huffman::Encode(const std::string &str, std::string &out)
+        {
+            uint64_t acc = 0;
+            int bits = 0;
+            for (unsigned char c : str)
+            {
+                acc = (acc << HUFFMAN_BITS[c]) | HUFFMAN_CODES[c];
+                bits += HUFFMAN_BITS[c];
+                while (bits >= 8)
+                {
+                    bits -= 8;
+                    out += (char)(acc >> bits);
+                }
+            }
+            // 以EOS的高位(全1)补齐最后一个字节
+            if (bits > 0)
+            {
+                out += (char)((acc << (8 - bits)) | (0xFF >> bits));
+            }
+        }
+
+        bool Huffman::Decode(const uint8_t *data, size_t len, std::string &out)
+        {
+            const std::vector<HuffmanTree::Node> &nodes = GetHuffmanTree().nodes;
+            size_t cur = 0;
+            int pad_bits = 0;    // 上一个符号之后已读的位数
+            bool pad_ones = true; // 这些位是否全为1
+            for (size_t i = 0; i < len; ++i)
+            {
+                for (int bit = 7; bit >= 0; --bit)
+                {
+                    int b = (data[i] >> bit) & 1;
+                    cur = nodes[cur].children[b];
+                    if (cur == 0)
+                    {
+                        return false;
+                    }
+                    ++pad_bits;
+                    pad_ones = pad_ones && b;
+                    if (nodes[cur].symbol >= 0)
+                    {
+                        if (nodes[cur].symbol == 256)
+                        {
+                            return false;
+                        }
+                        out += (char)nodes[cur].symbol;
+                        cur = 0;
+                        pad_bits = 0;
+                        pad_ones = true;
+                    }
+                }
+            }
+            return cur == 0 || (pad_bits <= 7 && pad_ones);
+        }
+
+        void HpackEncodeInt(uint64_t value, int prefix, uint8_t flags, std::string &out)
+        {
+            uint64_t max_prefix = (1u << prefix) - 1;
+            if (value < max_prefix)
+            {
+                out += (char)(flags | value);
+                return;
+            }
+            out += (char)(flags | max_prefix);
+            value -= max_prefix;
+            while (value >= 128)
+            {
+                out += (char)((value & 0x7F) | 0x80);
+                value >>= 7;
+            }
+            out += (char)value;
+        }
+
+        bool HpackDecodeInt(const uint8_t *&p, const uint8_t *end, int prefix, uint64_t &value)
+        {
+            if (p >= end)
+            {
+                return false;
+            }
+            uint64_t max_prefix = (1u << prefix) - 1;
+            value = *p++ & max_prefix;
+            if (value < max_prefix)
+            {
+                return true;
+            }
+            int shift = 0;
+            while (p < end)
+            {
+                uint8_t b = *p++;
+                // 超过8个延续字节已远大于任何合理的长度或下标
+                if (shift > 56)
+                {
+                    return false;
+                }
+                value += (uint64_t)(b & 0x7F) << shift;
+                shift += 7;
+                if (!(b & 0x80))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief 编码字符串，Huffman编码更短时使用
+         */
+        static void EncodeString(const std::string &str, std::string &out)
+        {
+            size_t huffman_len = Huffman::EncodedLength(str);
+            if (huffman_len < str.size())
+            {
+                HpackEncodeInt(huffman_len, 7, 0x80, out);
+                Huffman::Encode(str, out);
+            }
+            else
+            {
+                HpackEncodeInt(str.size(), 7, 0, out);
+                out += str;
+            }
+        }
+
+        static bool DecodeString(const uint8_t *&p, const uint8_t *end, std::string &out)
+        {
+            if (p >= end)
+            {
+                return false;
+            }
+            bool huffman = *p & 0x80;
+            uint64_t len;
+            if (!HpackDecodeInt(p, end, 7, len) || len > (uint64_t)(end - p))
+            {
+                return false;
+            }
+            out.clear();
+            if (huffman)
+            {
+                if (!Huffman::Decode(p, len, out))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                out.assign((const char *)p, len);
+            }
+            p += len;
+            return true;
+        }
+
+        struct StaticEntry
+        {
+            const char *name;
+            const char *value;
+        };
+
+        // 静态表(RFC 7541 附录A)
+        static const StaticEntry STATIC_TABLE[HpackTable::STATIC_SIZE] = {
+            {":authority", ""},
+            {":method", "GET"},
+            {":method", "POST"},
+            {":path", "/"},
+            {":path", "/index.html"},
+            {":scheme", "http"},
+            {":scheme", "https"},
+            {":status", "200"},
+            {":status", "204"},
+            {":status", "206"},
+            {":status", "304"},
+            {":status", "400"},
+            {":status", "404"},
+            {":status", "500"},
+            {"accept-charset", ""},
+            {"accept-encoding", "gzip, deflate"},
+            {"accept-language", ""},
+            {"accept-ranges", ""},
+            {"accept", ""},
+            {"access-control-allow-origin", ""},
+            {"age", ""},
+            {"allow", ""},
+            {"authorization", ""},
+            {"cache-control", ""},
+            {"content-disposition", ""},
+            {"content-encoding", ""},
+            {"content-language", ""},
+            {"content-length", ""},
+            {"content-location", ""},
+            {"content-range", ""},
+            {"content-type", ""},
+            {"cookie", ""},
+            {"date", ""},
+            {"etag", ""},
+            {"expect", ""},
+            {"expires", ""},
+            {"from", ""},
+            {"host", ""},
+            {"if-match", ""},
+            {"if-modified-since", ""},
+            {"if-none-match", ""},
+            {"if-range", ""},
+            {"if-unmodified-since", ""},
+            {"last-modified", ""},
+            {"link", ""},
+            {"location", ""},
+            {"max-forwards", ""},
+            {"proxy-authenticate", ""},
+            {"proxy-authorization", ""},
+            {"range", ""},
+            {"referer", ""},
+            {"refresh", ""},
+            {"retry-after", ""},
+            {"server", ""},
+            {"set-cookie", ""},
+            {"strict-transport-security", ""},
+            {"transfer-encoding", ""},
+            {"user-agent", ""},
+            {"vary", ""},
+            {"via", ""},
+            {"www-authenticate", ""},
+        };
+
+        bool HpackTable::get(size_t index, std::string &name, std::string &value) const
+        {
+            if (index == 0)
+            {
+                return false;
+            }
+            if (index <= STATIC_SIZE)
+            {
+                name = STATIC_TABLE[index - 1].name;
+                value = STATIC_TABLE[index - 1].value;
+                return true;
+            }
+            index -= STATIC_SIZE + 1;
+            if (index >= m_entries.size())
+            {
+                return false;
+            }
+            name = m_entries[index].first;
+            value = m_entries[index].second;
+            return true;
+        }
+
+        void HpackTable::add(const std::string &name, const std::string &value)
+        {
+            size_t size = name.size() + value.size() + 32;
+            if (size > m_maxSize)
+            {
+                // 比整张表还大的条目使表清空(RFC 7541 4.4)
+                m_entries.clear();
+                m_size = 0;
+                return;
+            }
+            m_entries.emplace_front(name, value);
+            m_size += size;
+            evict();
+        }
+
+        void HpackTable::setMaxSize(size_t max_size)
+        {
+            m_maxSize = max_size;
+            evict();
+        }
+
+        void HpackTable::evict()
+        {
+            while (m_size > m_maxSize && !m_entries.empty())
+            {
+                m_size -= m_entries.back().first.size() + m_entries.back().second.size() + 32;
+                m_entries.pop_back();
+            }
+        }
+
+        size_t HpackTable::find(const std::string &name, const std::string &value, bool &value_match) const
+        {
+            size_t name_index = 0;
+            for (size_t i = 0; i < STATIC_SIZE; ++i)
+            {
+                if (name == STATIC_TABLE[i].name)
+                {
+                    if (value == STATIC_TABLE[i].value)
+                    {
+                        value_match = true;
+                        return i + 1;
+                    }
+                    if (!name_index)
+                    {
+                        name_index = i + 1;
+                    }
+                }
+            }
+            for (size_t i = 0; i < m_entries.size(); ++i)
+            {
+                if (m_entries[i].first == name)
+                {
+                    if (m_entries[i].second == value)
+                    {
+                        value_match = true;
+                        return STATIC_SIZE + 1 + i;
+                    }
+                    if (!name_index)
+                    {
+                        name_index = STATIC_SIZE + 1 + i;
+                    }
+                }
+            }
+            value_match = false;
+            return name_index;
+        }
+
+        bool HpackDecoder::decode(const uint8_t *data, size_t len, HeaderList &headers)
+        {
+            const uint8_t *p = data;
+            const uint8_t *end = data + len;
+            bool header_seen = false;
+            while (p < end)
+            {
+                uint8_t b = *p;
+                uint64_t index;
+                std::string name, value;
+                if (b & 0x80)
+                {
+                    // 已索引字段
+                    if (!HpackDecodeInt(p, end, 7, index) || !m_table.get(index, name, value))
+                    {
+                        return false;
+                    }
+                }
+                else if ((b & 0xE0) == 0x20)
+                {
+                    // 动态表大小更新，只能出现在头部块开头且不超过SETTINGS的上限
+                    if (header_seen || !HpackDecodeInt(p, end, 5, index) || index > m_maxAllowed)
+                    {
+                        return false;
+                    }
+                    m_table.setMaxSize(index);
+                    continue;
+                }
+                else
+                {
+                    // 字面量：增量索引(01)、不索引(0000)、永不索引(0001)
+                    bool indexing = (b & 0xC0) == 0x40;
+                    int prefix = indexing ? 6 : 4;
+                    if (!HpackDecodeInt(p, end, prefix, index))
+                    {
+                        return false;
+                    }
+                    if (index)
+                    {
+                        std::string ignored;
+                        if (!m_table.get(index, name, ignored))
+                        {
+                            return false;
+                        }
+                    }
+                    else if (!DecodeString(p, end, name))
+                    {
+                        return false;
+                    }
+                    if (!DecodeString(p, end, value))
+                    {
+                        return false;
+                    }
+                    if (indexing)
+                    {
+                        m_table.add(name, value);
+                    }
+                }
+                header_seen = true;
+                headers.emplace_back(std::move(name), std::move(value));
+            }
+            return true;
+        }
+
+        void HpackEncoder::setMaxTableSize(size_t size)
+        {
+            // 本端使用的动态表不超过默认的4096
+            size = std::min<size_t>(size, 4096);
+            if (size != m_table.maxSize())
+            {
+                m_table.setMaxSize(size);
+                m_sizeUpdate = true;
+            }
+        }
+
+        void HpackEncoder::encode(const HeaderList &headers, std::string &out)
+        {
+            if (m_sizeUpdate)
+            {
+                HpackEncodeInt(m_table.maxSize(), 5, 0x20, out);
+                m_sizeUpdate = false;
+            }
+            for (auto &header : headers)
+            {
+                bool value_match = false;
+                size_t index = m_table.find(header.first, header.second, value_match);
+                if (index && value_match)
+                {
+                    HpackEncodeInt(index, 7, 0x80, out);
+                    continue;
+                }
+                // 长值、长度与日期多为一次性的值，进入动态表只会挤掉有用的条目
+                bool indexing = header.second.size() <= 64 && header.first != "content-length" && header.first != "date" &&
+                                header.first != ":path" && header.first != "set-cookie";
+                if (indexing)
+                {
+                    HpackEncodeInt(index, 6, 0x40, out);
+                }
+                else
+                {
+                    HpackEncodeInt(index, 4, 0x00, out);
+                }
+                if (!index)
+                {
+                    EncodeString(header.first, out);
+                }
+                EncodeString(header.second, out);
+                if (indexing)
+                {
+                    m_table.add(header.first, header.second);
+                }
+            }
+        }
+
+    } // namespace http
+
+} // namespace lim_webserver
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <deque>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        /**
+         * @brief 头部字段列表，名字为小写，保持收发顺序
+         */
+        using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+        /**
+         * @brief HPACK的Huffman编码(RFC 7541 附录B)
+         */
+        class Huffman
+        {
+        public:
+            /**
+             * @brief 编码后的字节数
+             */
+            static size_t EncodedLength(const std::string &str);
+
+            static void Encode(const std::string &str, std::string &out);
+
+            /**
+             * @return false 编码非法：含EOS、填充超过7位或填充不全为1
+             */
+            static bool Decode(const uint8_t *data, size_t len, std::string &out);
+        };
+
+        /**
+         * @brief HPACK动态表
+         *
+         * @details 下标从1开始，1到61为静态表，之后为动态表(最新的条目下标最小)。
+         *          条目大小按名字与值的长度加32计算，超出上限时从最旧的条目开始淘汰。
+         */
+        class HpackTable
+        {
+        public:
+            static const size_t STATIC_SIZE = 61;
+
+            explicit HpackTable(size_t max_size = 4096) : m_maxSize(max_size) {}
+
+            /**
+             * @return false 下标越界
+             */
+            bool get(size_t index, std::string &name, std::string &value) const;
+
+            void add(const std::string &name, const std::string &value);
+
+            void setMaxSize(size_t max_size);
+
+            inline size_t maxSize() const { return m_maxSize; }
+
+            /**
+             * @brief 查找条目
+             *
+             * @param[out] value_match 找到的条目值是否也相同
+             * @return size_t 下标，0为未找到
+             */
+            size_t find(const std::string &name, const std::string &value, bool &value_match) const;
+
+        private:
+            void evict();
+
+        private:
+            std::deque<std::pair<std::string, std::string>> m_entries; // 动态表，队首最新
+            size_t m_size = 0;                                        // 当前大小
+            size_t m_maxSize;                                         // 大小上限
+        };
+
+        /**
+         * @brief HPACK解码器，每个连接一个，按收到头部块的顺序使用
+         */
+        class HpackDecoder
+        {
+        public:
+            /**
+             * @brief 本端允许对端使用的动态表上限，即SETTINGS_HEADER_TABLE_SIZE
+             */
+            inline void setMaxTableSize(size_t size) { m_maxAllowed = size; }
+
+            /**
+             * @brief 解码一个完整的头部块
+             *
+             * @return false 压缩错误，连接须以COMPRESSION_ERROR关闭
+             */
+            bool decode(const uint8_t *data, size_t len, HeaderList &headers);
+
+        private:
+            HpackTable m_table;
+            size_t m_maxAllowed = 4096;
+        };
+
+        /**
+         * @brief HPACK编码器，每个连接一个，头部块须按编码顺序发出
+         *
+         * @details 与静态表或动态表完全匹配的字段编码为下标；其余字段以增量索引的字面量编码，
+         *          过长或易变的字段不进入动态表。字符串在Huffman编码更短时使用Huffman编码。
+         */
+        class HpackEncoder
+        {
+        public:
+            /**
+             * @brief 对端通告的SETTINGS_HEADER_TABLE_SIZE，下次编码时先发出表大小更新
+             */
+            void setMaxTableSize(size_t size);
+
+            void encode(const HeaderList &headers, std::string &out);
+
+        private:
+            HpackTable m_table;
+            bool m_sizeUpdate = false; // 是否需要发出表大小更新
+        };
+
+        /**
+         * @brief 带前缀的整数编码(RFC 7541 5.1)
+         *
+         * @param flags  首字节中前缀以外的高位
+         * @param prefix 前缀位数
+         */
+        void HpackEncodeInt(uint64_t value, int prefix, uint8_t flags, std::string &out);
+
+        /**
+         * @return false 数据不足或溢出
+         */
+        bool HpackDecodeInt(const uint8_t *&p, const uint8_t *end, int prefix, uint64_t &value);
+
+    } // namespace http
+
+} // namespace lim_webserver
@@ -0,0 +1,928 @@
+#include "Http2Session.h"
+#include "base/Configer.h"
+#include "base/Util.h"
+#include "coroutine/Processor.h"
+#include "coroutine/Scheduler.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+#include <sys/socket.h>
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        static Logger::ptr g_logger = LOG_SYS();
+
+        static ConfigerVar<uint32_t>::ptr g_http2_max_concurrent_streams =
+            Configer::Lookup<uint32_t>("http2.max_concurrent_streams", 128, "max concurrent streams per http2 connection, more are refused");
+
+        static ConfigerVar<uint32_t>::ptr g_http2_initial_window_size =
+            Configer::Lookup<uint32_t>("http2.initial_window_size", 1024 * 1024, "http2 receive window advertised for each stream and the connection");
+
+        const char HTTP2_PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+        // 读缓冲区大小，能容纳多个默认大小(16KB)的帧
+        static const size_t READ_BUFFER_SIZE = 64 * 1024;
+
+        // 本端接收的最大帧长度，即不修改的SETTINGS_MAX_FRAME_SIZE
+        static const uint32_t LOCAL_MAX_FRAME = 16384;
+
+        // 头部块(含CONTINUATION)的上限
+        static const size_t MAX_HEADER_BLOCK = 64 * 1024;
+
+        static const int64_t MAX_WINDOW = 0x7fffffff;
+
+        static inline uint32_t ReadU32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]; }
+
+        static inline void WriteU32(uint8_t *p, uint32_t v)
+        {
+            p[0] = v >> 24;
+            p[1] = v >> 16;
+            p[2] = v >> 8;
+            p[3] = v;
+        }
+
+        static inline void WriteSetting(uint8_t *p, Http2Setting id, uint32_t value)
+        {
+            p[0] = (uint16_t)id >> 8;
+            p[1] = (uint16_t)id;
+            WriteU32(p + 2, value);
+        }
+
+        /**
+         * @brief 去掉PADDED标志带来的填充
+         *
+         * @return false 填充长度不小于载荷长度
+         */
+        static bool StripPadding(const Http2FrameHeader &head, const uint8_t *&data, size_t &len)
+        {
+            len = head.length;
+            if (!(head.flags & HTTP2_FLAG_PADDED))
+            {
+                return true;
+            }
+            if (len < 1 || (size_t)data[0] + 1 > len)
+            {
+                return false;
+            }
+            len -= (size_t)data[0] + 1;
+            ++data;
+            return true;
+        }
+
+        void Http2FrameHeader::encode(uint8_t *out) const
+        {
+            out[0] = length >> 16;
+            out[1] = length >> 8;
+            out[2] = length;
+            out[3] = (uint8_t)type;
+            out[4] = flags;
+            WriteU32(out + 5, stream_id & 0x7fffffff);
+        }
+
+        void Http2FrameHeader::decode(const uint8_t *in)
+        {
+            length = ((uint32_t)in[0] << 16) | ((uint32_t)in[1] << 8) | in[2];
+            type = (Http2FrameType)in[3];
+            flags = in[4];
+            stream_id = ReadU32(in + 5) & 0x7fffffff;
+        }
+
+        Http2Session::Http2Session(Socket::ptr sock, bool owner)
+            : HttpSession(sock, owner), m_maxStreams(g_http2_max_concurrent_streams->getValue()),
+              m_localWindow(std::min<uint32_t>(std::max<uint32_t>(g_http2_initial_window_size->getValue(), 65535), MAX_WINDOW)),
+              m_maxBodySize(HttpRequestParser::GetHttpRequestMaxBodySize())
+        {
+        }
+
+        void Http2Session::serve(const Handler &handler, HttpRequest::ptr upgrade)
+        {
+            m_handler = handler;
+            if (upgrade)
+            {
+                // HTTP2-Settings为base64url编码的SETTINGS载荷，等同于对端的第一个SETTINGS帧
+                std::string settings;
+                if (!StringUtil::Base64Decode(upgrade->getHeader("HTTP2-Settings"), settings) || settings.size() % 6 != 0 ||
+                    !applySettings((const uint8_t *)settings.data(), settings.size()))
+                {
+                    HttpSession::close();
+                    return;
+                }
+                static const char SWITCHING[] = "HTTP/1.1 101 Switching Protocols\r\n"
+                                                "Connection: Upgrade\r\n"
+                                                "Upgrade: h2c\r\n\r\n";
+                if (m_socket->send(SWITCHING, sizeof(SWITCHING) - 1, MSG_NOSIGNAL) <= 0)
+                {
+                    HttpSession::close();
+                    return;
+                }
+            }
+            if (fill(HTTP2_PREFACE_SIZE) <= 0 || memcmp(&m_rbuf[m_rpos], HTTP2_PREFACE, HTTP2_PREFACE_SIZE) != 0)
+            {
+                HttpSession::close();
+                return;
+            }
+            m_rpos += HTTP2_PREFACE_SIZE;
+
+            Http2Session::ptr self = shared_from_this();
+            Processor::GetCurrentScheduler()->createTask([self]() { self->senderLoop(); });
+
+            // 本端的SETTINGS，并把连接级接收窗口扩大到与流相同
+            uint8_t settings[12];
+            WriteSetting(settings, Http2Setting::MAX_CONCURRENT_STREAMS, m_maxStreams);
+            WriteSetting(settings + 6, Http2Setting::INITIAL_WINDOW_SIZE, m_localWindow);
+            post(Http2FrameType::SETTINGS, 0, 0, settings, sizeof(settings));
+            if (m_localWindow > 65535)
+            {
+                uint8_t increment[4];
+                WriteU32(increment, m_localWindow - 65535);
+                post(Http2FrameType::WINDOW_UPDATE, 0, 0, increment, sizeof(increment));
+            }
+
+            if (upgrade)
+            {
+                // 升级请求隐式开启流1，且对端已结束发送(RFC 7540 3.2)
+                Http2Stream::ptr stream = std::make_shared<Http2Stream>();
+                stream->id = 1;
+                stream->request = upgrade;
+                m_lastStreamId = 1;
+                {
+                    CoMutex::Lock lock(m_mutex);
+                    stream->sendWindow = m_peerInitialWindow;
+                    m_streams[1] = stream;
+                }
+                dispatch(stream);
+            }
+
+            while (!isClosed())
+            {
+                if (fill(Http2FrameHeader::SIZE) <= 0)
+                {
+                    break;
+                }
+                Http2FrameHeader head;
+                head.decode((const uint8_t *)&m_rbuf[m_rpos]);
+                if (head.length > LOCAL_MAX_FRAME)
+                {
+                    fail(Http2Error::FRAME_SIZE_ERROR);
+                    break;
+                }
+                if (fill(Http2FrameHeader::SIZE + head.length) <= 0)
+                {
+                    break;
+                }
+                // 载荷在下次fill之前一直有效
+                const uint8_t *payload = (const uint8_t *)&m_rbuf[m_rpos + Http2FrameHeader::SIZE];
+                m_rpos += Http2FrameHeader::SIZE + head.length;
+                if (!onFrame(head, payload))
+                {
+                    break;
+                }
+            }
+            shutdown();
+        }
+
+        int Http2Session::fill(size_t need)
+        {
+            while (m_rend - m_rpos < need)
+            {
+                if (m_rpos > 0)
+                {
+                    memmove(&m_rbuf[0], &m_rbuf[m_rpos], m_rend - m_rpos);
+                    m_rend -= m_rpos;
+                    m_rpos = 0;
+                }
+                if (m_rbuf.size() < std::max(need, READ_BUFFER_SIZE))
+                {
+                    m_rbuf.resize(std::max(need, READ_BUFFER_SIZE));
+                }
+                int n = resv(&m_rbuf[m_rend], m_rbuf.size() - m_rend);
+                if (n <= 0)
+                {
+                    return n;
+                }
+                m_rend += n;
+            }
+            return 1;
+        }
+
+        bool Http2Session::onFrame(const Http2FrameHeader &head, const uint8_t *payload)
+        {
+            // 头部块未结束时只能收到同一流的CONTINUATION
+            if (m_continuationStream && (head.type != Http2FrameType::CONTINUATION || head.stream_id != m_continuationStream))
+            {
+                return fail(Http2Error::PROTOCOL_ERROR);
+            }
+            switch (head.type)
+            {
+            case Http2FrameType::DATA:
+                return onData(head, payload);
+            case Http2FrameType::HEADERS:
+                return onHeaders(head, payload);
+            case Http2FrameType::CONTINUATION:
+                if (!m_continuationStream)
+                {
+                    return fail(Http2Error::PROTOCOL_ERROR);
+                }
+                if (m_headerBlock.size() + head.length > MAX_HEADER_BLOCK)
+                {
+                    return fail(Http2Error::ENHANCE_YOUR_CALM);
+                }
+                m_headerBlock.append((const char *)payload, head.length);
+                if (head.flags & HTTP2_FLAG_END_HEADERS)
+                {
+                    uint32_t stream_id = m_continuationStream;
+                    m_continuationStream = 0;
+                    return onHeaderBlock(stream_id, m_continuationEnd);
+                }
+                return true;
+            case Http2FrameType::PRIORITY:
+                // 不做优先级调度，只检查格式
+                if (!head.stream_id)
+                {
+                    return fail(Http2Error::PROTOCOL_ERROR);
+                }
+                if (head.length != 5)
+                {
+                    resetStream(head.stream_id, Http2Error::FRAME_SIZE_ERROR);
+                }
+                return true;
+            case Http2FrameType::RST_STREAM:
+            {
+                if (!head.stream_id || head.stream_id > m_lastStreamId)
+                {
+                    return fail(Http2Error::PROTOCOL_ERROR);
+                }
+                if (head.length != 4)
+                {
+                    return fail(Http2Error::FRAME_SIZE_ERROR);
+                }
+                CoMutex::Lock lock(m_mutex);
+                auto it = m_streams.find(head.stream_id);
+                if (it != m_streams.end())
+                {
+                    it->second->reset = true;
+                    // 已交给处理协程的流由处理协程移除
+                    if (!it->second->dispatched)
+                    {
+                        m_streams.erase(it);
+                    }
+                }
+                m_windowCond.notify_all();
+                return true;
+            }
+            case Http2FrameType::SETTINGS:
+                return onSettings(head, payload);
+            case Http2FrameType::PUSH_PROMISE:
+                // 客户端不能推送
+                return fail(Http2Error::PROTOCOL_ERROR);
+            case Http2FrameType::PING:
+                if (head.stream_id)
+                {
+                    return fail(Http2Error::PROTOCOL_ERROR);
+                }
+                if (head.length != 8)
+                {
+                    return fail(Http2Error::FRAME_SIZE_ERROR);
+                }
+                if (!(head.flags & HTTP2_FLAG_ACK))
+                {
+                    post(Http2FrameType::PING, HTTP2_FLAG_ACK, 0, payload, 8);
+                }
+                return true;
+            case Http2FrameType::GOAWAY:
+                if (head.stream_id)
+                {
+                    return fail(Http2Error::PROTOCOL_ERROR);
+                }
+                // 对端不再开启新流，已开启的流照常完成，由对端关闭连接
+                LOG_DEBUG(g_logger) << "http2 goaway from " << peerAddressString() << " error=" << (head.length >= 8 ? ReadU32(payload + 4) : 0);
+                return true;
+            case Http2FrameType::WINDOW_UPDATE:
+                return onWindowUpdate(head, payload);
+            default:
+                // 未知类型的帧必须忽略
+                return true;
+            }
+        }
+
+        bool Http2Session::onData(const Http2FrameHeader &head, const uint8_t *payload)
+        {
+            if (!head.stream_id)
+            {
+                return fail(Http2Error::PROTOCOL_ERROR);
+            }
+            const uint8_t *data = payload;
+            size_t len;
+            if (!StripPadding(head, data, len))
+            {
+                return fail(Http2Error::PROTOCOL_ERROR);
+            }
+            // 流控按整个载荷(含填充)计算，过半时归还，避免逐帧发送WINDOW_UPDATE
+            m_recvConsumed += head.length;
+            if (m_recvConsumed >= m_localWindow / 2)
+            {
+                uint8_t increment[4];
+                WriteU32(increment, m_recvConsumed);
+                post(Http2FrameType::WINDOW_UPDATE, 0, 0, increment, sizeof(increment));
+                m_recvConsumed = 0;
+            }
+
+            Http2Stream::ptr stream;
+            {
+                CoMutex::Lock lock(m_mutex);
+                auto it = m_streams.find(head.stream_id);
+                if (it != m_streams.end())
+                {
+                    stream = it->second;
+                }
+            }
+            if (!stream || stream->dispatched)
+            {
+                if (head.stream_id > m_lastStreamId)
+                {
+                    return fail(Http2Error::PROTOCOL_ERROR);
+                }
+                resetStream(head.stream_id, Http2Error::STREAM_CLOSED);
+                return true;
+            }
+            if (stream->body.size() + len > m_maxBodySize)
+            {
+                resetStream(head.stream_id, Http2Error::REFUSED_STREAM);
+                removeStream(head.stream_id);
+                return true;
+            }
+            stream->body.append((const char *)data, len);
+            if (head.flags & HTTP2_FLAG_END_STREAM)
+            {
+                dispatch(stream);
+                return true;
+            }
+            stream->recvConsumed += head.length;
+            if (stream->recvConsumed >= m_localWindow / 2)
+            {
+                uint8_t increment[4];
+                WriteU32(increment, stream->recvConsumed);
+                post(Http2FrameType::WINDOW_UPDATE, 0, head.stream_id, increment, sizeof(increment));
+                stream->recvConsumed = 0;
+            }
+            return true;
+        }
+
+        bool Http2Session::onHeaders(const Http2FrameHeader &head, const uint8_t *payload)
+        {
+            // 客户端开启的流ID为奇数
+            if (!head.stream_id || !(head.stream_id & 1))
+            {
+                return fail(Http2Error::PROTOCOL_ERROR);
+            }
+            const uint8_t *data = payload;
+            size_t len;
+            if (!StripPadding(head, data, len))
+            {
+                return fail(Http2Error::PROTOCOL_ERROR);
+            }
+            if (head.flags & HTTP2_FLAG_PRIORITY)
+            {
+                // 依赖的流ID与权重，不做优先级调度
+                if (len < 5)
+                {
+                    return fail(Http2Error::FRAME_SIZE_ERROR);
+                }
+                data += 5;
+                len -= 5;
+            }
+            m_headerBlock.assign((const char *)data, len);
+            bool end_stream = head.flags & HTTP2_FLAG_END_STREAM;
+            if (!(head.flags & HTTP2_FLAG_END_HEADERS))
+            {
+                m_continuationStream = head.stream_id;
+                m_continuationEnd = end_stream;
+                return true;
+            }
+            return onHeaderBlock(head.stream_id, end_stream);
+        }
+
+        bool Http2Session::onHeaderBlock(uint32_t stream_id, bool end_stream)
+        {
+            // 即使流随后被拒绝也必须解码，保持与对端的动态表同步
+            HeaderList headers;
+            bool ok = m_decoder.decode((const uint8_t *)m_headerBlock.data(), m_headerBlock.size(), headers);
+            m_headerBlock.clear();
+            if (!ok)
+            {
+                return fail(Http2Error::COMPRESSION_ERROR);
+            }
+
+            if (stream_id <= m_lastStreamId)
+            {
+                // 已有流上的头部块只能是带END_STREAM的尾部字段，尾部字段不传给处理函数
+                Http2Stream::ptr stream;
+                {
+                    CoMutex::Lock lock(m_mutex);
+                    auto it = m_streams.find(stream_id);
+                    if (it != m_streams.end())
+                    {
+                        stream = it->second;
+                    }
+                }
+                if (!stream || stream->dispatched)
+                {
+                    resetStream(stream_id, Http2Error::STREAM_CLOSED);
+                    return true;
+                }
+                if (!end_stream)
+                {
+                    return fail(Http2Error::PROTOCOL_ERROR);
+                }
+                dispatch(stream);
+                return true;
+            }
+
+            m_lastStreamId = stream_id;
+            Http2Stream::ptr stream = std::make_shared<Http2Stream>();
+            stream->id = stream_id;
+            stream->headers = std::move(headers);
+            {
+                CoMutex::Lock lock(m_mutex);
+                if (m_streams.size() >= m_maxStreams)
+                {
+                    stream = nullptr;
+                }
+                else
+                {
+                    stream->sendWindow = m_peerInitialWindow;
+                    m_streams[stream_id] = stream;
+                }
+            }
+            if (!stream)
+            {
+                resetStream(stream_id, Http2Error::REFUSED_STREAM);
+                return true;
+            }
+            if (end_stream)
+            {
+                dispatch(stream);
+            }
+            return true;
+        }
+
+        bool Http2Session::onSettings(const Http2FrameHeader &head, const uint8_t *payload)
+        {
+            if (head.stream_id)
+            {
+                return fail(Http2Error::PROTOCOL_ERROR);
+            }
+            if (head.flags & HTTP2_FLAG_ACK)
+            {
+                return head.length == 0 ? true : fail(Http2Error::FRAME_SIZE_ERROR);
+            }
+            if (head.length % 6 != 0)
+            {
+                return fail(Http2Error::FRAME_SIZE_ERROR);
+            }
+            if (!applySettings(payload, head.length))
+            {
+                return false;
+            }
+            post(Http2FrameType::SETTINGS, HTTP2_FLAG_ACK, 0);
+            return true;
+        }
+
+        bool Http2Session::applySettings(const uint8_t *payload, size_t len)
+        {
+            for (size_t i = 0; i + 6 <= len; i += 6)
+            {
+                Http2Setting id = (Http2Setting)((payload[i] << 8) | payload[i + 1]);
+                uint32_t value = ReadU32(payload + i + 2);
+                switch (id)
+                {
+                case Http2Setting::HEADER_TABLE_SIZE:
+                {
+                    Spinlock::Lock lock(m_queueLock);
+                    m_encoder.setMaxTableSize(value);
+                    break;
+                }
+                case Http2Setting::ENABLE_PUSH:
+                    if (value > 1)
+                    {
+                        return fail(Http2Error::PROTOCOL_ERROR);
+                    }
+                    break;
+                case Http2Setting::INITIAL_WINDOW_SIZE:
+                {
+                    if (value > MAX_WINDOW)
+                    {
+                        return fail(Http2Error::FLOW_CONTROL_ERROR);
+                    }
+                    // 差值作用于所有流的发送窗口，窗口可能因此变为负数(RFC 7540 6.9.2)
+                    CoMutex::Lock lock(m_mutex);
+                    int64_t delta = (int64_t)value - m_peerInitialWindow;
+                    m_peerInitialWindow = value;
+                    for (auto &it : m_streams)
+                    {
+                        it.second->sendWindow += delta;
+                    }
+                    m_windowCond.notify_all();
+                    break;
+                }
+                case Http2Setting::MAX_FRAME_SIZE:
+                    if (value < 16384 || value > 16777215)
+                    {
+                        return fail(Http2Error::PROTOCOL_ERROR);
+                    }
+                    m_peerMaxFrame.store(value, std::memory_order_relaxed);
+                    break;
+                default:
+                    // MAX_CONCURRENT_STREAMS限制本端推送，MAX_HEADER_LIST_SIZE只是建议，未知参数必须忽略
+                    break;
+                }
+            }
+            return true;
+        }
+
+        bool Http2Session::onWindowUpdate(const Http2FrameHeader &head, const uint8_t *payload)
+        {
+            if (head.length != 4)
+            {
+                return fail(Http2Error::FRAME_SIZE_ERROR);
+            }
+            uint32_t increment = ReadU32(payload) & 0x7fffffff;
+            if (!increment)
+            {
+                if (!head.stream_id)
+                {
+                    return fail(Http2Error::PROTOCOL_ERROR);
+                }
+                resetStream(head.stream_id, Http2Error::PROTOCOL_ERROR);
+                return true;
+            }
+            bool overflow = false;
+            {
+                CoMutex::Lock lock(m_mutex);
+                if (!head.stream_id)
+                {
+                    m_sendWindow += increment;
+                    overflow = m_sendWindow > MAX_WINDOW;
+                }
+                else
+                {
+                    // 已结束的流上的WINDOW_UPDATE直接忽略
+                    auto it = m_streams.find(head.stream_id);
+                    if (it != m_streams.end())
+                    {
+                        it->second->sendWindow += increment;
+                        if (it->second->sendWindow > MAX_WINDOW)
+                        {
+                            it->second->reset = true;
+                            resetStream(head.stream_id, Http2Error::FLOW_CONTROL_ERROR);
+                        }
+                    }
+                }
+                m_windowCond.notify_all();
+            }
+            return overflow ? fail(Http2Error::FLOW_CONTROL_ERROR) : true;
+        }
+
+        void Http2Session::dispatch(const Http2Stream::ptr &stream)
+        {
+            stream->dispatched = true;
+            Http2Session::ptr self = shared_from_this();
+            Processor::GetCurrentScheduler()->createTask([self, stream]() { self->handleStream(stream); });
+        }
+
+        void Http2Session::handleStream(Http2Stream::ptr stream)
+        {
+            HttpRequest::ptr req = stream->request ? stream->request : buildRequest(stream);
+            if (!req)
+            {
+                resetStream(stream->id, Http2Error::PROTOCOL_ERROR);
+                removeStream(stream->id);
+                return;
+            }
+            HttpResponse::ptr rsp(new HttpResponse(0x20, false));
+            m_handler(req, rsp);
+            sendResponse(stream, rsp);
+            removeStream(stream->id);
+        }
+
+        HttpRequest::ptr Http2Session::buildRequest(const Http2Stream::ptr &stream)
+        {
+            HttpRequest::ptr req(new HttpRequest(0x20, false));
+            std::string method, path, authority, cookie;
+            for (auto &header : stream->headers)
+            {
+                const std::string &name = header.first;
+                if (!name.empty() && name[0] == ':')
+                {
+                    if (name == ":method")
+                    {
+                        method = header.second;
+                    }
+                    else if (name == ":path")
+                    {
+                        path = header.second;
+                    }
+                    else if (name == ":authority")
+                    {
+                        authority = header.second;
+                    }
+                    else if (name != ":scheme")
+                    {
+                        return nullptr;
+                    }
+                }
+                else if (name == "cookie")
+                {
+                    // cookie可能被拆成多个字段以提高压缩率，交给处理函数前合并(RFC 7540 8.1.2.5)
+                    if (!cookie.empty())
+                    {
+                        cookie += "; ";
+                    }
+                    cookie += header.second;
+                }
+                else
+                {
+                    req->setHeader(name, header.second);
+                }
+            }
+            HttpMethod m = StringToHttpMethod(method);
+            if (path.empty() || m == HttpMethod::INVALID_METHOD)
+            {
+                return nullptr;
+            }
+            req->setMethod(m);
+            size_t pos = path.find('?');
+            if (pos != std::string::npos)
+            {
+                req->setQuery(path.substr(pos + 1));
+                path.resize(pos);
+            }
+            req->setPath(path);
+            if (!cookie.empty())
+            {
+                req->setHeader("cookie", cookie);
+            }
+            if (!authority.empty() && !req->hasHeader("host"))
+            {
+                req->setHeader("host", authority);
+            }
+            req->setBody(stream->body);
+            stream->body.clear();
+            return req;
+        }
+
+        void Http2Session::sendResponse(const Http2Stream::ptr &stream, HttpResponse::ptr rsp)
+        {
+            const std::string &body = rsp->body();
+            HeaderList headers;
+            headers.emplace_back(":status", std::to_string((int)rsp->status()));
+            for (auto &header : rsp->headers())
+            {
+                std::string name = header.first;
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                // 连接相关的头部在HTTP/2中非法(RFC 7540 8.1.2.2)，content-length按实际消息体重新给出
+                if (name == "connection" || name == "keep-alive" || name == "proxy-connection" || name == "transfer-encoding" || name == "upgrade" ||
+                    name == "content-length")
+                {
+                    continue;
+                }
+                headers.emplace_back(std::move(name), header.second);
+            }
+            for (auto &cookie : rsp->cookies())
+            {
+                headers.emplace_back("set-cookie", cookie);
+            }
+            headers.emplace_back("content-length", std::to_string(body.size()));
+
+            if (stream->reset)
+            {
+                return;
+            }
+            bool notify;
+            {
+                Spinlock::Lock lock(m_queueLock);
+                if (m_closed.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+                std::string block;
+                m_encoder.encode(headers, block);
+                std::shared_ptr<const std::string> owner = std::make_shared<const std::string>(std::move(block));
+                notify = m_sendQueue.empty();
+                // 超过对端最大帧长度的头部块拆为HEADERS与若干CONTINUATION
+                size_t max_frame = m_peerMaxFrame.load(std::memory_order_relaxed);
+                size_t offset = 0;
+                do
+                {
+                    size_t n = std::min(max_frame, owner->size() - offset);
+                    bool last = offset + n == owner->size();
+                    Http2FrameType type = offset == 0 ? Http2FrameType::HEADERS : Http2FrameType::CONTINUATION;
+                    uint8_t flags = (last ? HTTP2_FLAG_END_HEADERS : 0) | (offset == 0 && body.empty() ? HTTP2_FLAG_END_STREAM : 0);
+                    pushLocked(type, flags, stream->id, owner, owner->data() + offset, n);
+                    offset += n;
+                } while (offset < owner->size());
+            }
+            if (notify)
+            {
+                m_sendSignal.notify();
+            }
+
+            // DATA帧直接引用响应体，响应对象随最后一帧写出后释放
+            std::shared_ptr<const std::string> owner(rsp, &body);
+            size_t offset = 0;
+            while (offset < body.size())
+            {
+                size_t n;
+                {
+                    CoMutex::Lock lock(m_mutex);
+                    while (!isClosed() && !stream->reset && (m_sendWindow <= 0 || stream->sendWindow <= 0))
+                    {
+                        m_windowCond.wait(m_mutex);
+                    }
+                    if (isClosed() || stream->reset)
+                    {
+                        return;
+                    }
+                    n = std::min<int64_t>({(int64_t)(body.size() - offset), (int64_t)m_peerMaxFrame.load(std::memory_order_relaxed), m_sendWindow,
+                                           stream->sendWindow});
+                    m_sendWindow -= n;
+                    stream->sendWindow -= n;
+                }
+                bool last = offset + n == body.size();
+                {
+                    Spinlock::Lock lock(m_queueLock);
+                    if (m_closed.load(std::memory_order_relaxed))
+                    {
+                        return;
+                    }
+                    notify = m_sendQueue.empty();
+                    pushLocked(Http2FrameType::DATA, last ? HTTP2_FLAG_END_STREAM : 0, stream->id, owner, body.data() + offset, n);
+                }
+                if (notify)
+                {
+                    m_sendSignal.notify();
+                }
+                offset += n;
+            }
+        }
+
+        bool Http2Session::post(Http2FrameType type, uint8_t flags, uint32_t stream_id, const void *payload, size_t len)
+        {
+            std::shared_ptr<const std::string> owner;
+            if (len)
+            {
+                owner = std::make_shared<const std::string>((const char *)payload, len);
+            }
+            bool notify;
+            {
+                Spinlock::Lock lock(m_queueLock);
+                if (m_closed.load(std::memory_order_relaxed))
+                {
+                    return false;
+                }
+                notify = m_sendQueue.empty();
+                pushLocked(type, flags, stream_id, owner, owner ? owner->data() : nullptr, len);
+            }
+            // 只在队列由空变为非空时通知，发送协程每次醒来取走全部帧
+            if (notify)
+            {
+                m_sendSignal.notify();
+            }
+            return true;
+        }
+
+        void Http2Session::pushLocked(Http2FrameType type, uint8_t flags, uint32_t stream_id, const std::shared_ptr<const std::string> &owner,
+                                      const char *data, size_t len)
+        {
+            m_sendQueue.emplace_back();
+            OutFrame &frame = m_sendQueue.back();
+            Http2FrameHeader head;
+            head.length = len;
+            head.type = type;
+            head.flags = flags;
+            head.stream_id = stream_id;
+            head.encode(frame.head);
+            frame.owner = owner;
+            frame.data = data;
+            frame.len = len;
+        }
+
+        void Http2Session::resetStream(uint32_t stream_id, Http2Error error)
+        {
+            uint8_t payload[4];
+            WriteU32(payload, (uint32_t)error);
+            post(Http2FrameType::RST_STREAM, 0, stream_id, payload, sizeof(payload));
+        }
+
+        bool Http2Session::fail(Http2Error error)
+        {
+            LOG_DEBUG(g_logger) << "http2 connection error from " << peerAddressString() << " error=" << (uint32_t)error;
+            uint8_t payload[8];
+            WriteU32(payload, m_lastStreamId);
+            WriteU32(payload + 4, (uint32_t)error);
+            post(Http2FrameType::GOAWAY, 0, 0, payload, sizeof(payload));
+            return false;
+        }
+
+        void Http2Session::removeStream(uint32_t stream_id)
+        {
+            CoMutex::Lock lock(m_mutex);
+            m_streams.erase(stream_id);
+        }
+
+        int Http2Session::writeAll(iovec *iov, int count)
+        {
+            int total = 0;
+            while (count > 0)
+            {
+                int n = m_socket->send(iov, std::min(count, IOV_MAX), MSG_NOSIGNAL);
+                if (n <= 0)
+                {
+                    return n;
+                }
+                total += n;
+                // 跳过已写完的段，调整写了一部分的段
+                while (count > 0 && (size_t)n >= iov->iov_len)
+                {
+                    n -= iov->iov_len;
+                    ++iov;
+                    --count;
+                }
+                if (count > 0)
+                {
+                    iov->iov_base = (char *)iov->iov_base + n;
+                    iov->iov_len -= n;
+                }
+            }
+            return total;
+        }
+
+        void Http2Session::senderLoop()
+        {
+            std::vector<OutFrame> batch;
+            std::vector<iovec> iov;
+            while (true)
+            {
+                m_sendSignal.wait();
+                bool closed;
+                {
+                    Spinlock::Lock lock(m_queueLock);
+                    batch.swap(m_sendQueue);
+                    closed = m_closed.load(std::memory_order_relaxed);
+                }
+                if (!batch.empty())
+                {
+                    iov.clear();
+                    for (OutFrame &frame : batch)
+                    {
+                        iov.push_back({frame.head, Http2FrameHeader::SIZE});
+                        if (frame.len)
+                        {
+                            iov.push_back({(void *)frame.data, frame.len});
+                        }
+                    }
+                    int rt = writeAll(iov.data(), iov.size());
+                    batch.clear();
+                    if (rt <= 0)
+                    {
+                        // 写失败后不再接受新的帧，并唤醒阻塞在读上的处理协程
+                        {
+                            Spinlock::Lock lock(m_queueLock);
+                            m_closed.store(true, std::memory_order_release);
+                            m_sendQueue.clear();
+                        }
+                        ::shutdown(m_socket->fd(), SHUT_RDWR);
+                        break;
+                    }
+                }
+                // 关闭后不会再有新的帧入队，写完最后一批即可退出
+                if (closed)
+                {
+                    break;
+                }
+            }
+            m_senderDone.notify();
+        }
+
+        void Http2Session::shutdown()
+        {
+            {
+                Spinlock::Lock lock(m_queueLock);
+                m_closed.store(true, std::memory_order_release);
+            }
+            m_sendSignal.notify();
+            {
+                CoMutex::Lock lock(m_mutex);
+                m_windowCond.notify_all();
+            }
+            m_senderDone.wait();
+            HttpSession::close();
+        }
+
+    } // namespace http
+
+} // namespace lim_webserver
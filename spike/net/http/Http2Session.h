@@ -0,0 +1,269 @@
+#pragma once
+
+#include "base/Mutex.h"
+#include "coroutine/CoSync.h"
+#include "net/http/Hpack.h"
+#include "net/http/HttpSession.h"
+
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+#include <sys/uio.h>
+#include <unordered_map>
+#include <vector>
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        /**
+         * @brief 帧类型(RFC 7540 6)
+         */
+        enum class Http2FrameType : uint8_t
+        {
+            DATA = 0x0,
+            HEADERS = 0x1,
+            PRIORITY = 0x2,
+            RST_STREAM = 0x3,
+            SETTINGS = 0x4,
+            PUSH_PROMISE = 0x5,
+            PING = 0x6,
+            GOAWAY = 0x7,
+            WINDOW_UPDATE = 0x8,
+            CONTINUATION = 0x9
+        };
+
+        /**
+         * @brief 帧标志
+         */
+        enum Http2Flag : uint8_t
+        {
+            HTTP2_FLAG_END_STREAM = 0x1,
+            HTTP2_FLAG_ACK = 0x1,
+            HTTP2_FLAG_END_HEADERS = 0x4,
+            HTTP2_FLAG_PADDED = 0x8,
+            HTTP2_FLAG_PRIORITY = 0x20
+        };
+
+        /**
+         * @brief 错误码(RFC 7540 7)
+         */
+        enum class Http2Error : uint32_t
+        {
+            NO_ERROR = 0x0,
+            PROTOCOL_ERROR = 0x1,
+            INTERNAL_ERROR = 0x2,
+            FLOW_CONTROL_ERROR = 0x3,
+            SETTINGS_TIMEOUT = 0x4,
+            STREAM_CLOSED = 0x5,
+            FRAME_SIZE_ERROR = 0x6,
+            REFUSED_STREAM = 0x7,
+            CANCEL = 0x8,
+            COMPRESSION_ERROR = 0x9,
+            CONNECT_ERROR = 0xa,
+            ENHANCE_YOUR_CALM = 0xb,
+            INADEQUATE_SECURITY = 0xc,
+            HTTP_1_1_REQUIRED = 0xd
+        };
+
+        /**
+         * @brief SETTINGS参数(RFC 7540 6.5.2)
+         */
+        enum class Http2Setting : uint16_t
+        {
+            HEADER_TABLE_SIZE = 0x1,
+            ENABLE_PUSH = 0x2,
+            MAX_CONCURRENT_STREAMS = 0x3,
+            INITIAL_WINDOW_SIZE = 0x4,
+            MAX_FRAME_SIZE = 0x5,
+            MAX_HEADER_LIST_SIZE = 0x6
+        };
+
+        /**
+         * @brief 客户端连接序言
+         */
+        extern const char HTTP2_PREFACE[];
+        static const size_t HTTP2_PREFACE_SIZE = 24;
+
+        /**
+         * @brief 9字节帧头
+         */
+        struct Http2FrameHeader
+        {
+            static const size_t SIZE = 9;
+
+            uint32_t length = 0;
+            Http2FrameType type = Http2FrameType::DATA;
+            uint8_t flags = 0;
+            uint32_t stream_id = 0;
+
+            void encode(uint8_t *out) const;
+
+            void decode(const uint8_t *in);
+        };
+
+        /**
+         * @brief 服务端的一个流
+         */
+        struct Http2Stream
+        {
+            using ptr = std::shared_ptr<Http2Stream>;
+
+            uint32_t id;
+            HeaderList headers;        // 请求头部，包括伪头部
+            std::string body;          // 请求体
+            HttpRequest::ptr request;  // h2c升级时由HTTP/1.1请求直接给出
+            int64_t sendWindow;        // 发送窗口
+            uint32_t recvConsumed = 0; // 已接收但未通过WINDOW_UPDATE归还的字节数
+            bool dispatched = false;   // 对端已结束发送，请求已交给处理协程
+            std::atomic<bool> reset{false}; // 已被RST_STREAM终止
+        };
+
+        /**
+         * @brief 服务端HTTP/2会话(明文h2c)
+         *
+         * @details 读：处理连接的协程循环读帧，HPACK解码与流控都在这里完成；请求接收完整后为该流开启一个协程，
+         *          调用与HTTP/1.1相同的处理函数，多个流的请求因此并发处理。
+         *          写：所有帧放入发送队列，由唯一的发送协程一次取走并以writev批量写出。头部块在队列锁内编码并入队，
+         *          保证HPACK动态表的更新顺序与对端收到的顺序一致；DATA帧直接引用响应体，不复制。
+         *          发送受连接与流两级窗口限制，窗口不足的流在条件变量上等待WINDOW_UPDATE。
+         */
+        class Http2Session : public HttpSession, public std::enable_shared_from_this<Http2Session>
+        {
+        public:
+            using ptr = std::shared_ptr<Http2Session>;
+            using Handler = std::function<void(HttpRequest::ptr, HttpResponse::ptr)>;
+
+            Http2Session(Socket::ptr sock, bool owner = true);
+
+            /**
+             * @brief 处理整个连接直到对端关闭或出错，须在协程中调用
+             *
+             * @param handler 每个请求在各自的协程中调用，填写响应后由会话发出
+             * @param upgrade h2c升级请求(带HTTP2-Settings头)，非空时先回复101，该请求作为流1处理；
+             *                为空时连接须以客户端序言开头(prior knowledge)
+             */
+            void serve(const Handler &handler, HttpRequest::ptr upgrade = nullptr);
+
+            inline bool isClosed() const { return m_closed.load(std::memory_order_acquire); }
+
+        private:
+            struct OutFrame
+            {
+                uint8_t head[Http2FrameHeader::SIZE];
+                std::shared_ptr<const std::string> owner; // 持有载荷
+                const char *data;
+                size_t len;
+            };
+
+            /**
+             * @brief 保证读缓冲区中至少有need字节未处理的数据
+             */
+            int fill(size_t need);
+
+            /**
+             * @brief 处理一帧
+             *
+             * @return false 连接错误，已放入GOAWAY
+             */
+            bool onFrame(const Http2FrameHeader &head, const uint8_t *payload);
+
+            bool onData(const Http2FrameHeader &head, const uint8_t *payload);
+
+            bool onHeaders(const Http2FrameHeader &head, const uint8_t *payload);
+
+            /**
+             * @brief 头部块接收完整后解码并建立流
+             */
+            bool onHeaderBlock(uint32_t stream_id, bool end_stream);
+
+            bool onSettings(const Http2FrameHeader &head, const uint8_t *payload);
+
+            bool onWindowUpdate(const Http2FrameHeader &head, const uint8_t *payload);
+
+            /**
+             * @brief 解析SETTINGS载荷并生效
+             */
+            bool applySettings(const uint8_t *payload, size_t len);
+
+            /**
+             * @brief 为请求已接收完整的流开启处理协程
+             */
+            void dispatch(const Http2Stream::ptr &stream);
+
+            /**
+             * @brief 流的处理协程：构造请求、调用处理函数、发出响应
+             */
+            void handleStream(Http2Stream::ptr stream);
+
+            /**
+             * @brief 由流的头部构造请求
+             *
+             * @return nullptr 缺少伪头部或方法非法
+             */
+            HttpRequest::ptr buildRequest(const Http2Stream::ptr &stream);
+
+            void sendResponse(const Http2Stream::ptr &stream, HttpResponse::ptr rsp);
+
+            /**
+             * @brief 放入一个控制帧，载荷会被复制
+             */
+            bool post(Http2FrameType type, uint8_t flags, uint32_t stream_id, const void *payload = nullptr, size_t len = 0);
+
+            /**
+             * @brief 调用方须持有m_queueLock
+             */
+            void pushLocked(Http2FrameType type, uint8_t flags, uint32_t stream_id, const std::shared_ptr<const std::string> &owner, const char *data,
+                            size_t len);
+
+            void resetStream(uint32_t stream_id, Http2Error error);
+
+            /**
+             * @brief 连接错误：放入GOAWAY，之后读循环结束
+             */
+            bool fail(Http2Error error);
+
+            void removeStream(uint32_t stream_id);
+
+            int writeAll(iovec *iov, int count);
+
+            void senderLoop();
+
+            /**
+             * @brief 停止接收新的帧，等发送协程写完队列中的帧后关闭连接
+             */
+            void shutdown();
+
+        private:
+            Handler m_handler;
+            std::string m_rbuf;      // 读缓冲区
+            size_t m_rpos = 0;       // 读缓冲区中未处理数据的起点
+            size_t m_rend = 0;       // 读缓冲区中有效数据的终点
+            HpackDecoder m_decoder;  // 只在读协程中使用
+            std::string m_headerBlock;       // 正在接收的头部块
+            uint32_t m_continuationStream = 0; // 等待CONTINUATION的流，0为无
+            bool m_continuationEnd = false;    // 该头部块的HEADERS帧是否带END_STREAM
+            uint32_t m_lastStreamId = 0;       // 对端开启的最大流ID
+            uint32_t m_recvConsumed = 0;       // 连接级已接收但未归还的字节数
+            uint32_t m_maxStreams;             // 本端允许的最大并发流数
+            uint32_t m_localWindow;            // 本端通告的初始窗口
+            uint64_t m_maxBodySize;            // 请求体上限
+
+            CoMutex m_mutex;                                       // 保护流表与发送窗口
+            CoCondVar m_windowCond;                                // 发送窗口增大或连接关闭时通知
+            std::unordered_map<uint32_t, Http2Stream::ptr> m_streams; // 活跃的流
+            int64_t m_sendWindow = 65535;                          // 连接级发送窗口
+            int64_t m_peerInitialWindow = 65535;                   // 对端的SETTINGS_INITIAL_WINDOW_SIZE
+            std::atomic<uint32_t> m_peerMaxFrame{16384};           // 对端的SETTINGS_MAX_FRAME_SIZE
+
+            Spinlock m_queueLock;             // 保护发送队列、HPACK编码器与关闭标志的设置
+            std::vector<OutFrame> m_sendQueue; // 发送队列
+            HpackEncoder m_encoder;           // 在m_queueLock内使用
+            CoSemaphore m_sendSignal;         // 队列由空变为非空或关闭时通知发送协程
+            CoSemaphore m_senderDone;         // 发送协程退出时通知
+            std::atomic<bool> m_closed{false}; // 是否已停止接收新的帧
+        };
+
+    } // namespace http
+
+} // namespace lim_webserver
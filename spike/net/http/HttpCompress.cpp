@@ -0,0 +1,512 @@
+#include "HttpCompress.h"
+#include "base/Configer.h"
+#include "base/Metrics.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include <string_view>
+#include <zlib.h>
+#ifdef SPNET_WITH_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        static Logger::ptr g_logger = LOG_SYS();
+
+        static ConfigerVar<bool>::ptr g_http_server_compress =
+            Configer::Lookup("http_server.compress", true, "compress text responses by Accept-Encoding with gzip, deflate or br");
+
+        static ConfigerVar<uint64_t>::ptr g_http_server_compress_min_size =
+            Configer::Lookup("http_server.compress_min_size", (uint64_t)1024, "smallest response body in bytes worth compressing");
+
+        static ConfigerVar<int>::ptr g_http_server_compress_level =
+            Configer::Lookup("http_server.compress_level", 6, "compression level, 1-9 for gzip and deflate, 0-11 for br");
+
+        static ConfigerVar<uint64_t>::ptr g_http_server_compress_cache_size =
+            Configer::Lookup("http_server.compress_cache_size", (uint64_t)(16 * 1024 * 1024), "bytes of compressed cacheable responses kept in the lru cache, 0 to disable");
+
+        // 每个缓存条目除数据外的估计开销：链表节点、索引与控制块
+        static const size_t CACHE_ENTRY_OVERHEAD = 128;
+
+        /**
+         * @brief 压缩指标，首次使用时注册
+         */
+        struct CompressMetrics
+        {
+            MetricCounter *input[4];
+            MetricCounter *output[4];
+            MetricCounter *hits;
+            MetricCounter *misses;
+
+            static CompressMetrics &Get()
+            {
+                static CompressMetrics metrics = []()
+                {
+                    CompressMetrics m;
+                    MetricsRegistry *registry = MetricsRegistry::GetInstance();
+                    for (ContentCoding coding : {ContentCoding::IDENTITY, ContentCoding::GZIP, ContentCoding::DEFLATE, ContentCoding::BR})
+                    {
+                        MetricLabels labels = {{"coding", coding == ContentCoding::IDENTITY ? "identity" : ContentCodingToString(coding)}};
+                        m.input[(int)coding] = registry->counter("spnet_http_compress_input_bytes_total", "Response bytes fed to the compressor", labels);
+                        m.output[(int)coding] = registry->counter("spnet_http_compress_output_bytes_total", "Bytes produced by the compressor", labels);
+                    }
+                    m.hits = registry->counter("spnet_http_compress_cache_hits_total", "Responses served from the compressed variant cache");
+                    m.misses = registry->counter("spnet_http_compress_cache_misses_total", "Cacheable responses compressed because the variant was not cached");
+                    return m;
+                }();
+                return metrics;
+            }
+        };
+
+        const char *ContentCodingToString(ContentCoding coding)
+        {
+            switch (coding)
+            {
+            case ContentCoding::GZIP:
+                return "gzip";
+            case ContentCoding::DEFLATE:
+                return "deflate";
+            case ContentCoding::BR:
+                return "br";
+            default:
+                return "";
+            }
+        }
+
+        bool IsContentCodingSupported(ContentCoding coding)
+        {
+#ifdef SPNET_WITH_BROTLI
+            return true;
+#else
+            return coding != ContentCoding::BR;
+#endif
+        }
+
+        static std::string_view Trim(std::string_view s)
+        {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+            {
+                s.remove_prefix(1);
+            }
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+            {
+                s.remove_suffix(1);
+            }
+            return s;
+        }
+
+        static bool EqualsIgnoreCase(std::string_view a, const char *b)
+        {
+            return a.size() == strlen(b) && strncasecmp(a.data(), b, a.size()) == 0;
+        }
+
+        ContentCoding NegotiateContentCoding(const std::string &accept_encoding)
+        {
+            // 依次为br、gzip、deflate、*的q值，-1为未出现
+            double q[4] = {-1, -1, -1, -1};
+            std::string_view rest(accept_encoding);
+            while (!rest.empty())
+            {
+                size_t comma = rest.find(',');
+                std::string_view item = rest.substr(0, comma);
+                rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+
+                size_t semi = item.find(';');
+                std::string_view name = Trim(item.substr(0, semi));
+                double weight = 1;
+                if (semi != std::string_view::npos)
+                {
+                    std::string_view param = Trim(item.substr(semi + 1));
+                    if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=')
+                    {
+                        weight = strtod(std::string(param.substr(2)).c_str(), nullptr);
+                    }
+                }
+                int index = EqualsIgnoreCase(name, "br") ? 0
+                            : EqualsIgnoreCase(name, "gzip") || EqualsIgnoreCase(name, "x-gzip") ? 1
+                            : EqualsIgnoreCase(name, "deflate")                                    ? 2
+                            : name == "*"                                                          ? 3
+                                                                                                   : -1;
+                if (index >= 0)
+                {
+                    q[index] = weight;
+                }
+            }
+            static const ContentCoding CODINGS[3] = {ContentCoding::BR, ContentCoding::GZIP, ContentCoding::DEFLATE};
+            ContentCoding best = ContentCoding::IDENTITY;
+            double best_q = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                double weight = q[i] >= 0 ? q[i] : q[3];
+                if (weight > best_q && IsContentCodingSupported(CODINGS[i]))
+                {
+                    best = CODINGS[i];
+                    best_q = weight;
+                }
+            }
+            return best;
+        }
+
+        StreamCompressor::StreamCompressor(ContentCoding coding, int level) : m_coding(coding)
+        {
+            if (coding == ContentCoding::GZIP || coding == ContentCoding::DEFLATE)
+            {
+                m_zstream = new z_stream();
+                // 31为带gzip头尾，15为HTTP中deflate所指的zlib格式
+                int window_bits = coding == ContentCoding::GZIP ? 15 + 16 : 15;
+                if (deflateInit2(m_zstream, std::min(std::max(level, 1), 9), Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                {
+                    LOG_ERROR(g_logger) << "deflateInit2 fail";
+                    delete m_zstream;
+                    m_zstream = nullptr;
+                }
+            }
+#ifdef SPNET_WITH_BROTLI
+            else if (coding == ContentCoding::BR)
+            {
+                m_brotli = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+                if (m_brotli)
+                {
+                    BrotliEncoderSetParameter(m_brotli, BROTLI_PARAM_QUALITY, std::min(std::max(level, 0), BROTLI_MAX_QUALITY));
+                    BrotliEncoderSetParameter(m_brotli, BROTLI_PARAM_MODE, BROTLI_MODE_TEXT);
+                }
+            }
+#endif
+        }
+
+        StreamCompressor::~StreamCompressor()
+        {
+            if (m_zstream)
+            {
+                deflateEnd(m_zstream);
+                delete m_zstream;
+            }
+#ifdef SPNET_WITH_BROTLI
+            if (m_brotli)
+            {
+                BrotliEncoderDestroyInstance(m_brotli);
+            }
+#endif
+        }
+
+        bool StreamCompressor::deflate(const void *data, size_t length, int mode, std::string &out)
+        {
+            m_zstream->next_in = (Bytef *)data;
+            m_zstream->avail_in = length;
+            while (true)
+            {
+                // 直接写入out的尾部，省去中间缓冲
+                size_t used = out.size();
+                out.resize(used + std::max<size_t>(deflateBound(m_zstream, m_zstream->avail_in), 4096));
+                m_zstream->next_out = (Bytef *)&out[used];
+                m_zstream->avail_out = out.size() - used;
+                int rt = ::deflate(m_zstream, mode);
+                out.resize(out.size() - m_zstream->avail_out);
+                if (rt == Z_STREAM_ERROR)
+                {
+                    return false;
+                }
+                if (mode == Z_FINISH ? rt == Z_STREAM_END : m_zstream->avail_in == 0 && m_zstream->avail_out != 0)
+                {
+                    return true;
+                }
+            }
+        }
+
+        bool StreamCompressor::brotli(const void *data, size_t length, int op, std::string &out)
+        {
+#ifdef SPNET_WITH_BROTLI
+            const uint8_t *next_in = (const uint8_t *)data;
+            size_t avail_in = length;
+            if (op == BROTLI_OPERATION_FINISH && length)
+            {
+                BrotliEncoderSetParameter(m_brotli, BROTLI_PARAM_SIZE_HINT, std::min<size_t>(length, 1u << 30));
+            }
+            do
+            {
+                size_t used = out.size();
+                out.resize(used + std::max<size_t>(avail_in / 2, 4096));
+                uint8_t *next_out = (uint8_t *)&out[used];
+                size_t avail_out = out.size() - used;
+                if (!BrotliEncoderCompressStream(m_brotli, (BrotliEncoderOperation)op, &avail_in, &next_in, &avail_out, &next_out, nullptr))
+                {
+                    out.resize(used);
+                    return false;
+                }
+                out.resize(out.size() - avail_out);
+            } while (avail_in || BrotliEncoderHasMoreOutput(m_brotli) || (op == BROTLI_OPERATION_FINISH && !BrotliEncoderIsFinished(m_brotli)));
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        bool StreamCompressor::update(const void *data, size_t length, std::string &out)
+        {
+            if (m_zstream)
+            {
+                return deflate(data, length, Z_NO_FLUSH, out);
+            }
+#ifdef SPNET_WITH_BROTLI
+            if (m_brotli)
+            {
+                return brotli(data, length, BROTLI_OPERATION_PROCESS, out);
+            }
+#endif
+            return false;
+        }
+
+        bool StreamCompressor::flush(std::string &out)
+        {
+            if (m_zstream)
+            {
+                return deflate(nullptr, 0, Z_SYNC_FLUSH, out);
+            }
+#ifdef SPNET_WITH_BROTLI
+            if (m_brotli)
+            {
+                return brotli(nullptr, 0, BROTLI_OPERATION_FLUSH, out);
+            }
+#endif
+            return false;
+        }
+
+        bool StreamCompressor::finish(std::string &out)
+        {
+            if (m_zstream)
+            {
+                return deflate(nullptr, 0, Z_FINISH, out);
+            }
+#ifdef SPNET_WITH_BROTLI
+            if (m_brotli)
+            {
+                return brotli(nullptr, 0, BROTLI_OPERATION_FINISH, out);
+            }
+#endif
+            return false;
+        }
+
+        bool Compress(ContentCoding coding, int level, const std::string &in, std::string &out)
+        {
+            StreamCompressor compressor(coding, level);
+            if (!compressor.isValid())
+            {
+                return false;
+            }
+            out.clear();
+#ifdef SPNET_WITH_BROTLI
+            if (coding == ContentCoding::BR)
+            {
+                // 一次性输入并结束，编码器按大小提示选择窗口
+                return compressor.brotli(in.data(), in.size(), BROTLI_OPERATION_FINISH, out);
+            }
+#endif
+            return compressor.deflate(in.data(), in.size(), Z_FINISH, out);
+        }
+
+        CompressCache::CompressCache(size_t capacity) : m_capacity(capacity) {}
+
+        CompressCache::Value CompressCache::get(const std::string &key)
+        {
+            Mutex::Lock lock(m_mutex);
+            auto it = m_index.find(key);
+            if (it == m_index.end())
+            {
+                return nullptr;
+            }
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            return it->second->value;
+        }
+
+        void CompressCache::put(const std::string &key, Value value)
+        {
+            size_t charge = key.size() + value->size() + CACHE_ENTRY_OVERHEAD;
+            Mutex::Lock lock(m_mutex);
+            if (charge > m_capacity / 8)
+            {
+                return;
+            }
+            auto it = m_index.find(key);
+            if (it != m_index.end())
+            {
+                // 并发未命中时可能重复压缩，保留先放入的
+                m_lru.splice(m_lru.begin(), m_lru, it->second);
+                return;
+            }
+            m_lru.push_front(Entry{key, value, charge});
+            m_index[key] = m_lru.begin();
+            m_size += charge;
+            evict();
+        }
+
+        void CompressCache::evict()
+        {
+            while (m_size > m_capacity && !m_lru.empty())
+            {
+                Entry &entry = m_lru.back();
+                m_size -= entry.charge;
+                m_index.erase(entry.key);
+                m_lru.pop_back();
+            }
+        }
+
+        void CompressCache::setCapacity(size_t capacity)
+        {
+            Mutex::Lock lock(m_mutex);
+            m_capacity = capacity;
+            evict();
+        }
+
+        size_t CompressCache::size()
+        {
+            Mutex::Lock lock(m_mutex);
+            return m_size;
+        }
+
+        size_t CompressCache::count()
+        {
+            Mutex::Lock lock(m_mutex);
+            return m_index.size();
+        }
+
+        HttpCompressor::HttpCompressor()
+            : m_enabled(g_http_server_compress->getValue()), m_minSize(g_http_server_compress_min_size->getValue()),
+              m_level(g_http_server_compress_level->getValue()), m_cache(g_http_server_compress_cache_size->getValue())
+        {
+        }
+
+        bool HttpCompressor::IsCompressibleType(const std::string &content_type)
+        {
+            std::string_view type(content_type);
+            type = Trim(type.substr(0, type.find(';')));
+            if (type.size() > 5 && strncasecmp(type.data(), "text/", 5) == 0)
+            {
+                return true;
+            }
+            static const char *TYPES[] = {"application/json", "application/javascript", "application/xml", "application/xhtml+xml", "image/svg+xml"};
+            for (const char *t : TYPES)
+            {
+                if (EqualsIgnoreCase(type, t))
+                {
+                    return true;
+                }
+            }
+            // application/problem+json、application/rss+xml等结构化后缀
+            return type.size() > 5 && (strncasecmp(type.data() + type.size() - 5, "+json", 5) == 0 || strncasecmp(type.data() + type.size() - 4, "+xml", 4) == 0);
+        }
+
+        /**
+         * @brief 以8字节为单位的FNV-1a，与std::hash一起组成缓存键，降低不同响应体冲突的概率
+         */
+        static uint64_t HashBody(const std::string &body)
+        {
+            uint64_t h = 14695981039346656037ull;
+            const char *p = body.data();
+            size_t n = body.size();
+            for (; n >= 8; p += 8, n -= 8)
+            {
+                uint64_t w;
+                memcpy(&w, p, 8);
+                h = (h ^ w) * 1099511628211ull;
+            }
+            for (; n; ++p, --n)
+            {
+                h = (h ^ (uint8_t)*p) * 1099511628211ull;
+            }
+            return h;
+        }
+
+        /**
+         * @brief 可缓存的响应返回缓存键，否则返回空串
+         */
+        static std::string CacheKey(HttpRequest::ptr req, HttpResponse::ptr rsp, ContentCoding coding)
+        {
+            std::string key = ContentCodingToString(coding);
+            const std::string &body = rsp->body();
+            std::string etag = rsp->getHeader("ETag");
+            if (!etag.empty())
+            {
+                // ETag只在同一资源内唯一，加上路径、参数与长度：参数不同即为不同资源
+                return key + "|e|" + req->path() + "?" + req->query() + "|" + etag + "|" + std::to_string(body.size());
+            }
+            std::string cache_control = rsp->getHeader("Cache-Control");
+            std::transform(cache_control.begin(), cache_control.end(), cache_control.begin(), ::tolower);
+            if (cache_control.empty() || cache_control.find("no-store") != std::string::npos || cache_control.find("private") != std::string::npos ||
+                (cache_control.find("public") == std::string::npos && cache_control.find("max-age") == std::string::npos))
+            {
+                return "";
+            }
+            char buf[64];
+            snprintf(buf, sizeof(buf), "|h|%016lx%016lx|%zu", (unsigned long)HashBody(body), (unsigned long)std::hash<std::string>()(body), body.size());
+            return key + buf;
+        }
+
+        bool HttpCompressor::compress(HttpRequest::ptr req, HttpResponse::ptr rsp)
+        {
+            const std::string &body = rsp->body();
+            if (!m_enabled || body.size() < m_minSize || rsp->isWebsocket() || rsp->status() == HttpStatus::PARTIAL_CONTENT ||
+                !rsp->getHeader("Content-Encoding").empty() || !IsCompressibleType(rsp->getHeader("Content-Type")))
+            {
+                return false;
+            }
+            // 无论本次是否压缩，响应都随Accept-Encoding变化，告知中间缓存
+            std::string vary = rsp->getHeader("Vary");
+            if (vary.empty())
+            {
+                rsp->setHeader("Vary", "Accept-Encoding");
+            }
+            else if (strcasestr(vary.c_str(), "accept-encoding") == nullptr && vary != "*")
+            {
+                rsp->setHeader("Vary", vary + ", Accept-Encoding");
+            }
+
+            ContentCoding coding = NegotiateContentCoding(req->getHeader("Accept-Encoding"));
+            if (coding == ContentCoding::IDENTITY)
+            {
+                return false;
+            }
+            CompressMetrics &metrics = CompressMetrics::Get();
+            std::string key = m_cache.getCapacity() ? CacheKey(req, rsp, coding) : "";
+            CompressCache::Value value = key.empty() ? nullptr : m_cache.get(key);
+            if (value)
+            {
+                metrics.hits->inc();
+            }
+            else
+            {
+                std::string out;
+                if (!Compress(coding, m_level, body, out))
+                {
+                    LOG_ERROR(g_logger) << "compress " << body.size() << " bytes with " << ContentCodingToString(coding) << " fail";
+                    return false;
+                }
+                metrics.input[(int)coding]->inc(body.size());
+                metrics.output[(int)coding]->inc(out.size());
+                value = std::make_shared<const std::string>(std::move(out));
+                if (!key.empty())
+                {
+                    metrics.misses->inc();
+                    m_cache.put(key, value);
+                }
+            }
+            if (value->size() >= body.size())
+            {
+                return false;
+            }
+            rsp->setBody(*value);
+            rsp->setHeader("Content-Encoding", ContentCodingToString(coding));
+            // 编码后的表示与原表示字节不同，强ETag降为弱ETag
+            std::string etag = rsp->getHeader("ETag");
+            if (!etag.empty() && etag.compare(0, 2, "W/") != 0)
+            {
+                rsp->setHeader("ETag", "W/" + etag);
+            }
+            return true;
+        }
+    } // namespace http
+} // namespace lim_webserver
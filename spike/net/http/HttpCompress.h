@@ -0,0 +1,194 @@
+#pragma once
+
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "base/Mutex.h"
+#include "base/Noncopyable.h"
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+struct z_stream_s;
+struct BrotliEncoderStateStruct;
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        /**
+         * @brief 响应体的内容编码
+         */
+        enum class ContentCoding
+        {
+            IDENTITY = 0,
+            GZIP,
+            DEFLATE,
+            BR,
+        };
+
+        /**
+         * @brief Content-Encoding中的名字，IDENTITY为空串
+         */
+        const char *ContentCodingToString(ContentCoding coding);
+
+        /**
+         * @brief 是否编译了该编码的支持，br需要构建时找到brotli
+         */
+        bool IsContentCodingSupported(ContentCoding coding);
+
+        /**
+         * @brief 按Accept-Encoding选择编码：q值最高者优先，q值相同时依次取br、gzip、deflate，都不可接受时为IDENTITY
+         */
+        ContentCoding NegotiateContentCoding(const std::string &accept_encoding);
+
+        /**
+         * @brief 一次性压缩整个响应体
+         */
+        bool Compress(ContentCoding coding, int level, const std::string &in, std::string &out);
+
+        /**
+         * @brief 流式压缩器，用于分块发送的响应体：每块数据经update追加到输出，
+         *        需要让对端立刻解出已发送的部分时调用flush，最后调用finish写出结尾
+         */
+        class StreamCompressor : Noncopyable
+        {
+        public:
+            /**
+             * @param level 压缩级别，gzip/deflate取1~9，br取0~11，超出时截断
+             */
+            StreamCompressor(ContentCoding coding, int level);
+
+            ~StreamCompressor();
+
+            inline bool isValid() const { return m_zstream || m_brotli; }
+
+            inline ContentCoding coding() const { return m_coding; }
+
+            /**
+             * @brief 压缩一段数据，产生的输出追加到out
+             */
+            bool update(const void *data, size_t length, std::string &out);
+
+            /**
+             * @brief 输出目前为止的全部数据，对端收到后即可解压
+             */
+            bool flush(std::string &out);
+
+            /**
+             * @brief 结束压缩流，之后不能再调用update
+             */
+            bool finish(std::string &out);
+
+        private:
+            friend bool Compress(ContentCoding coding, int level, const std::string &in, std::string &out);
+
+            bool deflate(const void *data, size_t length, int mode, std::string &out);
+
+            bool brotli(const void *data, size_t length, int op, std::string &out);
+
+        private:
+            ContentCoding m_coding;
+            z_stream_s *m_zstream = nullptr;
+            BrotliEncoderStateStruct *m_brotli = nullptr;
+        };
+
+        /**
+         * @brief 按字节数限制容量的LRU缓存，保存响应体的压缩结果
+         */
+        class CompressCache : Noncopyable
+        {
+        public:
+            using Value = std::shared_ptr<const std::string>;
+
+            /**
+             * @param capacity 容量，单位：字节，0为不缓存
+             */
+            explicit CompressCache(size_t capacity);
+
+            Value get(const std::string &key);
+
+            /**
+             * @brief 放入缓存，超出容量时淘汰最久未用的条目，超过容量1/8的条目不缓存
+             */
+            void put(const std::string &key, Value value);
+
+            void setCapacity(size_t capacity);
+
+            inline size_t getCapacity() const { return m_capacity; }
+
+            /**
+             * @brief 已占用的字节数
+             */
+            size_t size();
+
+            size_t count();
+
+        private:
+            void evict();
+
+        private:
+            struct Entry
+            {
+                std::string key;
+                Value value;
+                size_t charge; // 计入容量的字节数
+            };
+
+            Mutex m_mutex;
+            std::list<Entry> m_lru; // 头部为最近使用
+            std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+            size_t m_capacity;
+            size_t m_size = 0;
+        };
+
+        /**
+         * @brief 按请求协商的编码压缩响应体
+         *
+         * @details 只压缩不小于阈值、类型可压缩且尚未编码的响应。带ETag或可被共享缓存的响应
+         *          (Cache-Control为public或带max-age，且没有no-store、private)的压缩结果放入LRU缓存，
+         *          以ETag或响应体的哈希为键，热点响应只压缩一次；其余响应每次压缩。
+         */
+        class HttpCompressor : Noncopyable
+        {
+        public:
+            /**
+             * @brief 参数取自http_server.compress*配置
+             */
+            HttpCompressor();
+
+            inline void setEnabled(bool v) { m_enabled = v; }
+
+            inline bool isEnabled() const { return m_enabled; }
+
+            inline void setMinSize(size_t v) { m_minSize = v; }
+
+            inline size_t getMinSize() const { return m_minSize; }
+
+            inline void setLevel(int v) { m_level = v; }
+
+            inline int getLevel() const { return m_level; }
+
+            inline CompressCache &cache() { return m_cache; }
+
+            /**
+             * @brief 需要时压缩响应体并设置Content-Encoding与Vary
+             *
+             * @return 是否替换了响应体
+             */
+            bool compress(HttpRequest::ptr req, HttpResponse::ptr rsp);
+
+            /**
+             * @brief Content-Type是否值得压缩：文本、JSON、JavaScript、XML与SVG
+             */
+            static bool IsCompressibleType(const std::string &content_type);
+
+        private:
+            bool m_enabled;
+            size_t m_minSize; // 压缩阈值，单位：字节
+            int m_level;
+            CompressCache m_cache;
+        };
+    } // namespace http
+} // namespace lim_webserver
@@ -19,38 +19,13 @@ namespace lim_webserver
         static ConfigerVar<uint64_t>::ptr g_http_response_max_body_size =
             Configer::Lookup("http.response.max_body_size", (uint64_t)(64 * 1024 * 1024), "http response max body size");
 
-        static uint64_t s_http_request_buffer_size = 0;
-        static uint64_t s_http_request_max_body_size = 0;
-        static uint64_t s_http_response_buffer_size = 0;
-        static uint64_t s_http_response_max_body_size = 0;
+        uint64_t HttpRequestParser::GetHttpRequestBufferSize() { return g_http_request_buffer_size->get(); }
 
-        uint64_t HttpRequestParser::GetHttpRequestBufferSize() { return s_http_request_buffer_size; }
+        uint64_t HttpRequestParser::GetHttpRequestMaxBodySize() { return g_http_request_max_body_size->get(); }
 
-        uint64_t HttpRequestParser::GetHttpRequestMaxBodySize() { return s_http_request_max_body_size; }
+        uint64_t HttpResponseParser::GetHttpResponseBufferSize() { return g_http_response_buffer_size->get(); }
 
-        uint64_t HttpResponseParser::GetHttpResponseBufferSize() { return s_http_response_buffer_size; }
-
-        uint64_t HttpResponseParser::GetHttpResponseMaxBodySize() { return s_http_response_max_body_size; }
-
-        namespace
-        {
-            struct _RequestSizeIniter
-            {
-                _RequestSizeIniter()
-                {
-                    s_http_request_buffer_size = g_http_request_buffer_size->getValue();
-                    s_http_request_max_body_size = g_http_request_max_body_size->getValue();
-                    s_http_response_buffer_size = g_http_response_buffer_size->getValue();
-                    s_http_response_max_body_size = g_http_response_max_body_size->getValue();
-
-                    g_http_request_buffer_size->addListener([](const uint64_t &ov, const uint64_t &nv) { s_http_request_buffer_size = nv; });
-                    g_http_request_max_body_size->addListener([](const uint64_t &ov, const uint64_t &nv) { s_http_request_max_body_size = nv; });
-                    g_http_response_buffer_size->addListener([](const uint64_t &ov, const uint64_t &nv) { s_http_response_buffer_size = nv; });
-                    g_http_response_max_body_size->addListener([](const uint64_t &ov, const uint64_t &nv) { s_http_response_max_body_size = nv; });
-                }
-            };
-            static _RequestSizeIniter _init;
-        }
+        uint64_t HttpResponseParser::GetHttpResponseMaxBodySize() { return g_http_response_max_body_size->get(); }
 
         void on_request_method(void *data, const char *at, size_t length)
         {
@@ -52,6 +52,11 @@ namespace lim_webserver
              */
             const MapType &headers() const { return m_headers; }
 
+            /**
+             * @brief 返回要发出的Set-Cookie值
+             */
+            const std::vector<std::string> &cookies() const { return m_cookies; }
+
             /**
              * @brief 设置响应状态
              * @param[in] v 响应状态
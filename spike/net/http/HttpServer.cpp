@@ -1,44 +1,244 @@
 #include "HttpServer.h"
+#include "Http2Session.h"
 #include "HttpSession.h"
+#include "base/Configer.h"
+#include "base/Trace.h"
+#include "coroutine/Profiler.h"
 #include "splog.h"
 
+#include <algorithm>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
 namespace lim_webserver
 {
     namespace http
     {
         static Logger::ptr g_logger = LOG_SYS();
 
-        HttpServer::HttpServer(bool keepalive, Scheduler *worker, Scheduler *accepter) : TcpServer(worker, accepter), m_isKeepalive(keepalive) {}
+        static ConfigerVar<std::string>::ptr g_http_server_metrics_path =
+            Configer::Lookup("http_server.metrics_path", std::string(""), "path serving prometheus metrics, empty to disable");
+
+        static ConfigerVar<std::string>::ptr g_http_server_debug_path =
+            Configer::Lookup("http_server.debug_path", std::string(""), "path prefix serving task dumps and cpu profiles, empty to disable");
+
+        static ConfigerVar<uint64_t>::ptr g_http_server_response_cache_size =
+            Configer::Lookup("http_server.response_cache_size", (uint64_t)0, "bytes of serialized responses cached in front of handlers, 0 to disable");
+
+        static ConfigerVar<std::vector<std::string>>::ptr g_http_server_response_cache_vary = Configer::Lookup(
+            "http_server.response_cache_vary", std::vector<std::string>{"Accept-Encoding"}, "request headers that are part of the response cache key");
+
+        static ConfigerVar<bool>::ptr g_http_server_http2 =
+            Configer::Lookup("http_server.http2", false, "accept cleartext http2 by prior knowledge or Upgrade: h2c");
+
+        HttpServer::HttpServer(bool keepalive, Scheduler *worker, Scheduler *accepter)
+            : TcpServer(worker, accepter), m_isKeepalive(keepalive), m_http2(g_http_server_http2->getValue()), m_metricsPath(g_http_server_metrics_path->getValue()),
+              m_debugPath(g_http_server_debug_path->getValue())
+        {
+            if (g_http_server_response_cache_size->getValue())
+            {
+                m_responseCache = std::make_shared<ResponseCache>("http", g_http_server_response_cache_size->getValue(), g_http_server_response_cache_vary->getValue());
+            }
+        }
+
+        bool HttpServer::handleAdmin(HttpRequest::ptr req, HttpResponse::ptr rsp)
+        {
+            const std::string &path = req->path();
+            if (!m_metricsPath.empty() && path == m_metricsPath)
+            {
+                rsp->setHeader("Content-Type", "text/plain; version=0.0.4");
+                rsp->setBody(MetricsRegistry::GetInstance()->toPrometheus());
+                return true;
+            }
+            if (m_debugPath.empty() || path.compare(0, m_debugPath.size(), m_debugPath) != 0)
+            {
+                return false;
+            }
+            std::string sub = path.substr(m_debugPath.size());
+            rsp->setHeader("Content-Type", "text/plain");
+            if (sub == "/tasks")
+            {
+                rsp->setBody(TaskDumper::Dump());
+            }
+            else if (sub == "/profile")
+            {
+                int seconds = std::min(std::max(req->getParamAs<int>("seconds", 5), 1), 60);
+                int hz = req->getParamAs<int>("hz", 99);
+                SamplingProfiler *profiler = SamplingProfiler::GetInstance();
+                if (!profiler->start(hz))
+                {
+                    rsp->setStatus(HttpStatus::CONFLICT);
+                    rsp->setBody("profiler is already running or hz is invalid\n");
+                    return true;
+                }
+                // hook后的sleep只挂起当前协程，采样期间服务照常处理请求
+                sleep(seconds);
+                rsp->setBody(profiler->stop());
+            }
+            else if (sub == "/trace")
+            {
+                // 默认导出最慢的100个耗时不低于10ms的请求
+                uint64_t min_us = std::max(req->getParamAs<int64_t>("min_ms", 10), (int64_t)0) * 1000;
+                size_t limit = std::max(req->getParamAs<int64_t>("limit", 100), (int64_t)1);
+                rsp->setHeader("Content-Type", "application/json");
+                rsp->setBody(RequestTrace::ExportChrome(min_us, limit));
+            }
+            else
+            {
+                rsp->setStatus(HttpStatus::NOT_FOUND);
+                rsp->setBody("unknown debug path, try " + m_debugPath + "/tasks, " + m_debugPath + "/profile?seconds=5&hz=99 or " + m_debugPath +
+                             "/trace?min_ms=10&limit=100\n");
+            }
+            return true;
+        }
+
+        MetricHistogram *HttpServer::latencyOf(int status)
+        {
+            if (status < 0 || status >= MAX_STATUS)
+            {
+                status = 0;
+            }
+            MetricHistogram *histogram = m_latency[status].load(std::memory_order_acquire);
+            if (!histogram)
+            {
+                // 并发首次注册时注册表返回同一对象，重复写入无害
+                histogram = MetricsRegistry::GetInstance()->histogram("spnet_http_request_duration_seconds", "Time from request parsed to response sent",
+                                                                      {{"server", m_name}, {"status", std::to_string(status)}}, 1e-6,
+                                                                      MetricsRegistry::LatencyBounds());
+                m_latency[status].store(histogram, std::memory_order_release);
+            }
+            return histogram;
+        }
+
+        void HttpServer::handleRequest(HttpRequest::ptr req, HttpResponse::ptr rsp)
+        {
+            if (!handleAdmin(req, rsp))
+            {
+                rsp->setBody("hello world, If you see this page, the lim web server is successfully installed and working. Further configuration is required.");
+            }
+        }
+
+        void HttpServer::serveHttp2(Socket::ptr client, HttpRequest::ptr upgrade)
+        {
+            Http2Session::ptr session = std::make_shared<Http2Session>(client);
+            LOG_TRACE(g_logger) << "serve http2 " << session->peerAddressString() << (upgrade ? " by upgrade" : " by prior knowledge");
+            session->serve(
+                [this](HttpRequest::ptr req, HttpResponse::ptr rsp)
+                {
+                    uint64_t start = MetricNowNS();
+                    rsp->setHeader("Server", m_name);
+                    handleRequest(req, rsp);
+                    m_compressor.compress(req, rsp);
+                    // 响应由会话的发送协程异步写出，HTTP/2的延迟只统计到处理完成
+                    latencyOf((int)rsp->status())->record((MetricNowNS() - start) / 1000);
+                },
+                upgrade);
+        }
 
         void HttpServer::handleClient(Socket::ptr client)
         {
-            HttpSession::ptr session(new HttpSession(client));
+            HttpSession::ptr session;
+            if (m_ssl)
+            {
+                // TLS上只走HTTP/1.1，h2需要ALPN协商
+                SslSocketStream::ptr tls = std::make_shared<SslSocketStream>(client, m_sslCtx);
+                if (!tls->handshake())
+                {
+                    tls->close();
+                    return;
+                }
+                session.reset(new HttpSession(tls));
+            }
+            else if (m_http2)
+            {
+                // 只窥探不读取，不是HTTP/2序言时数据原样留给HTTP/1.1解析
+                char preface[4];
+                if (client->recv(preface, sizeof(preface), MSG_PEEK) == (int)sizeof(preface) && memcmp(preface, HTTP2_PREFACE, sizeof(preface)) == 0)
+                {
+                    serveHttp2(client, nullptr);
+                    return;
+                }
+            }
+            if (!session)
+            {
+                session.reset(new HttpSession(client));
+            }
             LOG_TRACE(g_logger) << "handleClient " << session->peerAddressString();
             while (true)
             {
                 auto req = session->recvRequest();
                 if (!req)
                 {
-                    LOG_DEBUG(g_logger) << "recv http request fail, errno=" << errno << " errstr=" << strerror(errno)
-                                        << " cliet:" << session->peerAddressString() << " keep_alive=" << m_isKeepalive;
+                    LOG_EVERY_MS(g_logger, LogLevel_DEBUG, 1000) << "recv http request fail, errno=" << errno << " errstr=" << strerror(errno)
+                                                                 << " cliet:" << session->peerAddressString() << " keep_alive=" << m_isKeepalive;
                     break;
                 }
 
-                HttpResponse::ptr rsp(new HttpResponse(req->version(), req->isClose() || !m_isKeepalive));
-                rsp->setHeader("Server", m_name);
-                rsp->setBody("hello world, If you see this page, the lim web server is successfully installed and working. Further configuration is required.");
-                session->sendResponse(rsp);
+                if (m_http2 && !m_ssl && strcasecmp(req->getHeader("Upgrade").c_str(), "h2c") == 0 && req->hasHeader("HTTP2-Settings"))
+                {
+                    serveHttp2(client, req);
+                    return;
+                }
+
+                uint64_t start = MetricNowNS();
+                bool close = req->isClose() || !m_isKeepalive;
+                std::string cache_key = m_responseCache ? m_responseCache->makeKey(req) : "";
+                ResponseCache::EntryPtr cached = cache_key.empty() ? nullptr : m_responseCache->lookup(cache_key);
+                RequestTrace *trace = RequestTrace::Current();
+                if (cached)
+                {
+                    // 命中时发送序列化好的字节，不构造响应也不调用处理函数；拼接缓冲按线程复用
+                    static thread_local std::string s_cached;
+                    ResponseCache::Render(*cached, close, MetricNowNS(), s_cached);
+                    session->send(s_cached.data(), s_cached.size());
+                    latencyOf(cached->status)->record((MetricNowNS() - start) / 1000);
+                    LOG_TRACE(g_logger) << "cliet: " << session->peerAddressString() << ", cached request:\n" << req->toString();
+                }
+                else
+                {
+                    HttpResponse::ptr rsp(new HttpResponse(req->version(), close));
+                    rsp->setHeader("Server", m_name);
+                    handleRequest(req, rsp);
+                    m_compressor.compress(req, rsp);
+                    if (!cache_key.empty())
+                    {
+                        m_responseCache->store(cache_key, rsp);
+                    }
+                    if (trace)
+                    {
+                        trace->add(TracePoint::HANDLED);
+                    }
+                    session->sendResponse(rsp);
+                    latencyOf((int)rsp->status())->record((MetricNowNS() - start) / 1000);
 
-                LOG_TRACE(g_logger) << "cliet: " << session->peerAddressString() << ", request:\n" << req->toString();
-                LOG_TRACE(g_logger) << "cliet: " << session->peerAddressString() << ", response:\n" << rsp->toString();
+                    LOG_TRACE(g_logger) << "cliet: " << session->peerAddressString() << ", request:\n" << req->toString();
+                    LOG_TRACE(g_logger) << "cliet: " << session->peerAddressString() << ", response:\n" << rsp->toString();
+                }
+                if (trace)
+                {
+                    trace->add(TracePoint::SENT);
+                    trace->finish();
+                }
 
-                if (!m_isKeepalive || req->isClose())
+                if (close)
                 {
                     break;
                 }
             }
             session->close();
         }
+
+        void HttpServer::rejectClient(Socket::ptr client)
+        {
+            // 新连接的发送缓冲区为空，一次send即可写完，不会挂起accept协程
+            static const char REJECT_RESPONSE[] = "HTTP/1.1 503 Service Unavailable\r\n"
+                                                  "Connection: close\r\n"
+                                                  "Retry-After: 1\r\n"
+                                                  "Content-Length: 0\r\n\r\n";
+            client->send(REJECT_RESPONSE, sizeof(REJECT_RESPONSE) - 1, MSG_NOSIGNAL);
+            lingerClose(client);
+        }
     } // namespace http
 
 } // namespace lim_webserver
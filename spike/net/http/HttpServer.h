@@ -1,6 +1,11 @@
 #pragma once
 
+#include "base/Metrics.h"
 #include "net/Server.h"
+#include "net/http/HttpCompress.h"
+#include "net/http/ResponseCache.h"
+#include "net/http/HttpRequest.h"
+#include "net/http/HttpResponse.h"
 
 namespace lim_webserver
 {
@@ -23,11 +28,91 @@ namespace lim_webserver
              */
             HttpServer(bool keepalive = false, Scheduler *worker = EventLoop::GetCurrentScheduler(), Scheduler *accepter = EventLoop::GetCurrentScheduler());
 
+            /**
+             * @brief 设置输出Prometheus指标的路径，空串为关闭，通常只在管理端口的服务器上开启
+             */
+            inline void setMetricsPath(const std::string &path) { m_metricsPath = path; }
+
+            inline const std::string &getMetricsPath() const { return m_metricsPath; }
+
+            /**
+             * @brief 设置调试路径前缀，空串为关闭。开启后提供：
+             *        <prefix>/tasks 转储所有协程；
+             *        <prefix>/profile?seconds=5&hz=99 采样指定秒数后返回folded格式的调用栈；
+             *        <prefix>/trace?min_ms=10&limit=100 以Chrome trace-event JSON导出慢请求的链路追踪(需开启trace.enable)
+             */
+            inline void setDebugPath(const std::string &path) { m_debugPath = path; }
+
+            inline const std::string &getDebugPath() const { return m_debugPath; }
+
+            /**
+             * @brief 是否接受明文HTTP/2：以客户端序言开头的连接(prior knowledge)与Upgrade: h2c升级请求
+             *
+             * @details 默认关闭(http_server.http2)。开启后每个新连接先以MSG_PEEK窥探序言，多一次recv系统调用
+             */
+            inline void setHttp2(bool v) { m_http2 = v; }
+
+            inline bool isHttp2() const { return m_http2; }
+
+            /**
+             * @brief 响应压缩的参数与压缩结果缓存
+             */
+            inline HttpCompressor &getCompressor() { return m_compressor; }
+
+            /**
+             * @brief 设置HTTP/1.1请求的响应缓存，为空时关闭，默认按http_server.response_cache_size创建
+             *
+             * @note 须在start之前设置
+             */
+            inline void setResponseCache(ResponseCache::ptr cache) { m_responseCache = cache; }
+
+            inline ResponseCache::ptr getResponseCache() const { return m_responseCache; }
+
         protected:
             virtual void handleClient(Socket::ptr client) override;
 
+            /**
+             * @brief 处理一个请求，HTTP/1.1与HTTP/2共用，默认提供管理路径并回复欢迎页
+             *
+             * @note HTTP/2的多个流在各自的协程中并发调用
+             */
+            virtual void handleRequest(HttpRequest::ptr req, HttpResponse::ptr rsp);
+
+            /**
+             * @brief 回复503后关闭，客户端可据此退避重试
+             */
+            virtual void rejectClient(Socket::ptr client) override;
+
+        private:
+            /**
+             * @brief 处理指标与调试路径的请求
+             *
+             * @return false 不是管理路径
+             */
+            bool handleAdmin(HttpRequest::ptr req, HttpResponse::ptr rsp);
+
+            /**
+             * @brief 取得该状态码的请求延迟直方图，首次使用时注册
+             */
+            MetricHistogram *latencyOf(int status);
+
+            /**
+             * @brief 以HTTP/2处理整个连接
+             *
+             * @param upgrade h2c升级请求，为空时连接以客户端序言开头
+             */
+            void serveHttp2(Socket::ptr client, HttpRequest::ptr upgrade);
+
         private:
-            bool m_isKeepalive; // 是否支持长连接
+            static const int MAX_STATUS = 600;
+
+            bool m_isKeepalive;       // 是否支持长连接
+            bool m_http2;             // 是否接受明文HTTP/2
+            std::string m_metricsPath; // 指标路径
+            std::string m_debugPath;   // 调试路径前缀
+            HttpCompressor m_compressor; // 响应压缩
+            ResponseCache::ptr m_responseCache; // 响应缓存
+            std::atomic<MetricHistogram *> m_latency[MAX_STATUS] = {}; // 按状态码的请求延迟，单位：微秒
         };
     } // namespace http
 
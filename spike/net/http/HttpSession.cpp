@@ -1,4 +1,5 @@
 #include "HttpSession.h"
+#include "base/Trace.h"
 #include "splog.h"
 
 namespace lim_webserver
@@ -7,6 +8,22 @@ namespace lim_webserver
     {
         HttpSession::HttpSession(Socket::ptr sock, bool owner) : SocketStream(sock, owner) {}
 
+        HttpSession::HttpSession(SocketStream::ptr transport) : SocketStream(transport->socket(), false), m_transport(transport) {}
+
+        int HttpSession::resv(void *buffer, size_t length) { return m_transport ? m_transport->resv(buffer, length) : SocketStream::resv(buffer, length); }
+
+        int HttpSession::send(const void *buffer, size_t length) { return m_transport ? m_transport->send(buffer, length) : SocketStream::send(buffer, length); }
+
+        void HttpSession::close()
+        {
+            if (m_transport)
+            {
+                m_transport->close();
+                return;
+            }
+            SocketStream::close();
+        }
+
         HttpRequest::ptr HttpSession::recvRequest()
         {
             HttpRequestParser::ptr parser(new HttpRequestParser);
@@ -70,6 +87,11 @@ namespace lim_webserver
             }
 
             parser->data()->init();
+            RequestTrace *trace = RequestTrace::Current();
+            if (trace)
+            {
+                trace->add(TracePoint::PARSED, m_socket->fd());
+            }
             return parser->data();
         }
 
@@ -20,6 +20,11 @@ namespace lim_webserver
              */
             HttpSession(Socket::ptr sock, bool owner = true);
 
+            /**
+             * @brief 在已建立的传输流(如TLS)上收发HTTP报文，关闭会话即关闭传输流
+             */
+            HttpSession(SocketStream::ptr transport);
+
             /**
              * @brief 接收HTTP请求
              */
@@ -33,6 +38,15 @@ namespace lim_webserver
              *         <0 Socket异常
              */
             int sendResponse(HttpResponse::ptr rsp);
+
+            virtual int resv(void *buffer, size_t length) override;
+
+            virtual int send(const void *buffer, size_t length) override;
+
+            virtual void close() override;
+
+        private:
+            SocketStream::ptr m_transport; // 为空时直接读写套接字
         };
     } // namespace http
 
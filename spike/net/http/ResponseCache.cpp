@@ -0,0 +1,424 @@
+#include "ResponseCache.h"
+#include "HttpCompress.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <thread>
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        // 每个条目除响应字节外的估计开销：条目、索引与槽位
+        static const size_t ENTRY_OVERHEAD = 192;
+
+        static const uint64_t SKETCH_SEEDS[4] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull};
+
+        static size_t RoundUpPow2(size_t v)
+        {
+            size_t n = 1;
+            while (n < v)
+            {
+                n <<= 1;
+            }
+            return n;
+        }
+
+        FrequencySketch::FrequencySketch(size_t width)
+        {
+            width = RoundUpPow2(std::max<size_t>(width, 64));
+            m_table.resize(width * 4);
+            m_mask = width - 1;
+            m_sampleSize = width * 10;
+        }
+
+        size_t FrequencySketch::indexOf(uint64_t hash, int row) const
+        {
+            uint64_t h = (hash + row) * SKETCH_SEEDS[row];
+            return row * (m_mask + 1) + ((h >> 32) & m_mask);
+        }
+
+        void FrequencySketch::increment(uint64_t hash)
+        {
+            bool added = false;
+            for (int row = 0; row < 4; ++row)
+            {
+                uint8_t &counter = m_table[indexOf(hash, row)];
+                if (counter < 15)
+                {
+                    ++counter;
+                    added = true;
+                }
+            }
+            if (added && ++m_additions >= m_sampleSize)
+            {
+                reset();
+            }
+        }
+
+        uint8_t FrequencySketch::frequency(uint64_t hash) const
+        {
+            uint8_t freq = 15;
+            for (int row = 0; row < 4; ++row)
+            {
+                freq = std::min(freq, m_table[indexOf(hash, row)]);
+            }
+            return freq;
+        }
+
+        void FrequencySketch::reset()
+        {
+            for (uint8_t &counter : m_table)
+            {
+                counter >>= 1;
+            }
+            m_additions /= 2;
+        }
+
+        ResponseCache::ResponseCache(const std::string &name, size_t capacity, const std::vector<std::string> &vary)
+            : m_capacity(capacity), m_vary(vary), m_shardCount(RoundUpPow2(std::max(std::thread::hardware_concurrency(), 1u)))
+        {
+            m_shardCapacity = m_capacity / m_shardCount;
+            m_shards.reset(new Shard[m_shardCount]);
+            // 按平均1KB一个条目估计分片内的条目数，计数器取其4倍
+            size_t width = std::min<size_t>(std::max<size_t>(m_shardCapacity / 1024 * 4, 256), 1 << 20);
+            for (size_t i = 0; i < m_shardCount; ++i)
+            {
+                m_shards[i].sketch.reset(new FrequencySketch(width));
+            }
+
+            MetricsRegistry *registry = MetricsRegistry::GetInstance();
+            MetricLabels labels = {{"cache", name}};
+            m_hits = registry->counter("spnet_http_response_cache_hits_total", "Requests answered from the response cache", labels);
+            m_misses = registry->counter("spnet_http_response_cache_misses_total", "Cacheable requests not found in the response cache", labels);
+            m_stores = registry->counter("spnet_http_response_cache_stores_total", "Responses put into the response cache", labels);
+            m_rejects = registry->counter("spnet_http_response_cache_rejects_total", "Responses refused by TinyLFU admission", labels);
+            m_evictions = registry->counter("spnet_http_response_cache_evictions_total", "Responses evicted or expired from the response cache", labels);
+            m_bytes = registry->gauge("spnet_http_response_cache_bytes", "Bytes held by the response cache", labels);
+            m_entries = registry->gauge("spnet_http_response_cache_entries", "Responses held by the response cache", labels);
+        }
+
+        ResponseCache::~ResponseCache()
+        {
+            // 指标在注册表中长期存在，扣除本缓存占用的部分
+            m_bytes->sub(size());
+            m_entries->sub(count());
+        }
+
+        ResponseCache::Shard &ResponseCache::localShard() { return m_shards[MetricSlot() & (m_shardCount - 1)]; }
+
+        std::string ResponseCache::makeKey(HttpRequest::ptr req) const
+        {
+            if (req->method() != HttpMethod::GET || req->hasHeader("Authorization") || req->hasHeader("Range"))
+            {
+                return "";
+            }
+            // 客户端要求重新验证时绕过缓存，由处理函数给出最新的响应
+            std::string cache_control = req->getHeader("Cache-Control");
+            if (!cache_control.empty())
+            {
+                if (strcasestr(cache_control.c_str(), "no-cache") || strcasestr(cache_control.c_str(), "no-store"))
+                {
+                    return "";
+                }
+                const char *max_age = strcasestr(cache_control.c_str(), "max-age=");
+                if (max_age && strtoull(max_age + strlen("max-age="), nullptr, 10) == 0)
+                {
+                    return "";
+                }
+            }
+            else if (strcasestr(req->getHeader("Pragma").c_str(), "no-cache"))
+            {
+                // 没有Cache-Control时按Pragma: no-cache处理(RFC 9111 §5.4)
+                return "";
+            }
+            // 同一路径在不同虚拟主机下是不同的资源
+            std::string key = "GET " + std::to_string(req->version()) + " " + req->getHeader("Host") + " " + req->path();
+            if (!req->query().empty())
+            {
+                key += "?" + req->query();
+            }
+            for (auto &name : m_vary)
+            {
+                key += "\n" + name + ":";
+                if (strcasecmp(name.c_str(), "Accept-Encoding") == 0)
+                {
+                    // 按协商结果计入，写法不同但选出同一编码的请求共用条目
+                    key += ContentCodingToString(NegotiateContentCoding(req->getHeader(name)));
+                }
+                else
+                {
+                    key += req->getHeader(name);
+                }
+            }
+            return key;
+        }
+
+        ResponseCache::EntryPtr ResponseCache::lookup(const std::string &key)
+        {
+            uint64_t hash = std::hash<std::string>()(key);
+            uint64_t now = MetricNowNS();
+            Shard &shard = localShard();
+            EntryPtr entry;
+            size_t expired = 0; // 过期条目的占用，0为未过期
+            {
+                Spinlock::Lock lock(shard.lock);
+                shard.sketch->increment(hash);
+                auto it = shard.index.find(key);
+                if (it != shard.index.end())
+                {
+                    Slot &slot = shard.slots[it->second];
+                    if (slot.entry->expires > now)
+                    {
+                        slot.referenced = true;
+                        entry = slot.entry;
+                    }
+                    else
+                    {
+                        expired = slot.charge;
+                        remove(shard, it->second);
+                    }
+                }
+            }
+            if (expired)
+            {
+                m_bytes->sub(expired);
+                m_entries->sub(1);
+                m_evictions->inc();
+            }
+            (entry ? m_hits : m_misses)->inc();
+            return entry;
+        }
+
+        uint64_t ResponseCache::MaxAge(HttpResponse::ptr rsp)
+        {
+            std::string cache_control = rsp->getHeader("Cache-Control");
+            std::transform(cache_control.begin(), cache_control.end(), cache_control.begin(), ::tolower);
+            if (cache_control.empty() || cache_control.find("no-store") != std::string::npos || cache_control.find("no-cache") != std::string::npos ||
+                cache_control.find("private") != std::string::npos)
+            {
+                return 0;
+            }
+            // 本缓存由多个客户端共享，s-maxage优先
+            for (const char *directive : {"s-maxage=", "max-age="})
+            {
+                size_t pos = cache_control.find(directive);
+                if (pos != std::string::npos && (pos == 0 || cache_control[pos - 1] == ' ' || cache_control[pos - 1] == ','))
+                {
+                    return strtoull(cache_control.c_str() + pos + strlen(directive), nullptr, 10);
+                }
+            }
+            return 0;
+        }
+
+        bool ResponseCache::store(const std::string &key, HttpResponse::ptr rsp)
+        {
+            if (key.empty() || rsp->isWebsocket() || !rsp->cookies().empty())
+            {
+                return false;
+            }
+            switch (rsp->status())
+            {
+            case HttpStatus::OK:
+            case HttpStatus::NON_AUTHORITATIVE_INFORMATION:
+            case HttpStatus::NO_CONTENT:
+            case HttpStatus::MOVED_PERMANENTLY:
+            case HttpStatus::NOT_FOUND:
+            case HttpStatus::GONE:
+                break;
+            default:
+                return false;
+            }
+            uint64_t max_age = MaxAge(rsp);
+            if (!max_age)
+            {
+                return false;
+            }
+            // 响应随未计入键的请求头变化时不能缓存
+            std::string vary = rsp->getHeader("Vary");
+            for (size_t begin = 0; begin < vary.size();)
+            {
+                size_t end = std::min(vary.find(',', begin), vary.size());
+                std::string name = vary.substr(begin, end - begin);
+                name.erase(0, name.find_first_not_of(" \t"));
+                name.erase(name.find_last_not_of(" \t") + 1);
+                begin = end + 1;
+                if (name.empty())
+                {
+                    continue;
+                }
+                if (std::none_of(m_vary.begin(), m_vary.end(), [&name](const std::string &v) { return strcasecmp(v.c_str(), name.c_str()) == 0; }))
+                {
+                    return false;
+                }
+            }
+
+            std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+            entry->key = key;
+            bool close = rsp->isClose();
+            rsp->setClose(false);
+            entry->bytes = rsp->toString();
+            rsp->setClose(close);
+            size_t header_end = entry->bytes.find("\r\n\r\n");
+            entry->age_pos = entry->bytes.find("\r\n") + 2;
+            entry->connection_pos = entry->bytes.rfind("\r\nconnection: keep-alive\r\n", header_end);
+            if (entry->connection_pos != std::string::npos)
+            {
+                entry->connection_pos += 2;
+            }
+            entry->status = (int)rsp->status();
+            entry->stored = MetricNowNS();
+            entry->expires = entry->stored + max_age * 1000000000ull;
+
+            size_t charge = entry->bytes.size() + key.size() * 2 + ENTRY_OVERHEAD;
+            if (charge > m_shardCapacity / 2)
+            {
+                return false;
+            }
+            uint64_t hash = std::hash<std::string>()(key);
+            uint64_t now = MetricNowNS();
+            Shard &shard = localShard();
+            size_t evicted = 0;
+            int64_t bytes_delta = 0, entries_delta = 0;
+            bool admitted = true;
+            {
+                Spinlock::Lock lock(shard.lock);
+                size_t before_size = shard.size;
+                size_t before_count = shard.index.size();
+                auto it = shard.index.find(key);
+                if (it != shard.index.end())
+                {
+                    remove(shard, it->second);
+                }
+                uint8_t freq = shard.sketch->frequency(hash);
+                while (shard.size + charge > m_shardCapacity)
+                {
+                    size_t i = victim(shard);
+                    if (i == std::string::npos)
+                    {
+                        break;
+                    }
+                    Slot &slot = shard.slots[i];
+                    // 过期的直接淘汰；否则新条目更常用时才替换
+                    if (slot.entry->expires > now && shard.sketch->frequency(slot.hash) >= freq)
+                    {
+                        slot.referenced = true;
+                        admitted = false;
+                        break;
+                    }
+                    remove(shard, i);
+                    ++evicted;
+                }
+                if (admitted)
+                {
+                    size_t i;
+                    if (!shard.free.empty())
+                    {
+                        i = shard.free.back();
+                        shard.free.pop_back();
+                    }
+                    else
+                    {
+                        i = shard.slots.size();
+                        shard.slots.emplace_back();
+                    }
+                    shard.slots[i] = Slot{entry, hash, charge, false};
+                    shard.index[key] = i;
+                    shard.size += charge;
+                }
+                bytes_delta = (int64_t)shard.size - (int64_t)before_size;
+                entries_delta = (int64_t)shard.index.size() - (int64_t)before_count;
+            }
+            m_bytes->add(bytes_delta);
+            m_entries->add(entries_delta);
+            if (evicted)
+            {
+                m_evictions->inc(evicted);
+            }
+            (admitted ? m_stores : m_rejects)->inc();
+            return admitted;
+        }
+
+        void ResponseCache::remove(Shard &shard, size_t i)
+        {
+            Slot &slot = shard.slots[i];
+            shard.index.erase(slot.entry->key);
+            shard.size -= slot.charge;
+            slot.entry.reset();
+            shard.free.push_back(i);
+        }
+
+        size_t ResponseCache::victim(Shard &shard)
+        {
+            if (shard.index.empty())
+            {
+                return std::string::npos;
+            }
+            // 最多转两圈：第一圈清除引用位，第二圈必然找到
+            for (size_t step = 0; step < shard.slots.size() * 2; ++step)
+            {
+                size_t i = shard.hand;
+                shard.hand = (shard.hand + 1) % shard.slots.size();
+                Slot &slot = shard.slots[i];
+                if (!slot.entry)
+                {
+                    continue;
+                }
+                if (!slot.referenced)
+                {
+                    return i;
+                }
+                slot.referenced = false;
+            }
+            return std::string::npos;
+        }
+
+        void ResponseCache::Render(const Entry &entry, bool close, uint64_t now, std::string &out)
+        {
+            static const size_t KEEP_ALIVE_LINE = strlen("connection: keep-alive\r\n");
+            uint64_t age = now > entry.stored ? (now - entry.stored) / 1000000000ull : 0;
+            char age_line[32];
+            int age_len = snprintf(age_line, sizeof(age_line), "age: %lu\r\n", (unsigned long)age);
+
+            out.clear();
+            out.reserve(entry.bytes.size() + age_len + 8);
+            out.append(entry.bytes, 0, entry.age_pos);
+            out.append(age_line, age_len);
+            if (close && entry.connection_pos != std::string::npos)
+            {
+                out.append(entry.bytes, entry.age_pos, entry.connection_pos - entry.age_pos);
+                out.append("connection: close\r\n");
+                out.append(entry.bytes, entry.connection_pos + KEEP_ALIVE_LINE, std::string::npos);
+            }
+            else
+            {
+                out.append(entry.bytes, entry.age_pos, std::string::npos);
+            }
+        }
+
+        size_t ResponseCache::size()
+        {
+            size_t total = 0;
+            for (size_t i = 0; i < m_shardCount; ++i)
+            {
+                Spinlock::Lock lock(m_shards[i].lock);
+                total += m_shards[i].size;
+            }
+            return total;
+        }
+
+        size_t ResponseCache::count()
+        {
+            size_t total = 0;
+            for (size_t i = 0; i < m_shardCount; ++i)
+            {
+                Spinlock::Lock lock(m_shards[i].lock);
+                total += m_shards[i].index.size();
+            }
+            return total;
+        }
+    } // namespace http
+} // namespace lim_webserver
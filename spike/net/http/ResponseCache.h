@@ -0,0 +1,170 @@
+#pragma once
+
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "base/Metrics.h"
+#include "base/Mutex.h"
+#include "base/Noncopyable.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        /**
+         * @brief TinyLFU的访问频率估计：4行count-min sketch，计数上限15，
+         *        累计增加次数达到采样量时全部减半，使频率随时间衰减
+         */
+        class FrequencySketch
+        {
+        public:
+            /**
+             * @param width 每行的计数器数，取整为2的幂
+             */
+            explicit FrequencySketch(size_t width);
+
+            void increment(uint64_t hash);
+
+            uint8_t frequency(uint64_t hash) const;
+
+        private:
+            inline size_t indexOf(uint64_t hash, int row) const;
+
+            void reset();
+
+        private:
+            std::vector<uint8_t> m_table; // 4行依次排列
+            size_t m_mask;
+            size_t m_additions = 0;
+            size_t m_sampleSize;
+        };
+
+        /**
+         * @brief HTTP/1.1响应缓存，位于处理函数之前
+         *
+         * @details 以方法、版本、Host、路径、参数与选定的请求头为键，保存按keep-alive序列化好的完整响应，
+         *          命中时发送缓存的字节并补上Age头(RFC 9111 §5.1)，不构造HttpResponse也不调用处理函数。
+         *          按线程分片，每个处理器线程只访问自己的分片，分片锁不跨核争用；同一响应可能在多个分片各存一份。
+         *          只缓存带max-age(或s-maxage)、没有no-store/no-cache/private与Set-Cookie的响应，到期后失效。
+         *          分片内以CLOCK选择淘汰者，TinyLFU准入：新条目的访问频率不高于淘汰者时不替换。
+         */
+        class ResponseCache : Noncopyable
+        {
+        public:
+            using ptr = std::shared_ptr<ResponseCache>;
+
+            /**
+             * @brief 缓存的响应
+             */
+            struct Entry
+            {
+                std::string key;
+                std::string bytes;     // 以keep-alive序列化的完整响应
+                size_t age_pos;        // bytes中状态行之后的位置，Age头插入于此
+                size_t connection_pos; // bytes中Connection头所在行的起始位置，npos为没有
+                int status;
+                uint64_t stored;  // 存入时间，单调时钟，单位：纳秒
+                uint64_t expires; // 单调时钟，单位：纳秒
+            };
+            using EntryPtr = std::shared_ptr<const Entry>;
+
+            /**
+             * @param name     指标中的cache标签
+             * @param capacity 内存上限，单位：字节，平均分给各分片
+             * @param vary     参与缓存键的请求头，Accept-Encoding按协商出的编码计入
+             */
+            ResponseCache(const std::string &name, size_t capacity, const std::vector<std::string> &vary = {"Accept-Encoding"});
+
+            ~ResponseCache();
+
+            /**
+             * @brief 可以使用缓存的请求返回缓存键，否则返回空串：只有GET，带Authorization、Range、
+             *        Cache-Control: no-cache/no-store/max-age=0或Pragma: no-cache的请求绕过缓存
+             */
+            std::string makeKey(HttpRequest::ptr req) const;
+
+            /**
+             * @brief 查找未过期的响应，同时累计该键的访问频率
+             */
+            EntryPtr lookup(const std::string &key);
+
+            /**
+             * @brief 可缓存时序列化并放入缓存
+             *
+             * @return 是否放入
+             */
+            bool store(const std::string &key, HttpResponse::ptr rsp);
+
+            /**
+             * @brief 拼出发送给客户端的响应：插入Age头，close为true时改为Connection: close
+             *
+             * @param now 当前单调时间，单位：纳秒
+             * @param out 输出，先清空，可复用以免每次命中分配内存
+             */
+            static void Render(const Entry &entry, bool close, uint64_t now, std::string &out);
+
+            /**
+             * @brief 响应的有效期，不可缓存时为0，单位：秒
+             */
+            static uint64_t MaxAge(HttpResponse::ptr rsp);
+
+            inline size_t getCapacity() const { return m_capacity; }
+
+            /**
+             * @brief 已占用的字节数
+             */
+            size_t size();
+
+            size_t count();
+
+        private:
+            struct Slot
+            {
+                EntryPtr entry; // 为空表示空闲
+                uint64_t hash;
+                size_t charge; // 计入容量的字节数
+                bool referenced;
+            };
+
+            // 各线程访问各自的分片，按缓存行对齐避免相邻分片的锁互相干扰
+            struct alignas(64) Shard
+            {
+                Spinlock lock;
+                std::vector<Slot> slots;
+                std::vector<size_t> free; // 空闲槽位
+                std::unordered_map<std::string, size_t> index;
+                size_t hand = 0; // CLOCK指针
+                size_t size = 0;
+                std::unique_ptr<FrequencySketch> sketch;
+            };
+
+            Shard &localShard();
+
+            void remove(Shard &shard, size_t slot);
+
+            /**
+             * @brief 转动CLOCK指针，清除途经槽位的引用位，返回第一个未被引用的槽位，分片为空时返回npos
+             */
+            size_t victim(Shard &shard);
+
+        private:
+            size_t m_capacity;
+            size_t m_shardCapacity;
+            std::vector<std::string> m_vary;
+            size_t m_shardCount;
+            std::unique_ptr<Shard[]> m_shards;
+
+            MetricCounter *m_hits;
+            MetricCounter *m_misses;
+            MetricCounter *m_stores;
+            MetricCounter *m_rejects;
+            MetricCounter *m_evictions;
+            MetricGauge *m_bytes;
+            MetricGauge *m_entries;
+        };
+    } // namespace http
+} // namespace lim_webserver
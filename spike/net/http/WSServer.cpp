@@ -0,0 +1,87 @@
+#include "WSServer.h"
+#include "base/Configer.h"
+#include "splog.h"
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        static Logger::ptr g_logger = LOG_SYS();
+
+        static ConfigerVar<uint64_t>::ptr g_websocket_idle_timeout =
+            Configer::Lookup("websocket.idle_timeout", (uint64_t)0, "websocket read idle timeout in ms after handshake, 0 to rely on application pings");
+
+        WSServer::WSServer(Scheduler *worker, Scheduler *accepter) : TcpServer(worker, accepter) {}
+
+        void WSServer::handleClient(Socket::ptr client)
+        {
+            WSSession::ptr session = std::make_shared<WSSession>(client);
+            HttpRequest::ptr req = session->handleShake();
+            if (!req)
+            {
+                return;
+            }
+            // 长连接上对端可能长时间不发送数据，握手后改用websocket自己的空闲超时
+            client->setIdleTimeout(g_websocket_idle_timeout->getValue());
+            session->startSender();
+            {
+                RWMutex::WriteLock lock(m_mutex);
+                m_sessions.insert(session);
+            }
+            LOG_DEBUG(g_logger) << "websocket connected " << session->peerAddressString() << " path=" << req->path();
+            if (m_onConnect)
+            {
+                m_onConnect(session, req);
+            }
+
+            while (true)
+            {
+                WSMessage::ptr msg = session->recvMessage();
+                if (!msg)
+                {
+                    break;
+                }
+                if (m_onMessage)
+                {
+                    m_onMessage(session, msg);
+                }
+                else if (session->sendMessage(msg->data(), msg->opcode()) <= 0)
+                {
+                    break;
+                }
+            }
+
+            session->close();
+            {
+                RWMutex::WriteLock lock(m_mutex);
+                m_sessions.erase(session);
+            }
+            if (m_onClose)
+            {
+                m_onClose(session);
+            }
+        }
+
+        size_t WSServer::broadcast(const WSFrame::ptr &frame)
+        {
+            size_t count = 0;
+            RWMutex::ReadLock lock(m_mutex);
+            for (const WSSession::ptr &session : m_sessions)
+            {
+                if (session->post(frame))
+                {
+                    ++count;
+                }
+            }
+            return count;
+        }
+
+        size_t WSServer::getSessionCount()
+        {
+            RWMutex::ReadLock lock(m_mutex);
+            return m_sessions.size();
+        }
+
+    } // namespace http
+
+} // namespace lim_webserver
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "base/Mutex.h"
+#include "net/Server.h"
+#include "net/http/WSSession.h"
+
+#include <functional>
+#include <unordered_set>
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        /**
+         * @brief WebSocket服务器
+         *
+         * @details 每个连接先完成握手，再在处理连接的协程中循环recvMessage并交给消息回调；
+         *          同时在同一处理器上开启会话的发送协程，broadcast把同一个编码好的帧放入所有会话的发送队列。
+         */
+        class WSServer : public TcpServer
+        {
+        public:
+            using ptr = std::shared_ptr<WSServer>;
+            using ConnectCallback = std::function<void(WSSession::ptr, HttpRequest::ptr)>;
+            using MessageCallback = std::function<void(WSSession::ptr, WSMessage::ptr)>;
+            using CloseCallback = std::function<void(WSSession::ptr)>;
+
+        public:
+            WSServer(Scheduler *worker = EventLoop::GetCurrentScheduler(), Scheduler *accepter = EventLoop::GetCurrentScheduler());
+
+            /**
+             * @brief 握手完成后调用，在处理连接的协程中执行
+             */
+            inline void setConnectCallback(ConnectCallback cb) { m_onConnect = cb; }
+
+            /**
+             * @brief 收到完整消息时调用，未设置时原样回显
+             */
+            inline void setMessageCallback(MessageCallback cb) { m_onMessage = cb; }
+
+            /**
+             * @brief 会话结束时调用
+             */
+            inline void setCloseCallback(CloseCallback cb) { m_onClose = cb; }
+
+            /**
+             * @brief 向所有会话广播同一帧，不阻塞
+             *
+             * @return size_t 成功放入发送队列的会话数
+             */
+            size_t broadcast(const WSFrame::ptr &frame);
+
+            size_t broadcast(const std::string &data, WSOpcode opcode = WSOpcode::TEXT) { return broadcast(WSFrame::Create(opcode, data)); }
+
+            /**
+             * @brief 当前会话数
+             */
+            size_t getSessionCount();
+
+        protected:
+            virtual void handleClient(Socket::ptr client) override;
+
+        private:
+            RWMutex m_mutex;                             // 保护会话集合
+            std::unordered_set<WSSession::ptr> m_sessions; // 已握手的会话
+            ConnectCallback m_onConnect;
+            MessageCallback m_onMessage;
+            CloseCallback m_onClose;
+        };
+
+    } // namespace http
+
+} // namespace lim_webserver
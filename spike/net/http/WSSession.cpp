@@ -0,0 +1,570 @@
+#include "WSSession.h"
+#include "base/Configer.h"
+#include "base/Util.h"
+#include "coroutine/Processor.h"
+#include "coroutine/Scheduler.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <openssl/rand.h>
+#include <string.h>
+#include <sys/random.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        static Logger::ptr g_logger = LOG_SYS();
+
+        static ConfigerVar<uint64_t>::ptr g_websocket_max_message_size =
+            Configer::Lookup("websocket.max_message_size", (uint64_t)(32 * 1024 * 1024), "max websocket message size after reassembling fragments");
+
+        static ConfigerVar<uint32_t>::ptr g_websocket_max_send_queue =
+            Configer::Lookup<uint32_t>("websocket.max_send_queue", 4096, "max frames queued by post per websocket session, more are dropped");
+
+        static const char WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+        /**
+         * @brief 取不可预测的随机字节，用于客户端掩码键与握手随机数(RFC 6455 5.3)，
+         *        每线程缓存一批，不必每帧调用RAND_bytes
+         */
+        static void RandomBytes(void *out, size_t len)
+        {
+            static thread_local uint8_t t_pool[256];
+            static thread_local size_t t_pos = sizeof(t_pool);
+            if (t_pos + len > sizeof(t_pool))
+            {
+                if (RAND_bytes(t_pool, sizeof(t_pool)) != 1 && getrandom(t_pool, sizeof(t_pool), 0) != (ssize_t)sizeof(t_pool))
+                {
+                    LOG_ERROR(g_logger) << "websocket random bytes unavailable";
+                }
+                t_pos = 0;
+            }
+            memcpy(out, t_pool + t_pos, len);
+            t_pos += len;
+        }
+
+        // 读缓冲区大小，小于它的载荷随帧头一起读入
+        static const size_t READ_BUFFER_SIZE = 64 * 1024;
+
+        // 发送协程一次writev最多携带的帧数
+        static const size_t SEND_BATCH = 64;
+
+        void WSMask(void *data, size_t len, const uint8_t key[4], size_t offset)
+        {
+            uint8_t *p = (uint8_t *)data;
+            // 按offset轮转掩码，使p[0]对应key[0]
+            uint8_t k[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                k[i] = key[(offset + i) & 3];
+            }
+            uint32_t k32;
+            memcpy(&k32, k, 4);
+            uint64_t k64 = ((uint64_t)k32 << 32) | k32;
+            size_t i = 0;
+#if defined(__x86_64__)
+#if defined(__AVX2__)
+            __m256i k256 = _mm256_set1_epi32((int)k32);
+            for (; i + 32 <= len; i += 32)
+            {
+                __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+                _mm256_storeu_si256((__m256i *)(p + i), _mm256_xor_si256(v, k256));
+            }
+#endif
+            __m128i k128 = _mm_set1_epi32((int)k32);
+            for (; i + 16 <= len; i += 16)
+            {
+                __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+                _mm_storeu_si128((__m128i *)(p + i), _mm_xor_si128(v, k128));
+            }
+#endif
+            for (; i + 8 <= len; i += 8)
+            {
+                uint64_t v;
+                memcpy(&v, p + i, 8);
+                v ^= k64;
+                memcpy(p + i, &v, 8);
+            }
+            for (; i < len; ++i)
+            {
+                p[i] ^= k[i & 3];
+            }
+        }
+
+        size_t WSEncodeHead(uint8_t *out, WSOpcode opcode, bool fin, uint64_t len, const uint8_t *mask)
+        {
+            size_t n = 0;
+            out[n++] = (fin ? 0x80 : 0) | (uint8_t)opcode;
+            uint8_t mask_bit = mask ? 0x80 : 0;
+            if (len < 126)
+            {
+                out[n++] = mask_bit | (uint8_t)len;
+            }
+            else if (len <= 0xFFFF)
+            {
+                out[n++] = mask_bit | 126;
+                out[n++] = (uint8_t)(len >> 8);
+                out[n++] = (uint8_t)len;
+            }
+            else
+            {
+                out[n++] = mask_bit | 127;
+                for (int i = 7; i >= 0; --i)
+                {
+                    out[n++] = (uint8_t)(len >> (i * 8));
+                }
+            }
+            if (mask)
+            {
+                memcpy(out + n, mask, 4);
+                n += 4;
+            }
+            return n;
+        }
+
+        WSFrame::ptr WSFrame::Create(WSOpcode opcode, const void *data, size_t len, bool fin)
+        {
+            std::shared_ptr<WSFrame> frame = std::make_shared<WSFrame>();
+            uint8_t head[14];
+            size_t head_len = WSEncodeHead(head, opcode, fin, len, nullptr);
+            frame->m_data.reserve(head_len + len);
+            frame->m_data.append((const char *)head, head_len);
+            frame->m_data.append((const char *)data, len);
+            return frame;
+        }
+
+        WSSession::WSSession(Socket::ptr sock, bool owner, bool client)
+            : HttpSession(sock, owner), m_client(client), m_maxQueue(g_websocket_max_send_queue->getValue())
+        {
+        }
+
+        HttpRequest::ptr WSSession::handleShake()
+        {
+            HttpRequest::ptr req = recvRequest();
+            if (!req)
+            {
+                return nullptr;
+            }
+            std::string connection = req->getHeader("Connection");
+            std::transform(connection.begin(), connection.end(), connection.begin(), ::tolower);
+            std::string key = req->getHeader("Sec-WebSocket-Key");
+            if (strcasecmp(req->getHeader("Upgrade").c_str(), "websocket") != 0 || connection.find("upgrade") == std::string::npos ||
+                req->getHeader("Sec-WebSocket-Version") != "13" || key.empty())
+            {
+                LOG_DEBUG(g_logger) << "invalid websocket handshake from " << peerAddressString();
+                HttpResponse::ptr rsp(new HttpResponse(req->version(), true));
+                rsp->setStatus(HttpStatus::BAD_REQUEST);
+                sendResponse(rsp);
+                close();
+                return nullptr;
+            }
+
+            HttpResponse::ptr rsp(new HttpResponse(req->version(), false));
+            rsp->setStatus(HttpStatus::SWITCHING_PROTOCOLS);
+            rsp->setWebsocket(true);
+            rsp->setHeader("Upgrade", "websocket");
+            rsp->setHeader("Connection", "Upgrade");
+            rsp->setHeader("Sec-WebSocket-Accept", StringUtil::Base64Encode(StringUtil::Sha1(key + WS_GUID)));
+            if (sendResponse(rsp) <= 0)
+            {
+                close();
+                return nullptr;
+            }
+            req->setWebsocket(true);
+            return req;
+        }
+
+        WSSession::ptr WSSession::Connect(Address::ptr addr, const std::string &path, const std::string &host)
+        {
+            Socket::ptr sock = Socket::CreateTCP(addr);
+            if (!sock->connect(addr))
+            {
+                return nullptr;
+            }
+            WSSession::ptr session = std::make_shared<WSSession>(sock, true, true);
+
+            uint8_t nonce[16];
+            RandomBytes(nonce, sizeof(nonce));
+            std::string key = StringUtil::Base64Encode(nonce, sizeof(nonce));
+            std::string request = "GET " + path + " HTTP/1.1\r\n"
+                                  "Host: " + (host.empty() ? addr->toString() : host) + "\r\n"
+                                  "Upgrade: websocket\r\n"
+                                  "Connection: Upgrade\r\n"
+                                  "Sec-WebSocket-Key: " + key + "\r\n"
+                                  "Sec-WebSocket-Version: 13\r\n\r\n";
+            if (session->send(request.data(), request.size()) <= 0)
+            {
+                return nullptr;
+            }
+
+            // 读到响应头结束，之后的数据已是帧，留在读缓冲区中
+            size_t head_end;
+            while ((head_end = session->m_rbuf.find("\r\n\r\n", session->m_rpos)) == std::string::npos || head_end + 4 > session->m_rend)
+            {
+                if (session->m_rend - session->m_rpos > READ_BUFFER_SIZE || session->fill(session->m_rend - session->m_rpos + 1) <= 0)
+                {
+                    session->close();
+                    return nullptr;
+                }
+            }
+            std::string head = session->m_rbuf.substr(session->m_rpos, head_end - session->m_rpos);
+            session->m_rpos = head_end + 4;
+            std::transform(head.begin(), head.end(), head.begin(), ::tolower);
+            std::string expect = StringUtil::Base64Encode(StringUtil::Sha1(key + WS_GUID));
+            std::transform(expect.begin(), expect.end(), expect.begin(), ::tolower);
+            size_t pos = head.find("sec-websocket-accept:");
+            if (head.compare(0, 12, "http/1.1 101") != 0 || pos == std::string::npos ||
+                StringUtil::Trim(head.substr(pos + 21, head.find("\r\n", pos) - pos - 21)) != expect)
+            {
+                LOG_DEBUG(g_logger) << "websocket handshake rejected by " << addr->toString();
+                session->close();
+                return nullptr;
+            }
+            return session;
+        }
+
+        int WSSession::fill(size_t need)
+        {
+            while (m_rend - m_rpos < need)
+            {
+                if (m_rpos > 0)
+                {
+                    memmove(&m_rbuf[0], &m_rbuf[m_rpos], m_rend - m_rpos);
+                    m_rend -= m_rpos;
+                    m_rpos = 0;
+                }
+                if (m_rbuf.size() < std::max(need, READ_BUFFER_SIZE))
+                {
+                    m_rbuf.resize(std::max(need, READ_BUFFER_SIZE));
+                }
+                int n = resv(&m_rbuf[m_rend], m_rbuf.size() - m_rend);
+                if (n <= 0)
+                {
+                    return n;
+                }
+                m_rend += n;
+            }
+            return 1;
+        }
+
+        int WSSession::readPayload(char *dst, size_t len)
+        {
+            size_t buffered = std::min(len, m_rend - m_rpos);
+            memcpy(dst, &m_rbuf[m_rpos], buffered);
+            m_rpos += buffered;
+            size_t done = buffered;
+            while (done < len)
+            {
+                int n = resv(dst + done, len - done);
+                if (n <= 0)
+                {
+                    return n;
+                }
+                done += n;
+            }
+            return 1;
+        }
+
+        WSMessage::ptr WSSession::recvMessage()
+        {
+            std::string data;
+            WSOpcode opcode = WSOpcode::CONTINUE; // 正在合并的消息类型，CONTINUE表示尚未开始
+            uint64_t max_size = g_websocket_max_message_size->getValue();
+            while (!isClosed())
+            {
+                if (fill(2) <= 0)
+                {
+                    break;
+                }
+                const uint8_t *head = (const uint8_t *)&m_rbuf[m_rpos];
+                bool fin = head[0] & 0x80;
+                WSOpcode op = (WSOpcode)(head[0] & 0x0F);
+                bool masked = head[1] & 0x80;
+                uint8_t len7 = head[1] & 0x7F;
+                size_t head_len = 2 + (len7 == 126 ? 2 : (len7 == 127 ? 8 : 0)) + (masked ? 4 : 0);
+                if ((head[0] & 0x70) || masked == m_client)
+                {
+                    // 未协商扩展时RSV必须为0；客户端发出的帧必须加掩码，服务端发出的不得加掩码
+                    fail(1002);
+                    break;
+                }
+                if (fill(head_len) <= 0)
+                {
+                    break;
+                }
+                head = (const uint8_t *)&m_rbuf[m_rpos];
+                uint64_t len = len7;
+                if (len7 == 126)
+                {
+                    len = (head[2] << 8) | head[3];
+                }
+                else if (len7 == 127)
+                {
+                    len = 0;
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        len = (len << 8) | head[2 + i];
+                    }
+                }
+                uint8_t key[4] = {0};
+                if (masked)
+                {
+                    memcpy(key, head + head_len - 4, 4);
+                }
+                m_rpos += head_len;
+
+                bool control = (uint8_t)op & 0x8;
+                if (control)
+                {
+                    if (!fin || len > 125 || (op != WSOpcode::CLOSE && op != WSOpcode::PING && op != WSOpcode::PONG))
+                    {
+                        fail(1002);
+                        break;
+                    }
+                    char payload[125];
+                    if (readPayload(payload, len) <= 0)
+                    {
+                        break;
+                    }
+                    if (masked)
+                    {
+                        WSMask(payload, len, key);
+                    }
+                    if (op == WSOpcode::PING)
+                    {
+                        sendMessage(payload, len, WSOpcode::PONG);
+                    }
+                    else if (op == WSOpcode::CLOSE)
+                    {
+                        // 有负载时至少是2字节的状态码
+                        if (len == 1)
+                        {
+                            fail(1002);
+                            break;
+                        }
+                        // 回显对端的状态码后关闭
+                        uint16_t code = len >= 2 ? (((uint8_t)payload[0] << 8) | (uint8_t)payload[1]) : 1000;
+                        LOG_DEBUG(g_logger) << "websocket closed by " << peerAddressString() << " code=" << code;
+                        sendClose(code);
+                        close();
+                        break;
+                    }
+                    continue;
+                }
+
+                if (op != WSOpcode::CONTINUE && op != WSOpcode::TEXT && op != WSOpcode::BINARY)
+                {
+                    fail(1002);
+                    break;
+                }
+                // 新消息不能打断未结束的分片消息，后续帧之前必须有首帧
+                if ((op == WSOpcode::CONTINUE) == (opcode == WSOpcode::CONTINUE))
+                {
+                    fail(1002);
+                    break;
+                }
+                if (data.size() + len > max_size)
+                {
+                    fail(1009);
+                    break;
+                }
+                if (op != WSOpcode::CONTINUE)
+                {
+                    opcode = op;
+                }
+                size_t offset = data.size();
+                data.resize(offset + len);
+                if (readPayload(&data[offset], len) <= 0)
+                {
+                    break;
+                }
+                if (masked)
+                {
+                    WSMask(&data[offset], len, key);
+                }
+                if (fin)
+                {
+                    return std::make_shared<WSMessage>(opcode, std::move(data));
+                }
+            }
+            close();
+            return nullptr;
+        }
+
+        int WSSession::writeAll(iovec *iov, int count)
+        {
+            int total = 0;
+            while (count > 0)
+            {
+                int n = m_socket->send(iov, std::min(count, IOV_MAX), MSG_NOSIGNAL);
+                if (n <= 0)
+                {
+                    return n;
+                }
+                total += n;
+                // 跳过已写完的段，调整写了一部分的段
+                while (count > 0 && (size_t)n >= iov->iov_len)
+                {
+                    n -= iov->iov_len;
+                    ++iov;
+                    --count;
+                }
+                if (count > 0)
+                {
+                    iov->iov_base = (char *)iov->iov_base + n;
+                    iov->iov_len -= n;
+                }
+            }
+            return total;
+        }
+
+        int WSSession::sendMessage(const void *data, size_t len, WSOpcode opcode, bool fin)
+        {
+            uint8_t head[14];
+            iovec iov[2];
+            std::string masked;
+            if (m_client)
+            {
+                uint8_t key[4];
+                RandomBytes(key, sizeof(key));
+                masked.assign((const char *)data, len);
+                WSMask(&masked[0], len, key);
+                data = masked.data();
+                iov[0].iov_len = WSEncodeHead(head, opcode, fin, len, key);
+            }
+            else
+            {
+                iov[0].iov_len = WSEncodeHead(head, opcode, fin, len, nullptr);
+            }
+            iov[0].iov_base = head;
+            iov[1].iov_base = (void *)data;
+            iov[1].iov_len = len;
+            CoMutex::Lock lock(m_sendMutex);
+            return writeAll(iov, len ? 2 : 1);
+        }
+
+        int WSSession::sendFrame(const WSFrame::ptr &frame)
+        {
+            iovec iov;
+            iov.iov_base = (void *)frame->data();
+            iov.iov_len = frame->size();
+            CoMutex::Lock lock(m_sendMutex);
+            return writeAll(&iov, 1);
+        }
+
+        int WSSession::sendClose(uint16_t code, const std::string &reason)
+        {
+            if (m_closeSent)
+            {
+                return 0;
+            }
+            m_closeSent = true;
+            std::string payload;
+            payload += (char)(code >> 8);
+            payload += (char)code;
+            payload += reason.substr(0, 123);
+            return sendMessage(payload, WSOpcode::CLOSE);
+        }
+
+        void WSSession::fail(uint16_t code)
+        {
+            LOG_DEBUG(g_logger) << "websocket protocol error from " << peerAddressString() << " code=" << code;
+            sendClose(code);
+            close();
+        }
+
+        void WSSession::startSender()
+        {
+            if (m_senderStarted)
+            {
+                return;
+            }
+            m_senderStarted = true;
+            WSSession::ptr self = shared_from_this();
+            Processor::GetCurrentScheduler()->createTask([self]() { self->senderLoop(); });
+        }
+
+        bool WSSession::post(const WSFrame::ptr &frame)
+        {
+            if (isClosed())
+            {
+                return false;
+            }
+            bool notify;
+            {
+                Spinlock::Lock lock(m_queueLock);
+                if (m_sendQueue.size() >= m_maxQueue)
+                {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                notify = m_sendQueue.empty();
+                m_sendQueue.push_back(frame);
+            }
+            // 只在队列由空变为非空时通知，发送协程每次醒来取走全部帧
+            if (notify)
+            {
+                m_sendSignal.notify();
+            }
+            return true;
+        }
+
+        void WSSession::senderLoop()
+        {
+            std::vector<WSFrame::ptr> batch;
+            iovec iov[SEND_BATCH];
+            while (true)
+            {
+                m_sendSignal.wait();
+                if (isClosed())
+                {
+                    break;
+                }
+                {
+                    Spinlock::Lock lock(m_queueLock);
+                    batch.swap(m_sendQueue);
+                }
+                CoMutex::Lock lock(m_sendMutex);
+                for (size_t i = 0; i < batch.size() && !isClosed(); i += SEND_BATCH)
+                {
+                    size_t count = std::min(SEND_BATCH, batch.size() - i);
+                    for (size_t j = 0; j < count; ++j)
+                    {
+                        iov[j].iov_base = (void *)batch[i + j]->data();
+                        iov[j].iov_len = batch[i + j]->size();
+                    }
+                    if (writeAll(iov, count) <= 0)
+                    {
+                        lock.unlock();
+                        close();
+                        break;
+                    }
+                }
+                batch.clear();
+            }
+            Spinlock::Lock lock(m_queueLock);
+            m_sendQueue.clear();
+        }
+
+        void WSSession::close()
+        {
+            if (m_closed.exchange(true, std::memory_order_acq_rel))
+            {
+                return;
+            }
+            if (m_senderStarted)
+            {
+                m_sendSignal.notify();
+            }
+            HttpSession::close();
+        }
+
+    } // namespace http
+
+} // namespace lim_webserver
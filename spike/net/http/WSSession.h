@@ -0,0 +1,224 @@
+#pragma once
+
+#include "base/Mutex.h"
+#include "coroutine/CoSync.h"
+#include "net/http/HttpSession.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace lim_webserver
+{
+    namespace http
+    {
+        /**
+         * @brief WebSocket帧类型(RFC 6455 5.2)
+         */
+        enum class WSOpcode : uint8_t
+        {
+            CONTINUE = 0x0, // 分片消息的后续帧
+            TEXT = 0x1,     // 文本消息
+            BINARY = 0x2,   // 二进制消息
+            CLOSE = 0x8,    // 关闭
+            PING = 0x9,     // 心跳请求
+            PONG = 0xA      // 心跳响应
+        };
+
+        /**
+         * @brief 对数据原地异或掩码，加掩码与去掩码是同一操作
+         *
+         * @details x86_64上每次处理16字节(SSE2，编译开启AVX2时为32字节)，尾部按8字节与单字节处理
+         *
+         * @param key    4字节掩码
+         * @param offset data在整个载荷中的偏移，分段处理同一载荷时保证掩码对齐
+         */
+        void WSMask(void *data, size_t len, const uint8_t key[4], size_t offset = 0);
+
+        /**
+         * @brief 编码帧头
+         *
+         * @param out  至少14字节
+         * @param mask 4字节掩码，为nullptr时不加掩码(服务端发出的帧)
+         * @return size_t 帧头长度，2到14字节
+         */
+        size_t WSEncodeHead(uint8_t *out, WSOpcode opcode, bool fin, uint64_t len, const uint8_t *mask);
+
+        /**
+         * @brief 编码好的完整帧(帧头与载荷连续存放)，服务端发出的帧不加掩码，同一帧可发给任意多个会话
+         *
+         * @details 广播时只编码一次，各会话的发送队列持有同一对象的引用，由各自的发送协程以writev直接写出
+         */
+        class WSFrame
+        {
+        public:
+            using ptr = std::shared_ptr<const WSFrame>;
+
+            static ptr Create(WSOpcode opcode, const void *data, size_t len, bool fin = true);
+
+            static ptr Create(WSOpcode opcode, const std::string &data, bool fin = true) { return Create(opcode, data.data(), data.size(), fin); }
+
+            inline const char *data() const { return m_data.data(); }
+
+            inline size_t size() const { return m_data.size(); }
+
+        private:
+            std::string m_data; // 帧头与载荷
+        };
+
+        /**
+         * @brief 一条完整的消息，分片已合并
+         */
+        class WSMessage
+        {
+        public:
+            using ptr = std::shared_ptr<WSMessage>;
+
+            WSMessage(WSOpcode opcode, std::string &&data) : m_opcode(opcode), m_data(std::move(data)) {}
+
+            inline WSOpcode opcode() const { return m_opcode; }
+
+            inline const std::string &data() const { return m_data; }
+
+            inline std::string &data() { return m_data; }
+
+        private:
+            WSOpcode m_opcode;  // TEXT或BINARY
+            std::string m_data; // 载荷
+        };
+
+        /**
+         * @brief WebSocket会话
+         *
+         * @details 收：帧头与小载荷经会话内的读缓冲区批量读取，大载荷直接读入消息，去掩码原地完成；
+         *          分片自动合并，PING自动回复PONG，收到CLOSE时回复后关闭。
+         *          发：sendMessage把帧头写在栈上，与调用方的载荷组成两段iovec一次写出，载荷不复制；
+         *          post把共享的WSFrame放入发送队列，由startSender开启的发送协程批量writev，调用方不阻塞。
+         *          两条发送路径由同一把协程锁串行化，帧不会交错。
+         */
+        class WSSession : public HttpSession, public std::enable_shared_from_this<WSSession>
+        {
+        public:
+            using ptr = std::shared_ptr<WSSession>;
+
+            /**
+             * @param client 是否为客户端，客户端发出的帧加掩码，收到的帧不得带掩码，服务端相反
+             */
+            WSSession(Socket::ptr sock, bool owner = true, bool client = false);
+
+            /**
+             * @brief 服务端握手：读取升级请求并回复101
+             *
+             * @return HttpRequest::ptr 升级请求，非法请求回复400后关闭并返回nullptr
+             * @note 请求之后紧跟的帧会随请求缓冲区丢弃，客户端应按协议等到101后再发送
+             */
+            HttpRequest::ptr handleShake();
+
+            /**
+             * @brief 客户端：连接并完成握手，须在协程中调用
+             *
+             * @param path 请求路径
+             * @param host Host头，为空时取地址字符串
+             */
+            static ptr Connect(Address::ptr addr, const std::string &path = "/", const std::string &host = "");
+
+            /**
+             * @brief 接收一条完整的消息，期间到达的控制帧自动处理
+             *
+             * @return WSMessage::ptr 对端关闭、出错或违反协议时关闭会话并返回nullptr
+             */
+            WSMessage::ptr recvMessage();
+
+            /**
+             * @brief 发送一帧，载荷不复制(客户端需加掩码时除外)
+             *
+             * @return int 写出的字节数，<=0为失败
+             */
+            int sendMessage(const void *data, size_t len, WSOpcode opcode = WSOpcode::TEXT, bool fin = true);
+
+            int sendMessage(const std::string &data, WSOpcode opcode = WSOpcode::TEXT, bool fin = true)
+            {
+                return sendMessage(data.data(), data.size(), opcode, fin);
+            }
+
+            /**
+             * @brief 同步发送编码好的帧，只能用于服务端
+             */
+            int sendFrame(const WSFrame::ptr &frame);
+
+            int ping(const std::string &data = "") { return sendMessage(data, WSOpcode::PING); }
+
+            /**
+             * @brief 发送CLOSE帧，之后不应再发送数据帧
+             */
+            int sendClose(uint16_t code = 1000, const std::string &reason = "");
+
+            /**
+             * @brief 开启发送协程，在当前调度器上运行，须在协程中调用，post之前调用一次
+             */
+            void startSender();
+
+            /**
+             * @brief 把帧放入发送队列，不阻塞，只能用于服务端
+             *
+             * @return false 会话已关闭或队列已满(websocket.max_send_queue)，该帧被丢弃
+             */
+            bool post(const WSFrame::ptr &frame);
+
+            /**
+             * @brief 因发送队列满被丢弃的帧数
+             */
+            inline uint64_t getDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+            inline bool isClosed() const { return m_closed.load(std::memory_order_acquire); }
+
+            /**
+             * @brief 关闭会话，唤醒发送协程退出
+             */
+            void close() override;
+
+        private:
+            /**
+             * @brief 保证读缓冲区中至少有need字节未处理的数据
+             *
+             * @return int >0成功，<=0为读失败
+             */
+            int fill(size_t need);
+
+            /**
+             * @brief 读取len字节载荷到dst，先取读缓冲区中已有的数据，不足部分直接读入dst
+             */
+            int readPayload(char *dst, size_t len);
+
+            /**
+             * @brief 写出全部iovec，处理部分写，调用方须持有m_sendMutex
+             */
+            int writeAll(iovec *iov, int count);
+
+            /**
+             * @brief 违反协议时发送CLOSE帧后关闭
+             */
+            void fail(uint16_t code);
+
+            void senderLoop();
+
+        private:
+            bool m_client;                         // 是否为客户端
+            std::string m_rbuf;                    // 读缓冲区
+            size_t m_rpos = 0;                     // 读缓冲区中未处理数据的起点
+            size_t m_rend = 0;                     // 读缓冲区中有效数据的终点
+            std::atomic<bool> m_closed{false};     // 是否已关闭
+            bool m_closeSent = false;              // 是否已发送CLOSE帧
+            bool m_senderStarted = false;          // 发送协程是否已开启
+            CoMutex m_sendMutex;                   // 串行化两条发送路径
+            Spinlock m_queueLock;                  // 保护发送队列
+            std::vector<WSFrame::ptr> m_sendQueue; // 发送队列
+            CoSemaphore m_sendSignal;              // 队列由空变为非空或关闭时通知发送协程
+            size_t m_maxQueue;                     // 发送队列上限
+            std::atomic<uint64_t> m_dropped{0};    // 因队列满丢弃的帧数
+        };
+
+    } // namespace http
+
+} // namespace lim_webserver
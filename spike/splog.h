@@ -10,7 +10,18 @@
  * @param logger 目标日志器
  * @param level  事件级别
  */
-#define LOG_LEVEL(logger, level) lim_webserver::LogMessageWrap(lim_webserver::LogMessage::Create(logger, __FILE__, __LINE__, time(0), level, logger->getName())).getStream()
+#define LOG_LEVEL(logger, level) LOG_IF(logger, level, true)
+
+/**
+ * @brief 满足条件时写入日志
+ *
+ * @details 依次判断级别、condition与日志器的令牌桶，任一不满足则整条语句(包括<<右侧的表达式)都不会求值。
+ *          被限流的条数会以"[suppressed N messages]"的形式写在下一条放行日志的开头，
+ *          之后没有日志放行时由LogSuppression定期汇总输出。
+ */
+#define LOG_IF(logger, level, condition)                                                                                        \
+    for (lim_webserver::LogGate _lim_gate(&*(logger), level); _lim_gate.isOpen() && (condition) && _lim_gate.admit(); _lim_gate.close()) \
+    lim_webserver::LogMessageWrap(_lim_gate.getLogger(), __FILE__, __LINE__, time(0), level).getStream() << _lim_gate
 #define LOG_TRACE(logger) LOG_LEVEL(logger, LogLevel_TRACE)
 #define LOG_DEBUG(logger) LOG_LEVEL(logger, LogLevel_DEBUG)
 #define LOG_INFO(logger) LOG_LEVEL(logger, LogLevel_INFO)
@@ -18,6 +29,18 @@
 #define LOG_ERROR(logger) LOG_LEVEL(logger, LogLevel_ERROR)
 #define LOG_FATAL(logger) LOG_LEVEL(logger, LogLevel_FATAL)
 
+/**
+ * @brief 当前调用点的采样状态，每处宏展开对应一个独立的静态实例
+ */
+#define LOG_SITE() ([]() -> lim_webserver::LogSite & { static lim_webserver::LogSite site; return site; }())
+
+/**
+ * @brief 调用点采样：每n次写一次 / 只写前n次 / 每ms毫秒至多写一次(附带被抑制的条数)
+ */
+#define LOG_EVERY_N(logger, level, n) LOG_IF(logger, level, LOG_SITE().everyN(n, _lim_gate, __FILE__, __LINE__))
+#define LOG_FIRST_N(logger, level, n) LOG_IF(logger, level, LOG_SITE().firstN(n, _lim_gate, __FILE__, __LINE__))
+#define LOG_EVERY_MS(logger, level, ms) LOG_IF(logger, level, LOG_SITE().everyMS(ms, _lim_gate, __FILE__, __LINE__))
+
 #define LOG_ROOT() lim_webserver::LogManager::GetInstance()->getRoot()
 #define LOG_SYS() lim_webserver::LogManager::GetInstance()->getLogger("system")
 #define LOG_NAME(name) lim_webserver::LogManager::GetInstance()->getLogger(name)
@@ -0,0 +1,192 @@
+#include "FlushPolicy.h"
+#include "LogAppender.h"
+#include "LogRateLimit.h"
+#include "base/Affinity.h"
+
+#include <algorithm>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+
+namespace lim_webserver
+{
+    static const int s_fatal_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTERM};
+
+    LogFlusher::LogFlusher()
+        : m_cond(m_mutex)
+    {
+        for (auto &slot : m_appenders)
+        {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+        installSignalHandler();
+    }
+
+    LogFlusher::~LogFlusher()
+    {
+        {
+            Mutex::Lock lock(m_mutex);
+            m_stopping = true;
+            m_cond.notify_one();
+        }
+        if (m_thread)
+        {
+            m_thread->join();
+        }
+        LogSuppression::Report();
+    }
+
+    bool LogFlusher::add(OutputAppender *appender)
+    {
+        Mutex::Lock lock(m_mutex);
+        for (auto &slot : m_appenders)
+        {
+            if (slot.load(std::memory_order_relaxed) == appender)
+            {
+                return true;
+            }
+        }
+        for (auto &slot : m_appenders)
+        {
+            OutputAppender *expected = nullptr;
+            if (slot.compare_exchange_strong(expected, appender))
+            {
+                // 首个需要按时间刷新的输出地注册时才启动后台线程
+                if (appender->getFlushPolicy().interval > 0)
+                {
+                    startThread();
+                }
+                m_cond.notify_one();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void LogFlusher::del(OutputAppender *appender)
+    {
+        // 持锁保证后台线程不会再访问该输出地
+        Mutex::Lock lock(m_mutex);
+        for (auto &slot : m_appenders)
+        {
+            OutputAppender *expected = appender;
+            slot.compare_exchange_strong(expected, nullptr);
+        }
+    }
+
+    void LogFlusher::flushAll()
+    {
+        Mutex::Lock lock(m_mutex);
+        for (auto &slot : m_appenders)
+        {
+            OutputAppender *appender = slot.load(std::memory_order_acquire);
+            if (appender)
+            {
+                appender->flush();
+            }
+        }
+    }
+
+    void LogFlusher::startReporting()
+    {
+        if (m_reporting.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        Mutex::Lock lock(m_mutex);
+        m_reporting.store(true, std::memory_order_release);
+        startThread();
+        m_cond.notify_one();
+    }
+
+    void LogFlusher::startThread()
+    {
+        if (!m_thread)
+        {
+            m_thread = Thread::Create([this]()
+                                      { this->run(); },
+                                      "log_flusher");
+        }
+    }
+
+    uint64_t LogFlusher::NowMS()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return ts.tv_sec * 1000ul + ts.tv_nsec / 1000000;
+    }
+
+    void LogFlusher::run()
+    {
+        CpuAffinity::RegisterHousekeeping();
+        Mutex::Lock lock(m_mutex);
+        uint64_t next_report = NowMS() + LogSuppression::kReportInterval;
+        while (!m_stopping)
+        {
+            // 等待时间取各输出地最近一次到期时间，无到期任务时每秒检查一次
+            int wait = 1000;
+            uint64_t now = NowMS();
+            if (m_reporting.load(std::memory_order_relaxed))
+            {
+                if (now >= next_report)
+                {
+                    // 汇总会写日志，不能持有m_mutex，否则与输出地的注册/注销互锁
+                    lock.unlock();
+                    LogSuppression::Report();
+                    lock.lock();
+                    now = NowMS();
+                    next_report = now + LogSuppression::kReportInterval;
+                }
+                wait = std::min<int>(wait, next_report - now);
+            }
+            for (auto &slot : m_appenders)
+            {
+                OutputAppender *appender = slot.load(std::memory_order_acquire);
+                if (appender)
+                {
+                    int next = appender->flushIfDue(now);
+                    if (next >= 0)
+                    {
+                        wait = std::min(wait, next);
+                    }
+                }
+            }
+            m_cond.waitTime(std::max(wait, 1));
+        }
+    }
+
+    void LogFlusher::installSignalHandler()
+    {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = &LogFlusher::OnFatalSignal;
+        sigemptyset(&sa.sa_mask);
+        // 处理一次后恢复默认行为，再次raise时由系统终止进程并生成core
+        sa.sa_flags = SA_RESETHAND;
+        for (int sig : s_fatal_signals)
+        {
+            struct sigaction old;
+            // 不覆盖使用者已安装的处理函数
+            if (sigaction(sig, nullptr, &old) == 0 && old.sa_handler == SIG_DFL)
+            {
+                sigaction(sig, &sa, nullptr);
+            }
+        }
+    }
+
+    void LogFlusher::OnFatalSignal(int sig)
+    {
+        // 信号处理中不能持有m_mutex，只做尽力而为的刷新
+        LogFlusher *flusher = LogFlusher::GetInstance();
+        for (auto &slot : flusher->m_appenders)
+        {
+            OutputAppender *appender = slot.load(std::memory_order_acquire);
+            if (appender)
+            {
+                appender->flushOnSignal();
+            }
+        }
+        raise(sig);
+    }
+
+} // namespace lim_webserver
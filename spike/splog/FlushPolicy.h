@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+#include "base/Mutex.h"
+#include "base/Singleton.h"
+#include "base/Thread.h"
+#include "splog/LogLevel.h"
+
+namespace lim_webserver
+{
+    /**
+     * @brief 输出地的刷新策略
+     *
+     * @details 默认每条日志刷新一次(与旧行为一致)。关闭every_record后进入批量模式，
+     *          以下条件任一满足即刷新：
+     *          1. 待刷新数据量达到bytes(0表示不按字节数刷新)
+     *          2. 距上次刷新超过interval毫秒(0表示不按时间刷新，由LogFlusher后台检查)
+     *          3. 日志级别不低于level(OFF表示不按级别刷新)
+     */
+    struct FlushPolicy
+    {
+        bool every_record = true;       // 每条日志都刷新
+        size_t bytes = 0;               // 按字节数刷新的阈值
+        int interval = 0;               // 按时间刷新的间隔，单位：毫秒
+        LogLevel level = LogLevel_WARN; // 立即刷新的最低级别
+
+        /**
+         * @brief 批量刷新策略
+         */
+        static FlushPolicy Batch(size_t bytes, int interval, LogLevel level = LogLevel_WARN)
+        {
+            FlushPolicy policy;
+            policy.every_record = false;
+            policy.bytes = bytes;
+            policy.interval = interval;
+            policy.level = level;
+            return policy;
+        }
+
+        bool operator==(const FlushPolicy &oth) const
+        {
+            return every_record == oth.every_record && bytes == oth.bytes && interval == oth.interval && level == oth.level;
+        }
+    };
+
+    class OutputAppender;
+
+    /**
+     * @brief 刷新调度器
+     *
+     * @details 负责两件输出地自身无法完成的事：
+     *          1. 后台线程按interval刷新长时间没有新日志、但仍有待刷新数据的输出地
+     *          2. 在致命信号(SIGSEGV/SIGBUS/SIGFPE/SIGILL/SIGABRT/SIGTERM)到来时刷新全部输出地后再按默认行为退出
+     *          注册表是定长的原子指针数组，信号处理函数中可以无锁遍历。
+     */
+    class LogFlusher : public Singleton<LogFlusher>
+    {
+        friend Singleton<LogFlusher>;
+
+    public:
+        static const int kMaxAppenders = 64;
+
+    public:
+        /**
+         * @brief 注册输出地，注册表已满时返回false
+         */
+        bool add(OutputAppender *appender);
+
+        void del(OutputAppender *appender);
+
+        /**
+         * @brief 刷新全部已注册的输出地
+         */
+        void flushAll();
+
+        /**
+         * @brief 启动被抑制日志的定期汇总(LogSuppression::Report)
+         */
+        void startReporting();
+
+        /**
+         * @brief 获取当前毫秒级单调时间
+         */
+        static uint64_t NowMS();
+
+    private:
+        LogFlusher();
+        ~LogFlusher();
+
+        /**
+         * @brief 后台刷新线程
+         */
+        void run();
+
+        /**
+         * @brief 启动后台线程，调用方需持有m_mutex
+         */
+        void startThread();
+
+        /**
+         * @brief 安装致命信号处理函数
+         */
+        void installSignalHandler();
+
+        static void OnFatalSignal(int sig);
+
+    private:
+        std::atomic<OutputAppender *> m_appenders[kMaxAppenders]; // 已注册的输出地
+        Thread::ptr m_thread;                                     // 后台刷新线程
+        Mutex m_mutex;                                            // 线程启停锁
+        ConditionVariable m_cond;                                 // 后台线程等待
+        bool m_stopping = false;                                  // 停止标志位
+        std::atomic<bool> m_reporting{false};                     // 是否定期汇总被抑制的日志
+    };
+
+} // namespace lim_webserver
@@ -1,5 +1,7 @@
 #include "LogAppender.h"
+#include "base/Affinity.h"
 
+#include <algorithm>
 #include <iostream>
 #include <assert.h>
 
@@ -22,6 +24,7 @@ namespace lim_webserver
         m_name = lad.name;
         m_level = lad.level;
         m_formatter = LogFormatter::Create(lad.formatter);
+        m_flushPolicy = lad.flush;
     }
 
     void OutputAppender::format(LogStream &logstream, LogMessage::ptr message)
@@ -43,7 +46,33 @@ namespace lim_webserver
             return;
         }
         m_sink->append(logline, len);
-        m_sink->flush();
+    }
+
+    void OutputAppender::doAppend(LogMessage::ptr message)
+    {
+        if (!isStarted())
+        {
+            return;
+        }
+        LogStream logstream;
+        format(logstream, message);
+        const LogStream::Buffer &buf(logstream.buffer());
+        if (buf.length() == 0)
+        {
+            return;
+        }
+        m_sink->append(buf.data(), buf.length());
+
+        if (m_flushPolicy.every_record || message->getLevel() >= m_flushPolicy.level)
+        {
+            flush();
+            return;
+        }
+        size_t pending = m_pending.fetch_add(buf.length(), std::memory_order_relaxed) + buf.length();
+        if (m_flushPolicy.bytes > 0 && pending >= m_flushPolicy.bytes)
+        {
+            flush();
+        }
     }
 
     void OutputAppender::flush()
@@ -52,9 +81,40 @@ namespace lim_webserver
         {
             return;
         }
+        m_pending.store(0, std::memory_order_relaxed);
+        if (m_flushPolicy.interval > 0)
+        {
+            m_lastFlush.store(LogFlusher::NowMS(), std::memory_order_relaxed);
+        }
         m_sink->flush();
     }
 
+    int OutputAppender::flushIfDue(uint64_t now)
+    {
+        if (m_flushPolicy.every_record || m_flushPolicy.interval <= 0)
+        {
+            return -1;
+        }
+        uint64_t elapsed = now - std::min(now, m_lastFlush.load(std::memory_order_relaxed));
+        if (elapsed < static_cast<uint64_t>(m_flushPolicy.interval))
+        {
+            return m_flushPolicy.interval - elapsed;
+        }
+        if (m_pending.load(std::memory_order_relaxed) > 0)
+        {
+            flush();
+        }
+        return m_flushPolicy.interval;
+    }
+
+    void OutputAppender::flushOnSignal()
+    {
+        if (m_sink)
+        {
+            m_sink->flushOnSignal();
+        }
+    }
+
     void OutputAppender::start()
     {
         int errors = 0;
@@ -71,18 +131,28 @@ namespace lim_webserver
         if (errors == 0)
         {
             LogAppender::start();
+            // 批量刷新的输出地交由LogFlusher做定时刷新与崩溃前刷新
+            if (!m_flushPolicy.every_record && !m_registered)
+            {
+                m_lastFlush.store(LogFlusher::NowMS(), std::memory_order_relaxed);
+                m_registered = LogFlusher::GetInstance()->add(this);
+            }
         }
     }
 
     void OutputAppender::stop()
     {
-        if (!isStarted())
+        if (m_registered)
         {
-            return;
+            LogFlusher::GetInstance()->del(this);
+            m_registered = false;
         }
+        if (!isStarted())
         {
-            // TODO:关闭流
+            return;
         }
+        // 停止前刷新待刷新数据
+        flush();
         LogAppender::stop();
     }
 
@@ -113,7 +183,14 @@ namespace lim_webserver
     {
         m_append = lad.append;
         m_filename = lad.file;
-        m_sink = FileSink::ptr(new FileSink());
+        if (lad.mmap)
+        {
+            m_sink = MmapFileSink::ptr(new MmapFileSink(MmapFileSink::kDefaultExtentSize, lad.msync));
+        }
+        else
+        {
+            m_sink = FileSink::ptr(new FileSink());
+        }
     }
 
     void FileAppender::start()
@@ -134,6 +211,12 @@ namespace lim_webserver
     {
     }
 
+    RollingFileAppender::RollingFileAppender(const LogAppenderDefine &lad)
+        : FileAppender(lad)
+    {
+        setRollingPolicy(CreateRollingPolicy(lad.rolling));
+    }
+
     void RollingFileAppender::setRollingPolicy(RollingPolicy::ptr rollingPolicy)
     {
         m_rollingPolicy = rollingPolicy;
@@ -158,6 +241,14 @@ namespace lim_webserver
 
     void RollingFileAppender::start()
     {
+        if (m_rollingPolicy == nullptr || m_triggeringPolicy == nullptr)
+        {
+            std::cout << "error: No RollingPolicy or TriggeringPolicy set for the appender named " << m_name << std::endl;
+            return;
+        }
+        m_rollingPolicy->setParent(this);
+        m_rollingPolicy->start();
+        FileAppender::start();
     }
 
     void RollingFileAppender::format(LogStream &logstream, LogMessage::ptr message)
@@ -213,6 +304,7 @@ namespace lim_webserver
         {
             return;
         }
+        m_bytesCounter->inc(len);
         Mutex::Lock lock(m_append_mutex);
         // 若当前缓冲区大小支持写入内容则写入
         if (m_buffer.buffer1->avail() > len)
@@ -254,6 +346,10 @@ namespace lim_webserver
         }
         if (errors == 0)
         {
+            MetricsRegistry *registry = MetricsRegistry::GetInstance();
+            m_bytesCounter = registry->counter("spnet_log_async_bytes_total", "Bytes written to the async appender", {{"appender", m_name}});
+            m_droppedCounter = registry->counter("spnet_log_async_dropped_bytes_total", "Bytes dropped by the async appender when the backlog is too long",
+                                                 {{"appender", m_name}});
             LogAppender::start();
             m_thread = Thread::Create([this]()
                                       { this->run(); },
@@ -283,6 +379,7 @@ namespace lim_webserver
 
     void AsyncAppender::run()
     {
+        CpuAffinity::RegisterHousekeeping();
         // 创建新缓存
         DoubleBuffer newBuffer;
 
@@ -320,10 +417,15 @@ namespace lim_webserver
 
             assert(!newBuffer.buffer_vec.empty());
 
-            // 若内容过多，则可能存在异常，将多余部分删除
-            // TODO: 设计方法提示异常
+            // 若内容过多，则可能存在异常，将多余部分删除并计入丢弃字节数
             if (newBuffer.buffer_vec.size() > 25)
+            {
+                for (size_t i = 2; i < newBuffer.buffer_vec.size(); ++i)
+                {
+                    m_droppedCounter->inc(newBuffer.buffer_vec[i]->length());
+                }
                 newBuffer.buffer_vec.erase(newBuffer.buffer_vec.begin() + 2, newBuffer.buffer_vec.end());
+            }
 
             // 落地
             for (size_t i = 0; i < newBuffer.buffer_vec.size(); ++i)
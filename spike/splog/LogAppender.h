@@ -7,6 +7,7 @@
 
 
 #include <base/Mutex.h>
+#include "base/Metrics.h"
 #include "base/Thread.h"
 #include "base/Singleton.h"
 #include "splog/LogLevel.h"
@@ -14,6 +15,7 @@
 #include "splog/LogFormatter.h"
 #include "splog/RollingPolicy.h"
 #include "splog/LogSink.h"
+#include "splog/FlushPolicy.h"
 
 namespace lim_webserver
 {
@@ -27,12 +29,16 @@ namespace lim_webserver
 
     struct LogAppenderDefine
     {
-        int type = 0; // 1 File, 0 Stdout
+        int type = 0; // 2 RollingFile, 1 File, 0 Stdout
         std::string name;
         std::string file;
         std::string formatter = DEFAULT_PATTERN;
         LogLevel level = LogLevel_UNKNOWN;
         bool append = true;
+        bool mmap = false;                       // 是否使用内存映射落地
+        MsyncPolicy msync = MsyncPolicy::NONE;   // 内存映射的同步策略
+        FlushPolicy flush;                       // 刷新策略
+        RollingPolicyDefine rolling;             // 滚动策略(RollingFileAppender)
 
         bool operator<(const LogAppenderDefine &oth) const
         {
@@ -41,7 +47,7 @@ namespace lim_webserver
 
         bool operator==(const LogAppenderDefine &oth) const
         {
-            return name == oth.name && type == oth.type && file == oth.file && formatter == oth.formatter && level == oth.level && append == oth.append;
+            return name == oth.name && type == oth.type && file == oth.file && formatter == oth.formatter && level == oth.level && append == oth.append && mmap == oth.mmap && msync == oth.msync && flush == oth.flush && rolling == oth.rolling;
         }
 
         bool isValid() const
@@ -64,7 +70,7 @@ namespace lim_webserver
         /**
          * @brief 落地日志接口，将message解包为字符串并进行落地
          */
-        void doAppend(LogMessage::ptr message);
+        virtual void doAppend(LogMessage::ptr message);
 
         virtual int getType() = 0;
 
@@ -104,7 +110,7 @@ namespace lim_webserver
         virtual void append(const char *logline, int len) = 0;
 
         std::string m_name; // 名字
-        bool m_started;     // 启动标志位
+        bool m_started = false; // 启动标志位
     };
 
     class AsyncAppender;
@@ -122,8 +128,43 @@ namespace lim_webserver
         OutputAppender(const LogAppenderDefine &lad);
         ~OutputAppender() { stop(); };
 
+        /**
+         * @brief 格式化后落地，并按刷新策略决定是否刷新
+         */
+        void doAppend(LogMessage::ptr message) override;
+
+        /**
+         * @brief 刷新落地器中的待刷新数据
+         */
         void flush();
 
+        /**
+         * @brief 若按时间刷新已到期则刷新，由LogFlusher后台线程调用
+         *
+         * @param now 当前毫秒级单调时间
+         * @return int 距下次到期的毫秒数，未启用按时间刷新时返回-1
+         */
+        int flushIfDue(uint64_t now);
+
+        /**
+         * @brief 致命信号下尽力而为地刷新，不使用阻塞锁
+         */
+        void flushOnSignal();
+
+        /**
+         * @brief 设置刷新策略，需在start前调用
+         *
+         * @param policy 刷新策略
+         */
+        inline void setFlushPolicy(const FlushPolicy &policy) { m_flushPolicy = policy; }
+
+        /**
+         * @brief 获取刷新策略
+         *
+         * @return const FlushPolicy& 刷新策略
+         */
+        inline const FlushPolicy &getFlushPolicy() const { return m_flushPolicy; }
+
         /**
          * @brief 设置过滤级别
          *
@@ -170,6 +211,10 @@ namespace lim_webserver
         LogFormatter::ptr m_formatter;     // 格式器
         LogSink::ptr m_sink;               // 落地器
         LogStream::Buffer m_buffer;        // 4k缓存
+        FlushPolicy m_flushPolicy;         // 刷新策略
+        std::atomic<size_t> m_pending{0};   // 上次刷新后写入的字节数
+        std::atomic<uint64_t> m_lastFlush{0}; // 上次刷新的时间
+        bool m_registered = false;         // 是否已注册到LogFlusher
     };
 
     /**
@@ -213,6 +258,13 @@ namespace lim_webserver
             return std::dynamic_pointer_cast<FileSink>(m_sink)->open(m_filename.c_str(), m_append);
         }
 
+        /**
+         * @brief 替换文件落地器，需在start前调用
+         *
+         * @param sink 文件落地器
+         */
+        inline void setSink(FileSink::ptr sink) { m_sink = sink; }
+
         /**
          * @brief 设置原始文件名
          *
@@ -251,6 +303,9 @@ namespace lim_webserver
         bool m_append = true;   // 追加模式
     };
 
+    /**
+     * @brief 滚动输出到文件的Appender，滚动出的文件由LogArchiver在后台压缩与清理
+     */
     class RollingFileAppender : public FileAppender
     {
         friend AsyncAppender;
@@ -262,11 +317,16 @@ namespace lim_webserver
     public:
         RollingFileAppender(){};
         RollingFileAppender(const std::string &filename, RollingPolicy::ptr rollingPolicy, TriggeringPolicy::ptr triggeringPolicy);
+        RollingFileAppender(const LogAppenderDefine &lad);
+
+        int getType() override { return 2; }
 
         void setRollingPolicy(RollingPolicy::ptr rollingPolicy);
 
         void setTriggeringPolicy(TriggeringPolicy::ptr triggeringPolicy);
 
+        inline RollingPolicy::ptr getRollingPolicy() const { return m_rollingPolicy; }
+
         void start() override;
 
     private:
@@ -370,6 +430,9 @@ namespace lim_webserver
         Thread::ptr m_thread;           // 工作线程
         Mutex m_append_mutex;           // 后台交换缓存锁
         ConditionVariable m_cond;       // 条件变量
+
+        MetricCounter *m_bytesCounter = nullptr;   // 前端写入的字节数
+        MetricCounter *m_droppedCounter = nullptr; // 后端积压过多时丢弃的字节数
     };
 
     class AppenderFactory : public Singleton<AppenderFactory>
@@ -385,6 +448,13 @@ namespace lim_webserver
             return std::make_shared<FileAppender>();
         }
 
+        static FileAppender::ptr newMmapFileAppender(size_t extentSize = MmapFileSink::kDefaultExtentSize, MsyncPolicy policy = MsyncPolicy::NONE)
+        {
+            FileAppender::ptr appender = std::make_shared<FileAppender>();
+            appender->setSink(std::make_shared<MmapFileSink>(extentSize, policy));
+            return appender;
+        }
+
         static RollingFileAppender::ptr newRollingFileAppender()
         {
             return std::make_shared<RollingFileAppender>();
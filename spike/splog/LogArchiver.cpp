@@ -0,0 +1,298 @@
+#include "LogArchiver.h"
+#include "base/Affinity.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+#include <zlib.h>
+
+namespace lim_webserver
+{
+    // 压缩的分块大小，每块之后让出CPU
+    static const size_t kCompressChunk = 64 * 1024;
+
+    static std::string BaseName(const std::string &path)
+    {
+        size_t slash = path.rfind('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    CompressionType CompressionTypeFromString(const std::string &val)
+    {
+        if (val == "GZIP" || val == "gzip" || val == "gz")
+        {
+            return CompressionType::GZIP;
+        }
+        return CompressionType::NONE;
+    }
+
+    const char *CompressionTypeToString(CompressionType type)
+    {
+        switch (type)
+        {
+        case CompressionType::GZIP:
+            return "GZIP";
+        default:
+            return "NONE";
+        }
+    }
+
+    LogArchiver::LogArchiver()
+        : m_cond(m_mutex), m_idle(m_mutex)
+    {
+    }
+
+    LogArchiver::~LogArchiver()
+    {
+        {
+            Mutex::Lock lock(m_mutex);
+            m_stopping = true;
+            m_cond.notify_one();
+        }
+        if (m_thread)
+        {
+            m_thread->join();
+        }
+    }
+
+    void LogArchiver::submit(const ArchiveTask &task)
+    {
+        Mutex::Lock lock(m_mutex);
+        m_tasks.push_back(task);
+        if (!m_thread)
+        {
+            m_thread = Thread::Create([this]()
+                                      { this->run(); },
+                                      "log_archiver");
+        }
+        m_cond.notify_one();
+    }
+
+    void LogArchiver::wait()
+    {
+        Mutex::Lock lock(m_mutex);
+        m_idle.wait([this]()
+                    { return m_tasks.empty() && !m_busy; });
+    }
+
+    void LogArchiver::run()
+    {
+        // 最低CPU优先级与IDLE级IO优先级，只使用日志线程空闲下来的资源
+        pid_t tid = syscall(SYS_gettid);
+        setpriority(PRIO_PROCESS, tid, 19);
+        const int IOPRIO_WHO_PROCESS = 1, IOPRIO_CLASS_IDLE = 3, IOPRIO_CLASS_SHIFT = 13;
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+        CpuAffinity::RegisterHousekeeping();
+
+        while (true)
+        {
+            ArchiveTask task;
+            {
+                Mutex::Lock lock(m_mutex);
+                // 退出前处理完剩余任务
+                m_cond.wait([this]()
+                            { return m_stopping || !m_tasks.empty(); });
+                if (m_tasks.empty())
+                {
+                    break;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+                m_busy = true;
+            }
+            process(task);
+            {
+                Mutex::Lock lock(m_mutex);
+                m_busy = false;
+                m_idle.notify_all();
+            }
+        }
+    }
+
+    void LogArchiver::process(const ArchiveTask &task)
+    {
+        if (task.compression == CompressionType::GZIP)
+        {
+            size_t in = 0, out = 0;
+            if (Compress(task.file, task.file + ".gz", &in, &out))
+            {
+                m_bytesIn += in;
+                m_bytesOut += out;
+            }
+        }
+        ++m_archived;
+        if (task.max_history > 0 || task.total_size_cap > 0)
+        {
+            applyRetention(task);
+        }
+    }
+
+    bool LogArchiver::Compress(const std::string &src, const std::string &dst, size_t *bytesIn, size_t *bytesOut)
+    {
+        int fd = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            fprintf(stderr, "LogArchiver: open %s failed: %s\n", src.c_str(), strerror(errno));
+            return false;
+        }
+        // 先写临时文件，完成后再改名，避免清理或读者看到残缺的压缩包
+        std::string tmp = dst + ".tmp";
+        gzFile gz = gzopen(tmp.c_str(), "wb6");
+        if (!gz)
+        {
+            fprintf(stderr, "LogArchiver: gzopen %s failed\n", tmp.c_str());
+            ::close(fd);
+            return false;
+        }
+        gzbuffer(gz, kCompressChunk);
+
+        bool ok = true;
+        size_t total = 0;
+        std::vector<char> buf(kCompressChunk);
+        while (true)
+        {
+            ssize_t n = ::read(fd, buf.data(), buf.size());
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n < 0 || (n > 0 && gzwrite(gz, buf.data(), n) != n))
+            {
+                ok = false;
+                break;
+            }
+            if (n == 0)
+            {
+                break;
+            }
+            // 已读过的部分不会再用，及时释放页缓存；每块之后让出CPU，日志线程与压缩共用核心时不被连续占用
+            posix_fadvise(fd, total, n, POSIX_FADV_DONTNEED);
+            total += n;
+            sched_yield();
+        }
+        struct stat srcStat;
+        bool hasStat = fstat(fd, &srcStat) == 0;
+        ::close(fd);
+        if (gzclose(gz) != Z_OK)
+        {
+            ok = false;
+        }
+        // 压缩包沿用原文件的修改时间，清理时按日志内容的新旧排序而不是压缩完成的先后
+        if (ok && hasStat)
+        {
+            struct timespec times[2] = {srcStat.st_atim, srcStat.st_mtim};
+            utimensat(AT_FDCWD, tmp.c_str(), times, 0);
+        }
+        if (!ok || rename(tmp.c_str(), dst.c_str()) != 0)
+        {
+            fprintf(stderr, "LogArchiver: compress %s failed\n", src.c_str());
+            unlink(tmp.c_str());
+            return false;
+        }
+        unlink(src.c_str());
+
+        if (bytesIn)
+        {
+            *bytesIn = total;
+        }
+        if (bytesOut)
+        {
+            struct stat st;
+            *bytesOut = stat(dst.c_str(), &st) == 0 ? st.st_size : 0;
+        }
+        return true;
+    }
+
+    void LogArchiver::applyRetention(const ArchiveTask &task)
+    {
+        if (task.prefix.empty())
+        {
+            return;
+        }
+        DIR *dir = opendir(task.dir.c_str());
+        if (!dir)
+        {
+            return;
+        }
+
+        struct Archive
+        {
+            std::string path;
+            struct timespec mtime;
+            long size;
+        };
+        // 仍在队列中等待压缩的文件不参与清理，否则可能在压缩前被删除
+        std::unordered_set<std::string> pending;
+        {
+            Mutex::Lock lock(m_mutex);
+            for (auto &queued : m_tasks)
+            {
+                if (queued.dir == task.dir)
+                {
+                    pending.insert(BaseName(queued.file));
+                }
+            }
+        }
+
+        std::vector<Archive> archives;
+        while (struct dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name.compare(0, task.prefix.size(), task.prefix) != 0)
+            {
+                continue;
+            }
+            // 跳过正在压缩的临时文件
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0)
+            {
+                continue;
+            }
+            if (pending.count(name))
+            {
+                continue;
+            }
+            std::string path = task.dir + "/" + name;
+            struct stat st;
+            if (path == task.active || stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                continue;
+            }
+            archives.push_back({path, st.st_mtim, st.st_size});
+        }
+        closedir(dir);
+
+        // 新的在前，同一秒内滚动多次时依赖纳秒精度区分
+        std::sort(archives.begin(), archives.end(), [](const Archive &a, const Archive &b)
+                  {
+                      if (a.mtime.tv_sec != b.mtime.tv_sec)
+                      {
+                          return a.mtime.tv_sec > b.mtime.tv_sec;
+                      }
+                      return a.mtime.tv_nsec > b.mtime.tv_nsec; });
+
+        long total = 0;
+        for (size_t i = 0; i < archives.size(); ++i)
+        {
+            total += archives[i].size;
+            bool overCount = task.max_history > 0 && i >= static_cast<size_t>(task.max_history);
+            bool overSize = task.total_size_cap > 0 && total > task.total_size_cap;
+            if (overCount || overSize)
+            {
+                if (unlink(archives[i].path.c_str()) == 0)
+                {
+                    ++m_removed;
+                }
+            }
+        }
+    }
+
+} // namespace lim_webserver
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <string>
+
+#include "base/Mutex.h"
+#include "base/Singleton.h"
+#include "base/Thread.h"
+
+namespace lim_webserver
+{
+    /**
+     * NONE:  不压缩
+     * GZIP:  使用zlib压缩为.gz
+     */
+    enum class CompressionType
+    {
+        NONE, // 不压缩
+        GZIP  // gzip
+    };
+
+    /**
+     * @brief 将文本表示的压缩方式转换为枚举值，无法识别时返回NONE
+     */
+    CompressionType CompressionTypeFromString(const std::string &val);
+
+    /**
+     * @brief 将压缩方式转换为文本表示
+     */
+    const char *CompressionTypeToString(CompressionType type);
+
+    /**
+     * @brief 归档任务
+     */
+    struct ArchiveTask
+    {
+        std::string file;                                     // 待归档的文件
+        CompressionType compression = CompressionType::NONE;  // 压缩方式
+        std::string dir;                                      // 归档目录
+        std::string prefix;                                   // 归档文件名前缀，用于清理时识别同一输出地的归档
+        std::string active;                                   // 当前活动文件，清理时跳过
+        int max_history = 0;                                  // 最多保留的归档数，0为不限
+        long total_size_cap = 0;                              // 归档总大小上限，0为不限
+    };
+
+    /**
+     * @brief 日志归档器
+     *
+     * @details 单个后台线程按提交顺序压缩滚动出的文件并执行保留策略。线程以最低CPU优先级(nice 19)
+     *          与IDLE级IO优先级运行，按64KB分块压缩并在块间让出CPU、释放源文件的页缓存，
+     *          压缩不会在日志线程上进行，也尽量不与日志线程争抢资源。
+     *          清理时跳过仍在队列中等待压缩的文件。
+     */
+    class LogArchiver : public Singleton<LogArchiver>
+    {
+        friend Singleton<LogArchiver>;
+
+    public:
+        /**
+         * @brief 提交归档任务，首次提交时启动后台线程
+         */
+        void submit(const ArchiveTask &task);
+
+        /**
+         * @brief 阻塞直至已提交的任务全部完成
+         */
+        void wait();
+
+        inline size_t getArchivedCount() const { return m_archived; }
+        inline size_t getRemovedCount() const { return m_removed; }
+        inline size_t getBytesIn() const { return m_bytesIn; }
+        inline size_t getBytesOut() const { return m_bytesOut; }
+
+        /**
+         * @brief 将src压缩为dst，成功后删除src
+         *
+         * @return true 成功
+         * @return false 失败，src保留
+         */
+        static bool Compress(const std::string &src, const std::string &dst, size_t *bytesIn = nullptr, size_t *bytesOut = nullptr);
+
+    private:
+        LogArchiver();
+        ~LogArchiver();
+
+        void run();
+
+        void process(const ArchiveTask &task);
+
+        /**
+         * @brief 按数量与总大小清理最旧的归档，跳过仍在队列中的文件
+         */
+        void applyRetention(const ArchiveTask &task);
+
+    private:
+        std::deque<ArchiveTask> m_tasks;      // 任务队列
+        bool m_busy = false;                  // 是否正在处理任务
+        bool m_stopping = false;              // 停止标志位
+        Thread::ptr m_thread;                 // 后台线程
+        Mutex m_mutex;                        // 队列锁
+        ConditionVariable m_cond;             // 任务到达
+        ConditionVariable m_idle;             // 任务全部完成
+        std::atomic<size_t> m_archived{0};    // 已归档文件数
+        std::atomic<size_t> m_removed{0};     // 因保留策略删除的文件数
+        std::atomic<size_t> m_bytesIn{0};     // 压缩前字节数
+        std::atomic<size_t> m_bytesOut{0};    // 压缩后字节数
+    };
+
+} // namespace lim_webserver
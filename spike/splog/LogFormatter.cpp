@@ -82,9 +82,21 @@ namespace lim_webserver
             : m_format(format) {}
         void format(LogStream &stream, LogMessage::ptr event) override
         {
+            // 每个线程缓存最近一秒的时间字符串，同一秒内的日志不加锁也不拷贝std::string
+            static thread_local time_t t_last_second = -1;
+            static thread_local char t_time[32];
+            static thread_local int t_length = 0;
             time_t time_l = event->getTime(); // 获取时间
-            std::string buf = TimeManager::GetInstance()->getTimeString(time_l);
-            stream << buf;
+            if (time_l != t_last_second)
+            {
+                struct tm tm_time;
+                localtime_r(&time_l, &tm_time);
+                t_length = snprintf(t_time, sizeof(t_time), "%4d-%02d-%02d %02d:%02d:%02d",
+                                    tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+                                    tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
+                t_last_second = time_l;
+            }
+            stream.append(t_time, t_length);
         }
 
     private:
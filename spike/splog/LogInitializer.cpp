@@ -32,9 +32,12 @@ namespace lim_webserver
                         // TODO：
                         ++it2;
                     }
-                    else // 共有的部分，改动配置
+                    else // 共有的部分，仅在配置有改动时重建
                     {
-                        logManager->createOrUpdateAppender(*it1);
+                        if (!(*it1 == *it2))
+                        {
+                            logManager->createOrUpdateAppender(*it1);
+                        }
                         ++it1;
                         ++it2;
                     }
@@ -63,14 +66,17 @@ namespace lim_webserver
                         ++it3;
                     }
                     // 旧的比新的小，表示旧的有新的没有，为删除
-                    if (*it4 < *it3) 
+                    else if (*it4 < *it3)
                     {
                         logManager->delLogger(it4->name);
                         ++it4;
                     }
-                    else // 共有的部分，改动配置
+                    else // 共有的部分，仅在配置有改动时更新
                     {
-                        logManager->createOrUpdateLogger(*it3);
+                        if (*it3 != *it4)
+                        {
+                            logManager->createOrUpdateLogger(*it3);
+                        }
                         ++it3;
                         ++it4;
                     }
@@ -24,6 +24,79 @@ namespace lim_webserver
     template <>
     class LexicalCast<std::string, LogConfigerDefine>
     {
+    private:
+        /**
+         * @brief 解析刷新策略，缺省或为record时每条刷新，为映射时进入批量模式
+         */
+        static FlushPolicy ParseFlushPolicy(const YAML::Node &node)
+        {
+            FlushPolicy policy;
+            if (!node.IsMap())
+            {
+                return policy;
+            }
+            policy.every_record = false;
+            if (node["bytes"].IsDefined())
+            {
+                policy.bytes = node["bytes"].as<size_t>();
+            }
+            if (node["interval"].IsDefined())
+            {
+                policy.interval = node["interval"].as<int>();
+            }
+            if (node["level"].IsDefined())
+            {
+                LogLevel level = LogLevelHandler::FromString(node["level"].as<std::string>());
+                // 无法识别的级别保留默认值，避免退化为每条刷新
+                if (level != LogLevel_UNKNOWN)
+                {
+                    policy.level = level;
+                }
+            }
+            return policy;
+        }
+
+        /**
+         * @brief 解析滚动策略
+         */
+        static RollingPolicyDefine ParseRollingPolicy(const YAML::Node &node)
+        {
+            RollingPolicyDefine rpd;
+            if (!node.IsMap())
+            {
+                return rpd;
+            }
+            if (node["policy"].IsDefined())
+            {
+                rpd.policy = node["policy"].as<std::string>();
+            }
+            if (node["pattern"].IsDefined())
+            {
+                rpd.pattern = node["pattern"].as<std::string>();
+            }
+            if (node["period"].IsDefined())
+            {
+                rpd.period = node["period"].as<long>();
+            }
+            if (node["max_file_size"].IsDefined())
+            {
+                rpd.max_file_size = node["max_file_size"].as<long>();
+            }
+            if (node["compression"].IsDefined())
+            {
+                rpd.compression = CompressionTypeFromString(node["compression"].as<std::string>());
+            }
+            if (node["max_history"].IsDefined())
+            {
+                rpd.max_history = node["max_history"].as<int>();
+            }
+            if (node["total_size_cap"].IsDefined())
+            {
+                rpd.total_size_cap = node["total_size_cap"].as<long>();
+            }
+            return rpd;
+        }
+
     public:
         LogConfigerDefine operator()(const std::string &v)
         {
@@ -40,9 +113,13 @@ namespace lim_webserver
                     }
                     std::string type = appenderNode["type"].as<std::string>();
                     LogAppenderDefine lad;
-                    if (type == "1") // FileAppender
+                    if (type == "1" || type == "2") // FileAppender, RollingFileAppender
                     {
-                        lad.type = 1;
+                        lad.type = type == "1" ? 1 : 2;
+                        if (lad.type == 2 && appenderNode["rolling"].IsDefined())
+                        {
+                            lad.rolling = ParseRollingPolicy(appenderNode["rolling"]);
+                        }
                         if (!appenderNode["file"].IsDefined())
                         {
                             std::cout << "log config error: fileappender file is null, " << appenderNode << std::endl;
@@ -57,6 +134,14 @@ namespace lim_webserver
                         {
                             lad.append = appenderNode["append"].as<bool>();
                         }
+                        if (appenderNode["mmap"].IsDefined())
+                        {
+                            lad.mmap = appenderNode["mmap"].as<bool>();
+                        }
+                        if (appenderNode["msync"].IsDefined())
+                        {
+                            lad.msync = MsyncPolicyFromString(appenderNode["msync"].as<std::string>());
+                        }
                         if (appenderNode["level"].IsDefined())
                         {
                             lad.level = LogLevelHandler::FromString(appenderNode["level"].as<std::string>());
@@ -65,6 +150,10 @@ namespace lim_webserver
                         {
                             lad.formatter = appenderNode["formatter"].as<std::string>();
                         }
+                        if (appenderNode["flush"].IsDefined())
+                        {
+                            lad.flush = ParseFlushPolicy(appenderNode["flush"]);
+                        }
                     }
                     else if (type == "0")
                     {
@@ -81,6 +170,10 @@ namespace lim_webserver
                         {
                             lad.formatter = appenderNode["formatter"].as<std::string>();
                         }
+                        if (appenderNode["flush"].IsDefined())
+                        {
+                            lad.flush = ParseFlushPolicy(appenderNode["flush"]);
+                        }
                     }
                     else
                     {
@@ -107,6 +200,12 @@ namespace lim_webserver
                     {
                         ld.appender_refs = logNode["appender-ref"].as<std::vector<std::string>>();
                     }
+                    if (logNode["rate_limit"].IsDefined())
+                    {
+                        YAML::Node limitNode = logNode["rate_limit"];
+                        ld.rate = limitNode["rate"].IsDefined() ? limitNode["rate"].as<long>() : 0;
+                        ld.burst = limitNode["burst"].IsDefined() ? limitNode["burst"].as<long>() : 0;
+                    }
 
                     lcd.loggers.push_back(ld);
                 }
@@ -125,11 +224,31 @@ namespace lim_webserver
             for (auto &lad : lcd.appenders)
             {
                 YAML::Node appenderNode;
-                if (lad.type == 1)
+                if (lad.type == 1 || lad.type == 2)
                 {
-                    appenderNode["type"] = "FileAppender";
+                    appenderNode["type"] = lad.type == 1 ? "FileAppender" : "RollingFileAppender";
                     appenderNode["file"] = lad.file;
                     appenderNode["append"] = lad.append;
+                    if (lad.mmap)
+                    {
+                        appenderNode["mmap"] = true;
+                        appenderNode["msync"] = MsyncPolicyToString(lad.msync);
+                    }
+                    if (lad.type == 2)
+                    {
+                        YAML::Node rollingNode;
+                        rollingNode["policy"] = lad.rolling.policy;
+                        if (!lad.rolling.pattern.empty())
+                        {
+                            rollingNode["pattern"] = lad.rolling.pattern;
+                        }
+                        rollingNode["period"] = lad.rolling.period;
+                        rollingNode["max_file_size"] = lad.rolling.max_file_size;
+                        rollingNode["compression"] = CompressionTypeToString(lad.rolling.compression);
+                        rollingNode["max_history"] = lad.rolling.max_history;
+                        rollingNode["total_size_cap"] = lad.rolling.total_size_cap;
+                        appenderNode["rolling"] = rollingNode;
+                    }
                 }
                 else if (lad.type == 0)
                 {
@@ -148,6 +267,12 @@ namespace lim_webserver
                 {
                     appenderNode["name"] = lad.name;
                 }
+                if (!lad.flush.every_record)
+                {
+                    appenderNode["flush"]["bytes"] = lad.flush.bytes;
+                    appenderNode["flush"]["interval"] = lad.flush.interval;
+                    appenderNode["flush"]["level"] = LogLevelHandler::ToString(lad.flush.level);
+                }
 
                 logConfigerNode["appenders"].push_back(appenderNode);
             }
@@ -166,6 +291,11 @@ namespace lim_webserver
                         logNode["appender-ref"].push_back(appender_ref);
                     }
                 }
+                if (ld.rate > 0)
+                {
+                    logNode["rate_limit"]["rate"] = ld.rate;
+                    logNode["rate_limit"]["burst"] = ld.burst;
+                }
                 logConfigerNode["loggers"].push_back(logNode);
             }
 
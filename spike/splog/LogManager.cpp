@@ -7,6 +7,12 @@ namespace lim_webserver
         init();
     }
 
+    LogManager::~LogManager()
+    {
+        // 日志器析构前输出最后一段被抑制的条数
+        LogSuppression::Stop();
+    }
+
     Logger::ptr LogManager::getLogger(const std::string &name)
     {
         MutexType::Lock lock(m_mutex);
@@ -76,6 +82,7 @@ namespace lim_webserver
     {
         logger->setName(ld.name);
         logger->setLevel(ld.level);
+        logger->setRateLimit(ld.rate, ld.burst);
         logger->clearAppender();
         for (auto appender_name : ld.appender_refs)
         {
@@ -151,6 +158,10 @@ namespace lim_webserver
             }
             appender = FileAppender::ptr(new FileAppender(lad));
         }
+        else if (lad.type == 2)
+        {
+            appender = RollingFileAppender::ptr(new RollingFileAppender(lad));
+        }
         else
         {
             appender = nullptr;
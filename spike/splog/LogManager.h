@@ -15,11 +15,20 @@ namespace lim_webserver
         LogMessageWrap(LogMessage::ptr e)
             : m_message(e) {}
         /**
-         * @brief 析构时输出日志
+         * @brief 从线程局部对象池中取出日志事件
+         */
+        LogMessageWrap(Logger *logger, FileName file, int32_t line, uint64_t time, LogLevel level)
+            : m_message(LogMessage::Acquire(logger, file, line, time, level)), m_pooled(true) {}
+        /**
+         * @brief 析构时输出日志，并归还池化的日志事件
          */
         ~LogMessageWrap()
         {
             m_message->getLogger()->log(m_message);
+            if (m_pooled)
+            {
+                LogMessage::Release(m_message.get());
+            }
         }
 
         /**
@@ -33,6 +42,7 @@ namespace lim_webserver
 
     private:
         LogMessage::ptr m_message; // 事件
+        bool m_pooled = false;     // 是否来自对象池
     };
 
     class LogManager:public Singleton<LogManager>
@@ -43,6 +53,7 @@ namespace lim_webserver
 
     public:
         LogManager();
+        ~LogManager();
         /**
          * @brief 使用指定名称日志器，若不存在，则创建默认格式的该名日志器
          */
@@ -0,0 +1,75 @@
+#include "LogMessage.h"
+#include "Logger.h"
+
+#include <vector>
+
+namespace lim_webserver
+{
+    /**
+     * @brief 线程局部的日志事件对象池
+     *
+     * @details 同一线程内嵌套打日志(如在<<中调用的函数又打了日志)时会同时借出多个对象，
+     *          协程迁移线程后归还到的是当前线程的池，因此池设置上限，超出部分直接释放。
+     */
+    class LogMessagePool
+    {
+    public:
+        static const size_t kMaxIdle = 16;
+
+        LogMessagePool() { m_idle.reserve(kMaxIdle); }
+
+        ~LogMessagePool()
+        {
+            for (auto message : m_idle)
+            {
+                delete message;
+            }
+        }
+
+        LogMessage *get(Logger *logger, FileName file, int32_t line, uint64_t time, LogLevel level)
+        {
+            if (m_idle.empty())
+            {
+                return new LogMessage(logger, file, line, time, level);
+            }
+            LogMessage *message = m_idle.back();
+            m_idle.pop_back();
+            message->reset(logger, file, line, time, level);
+            return message;
+        }
+
+        void put(LogMessage *message)
+        {
+            if (m_idle.size() < kMaxIdle)
+            {
+                m_idle.push_back(message);
+            }
+            else
+            {
+                delete message;
+            }
+        }
+
+    private:
+        std::vector<LogMessage *> m_idle; // 空闲对象
+    };
+
+    static thread_local LogMessagePool t_message_pool;
+
+    LogMessage::ptr LogMessage::Acquire(Logger *logger, FileName file, int32_t line, uint64_t time, LogLevel level)
+    {
+        // 别名构造：不持有所有权，也不分配控制块
+        return ptr(ptr(), t_message_pool.get(logger, file, line, time, level));
+    }
+
+    void LogMessage::Release(LogMessage *message)
+    {
+        t_message_pool.put(message);
+    }
+
+    const std::string &LogMessage::getName() const
+    {
+        return m_logger->getName();
+    }
+
+} // namespace lim_webserver
@@ -11,6 +11,9 @@ namespace lim_webserver
     class Logger;
     /**
      * @brief 日志消息类
+     *
+     * @details 热路径上的消息由线程局部的对象池提供(Acquire/Release)，稳态下不产生堆分配；
+     *          消息只引用日志器及其名称，不做拷贝，因此不可在日志语句结束后继续持有。
      */
     class LogMessage
     {
@@ -25,11 +28,23 @@ namespace lim_webserver
          * @param time          时间戳
          * @param level         日志级别，默认为DEBUG级别
          */
-        static ptr Create(std::shared_ptr<Logger> logger, FileName file, int32_t line, uint64_t time, LogLevel level, std::string name)
+        static ptr Create(Logger *logger, FileName file, int32_t line, uint64_t time, LogLevel level)
         {
-            return std::make_shared<LogMessage>(logger, file, line, time, level, name);
+            return std::make_shared<LogMessage>(logger, file, line, time, level);
         }
 
+        /**
+         * @brief 从线程局部对象池中取出一个日志事件
+         *
+         * @details 返回的智能指针不持有所有权(不分配控制块，拷贝也没有原子操作)，须与Release配对使用
+         */
+        static ptr Acquire(Logger *logger, FileName file, int32_t line, uint64_t time, LogLevel level);
+
+        /**
+         * @brief 将日志事件归还至当前线程的对象池
+         */
+        static void Release(LogMessage *message);
+
     public:
         /**
          * @brief 构造函数，用于创建日志事件对象
@@ -40,8 +55,21 @@ namespace lim_webserver
          * @param time          时间戳
          * @param level         日志级别，默认为DEBUG级别
          */
-        LogMessage(std::shared_ptr<Logger> logger, FileName file, int32_t line, uint64_t time, LogLevel level, std::string name)
-            : m_logger(logger), m_file(file), m_line(line), m_time(time), m_level(level), m_name(name) {}
+        LogMessage(Logger *logger, FileName file, int32_t line, uint64_t time, LogLevel level)
+            : m_logger(logger), m_file(file), m_line(line), m_time(time), m_level(level) {}
+
+        /**
+         * @brief 重置日志事件以便复用
+         */
+        void reset(Logger *logger, FileName file, int32_t line, uint64_t time, LogLevel level)
+        {
+            m_logger = logger;
+            m_file = file;
+            m_line = line;
+            m_time = time;
+            m_level = level;
+            m_logStream.resetBuffer();
+        }
 
         /**
          * @brief 获取文件路径。
@@ -70,9 +98,9 @@ namespace lim_webserver
         /**
          * @brief 获取日志事件的级别字符串。
          *
-         * @return std::string 事件级别字符串。
+         * @return const char* 事件级别字符串。
          */
-        std::string getLevelString() const { return LogLevelHandler::ToString(m_level); }
+        const char *getLevelString() const { return LogLevelHandler::ToString(m_level); }
         /**
          * @brief 获取用于向日志事件内容中追加文本的内容流。
          *
@@ -82,19 +110,21 @@ namespace lim_webserver
         /**
          * @brief 获取与该日志事件关联的日志器。
          *
-         * @return std::shared_ptr<Logger> 日志器的智能指针。
+         * @return Logger* 日志器指针。
          */
-        std::shared_ptr<Logger> getLogger() const { return m_logger; }
+        Logger *getLogger() const { return m_logger; }
 
-        const std::string &getName() const { return m_name; }
+        /**
+         * @brief 获取日志器名称，直接引用日志器中的名称
+         */
+        const std::string &getName() const;
 
     private:
+        Logger *m_logger;                 // 日志器
         FileName m_file;                  // 文件名
-        LogLevel m_level;                 // 级别
         uint32_t m_line = 0;              // 行号
         uint64_t m_time;                  // 时间戳
-        std::shared_ptr<Logger> m_logger; // 日志器
-        std::string m_name;               // 日志名称
+        LogLevel m_level;                 // 级别
         LogStream m_logStream;            // 内容流
     };
 } // namespace lim_webserver
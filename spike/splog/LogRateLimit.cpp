@@ -0,0 +1,224 @@
+#include "LogRateLimit.h"
+#include "Logger.h"
+#include "FlushPolicy.h"
+#include "LogManager.h"
+
+#include <algorithm>
+#include <time.h>
+#include <vector>
+
+namespace lim_webserver
+{
+    static uint64_t NowNS()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000ul + ts.tv_nsec;
+    }
+
+    void TokenBucket::setRate(long rate, long burst)
+    {
+        if (rate <= 0)
+        {
+            m_interval.store(0, std::memory_order_relaxed);
+            return;
+        }
+        uint64_t interval = 1000000000ul / rate;
+        burst = burst > 0 ? burst : rate;
+        m_window.store(interval * (burst - 1), std::memory_order_relaxed);
+        m_tat.store(0, std::memory_order_relaxed);
+        m_interval.store(std::max<uint64_t>(interval, 1), std::memory_order_relaxed);
+    }
+
+    bool TokenBucket::consume()
+    {
+        uint64_t interval = m_interval.load(std::memory_order_relaxed);
+        if (interval == 0)
+        {
+            return true;
+        }
+        uint64_t window = m_window.load(std::memory_order_relaxed);
+        uint64_t now = NowNS();
+        uint64_t tat = m_tat.load(std::memory_order_relaxed);
+        while (true)
+        {
+            uint64_t base = std::max(tat, now);
+            // 理论到达时间超前当前时间超过突发窗口，说明令牌已耗尽
+            if (base - now > window)
+            {
+                return false;
+            }
+            if (m_tat.compare_exchange_weak(tat, base + interval, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+    }
+
+    bool LogSite::everyN(uint64_t n, LogGate &gate, const char *file, int line)
+    {
+        uint64_t count = m_count.fetch_add(1, std::memory_order_relaxed);
+        if (n <= 1 || count % n == 0)
+        {
+            return pass(gate);
+        }
+        return suppress(gate, file, line);
+    }
+
+    bool LogSite::firstN(uint64_t n, LogGate &gate, const char *file, int line)
+    {
+        // 超过n后不再累加调用次数，只记抑制条数
+        if (m_count.load(std::memory_order_relaxed) < n && m_count.fetch_add(1, std::memory_order_relaxed) < n)
+        {
+            return pass(gate);
+        }
+        return suppress(gate, file, line);
+    }
+
+    bool LogSite::everyMS(uint64_t ms, LogGate &gate, const char *file, int line)
+    {
+        uint64_t now = LogFlusher::NowMS();
+        uint64_t last = m_last.load(std::memory_order_relaxed);
+        if ((last == 0 || now - last >= ms) && m_last.compare_exchange_strong(last, now, std::memory_order_relaxed))
+        {
+            return pass(gate);
+        }
+        return suppress(gate, file, line);
+    }
+
+    bool LogSite::pass(LogGate &gate)
+    {
+        // 先读再交换，无抑制时不产生写操作
+        if (m_suppressed.load(std::memory_order_relaxed) > 0)
+        {
+            gate.suppressed() += m_suppressed.exchange(0, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool LogSite::suppress(LogGate &gate, const char *file, int line)
+    {
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        if (!m_registered.load(std::memory_order_relaxed))
+        {
+            bool expected = false;
+            if (m_registered.compare_exchange_strong(expected, true))
+            {
+                LogSuppression::AddSite(this, gate.getLogger(), gate.getLevel(), file, line);
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 汇总的登记表，进程退出时不析构，静态对象析构期间仍可安全访问
+     *
+     * @details 调用点以无锁链表登记，日志器写入途中首次抑制也不会与正在汇总的线程争锁；
+     *          mutex保护日志器列表，并保证日志器不会在汇总途中被销毁。
+     */
+    struct SuppressionRegistry
+    {
+        Mutex mutex;
+        std::atomic<LogSite *> sites{nullptr};
+        std::vector<Logger *> loggers;
+        bool stopped = false;
+    };
+
+    static SuppressionRegistry *GetRegistry()
+    {
+        static SuppressionRegistry *s_registry = new SuppressionRegistry;
+        return s_registry;
+    }
+
+    void LogSuppression::AddSite(LogSite *site, Logger *logger, LogLevel level, const char *file, int line)
+    {
+        SuppressionRegistry *registry = GetRegistry();
+        site->m_level = level;
+        site->m_file = file;
+        site->m_line = line;
+        site->m_logger.store(logger, std::memory_order_relaxed);
+        LogSite *head = registry->sites.load(std::memory_order_relaxed);
+        do
+        {
+            site->m_next = head;
+        } while (!registry->sites.compare_exchange_weak(head, site, std::memory_order_release, std::memory_order_relaxed));
+        LogFlusher::GetInstance()->startReporting();
+    }
+
+    void LogSuppression::AddLogger(Logger *logger)
+    {
+        SuppressionRegistry *registry = GetRegistry();
+        {
+            Mutex::Lock lock(registry->mutex);
+            if (std::find(registry->loggers.begin(), registry->loggers.end(), logger) != registry->loggers.end())
+            {
+                return;
+            }
+            registry->loggers.push_back(logger);
+        }
+        LogFlusher::GetInstance()->startReporting();
+    }
+
+    void LogSuppression::DelLogger(Logger *logger)
+    {
+        SuppressionRegistry *registry = GetRegistry();
+        Mutex::Lock lock(registry->mutex);
+        auto it = std::find(registry->loggers.begin(), registry->loggers.end(), logger);
+        if (it != registry->loggers.end())
+        {
+            registry->loggers.erase(it);
+        }
+        for (LogSite *site = registry->sites.load(std::memory_order_acquire); site; site = site->m_next)
+        {
+            Logger *expected = logger;
+            site->m_logger.compare_exchange_strong(expected, nullptr);
+        }
+    }
+
+    void LogSuppression::Report()
+    {
+        SuppressionRegistry *registry = GetRegistry();
+        Mutex::Lock lock(registry->mutex);
+        if (registry->stopped)
+        {
+            return;
+        }
+        for (LogSite *site = registry->sites.load(std::memory_order_acquire); site; site = site->m_next)
+        {
+            Logger *logger = site->m_logger.load(std::memory_order_relaxed);
+            if (!logger || site->m_suppressed.load(std::memory_order_relaxed) == 0)
+            {
+                continue;
+            }
+            uint64_t suppressed = site->m_suppressed.exchange(0, std::memory_order_relaxed);
+            if (suppressed > 0)
+            {
+                LogMessageWrap(logger, FileName(site->m_file), site->m_line, time(0), site->m_level).getStream()
+                    << "[suppressed " << suppressed << " messages]";
+            }
+        }
+        for (Logger *logger : registry->loggers)
+        {
+            logger->reportSuppressed();
+        }
+    }
+
+    void LogSuppression::Stop()
+    {
+        Report();
+        SuppressionRegistry *registry = GetRegistry();
+        Mutex::Lock lock(registry->mutex);
+        registry->stopped = true;
+    }
+
+    LogGate::LogGate(Logger *logger, LogLevel level)
+        : m_logger(logger), m_level(level), m_open(level >= logger->getLevel())
+    {
+    }
+
+    bool LogGate::admit()
+    {
+        return m_logger->admit(m_suppressed);
+    }
+
+} // namespace lim_webserver
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+#include "splog/LogLevel.h"
+#include "splog/LogStream.h"
+
+namespace lim_webserver
+{
+    /**
+     * @brief 令牌桶限流器(GCRA实现)
+     *
+     * @details 只用一个原子变量记录理论到达时间，放行时CAS推进，无锁且不需要后台补充令牌。
+     *          rate为每秒放行数，burst为允许的突发数，rate为0时不限流。
+     */
+    class TokenBucket
+    {
+    public:
+        /**
+         * @brief 设置速率与突发数
+         *
+         * @param rate  每秒放行数，0为不限流
+         * @param burst 允许的突发数，0时取rate
+         */
+        void setRate(long rate, long burst);
+
+        inline bool isEnabled() const { return m_interval.load(std::memory_order_relaxed) > 0; }
+
+        /**
+         * @brief 尝试取一个令牌
+         */
+        bool consume();
+
+    private:
+        std::atomic<uint64_t> m_interval{0}; // 相邻两次放行的间隔，单位：纳秒
+        std::atomic<uint64_t> m_window{0};   // 突发允许提前的时间，单位：纳秒
+        std::atomic<uint64_t> m_tat{0};      // 理论到达时间
+    };
+
+    class Logger;
+    class LogGate;
+
+    /**
+     * @brief 日志调用点的采样状态，每个LOG_EVERY_N/LOG_FIRST_N/LOG_EVERY_MS展开处一个静态实例
+     *
+     * @details 被拦下的调用计入抑制条数，放行时作为摘要写在消息开头；
+     *          调用点首次抑制时登记到LogSuppression，由后台定期输出尚未报告的条数。
+     */
+    class LogSite
+    {
+        friend class LogSuppression;
+
+    public:
+        /**
+         * @brief 第1、n+1、2n+1...次调用时放行
+         */
+        bool everyN(uint64_t n, LogGate &gate, const char *file, int line);
+
+        /**
+         * @brief 前n次调用放行
+         */
+        bool firstN(uint64_t n, LogGate &gate, const char *file, int line);
+
+        /**
+         * @brief 每ms毫秒至多放行一次
+         */
+        bool everyMS(uint64_t ms, LogGate &gate, const char *file, int line);
+
+    private:
+        /**
+         * @brief 放行，把上次放行后被抑制的条数交给gate
+         */
+        bool pass(LogGate &gate);
+
+        /**
+         * @brief 拦下，首次拦下时登记调用点
+         */
+        bool suppress(LogGate &gate, const char *file, int line);
+
+    private:
+        std::atomic<uint64_t> m_count{0};      // 调用次数
+        std::atomic<uint64_t> m_last{0};       // 上次放行的时间
+        std::atomic<uint64_t> m_suppressed{0}; // 尚未报告的被抑制条数
+        std::atomic<bool> m_registered{false}; // 是否已登记
+        std::atomic<Logger *> m_logger{nullptr}; // 登记时的日志器，日志器销毁后置空
+        LogLevel m_level = LogLevel_UNKNOWN;   // 登记时的级别
+        const char *m_file = nullptr;          // 调用点所在文件
+        int m_line = 0;                        // 调用点所在行
+        LogSite *m_next = nullptr;             // 登记链表中的下一个调用点
+    };
+
+    /**
+     * @brief 被抑制日志的汇总
+     *
+     * @details 限流的日志器与抑制过日志的调用点在此登记，LogFlusher后台线程每隔kReportInterval毫秒
+     *          输出一次尚未报告的条数，日志系统析构时再输出一次，日志流停止后最后一段抑制也不会丢失。
+     *          汇总直接写入日志器，不经过级别之外的采样与限流。
+     */
+    class LogSuppression
+    {
+    public:
+        static const int kReportInterval = 1000;
+
+        static void AddSite(LogSite *site, Logger *logger, LogLevel level, const char *file, int line);
+
+        static void AddLogger(Logger *logger);
+
+        /**
+         * @brief 日志器销毁时注销，同时清除调用点对它的引用
+         */
+        static void DelLogger(Logger *logger);
+
+        /**
+         * @brief 输出全部尚未报告的抑制条数
+         */
+        static void Report();
+
+        /**
+         * @brief 最后输出一次并停止汇总，日志系统析构时调用
+         */
+        static void Stop();
+    };
+
+    /**
+     * @brief 日志语句的入口判断
+     *
+     * @details 在构造日志事件与执行<<之前依次判断级别、调用点采样与日志器令牌桶，
+     *          被拦下的语句不会求值右侧表达式。放行时把被抑制的条数作为摘要写在消息开头。
+     *          只保存日志器的裸指针，日志器需长于日志语句存活(由LogManager或静态变量持有)。
+     */
+    class LogGate
+    {
+    public:
+        LogGate(Logger *logger, LogLevel level);
+
+        inline LogLevel getLevel() const { return m_level; }
+
+        inline bool isOpen() const { return m_open; }
+
+        /**
+         * @brief 日志器级别的令牌桶判断
+         */
+        bool admit();
+
+        inline void close() { m_open = false; }
+
+        inline Logger *getLogger() const { return m_logger; }
+
+        inline uint64_t &suppressed() { return m_suppressed; }
+
+    private:
+        Logger *m_logger;         // 日志器
+        LogLevel m_level;         // 日志级别
+        uint64_t m_suppressed = 0; // 被抑制的条数
+        bool m_open;              // 是否放行
+    };
+
+    /**
+     * @brief 输出抑制摘要
+     */
+    inline LogStream &operator<<(LogStream &stream, LogGate &gate)
+    {
+        if (gate.suppressed() > 0)
+        {
+            stream << "[suppressed " << gate.suppressed() << " messages] ";
+        }
+        return stream;
+    }
+
+} // namespace lim_webserver
@@ -1,9 +1,18 @@
 #include "LogSink.h"
 
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio_ext.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace lim_webserver
 {
     void LogSink::append(const char *logline, const size_t len)
-    {   
+    {
         MutexType::Lock lock(m_mutex);
         size_t n = write(logline, len);
         size_t remain = len - n;
@@ -12,12 +21,12 @@ namespace lim_webserver
             size_t x = write(logline + n, remain);
             if (x == 0)
             {
-                int err = ferror(m_ptr);
+                int err = m_ptr ? ferror(m_ptr) : 1;
                 if (err)
                     fprintf(stderr, "AppendFile::append() failed\n");
                 break;
             }
-            x += x;
+            n += x;
             remain = len - n;
         }
     }
@@ -27,9 +36,60 @@ namespace lim_webserver
         return fwrite_unlocked(logline, 1, len, m_ptr);
     }
 
+    void LogSink::doFlush()
+    {
+        if (m_ptr)
+        {
+            fflush_unlocked(m_ptr);
+        }
+    }
+
+    /**
+     * @brief 以write(2)写出stdio缓冲中待写的数据，缓冲由setbuffer指定为buffer，待写数据从其起始处开始
+     */
+    static void WritePending(FILE *ptr, int fd, const char *buffer, size_t capacity)
+    {
+        if (!ptr || fd < 0)
+        {
+            return;
+        }
+        int saved_errno = errno;
+        size_t pending = std::min(__fpending(ptr), capacity);
+        while (pending > 0)
+        {
+            ssize_t n = ::write(fd, buffer, pending);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            buffer += n;
+            pending -= n;
+        }
+        errno = saved_errno;
+    }
+
+    void LogSink::flushOnSignal()
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (m_mutex.trylock())
+            {
+                WritePending(m_ptr, m_fileno, m_buffer, sizeof(m_buffer));
+                m_mutex.unlock();
+                return;
+            }
+        }
+        WritePending(m_ptr, m_fileno, m_buffer, sizeof(m_buffer));
+    }
+
     ConsoleSink::ConsoleSink()
     {
         m_ptr = stdout;
+        m_fileno = STDOUT_FILENO;
         setbuffer(m_ptr, m_buffer, sizeof(m_buffer));
     }
 
@@ -38,23 +98,255 @@ namespace lim_webserver
         MutexType::Lock lock(m_mutex);
         if(m_ptr)
         {
+            m_fileno = -1;
             fclose(m_ptr);
         }
         const char* mode = append ? "a+" : "w+";
         m_ptr = fopen(filename, mode);
+        if (!m_ptr)
+        {
+            fprintf(stderr, "FileSink::open(%s) failed: %s\n", filename, strerror(errno));
+            return;
+        }
+        m_fileno = fileno(m_ptr);
         setbuffer(m_ptr, m_buffer, sizeof(m_buffer));
-    }
-
-    long FileSink::getFileSize()
-    {
-        return m_fileSize->getSize();
+        // 重新打开(如滚动)后按新文件的真实大小计数
+        struct stat st;
+        m_fileSize.store(fstat(fileno(m_ptr), &st) == 0 ? st.st_size : 0, std::memory_order_relaxed);
     }
 
     size_t FileSink::write(const char *logline, size_t len)
     {
         size_t rt = LogSink::write(logline,len);
-        m_fileSize->addSize(rt);
+        // 只在m_mutex内更新，无需原子加
+        m_fileSize.store(m_fileSize.load(std::memory_order_relaxed) + rt, std::memory_order_relaxed);
         return rt;
     }
 
+    MsyncPolicy MsyncPolicyFromString(const std::string &val)
+    {
+        if (val == "ASYNC" || val == "async")
+        {
+            return MsyncPolicy::ASYNC;
+        }
+        if (val == "SYNC" || val == "sync")
+        {
+            return MsyncPolicy::SYNC;
+        }
+        return MsyncPolicy::NONE;
+    }
+
+    const char *MsyncPolicyToString(MsyncPolicy policy)
+    {
+        switch (policy)
+        {
+        case MsyncPolicy::ASYNC:
+            return "ASYNC";
+        case MsyncPolicy::SYNC:
+            return "SYNC";
+        default:
+            return "NONE";
+        }
+    }
+
+    /**
+     * @brief 从文件末尾向前找到最后一个非0字节，返回其后的长度
+     */
+    static size_t LogicalSize(int fd, size_t size)
+    {
+        char buf[64 * 1024];
+        while (size > 0)
+        {
+            size_t len = std::min(size, sizeof(buf));
+            ssize_t n = pread(fd, buf, len, size - len);
+            if (n != (ssize_t)len)
+            {
+                break;
+            }
+            for (size_t i = len; i > 0; --i)
+            {
+                if (buf[i - 1] != '\0')
+                {
+                    return size - len + i;
+                }
+            }
+            size -= len;
+        }
+        return size;
+    }
+
+    MmapFileSink::MmapFileSink(size_t extentSize, MsyncPolicy policy)
+        : m_msyncPolicy(policy)
+    {
+        // 映射窗口须按页对齐
+        size_t page = sysconf(_SC_PAGESIZE);
+        m_extentSize = std::max(extentSize, page);
+        m_extentSize = (m_extentSize + page - 1) / page * page;
+    }
+
+    MmapFileSink::~MmapFileSink()
+    {
+        close();
+    }
+
+    void MmapFileSink::open(const char *filename, bool append)
+    {
+        MutexType::Lock lock(m_mutex);
+        closeFile();
+
+        int flags = O_RDWR | O_CREAT | O_CLOEXEC | (append ? 0 : O_TRUNC);
+        m_fd = ::open(filename, flags, 0644);
+        if (m_fd < 0)
+        {
+            fprintf(stderr, "MmapFileSink::open(%s) failed: %s\n", filename, strerror(errno));
+            return;
+        }
+
+        struct stat st;
+        size_t size = 0;
+        if (fstat(m_fd, &st) == 0)
+        {
+            size = st.st_size;
+        }
+        // 进程崩溃时来不及截断，预分配的尾部全为0，续写前截掉，否则日志中间会留下一段0
+        size_t logical = LogicalSize(m_fd, size);
+        if (logical < size)
+        {
+            if (ftruncate(m_fd, logical) == 0)
+            {
+                size = logical;
+            }
+            else
+            {
+                fprintf(stderr, "MmapFileSink::open(%s) ftruncate failed: %s\n", filename, strerror(errno));
+            }
+        }
+        m_offset = m_syncOffset = m_allocated = size;
+        m_fileSize.store(size, std::memory_order_relaxed);
+    }
+
+    void MmapFileSink::doFlush()
+    {
+        switch (m_msyncPolicy)
+        {
+        case MsyncPolicy::ASYNC:
+            sync(MS_ASYNC);
+            break;
+        case MsyncPolicy::SYNC:
+            sync(MS_SYNC);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void MmapFileSink::close()
+    {
+        MutexType::Lock lock(m_mutex);
+        closeFile();
+    }
+
+    size_t MmapFileSink::write(const char *logline, size_t len)
+    {
+        if (m_fd < 0)
+        {
+            return 0;
+        }
+        size_t written = 0;
+        while (written < len)
+        {
+            // 窗口写满则在extent边界重新映射
+            if (!m_map || m_offset >= m_mapOffset + m_extentSize)
+            {
+                if (!remap(m_offset))
+                {
+                    break;
+                }
+            }
+            size_t n = std::min(m_mapOffset + m_extentSize - m_offset, len - written);
+            memcpy(m_map + (m_offset - m_mapOffset), logline + written, n);
+            m_offset += n;
+            written += n;
+        }
+        m_fileSize.store(m_fileSize.load(std::memory_order_relaxed) + written, std::memory_order_relaxed);
+        return written;
+    }
+
+    bool MmapFileSink::remap(size_t offset)
+    {
+        unmap();
+
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t start = offset / page * page;
+        size_t end = start + m_extentSize;
+        if (end > m_allocated)
+        {
+            // 预分配失败(如文件系统不支持)时退化为扩展文件长度
+            if (fallocate(m_fd, 0, m_allocated, end - m_allocated) != 0 && ftruncate(m_fd, end) != 0)
+            {
+                fprintf(stderr, "MmapFileSink::remap() allocate failed: %s\n", strerror(errno));
+                return false;
+            }
+            m_allocated = end;
+        }
+
+        void *addr = mmap(nullptr, m_extentSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, start);
+        if (addr == MAP_FAILED)
+        {
+            fprintf(stderr, "MmapFileSink::remap() mmap failed: %s\n", strerror(errno));
+            return false;
+        }
+        m_map = static_cast<char *>(addr);
+        m_mapOffset = start;
+        return true;
+    }
+
+    void MmapFileSink::sync(int flags)
+    {
+        if (!m_map || m_syncOffset >= m_offset)
+        {
+            return;
+        }
+        // 早于窗口的数据已在unmap时处理
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t begin = std::max(m_syncOffset, m_mapOffset) / page * page;
+        msync(m_map + (begin - m_mapOffset), m_offset - begin, flags);
+        m_syncOffset = m_offset;
+    }
+
+    void MmapFileSink::unmap()
+    {
+        if (!m_map)
+        {
+            return;
+        }
+        if (m_msyncPolicy != MsyncPolicy::NONE)
+        {
+            sync(m_msyncPolicy == MsyncPolicy::SYNC ? MS_SYNC : MS_ASYNC);
+        }
+        munmap(m_map, m_extentSize);
+        m_map = nullptr;
+    }
+
+    void MmapFileSink::closeFile()
+    {
+        if (m_fd < 0)
+        {
+            return;
+        }
+        unmap();
+        // 去掉预分配但未写入的尾部
+        if (ftruncate(m_fd, m_offset) != 0)
+        {
+            fprintf(stderr, "MmapFileSink::close() ftruncate failed: %s\n", strerror(errno));
+        }
+        if (m_msyncPolicy == MsyncPolicy::SYNC)
+        {
+            fdatasync(m_fd);
+        }
+        ::close(m_fd);
+        m_fd = -1;
+        m_offset = m_syncOffset = m_allocated = 0;
+    }
+
 } // namespace lim_webserver
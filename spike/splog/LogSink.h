@@ -3,8 +3,10 @@
 #include "base/FileSize.h"
 #include "base/Mutex.h"
 
+#include <atomic>
 #include <memory>
 #include <stdio.h>
+#include <string>
 
 namespace lim_webserver
 {
@@ -20,11 +22,23 @@ namespace lim_webserver
 
         void append(const char *logline, const size_t len);
 
-        inline void flush()
+        /**
+         * @brief 刷新缓存数据
+         */
+        void flush()
         {
-            fflush(m_ptr);
+            MutexType::Lock lock(m_mutex);
+            doFlush();
         }
 
+        /**
+         * @brief 尽力而为的刷新，供信号处理使用
+         *
+         * @details 只调用异步信号安全的函数：以write(2)把缓冲中待写的数据直接写入文件描述符，不经过stdio。
+         *          持锁线程可能正是崩溃的线程，自旋有限次数后不再等待锁直接写入
+         */
+        virtual void flushOnSignal();
+
         FILE *getPtr() const { return m_ptr; }
 
     protected:
@@ -33,7 +47,13 @@ namespace lim_webserver
          */
         virtual size_t write(const char *logline, size_t len);
 
+        /**
+         * @brief 刷新缓存数据，调用时已持有m_mutex
+         */
+        virtual void doFlush();
+
         FILE *m_ptr = nullptr; // 文件流
+        int m_fileno = -1;     // m_ptr的文件描述符，供信号处理直接写入
         char m_buffer[64 * 1024];
         MutexType m_mutex;
     };
@@ -53,14 +73,114 @@ namespace lim_webserver
         using ptr = std::shared_ptr<FileSink>;
 
     public:
-        void open(const char *filename, bool append);
+        virtual void open(const char *filename, bool append);
+
+        /**
+         * @brief 当前文件已存储的数据量，不持有m_mutex，可与写入和重新打开并发调用
+         */
+        long getFileSize() const { return m_fileSize.load(std::memory_order_relaxed); }
+
+    protected:
+        size_t write(const char *logline, size_t len) override;
+
+        std::atomic<uint64_t> m_fileSize{0}; // 当前已存储的数据量，写入与重新打开时在m_mutex内更新
+    };
+
+    /**
+     * NONE:   不主动同步，由内核回写脏页
+     * ASYNC:  flush时发起异步同步(MS_ASYNC)
+     * SYNC:   flush时同步落盘(MS_SYNC)
+     */
+    enum class MsyncPolicy
+    {
+        NONE,  // 不主动同步
+        ASYNC, // 异步同步
+        SYNC   // 同步落盘
+    };
+
+    /**
+     * @brief 将文本表示的同步策略转换为枚举值，无法识别时返回NONE
+     */
+    MsyncPolicy MsyncPolicyFromString(const std::string &val);
+
+    /**
+     * @brief 将同步策略转换为文本表示
+     */
+    const char *MsyncPolicyToString(MsyncPolicy policy);
+
+    /**
+     * @brief 基于内存映射的文件落地器
+     *
+     * @details 以extent为单位用fallocate预分配文件空间并映射为写窗口，日志直接memcpy进窗口，
+     *          写满后在extent边界重新映射。由于MAP_SHARED与页缓存共享，写入后其他进程即可读到，
+     *          flush只决定落盘的时机。文件在关闭或重新打开(滚动)时被截断为真实长度。
+     */
+    class MmapFileSink : public FileSink
+    {
+    public:
+        using ptr = std::shared_ptr<MmapFileSink>;
+
+        static const size_t kDefaultExtentSize = 16 * 1024 * 1024; // 16M
 
-        long getFileSize();
+    public:
+        MmapFileSink(size_t extentSize = kDefaultExtentSize, MsyncPolicy policy = MsyncPolicy::NONE);
+        ~MmapFileSink();
+
+        /**
+         * @brief 打开文件，若已打开则先截断并关闭旧文件
+         *
+         * @details 追加打开时截掉文件末尾的0，即上次进程崩溃时未截断的预分配空间
+         */
+        void open(const char *filename, bool append) override;
+
+        /**
+         * @brief 解除映射，截断文件至真实长度并关闭
+         */
+        void close();
+
+        inline void setMsyncPolicy(MsyncPolicy policy) { m_msyncPolicy = policy; }
+        inline MsyncPolicy getMsyncPolicy() const { return m_msyncPolicy; }
+
+        inline size_t getExtentSize() const { return m_extentSize; }
 
     private:
         size_t write(const char *logline, size_t len) override;
 
-        FileSize::ptr m_fileSize = FileSize::Create(); // 当前已存储的数据量
+        /**
+         * @brief 按同步策略将未同步的数据落盘
+         */
+        void doFlush() override;
+
+        /**
+         * @brief 数据写入映射后即在页缓存中，进程崩溃也不会丢失，信号处理时无需刷新
+         */
+        void flushOnSignal() override {}
+
+        /**
+         * @brief 预分配并映射以offset所在页为起点的extent
+         */
+        bool remap(size_t offset);
+
+        /**
+         * @brief 同步[m_syncOffset, m_offset)范围内的数据
+         *
+         * @param flags msync标志位
+         */
+        void sync(int flags);
+
+        void unmap();
+
+        void closeFile();
+
+    private:
+        int m_fd = -1;              // 文件句柄
+        char *m_map = nullptr;      // 当前映射窗口
+        size_t m_mapOffset = 0;     // 窗口在文件中的起始偏移
+        size_t m_offset = 0;        // 文件的真实长度(写入位置)
+        size_t m_syncOffset = 0;    // 已同步的位置
+        size_t m_allocated = 0;     // 已预分配的文件长度
+        size_t m_extentSize;        // 预分配与映射的粒度
+        MsyncPolicy m_msyncPolicy;  // 同步策略
     };
 
 } // namespace lim_webserver
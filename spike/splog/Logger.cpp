@@ -14,6 +14,11 @@ namespace lim_webserver
     Logger::Logger(const std::string &name)
         : m_name(name) {}
 
+    Logger::~Logger()
+    {
+        LogSuppression::DelLogger(this);
+    }
+
     void Logger::log(const LogMessage::ptr &message)
     {
         if (message->getLevel() >= m_level)
@@ -33,6 +38,50 @@ namespace lim_webserver
         }
     }
 
+    bool Logger::admit(uint64_t &suppressed)
+    {
+        if (!m_limiter.isEnabled())
+        {
+            return true;
+        }
+        if (!m_limiter.consume())
+        {
+            m_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // 先读再交换，无抑制时不产生写操作
+        if (m_suppressed.load(std::memory_order_relaxed) > 0)
+        {
+            suppressed += m_suppressed.exchange(0, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    void Logger::setRateLimit(long rate, long burst)
+    {
+        m_limiter.setRate(rate, burst);
+        if (m_limiter.isEnabled())
+        {
+            LogSuppression::AddLogger(this);
+        }
+    }
+
+    void Logger::reportSuppressed()
+    {
+        if (m_level == LogLevel_OFF || m_suppressed.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+        uint64_t suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0)
+        {
+            // 汇总至少以WARN级别输出，避免被日志器自身的级别过滤
+            LogLevel level = std::max(m_level, LogLevel_WARN);
+            LogMessageWrap(this, FileName(__FILE__), __LINE__, time(0), level).getStream()
+                << "[suppressed " << suppressed << " messages by rate limit]";
+        }
+    }
+
     void Logger::addAppender(LogAppender::ptr appender)
     {
         if (!appender->isStarted())
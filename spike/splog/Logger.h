@@ -13,6 +13,7 @@
 
 #include "splog/LogAppender.h"
 #include "splog/LogMessage.h"
+#include "splog/LogRateLimit.h"
 
 namespace lim_webserver
 {
@@ -30,10 +31,12 @@ namespace lim_webserver
         std::string name;
         std::vector<std::string> appender_refs;
         LogLevel level = LogLevel_UNKNOWN;
+        long rate = 0;  // 每秒放行的日志数，0为不限流
+        long burst = 0; // 允许的突发数，0时取rate
 
         bool operator==(const LoggerDefine &oth) const
         {
-            return name == oth.name && level == oth.level && appender_refs == oth.appender_refs;
+            return name == oth.name && level == oth.level && appender_refs == oth.appender_refs && rate == oth.rate && burst == oth.burst;
         }
 
         bool operator<(const LoggerDefine &oth) const
@@ -68,6 +71,7 @@ namespace lim_webserver
     public:
         Logger() {}
         Logger(const std::string &name);
+        ~Logger();
 
         /**
          * @brief 输出日志
@@ -133,10 +137,33 @@ namespace lim_webserver
          */
         inline void setName(const std::string &name) { m_name = name; }
 
+        /**
+         * @brief 设置令牌桶限流
+         *
+         * @param rate  每秒放行的日志数，0为不限流
+         * @param burst 允许的突发数，0时取rate
+         */
+        void setRateLimit(long rate, long burst = 0);
+
+        /**
+         * @brief 令牌桶判断，放行时将此前被限流的条数累加到suppressed并清零
+         *
+         * @return true 放行
+         * @return false 被限流
+         */
+        bool admit(uint64_t &suppressed);
+
+        /**
+         * @brief 输出尚未报告的被限流条数，由LogSuppression定期调用
+         */
+        void reportSuppressed();
+
     private:
         std::string m_name;                      // 日志名称
         LogLevel m_level = LogLevel_DEBUG;       // 日志级别
         std::list<LogAppender::ptr> m_appenders; // Appender集合
+        TokenBucket m_limiter;                   // 限流器
+        std::atomic<uint64_t> m_suppressed{0};   // 被限流的条数
     };
 
 }
\ No newline at end of file
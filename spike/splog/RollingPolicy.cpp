@@ -1,8 +1,25 @@
 #include "RollingPolicy.h"
 #include "LogAppender.h"
 
+#include <stdio.h>
+#include <sys/stat.h>
+
 namespace lim_webserver
 {
+    static bool FileExists(const std::string &path)
+    {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0;
+    }
+
+    void RollingPolicy::start()
+    {
+        if (m_pattern.empty())
+        {
+            m_pattern = getParentsRawFileProperty() + ".%Y%m%d-%H%M%S.%i";
+        }
+    }
+
     void RollingPolicy::setFileNamePattern(const std::string &pattern)
     {
         m_pattern = pattern;
@@ -13,7 +30,7 @@ namespace lim_webserver
         return m_pattern;
     }
 
-    void RollingPolicy::setParent(std::shared_ptr<FileAppender> appender)
+    void RollingPolicy::setParent(FileAppender *appender)
     {
         m_parent = appender;
     }
@@ -23,8 +40,126 @@ namespace lim_webserver
         return m_parent->rawFileProperty();
     }
 
+    std::string RollingPolicy::nextArchiveName(time_t periodStart)
+    {
+        struct tm tm_time;
+        localtime_r(&periodStart, &tm_time);
+        bool hasIndex = m_pattern.find("%i") != std::string::npos;
+        // 序号不复用被清理掉的较小值，保证序号越大归档越新
+        if (periodStart != m_indexPeriod)
+        {
+            m_indexPeriod = periodStart;
+            m_index = 0;
+        }
+        for (int index = m_index;; ++index)
+        {
+            // %i不是strftime的占位符，先替换为序号
+            std::string pattern = m_pattern;
+            if (hasIndex)
+            {
+                pattern.replace(pattern.find("%i"), 2, std::to_string(index));
+            }
+            char buf[1024];
+            size_t n = strftime(buf, sizeof(buf), pattern.c_str(), &tm_time);
+            std::string name(buf, n);
+            if (!hasIndex && index > 0)
+            {
+                name += "." + std::to_string(index);
+            }
+            if (!FileExists(name) && !FileExists(name + ".gz"))
+            {
+                m_index = index + 1;
+                return name;
+            }
+        }
+    }
+
+    void RollingPolicy::archive(time_t periodStart)
+    {
+        const std::string &active = getParentsRawFileProperty();
+        std::string archive = nextArchiveName(periodStart);
+        // 仅重命名，打开的句柄继续有效，重新打开后新日志写入新文件
+        if (rename(active.c_str(), archive.c_str()) != 0)
+        {
+            fprintf(stderr, "RollingPolicy: rename %s to %s failed\n", active.c_str(), archive.c_str());
+            return;
+        }
+        m_parent->openFile();
+
+        ArchiveTask task;
+        task.file = archive;
+        task.compression = m_compression;
+        task.active = active;
+        task.max_history = m_maxHistory;
+        task.total_size_cap = m_totalSizeCap;
+        // 以命名格式中第一个占位符之前的文件名部分作为归档前缀
+        size_t slash = m_pattern.rfind('/');
+        task.dir = slash == std::string::npos ? "." : m_pattern.substr(0, slash);
+        std::string name = slash == std::string::npos ? m_pattern : m_pattern.substr(slash + 1);
+        task.prefix = name.substr(0, name.find('%'));
+        if (slash == std::string::npos)
+        {
+            task.active = "./" + active;
+        }
+        LogArchiver::GetInstance()->submit(task);
+    }
+
+    void TimeBasedRollingPolicy::start()
+    {
+        RollingPolicy::start();
+        updatePeriod(time(0));
+    }
+
     void TimeBasedRollingPolicy::rollover()
     {
+        archive(m_periodStart);
+        updatePeriod(time(0));
+    }
+
+    const std::string &TimeBasedRollingPolicy::getActiveFileName()
+    {
+        return getParentsRawFileProperty();
+    }
+
+    bool TimeBasedRollingPolicy::isTriggeringMessage(FileSink::ptr file, LogMessage::ptr message)
+    {
+        return static_cast<time_t>(message->getTime()) >= m_nextRollTime;
+    }
+
+    void TimeBasedRollingPolicy::updatePeriod(time_t now)
+    {
+        // 按本地时间对齐，使按天滚动发生在本地零点
+        struct tm tm_time;
+        localtime_r(&now, &tm_time);
+        time_t local = now + tm_time.tm_gmtoff;
+        m_periodStart = local / m_period * m_period - tm_time.tm_gmtoff;
+        m_nextRollTime = m_periodStart + m_period;
+    }
+
+    bool SizeAndTimeBasedRollingPolicy::isTriggeringMessage(FileSink::ptr file, LogMessage::ptr message)
+    {
+        return TimeBasedRollingPolicy::isTriggeringMessage(file, message) || file->getFileSize() >= m_maxFileSize;
+    }
+
+    RollingPolicy::ptr CreateRollingPolicy(const RollingPolicyDefine &rpd)
+    {
+        TimeBasedRollingPolicy::ptr policy;
+        if (rpd.policy == "size_time")
+        {
+            SizeAndTimeBasedRollingPolicy::ptr sizePolicy = std::make_shared<SizeAndTimeBasedRollingPolicy>();
+            sizePolicy->setMaxFileSize(rpd.max_file_size);
+            policy = sizePolicy;
+        }
+        else
+        {
+            policy = std::make_shared<TimeBasedRollingPolicy>();
+        }
+        policy->setPeriod(rpd.period);
+        policy->setFileNamePattern(rpd.pattern);
+        policy->setCompression(rpd.compression);
+        policy->setMaxHistory(rpd.max_history);
+        policy->setTotalSizeCap(rpd.total_size_cap);
+        return policy;
     }
 
 } // namespace lim_webserver
@@ -1,15 +1,40 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <time.h>
 
 #include "TriggeringPolicy.h"
+#include "LogArchiver.h"
 
 namespace lim_webserver
 {
     class FileAppender;
 
+    /**
+     * @brief 滚动策略配置单
+     */
+    struct RollingPolicyDefine
+    {
+        std::string policy = "time";                          // 策略 time / size_time
+        std::string pattern;                                  // 归档文件命名格式
+        long period = 86400;                                  // 滚动周期，单位：秒
+        long max_file_size = 0;                               // 单个文件上限(size_time)
+        CompressionType compression = CompressionType::NONE;  // 归档压缩方式
+        int max_history = 0;                                  // 最多保留的归档数，0为不限
+        long total_size_cap = 0;                              // 归档总大小上限，0为不限
+
+        bool operator==(const RollingPolicyDefine &oth) const
+        {
+            return policy == oth.policy && pattern == oth.pattern && period == oth.period && max_file_size == oth.max_file_size && compression == oth.compression && max_history == oth.max_history && total_size_cap == oth.total_size_cap;
+        }
+    };
+
     /**
      * @brief 滚动策略基类
+     *
+     * @details 滚动时在日志线程中只做重命名与重新打开，压缩与清理交由LogArchiver后台完成。
+     *          命名格式支持strftime占位符与%i(同一时间段内的序号)，缺省为"原文件名.%Y%m%d-%H%M%S.%i"。
      */
     class RollingPolicy
     {
@@ -17,6 +42,8 @@ namespace lim_webserver
         using ptr = std::shared_ptr<RollingPolicy>;
 
     public:
+        virtual ~RollingPolicy() {}
+
         /**
          * @brief 文件滚动
          */
@@ -27,6 +54,11 @@ namespace lim_webserver
          */
         virtual const std::string &getActiveFileName() = 0;
 
+        /**
+         * @brief 输出地启动时调用，完成默认值推导
+         */
+        virtual void start();
+
         /**
          * @brief 设置文件命名格式
          */
@@ -38,22 +70,54 @@ namespace lim_webserver
         const std::string &getFileNamePattern();
 
         /**
-         * @brief 设置调用该策略的输出地
+         * @brief 设置调用该策略的输出地，输出地持有策略，此处不持有输出地以免循环引用
          */
-        void setParent(std::shared_ptr<FileAppender> appender);
+        void setParent(FileAppender *appender);
 
         /**
          * @brief 获取输出地的原始文件名
          */
         const std::string &getParentsRawFileProperty();
 
+        inline void setCompression(CompressionType compression) { m_compression = compression; }
+        inline CompressionType getCompression() const { return m_compression; }
+
+        /**
+         * @brief 设置最多保留的归档数，0为不限
+         */
+        inline void setMaxHistory(int maxHistory) { m_maxHistory = maxHistory; }
+        inline int getMaxHistory() const { return m_maxHistory; }
+
+        /**
+         * @brief 设置归档总大小上限，0为不限
+         */
+        inline void setTotalSizeCap(long totalSizeCap) { m_totalSizeCap = totalSizeCap; }
+        inline long getTotalSizeCap() const { return m_totalSizeCap; }
+
     protected:
-        std::shared_ptr<FileAppender> m_parent; // 调用该策略的输出地
-        std::string m_pattern;                  // 文件命名格式
+        /**
+         * @brief 将当前文件重命名为归档文件，重新打开输出地并提交后台归档任务
+         *
+         * @param periodStart 归档文件所属时间段的起始时间
+         */
+        void archive(time_t periodStart);
+
+        /**
+         * @brief 生成一个不与已有归档(含压缩后的文件)冲突的归档文件名
+         */
+        std::string nextArchiveName(time_t periodStart);
+
+        FileAppender *m_parent = nullptr;                     // 调用该策略的输出地
+        std::string m_pattern;                                // 文件命名格式
+        CompressionType m_compression = CompressionType::NONE; // 归档压缩方式
+        int m_maxHistory = 0;                                 // 最多保留的归档数
+        long m_totalSizeCap = 0;                              // 归档总大小上限
+        time_t m_indexPeriod = -1;                            // 序号所属的时间段
+        int m_index = 0;                                      // 下一个归档序号，同一时间段内只增不减
     };
 
     /**
-     * 基于时间的滚动策略，每天一个新文件
+     * 基于时间的滚动策略，默认每天一个新文件
      */
     class TimeBasedRollingPolicy : public RollingPolicy, public TriggeringPolicy
     {
@@ -61,21 +125,63 @@ namespace lim_webserver
         using ptr = std::shared_ptr<TimeBasedRollingPolicy>;
 
     public:
+        void start() override;
+
         void rollover() override;
 
+        const std::string &getActiveFileName() override;
+
+        bool isTriggeringMessage(FileSink::ptr file, LogMessage::ptr message) override;
+
+        /**
+         * @brief 设置滚动周期，按本地时间对齐
+         *
+         * @param period 单位：秒
+         */
+        inline void setPeriod(long period) { m_period = period > 0 ? period : 86400; }
+        inline long getPeriod() const { return m_period; }
+
     protected:
+        /**
+         * @brief 计算now所在时间段的起止
+         */
+        void updatePeriod(time_t now);
+
+        long m_period = 86400;    // 滚动周期
+        time_t m_periodStart = 0; // 当前时间段起始
+        time_t m_nextRollTime = 0; // 下次滚动时间
     };
 
     /**
-     * 基于时间和大小的滚动策略，每天进行滚动，当文件大小到达限定时滚动
+     * 基于时间和大小的滚动策略，每个周期进行滚动，当文件大小到达限定时也滚动
      */
     class SizeAndTimeBasedRollingPolicy : public TimeBasedRollingPolicy
     {
     public:
         using ptr = std::shared_ptr<SizeAndTimeBasedRollingPolicy>;
 
+        static const long DEFAULT_MAX_FILE_SIZE = 1024 * 1024 * 1024;
+
     public:
+        bool isTriggeringMessage(FileSink::ptr file, LogMessage::ptr message) override;
+
+        /**
+         * 设定最大文件大小
+         */
+        inline void setMaxFileSize(long size) { m_maxFileSize = size > 0 ? size : DEFAULT_MAX_FILE_SIZE; }
+
+        /**
+         * 获取最大文件大小
+         */
+        inline long getMaxFileSize() const { return m_maxFileSize; }
+
     private:
+        long m_maxFileSize = DEFAULT_MAX_FILE_SIZE; // 最大文件大小
     };
 
+    /**
+     * @brief 根据配置单构造滚动策略
+     */
+    RollingPolicy::ptr CreateRollingPolicy(const RollingPolicyDefine &rpd);
+
 } // namespace lim_webserver
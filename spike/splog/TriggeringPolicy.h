@@ -15,6 +15,8 @@ namespace lim_webserver
         using ptr = std::shared_ptr<TriggeringPolicy>;
 
     public:
+        virtual ~TriggeringPolicy() {}
+
         /**
          * 校验当前消息体时是否满足了触发条件
          */
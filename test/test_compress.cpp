@@ -0,0 +1,140 @@
+#include "net/http/HttpCompress.h"
+#include "splog.h"
+
+#include <zlib.h>
+
+using namespace lim_webserver;
+using namespace lim_webserver::http;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+/**
+ * @brief 解压gzip(带头尾)或deflate(zlib格式)
+ */
+static std::string Inflate(const std::string &in, bool gzip)
+{
+    z_stream zs{};
+    inflateInit2(&zs, gzip ? 15 + 16 : 15);
+    zs.next_in = (Bytef *)in.data();
+    zs.avail_in = in.size();
+    std::string out;
+    char buf[16384];
+    int rt;
+    do
+    {
+        zs.next_out = (Bytef *)buf;
+        zs.avail_out = sizeof(buf);
+        rt = inflate(&zs, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - zs.avail_out);
+    } while (rt == Z_OK);
+    inflateEnd(&zs);
+    return rt == Z_STREAM_END ? out : "";
+}
+
+static std::string MakeText(size_t size)
+{
+    std::string text;
+    for (int i = 0; text.size() < size; ++i)
+    {
+        text += "{\"id\":" + std::to_string(i) + ",\"name\":\"user" + std::to_string(i % 97) + "\"},";
+    }
+    return text;
+}
+
+void test_negotiate()
+{
+    bool br = IsContentCodingSupported(ContentCoding::BR);
+    ASSERT(NegotiateContentCoding("") == ContentCoding::IDENTITY);
+    ASSERT(NegotiateContentCoding("identity") == ContentCoding::IDENTITY);
+    ASSERT(NegotiateContentCoding("gzip, deflate") == ContentCoding::GZIP);
+    // q值相同时gzip优先于deflate，与书写顺序无关
+    ASSERT(NegotiateContentCoding("deflate, gzip") == ContentCoding::GZIP);
+    ASSERT(NegotiateContentCoding("gzip;q=0.5, deflate") == ContentCoding::DEFLATE);
+    ASSERT(NegotiateContentCoding("GZIP;Q=0.8, deflate;q=0.2") == ContentCoding::GZIP);
+    ASSERT(NegotiateContentCoding("gzip;q=0, deflate;q=0") == ContentCoding::IDENTITY);
+    ASSERT(NegotiateContentCoding("x-gzip") == ContentCoding::GZIP);
+    // 未列出的编码取*的q值
+    ASSERT(NegotiateContentCoding("*;q=0.5, gzip;q=0.1") == (br ? ContentCoding::BR : ContentCoding::DEFLATE));
+    ASSERT(NegotiateContentCoding("br;q=0.9, gzip") == ContentCoding::GZIP);
+    ASSERT(NegotiateContentCoding("br, gzip") == (br ? ContentCoding::BR : ContentCoding::GZIP));
+    LOG_INFO(g_logger) << "negotiate ok br=" << br;
+}
+
+void test_threshold()
+{
+    HttpCompressor compressor;
+    compressor.setEnabled(true);
+    compressor.setMinSize(1024);
+    HttpRequest::ptr req(new HttpRequest);
+    req->setHeader("Accept-Encoding", "gzip");
+
+    auto run = [&](const std::string &type, size_t size)
+    {
+        HttpResponse::ptr rsp(new HttpResponse);
+        rsp->setHeader("Content-Type", type);
+        rsp->setBody(MakeText(size));
+        return compressor.compress(req, rsp);
+    };
+    ASSERT(run("application/json", 4096));
+    ASSERT(run("text/html; charset=utf-8", 4096));
+    ASSERT(run("application/problem+json", 4096));
+    ASSERT(!run("application/json", 512));
+    ASSERT(!run("image/png", 4096));
+    ASSERT(!run("application/octet-stream", 4096));
+    ASSERT(HttpCompressor::IsCompressibleType("image/svg+xml") && !HttpCompressor::IsCompressibleType("text/"));
+    LOG_INFO(g_logger) << "threshold ok";
+}
+
+void test_round_trip_and_etag()
+{
+    HttpCompressor compressor;
+    compressor.setEnabled(true);
+    compressor.setMinSize(1024);
+    compressor.cache().setCapacity(1 << 20);
+    for (ContentCoding coding : {ContentCoding::GZIP, ContentCoding::DEFLATE})
+    {
+        HttpRequest::ptr req(new HttpRequest);
+        req->setHeader("Accept-Encoding", ContentCodingToString(coding));
+        HttpResponse::ptr rsp(new HttpResponse);
+        std::string body = MakeText(8192);
+        rsp->setHeader("Content-Type", "application/json");
+        rsp->setHeader("ETag", "\"v1\"");
+        rsp->setBody(body);
+        ASSERT(compressor.compress(req, rsp));
+        ASSERT(rsp->getHeader("Content-Encoding") == ContentCodingToString(coding));
+        ASSERT(rsp->getHeader("ETag") == "W/\"v1\"");
+        ASSERT(rsp->getHeader("Vary") == "Accept-Encoding");
+        ASSERT(Inflate(rsp->body(), coding == ContentCoding::GZIP) == body);
+    }
+
+    // 同一路径的不同参数带相同ETag与长度时不能共用缓存的压缩结果
+    for (int round = 0; round < 2; ++round)
+    {
+        for (const char *id : {"1", "2"})
+        {
+            HttpRequest::ptr req(new HttpRequest);
+            req->setPath("/a");
+            req->setQuery(std::string("id=") + id);
+            req->setHeader("Accept-Encoding", "gzip");
+            HttpResponse::ptr rsp(new HttpResponse);
+            std::string body = MakeText(4096);
+            body.replace(0, 6, std::string("{\"id\":") + id);
+            body.resize(4096);
+            rsp->setHeader("Content-Type", "application/json");
+            rsp->setHeader("ETag", "\"7\"");
+            rsp->setBody(body);
+            ASSERT(compressor.compress(req, rsp));
+            ASSERT(Inflate(rsp->body(), true) == body);
+        }
+    }
+    LOG_INFO(g_logger) << "round_trip_and_etag ok cache entries=" << compressor.cache().count();
+}
+
+int main()
+{
+    test_negotiate();
+    test_threshold();
+    test_round_trip_and_etag();
+    LOG_INFO(g_logger) << "test_compress passed";
+    return 0;
+}
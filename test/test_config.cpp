@@ -1,6 +1,9 @@
+#include "coroutine.h"
 #include "splog.h"
 #include "splog/LogInitializer.h"
 
+#include <atomic>
+
 using namespace lim_webserver;
 
 typename ConfigerVar<int>::ptr g_int_value_config = Configer::Lookup("system.port", (int)8080, "system port");
@@ -73,8 +76,53 @@ void test_visit()
     Configer::Visit(f);
 }
 
+/**
+ * @brief 读到的值跨越配置变更与协程切换后保持不变
+ */
+void test_get_across_yield()
+{
+    Scheduler *scheduler = Scheduler::Create();
+    scheduler->setName("config");
+    scheduler->startInNewThread(2);
+
+    const std::vector<int> old_value = g_int_vec_value_config->get();
+    const std::vector<int> new_value = {3, 4, 5};
+    std::atomic<int> stage{0};
+    bool ok = false;
+    scheduler->createTask([&]()
+                          {
+                              // 按引用持有也安全：返回值归调用者所有
+                              const std::vector<int> &value = g_int_vec_value_config->get();
+                              auto snapshot = g_int_vec_value_config->getSnapshot();
+                              stage = 1;
+                              while (stage != 2)
+                              {
+                                  Processor::CoYield();
+                              }
+                              // 本线程再次读取会刷新缓存，已读到的值不受影响
+                              std::vector<int> current = g_int_vec_value_config->get();
+                              Processor::CoYield();
+                              ok = value == old_value && *snapshot == old_value && current == new_value;
+                              stage = 3; });
+    while (stage != 1)
+    {
+        usleep(1000);
+    }
+    g_int_vec_value_config->setValue(new_value);
+    stage = 2;
+    while (stage != 3)
+    {
+        usleep(1000);
+    }
+    scheduler->stop();
+    g_int_vec_value_config->setValue(old_value);
+    LOG_INFO(LOG_ROOT()) << "get across set and yield ok=" << ok;
+    ASSERT(ok);
+}
+
 int main(int argc, char **argv)
 {
+    test_get_across_yield();
     // test_yaml();
     // test_config();
     // test_lexical();
@@ -0,0 +1,119 @@
+#include "base/Configer.h"
+#include "coroutine.h"
+#include "net.h"
+#include "net/EventLoop.h"
+#include "splog.h"
+
+#include <atomic>
+#include <fstream>
+#include <unistd.h>
+
+using namespace lim_webserver;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+static ConfigerVar<int>::ptr g_watch_value = Configer::Lookup("test_watch.value", 0, "value changed by test_config_watcher");
+
+static void WriteConfig(const std::string &file, bool hot_reload, int value)
+{
+    // 先写临时文件再rename，与编辑器替换文件的方式相同
+    std::string tmp = file + ".tmp";
+    std::ofstream(tmp) << "config:\n  hot_reload: " << (hot_reload ? "true" : "false") << "\ntest_watch:\n  value: " << value << "\n";
+    rename(tmp.c_str(), file.c_str());
+}
+
+static bool WaitFor(const std::function<bool()> &cond, int ms)
+{
+    for (int i = 0; i < ms / 10 && !cond(); ++i)
+    {
+        usleep(10 * 1000);
+    }
+    return cond();
+}
+
+void test_load(Scheduler *scheduler, const std::string &dir)
+{
+    // 配置文件自身开启热加载，之后的改动自动生效
+    std::string file = dir + "/hot.yaml";
+    WriteConfig(file, true, 1);
+    bool loaded = ConfigWatcher::Load(file, scheduler);
+    ASSERT(loaded && g_watch_value->getValue() == 1);
+    // 变更回调不在事件循环上执行
+    std::atomic<int> on_loop{-1};
+    uint64_t key = g_watch_value->addListener([&](const int &, const int &)
+                                              { on_loop = dynamic_cast<EventLoop *>(Processor::GetCurrentProcessor()) != nullptr; });
+    WriteConfig(file, true, 2);
+    bool reloaded = WaitFor([]() { return g_watch_value->getValue() == 2; }, 2000);
+    g_watch_value->delListener(key);
+    LOG_INFO(g_logger) << "hot reload value=" << g_watch_value->getValue() << " listener on event loop=" << on_loop;
+    ASSERT(reloaded && on_loop == 0);
+}
+
+void test_stop_in_loop(Scheduler *scheduler, const std::string &dir)
+{
+    // 在监听协程所在的单线程事件循环上的另一个协程中停止，不能死锁
+    std::string file = dir + "/stop.yaml";
+    WriteConfig(file, false, 3);
+    ConfigWatcher::ptr watcher = ConfigWatcher::Create(scheduler);
+    watcher->watch(file);
+    watcher->start();
+    usleep(50 * 1000);
+    std::atomic<bool> stopped{false};
+    scheduler->createTask([&]() { watcher->stop(); stopped = true; });
+    bool ok = WaitFor([&]() { return stopped.load(); }, 2000);
+    LOG_INFO(g_logger) << "stop from a task on the watcher loop returned=" << ok;
+    ASSERT(ok);
+}
+
+void test_stop_in_callback(Scheduler *scheduler, const std::string &dir)
+{
+    // 在配置变更的回调(即监听协程)中停止，不等待自己退出
+    std::string file = dir + "/callback.yaml";
+    WriteConfig(file, false, 4);
+    ConfigWatcher::ptr watcher = ConfigWatcher::Create(scheduler);
+    watcher->watch(file);
+    watcher->start();
+    std::atomic<bool> stopped{false};
+    uint64_t key = g_watch_value->addListener([&](const int &, const int &) { watcher->stop(); stopped = true; });
+    WriteConfig(file, false, 5);
+    bool ok = WaitFor([&]() { return stopped.load(); }, 2000);
+    g_watch_value->delListener(key);
+    LOG_INFO(g_logger) << "stop from the watcher callback returned=" << ok;
+    ASSERT(ok);
+}
+
+void test_stop_after_scheduler(const std::string &dir)
+{
+    // 调度器已停止时监听协程不会再运行，析构不能等待它退出
+    std::string file = dir + "/stopped.yaml";
+    WriteConfig(file, false, 6);
+    Scheduler *scheduler = Scheduler::CreateNetScheduler();
+    scheduler->setName("stopped");
+    scheduler->startInNewThread(1);
+    ConfigWatcher::ptr watcher = ConfigWatcher::Create(scheduler);
+    watcher->watch(file);
+    watcher->start();
+    usleep(50 * 1000);
+    scheduler->stop();
+    watcher.reset();
+    LOG_INFO(g_logger) << "watcher released after its scheduler stopped";
+}
+
+int main()
+{
+    char dir[] = "/tmp/test_config_watcher_XXXXXX";
+    ASSERT(mkdtemp(dir) != nullptr);
+    Scheduler *scheduler = Scheduler::CreateNetScheduler();
+    scheduler->setName("watcher");
+    scheduler->startInNewThread(1);
+
+    test_load(scheduler, dir);
+    test_stop_in_loop(scheduler, dir);
+    test_stop_in_callback(scheduler, dir);
+    test_stop_after_scheduler(dir);
+    // 共享监听器先于调度器停止
+    ConfigWatcher::Shutdown();
+    scheduler->stop();
+    LOG_INFO(g_logger) << "test_config_watcher passed";
+    return 0;
+}
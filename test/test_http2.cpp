@@ -0,0 +1,202 @@
+#include "coroutine.h"
+#include "net.h"
+#include "net/http/Http2Session.h"
+#include "net/http/HttpServer.h"
+#include "splog.h"
+
+#include <string.h>
+
+using namespace lim_webserver;
+using namespace lim_webserver::http;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+/**
+ * @brief 回显方法、路径、参数与请求体，/slow 延迟返回以观察多路复用，/big 返回1MB以观察流控
+ */
+class EchoServer : public HttpServer
+{
+public:
+    EchoServer(Scheduler *worker, Scheduler *accepter) : HttpServer(true, worker, accepter) {}
+
+protected:
+    void handleRequest(HttpRequest::ptr req, HttpResponse::ptr rsp) override
+    {
+        if (req->path() == "/slow")
+        {
+            usleep(200 * 1000);
+        }
+        rsp->setHeader("Content-Type", "text/plain");
+        if (req->path() == "/big")
+        {
+            rsp->setBody(std::string(1024 * 1024, 'x'));
+            return;
+        }
+        rsp->setCookie("visited", "1");
+        rsp->setBody(HttpMethodToString(req->method()) + std::string(" ") + req->path() + " query=" + req->query() + " host=" + req->getHeader("host") +
+                     " body=" + std::to_string(req->body().size()) + "\n");
+    }
+};
+
+static std::string Unhex(const char *hex)
+{
+    std::string out;
+    for (; hex[0] && hex[1]; hex += 2)
+    {
+        out += (char)std::stoi(std::string(hex, 2), nullptr, 16);
+    }
+    return out;
+}
+
+void test_hpack()
+{
+    // RFC 7541 C.4：三个使用Huffman编码且共享动态表的请求
+    const char *blocks[] = {"828684418cf1e3c2e5f23a6ba0ab90f4ff", "828684be5886a8eb10649cbf", "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"};
+    HpackDecoder decoder;
+    for (const char *hex : blocks)
+    {
+        std::string block = Unhex(hex);
+        HeaderList headers;
+        bool ok = decoder.decode((const uint8_t *)block.data(), block.size(), headers);
+        std::string line;
+        for (auto &h : headers)
+        {
+            line += h.first + "=" + h.second + " ";
+        }
+        LOG_INFO(g_logger) << "hpack ok=" << ok << " " << line;
+    }
+
+    HpackEncoder encoder;
+    HpackDecoder peer;
+    HeaderList headers = {{":status", "200"}, {"content-type", "text/plain"}, {"server", "lim"}, {"content-length", "42"}};
+    for (int i = 0; i < 2; ++i)
+    {
+        std::string block;
+        encoder.encode(headers, block);
+        HeaderList decoded;
+        bool ok = peer.decode((const uint8_t *)block.data(), block.size(), decoded);
+        LOG_INFO(g_logger) << "hpack roundtrip size=" << block.size() << " ok=" << ok << " equal=" << (decoded == headers);
+    }
+}
+
+/**
+ * @brief 以prior knowledge开启连接，在同一连接上并发发出多个请求，按到达顺序打印响应
+ */
+void test_client(Address::ptr addr)
+{
+    Socket::ptr sock = Socket::CreateTCP(addr);
+    if (!sock->connect(addr))
+    {
+        LOG_ERROR(g_logger) << "connect fail";
+        return;
+    }
+    std::string out(HTTP2_PREFACE, HTTP2_PREFACE_SIZE);
+    auto frame = [&out](Http2FrameType type, uint8_t flags, uint32_t id, const std::string &payload)
+    {
+        uint8_t head[Http2FrameHeader::SIZE];
+        Http2FrameHeader h;
+        h.length = payload.size();
+        h.type = type;
+        h.flags = flags;
+        h.stream_id = id;
+        h.encode(head);
+        out.append((const char *)head, sizeof(head));
+        out += payload;
+    };
+    frame(Http2FrameType::SETTINGS, 0, 0, "");
+
+    HpackEncoder encoder;
+    const char *paths[] = {"/slow", "/a?x=1", "/b"};
+    for (int i = 0; i < 3; ++i)
+    {
+        std::string block;
+        encoder.encode({{":method", i == 2 ? "POST" : "GET"}, {":scheme", "http"}, {":path", paths[i]}, {":authority", "localhost"}}, block);
+        uint32_t id = 2 * i + 1;
+        if (i == 2)
+        {
+            frame(Http2FrameType::HEADERS, HTTP2_FLAG_END_HEADERS, id, block);
+            frame(Http2FrameType::DATA, HTTP2_FLAG_END_STREAM, id, std::string(1000, 'p'));
+        }
+        else
+        {
+            frame(Http2FrameType::HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, id, block);
+        }
+    }
+    sock->send(out.data(), out.size());
+
+    HpackDecoder decoder;
+    std::string buf;
+    int finished = 0;
+    char tmp[4096];
+    while (finished < 3)
+    {
+        int n = sock->recv(tmp, sizeof(tmp));
+        if (n <= 0)
+        {
+            LOG_ERROR(g_logger) << "recv fail";
+            return;
+        }
+        buf.append(tmp, n);
+        while (buf.size() >= Http2FrameHeader::SIZE)
+        {
+            Http2FrameHeader h;
+            h.decode((const uint8_t *)buf.data());
+            if (buf.size() < Http2FrameHeader::SIZE + h.length)
+            {
+                break;
+            }
+            std::string payload = buf.substr(Http2FrameHeader::SIZE, h.length);
+            buf.erase(0, Http2FrameHeader::SIZE + h.length);
+            if (h.type == Http2FrameType::HEADERS)
+            {
+                HeaderList headers;
+                decoder.decode((const uint8_t *)payload.data(), payload.size(), headers);
+                std::string line;
+                for (auto &kv : headers)
+                {
+                    line += kv.first + "=" + kv.second + " ";
+                }
+                LOG_INFO(g_logger) << "stream " << h.stream_id << " headers " << line;
+            }
+            else if (h.type == Http2FrameType::DATA)
+            {
+                LOG_INFO(g_logger) << "stream " << h.stream_id << " data " << payload;
+            }
+            else
+            {
+                LOG_INFO(g_logger) << "frame type=" << (int)h.type << " flags=" << (int)h.flags << " stream=" << h.stream_id;
+            }
+            if ((h.type == Http2FrameType::DATA || h.type == Http2FrameType::HEADERS) && (h.flags & HTTP2_FLAG_END_STREAM))
+            {
+                ++finished;
+            }
+        }
+    }
+    sock->close();
+}
+
+int main(int argc, char **argv)
+{
+    test_hpack();
+
+    Scheduler *server_sched = Scheduler::CreateNetScheduler();
+    server_sched->setName("server");
+    server_sched->startInNewThread(1);
+    EchoServer *server = new EchoServer(server_sched, server_sched);
+    server->setName("h2");
+    server->setHttp2(true);
+    Address::ptr addr = Address::LookupAnyIPAddress("127.0.0.1:8023");
+    if (!server->bind(addr))
+    {
+        return 1;
+    }
+    server->start();
+
+    Scheduler *client_sched = Scheduler::CreateNetScheduler();
+    client_sched->setName("client");
+    client_sched->startInNewThread(1);
+    client_sched->createTask([addr]() { test_client(addr); });
+    // 之后可用 curl --http2-prior-knowledge、curl --http2 或 nghttp 访问 http://127.0.0.1:8023
+    sleep(argc > 1 ? atoi(argv[1]) : 1);
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "net.h"
+#include "coroutine/FdInfo.h"
+#include "coroutine/Hook.h"
+#include "splog.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace lim_webserver;
+
+static Logger::ptr g_logger = LOG_ROOT();
+
+/**
+ * @brief 收到一条数据后按模式进入不同状态：睡眠(处理中)、关闭空闲超时后阻塞读(websocket)
+ */
+class StallServer : public TcpServer
+{
+public:
+    StallServer(Scheduler *worker, Scheduler *accepter) : TcpServer(worker, accepter) {}
+
+    uint16_t port() { return std::static_pointer_cast<IPAddress>(m_socket_vec[0]->localAddress())->getPort(); }
+
+    std::atomic<int> untracked{0};
+
+protected:
+    void handleClient(Socket::ptr client) override
+    {
+        char c;
+        if (client->recv(&c, 1) != 1)
+        {
+            return;
+        }
+        if (c == 's')
+        {
+            // 连接受管理但不在等待读
+            sleep(3);
+        }
+        else
+        {
+            client->setIdleTimeout(0);
+            FdInfo::ptr info = FdManager::GetInstance()->get(client->fd());
+            if (info && !info->getIdleOwner())
+            {
+                ++untracked;
+            }
+            client->recv(&c, 1);
+        }
+        client->close();
+    }
+};
+
+static double ProcessCpuMS()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec * 1e3 + usage.ru_utime.tv_usec / 1e3 + usage.ru_stime.tv_sec * 1e3 + usage.ru_stime.tv_usec / 1e3;
+}
+
+static int Connect(uint16_t port, char mode)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = socket_f(AF_INET, SOCK_STREAM, 0);
+    int rt = connect_f(fd, (sockaddr *)&addr, sizeof(addr));
+    ASSERT(rt == 0);
+    ssize_t n = send_f(fd, &mode, 1, 0);
+    ASSERT(n == 1);
+    return fd;
+}
+
+/**
+ * @brief 受管理的连接都不在等待读时，事件循环应阻塞在poll而不是空转
+ */
+void test_busy_connection_blocks()
+{
+    Scheduler *worker = Scheduler::CreateNetScheduler();
+    worker->setName("idle");
+    worker->startInNewThread(1);
+    StallServer *server = new StallServer(worker, worker);
+    bool bound = server->bind(IPv4Address::Create("127.0.0.1", 0));
+    ASSERT(bound);
+    server->start();
+
+    std::vector<int> fds = {Connect(server->port(), 's'), Connect(server->port(), 'w')};
+    usleep(200 * 1000);
+    double start = ProcessCpuMS();
+    sleep(2);
+    double used = ProcessCpuMS() - start;
+    LOG_INFO(g_logger) << "cpu over 2s with a busy and a websocket-like connection: " << used << " ms, untracked=" << server->untracked;
+    ASSERT(server->untracked == 1);
+    ASSERT(used < 200, "event loop spins while no connection waits for data");
+    for (int fd : fds)
+    {
+        close_f(fd);
+    }
+    server->stop();
+    worker->stop();
+}
+
+int main(int argc, char **argv)
+{
+    LOG_SYS()->setLevel(LogLevel_ERROR);
+    test_busy_connection_blocks();
+    LOG_INFO(g_logger) << "test_idle passed";
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "coroutine.h"
+#include "net.h"
+#include "net/EventLoop.h"
+#include "net/IoChannel.h"
+#include "splog.h"
+
+#include <atomic>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace lim_webserver;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+static uint64_t NowMS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ul + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief 在当前事件循环上登记读事件并挂起，直到被唤醒
+ */
+static void WaitReadable(IoChannel::ptr channel)
+{
+    EventLoop *loop = dynamic_cast<EventLoop *>(Processor::GetCurrentProcessor());
+    channel->addEvent(IoEvent::READ);
+    loop->updateChannel(channel);
+    Processor::CoHold();
+}
+
+static void Drain(int fd)
+{
+    char buf[64];
+    while (::read(fd, buf, sizeof(buf)) > 0)
+    {
+    }
+}
+
+/**
+ * @brief 一次登记只唤醒一次；事件已存在时重新登记的协程也能被唤醒
+ */
+void test_wake_once(Scheduler *scheduler)
+{
+    int fds[2];
+    int rt = pipe2(fds, O_NONBLOCK | O_CLOEXEC);
+    ASSERT(rt == 0);
+    IoChannel::ptr channel = IoChannel::Create(fds[0]);
+
+    // 协程被读事件唤醒后转去睡眠，睡眠期间的读事件不能提前唤醒它
+    std::atomic<int> stage{0};
+    std::atomic<uint64_t> slept{0};
+    scheduler->createTask([&]()
+                          {
+                              WaitReadable(channel);
+                              Drain(fds[0]);
+                              stage = 1;
+                              uint64_t start = NowMS();
+                              usleep(300 * 1000);
+                              slept = NowMS() - start;
+                              stage = 2; });
+    usleep(50 * 1000);
+    ssize_t n = ::write(fds[1], "a", 1);
+    ASSERT(n == 1);
+    while (stage < 1)
+    {
+        usleep(1000);
+    }
+    usleep(50 * 1000);
+    n = ::write(fds[1], "b", 1);
+    ASSERT(n == 1);
+    while (stage < 2)
+    {
+        usleep(1000);
+    }
+    LOG_INFO(g_logger) << "slept " << slept << " ms while the pipe became readable again";
+    ASSERT(slept >= 290, "a stale io event woke a task parked in usleep");
+
+    // 读事件仍然登记着，新的协程再次登记后应被唤醒，而不是唤醒已结束的协程
+    ASSERT(channel->isReading());
+    std::atomic<bool> woken{false};
+    scheduler->createTask([&]()
+                          {
+                              Drain(fds[0]);
+                              WaitReadable(channel);
+                              woken = true; });
+    usleep(50 * 1000);
+    n = ::write(fds[1], "c", 1);
+    ASSERT(n == 1);
+    for (int i = 0; i < 200 && !woken; ++i)
+    {
+        usleep(10 * 1000);
+    }
+    LOG_INFO(g_logger) << "task waiting on an already registered event woken=" << woken;
+    ASSERT(woken);
+
+    std::atomic<bool> removed{false};
+    scheduler->createTask([&]()
+                          {
+                              EventLoop *loop = dynamic_cast<EventLoop *>(Processor::GetCurrentProcessor());
+                              channel->clearEvent();
+                              loop->removeChannel(channel);
+                              removed = true; });
+    while (!removed)
+    {
+        usleep(1000);
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+int main()
+{
+    Scheduler *scheduler = Scheduler::CreateNetScheduler();
+    scheduler->setName("channel");
+    scheduler->startInNewThread(1);
+    test_wake_once(scheduler);
+    LOG_INFO(g_logger) << "test_iochannel passed";
+    scheduler->stop();
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include "base/LFQueue.h"
+#include "splog.h"
+
 #include <iostream>
 #include <thread>
+#include <vector>
 
 using namespace lim_webserver;
 
@@ -33,8 +36,66 @@ void consumer()
     }
 }
 
+/**
+ * @brief 多个生产者并发入队，唯一的消费者边取边校验：元素不丢不重，同一生产者的元素保持入队顺序
+ */
+void test_multi_producer()
+{
+    const uint64_t producers = 4;
+    const uint64_t count = 200000;
+    LFQueue<uint64_t> queue;
+    LFQueue<uint64_t> merged;
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&queue, p, count]()
+                             {
+                                 for (uint64_t i = 0; i < count; ++i)
+                                 {
+                                     queue.enqueue(p << 32 | i);
+                                 } });
+    }
+
+    // 交替使用dequeue与concatenate取出
+    std::vector<uint64_t> next(producers, 0);
+    uint64_t received = 0;
+    bool ordered = true;
+    while (received < producers * count)
+    {
+        if (received % 3 == 0)
+        {
+            merged.concatenate(queue);
+        }
+        uint64_t value;
+        if (!merged.dequeue(value) && !queue.dequeue(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        uint64_t p = value >> 32;
+        if (p >= producers || (value & 0xffffffff) != next[p])
+        {
+            ordered = false;
+            break;
+        }
+        ++next[p];
+        ++received;
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    uint64_t value;
+    bool drained = !queue.dequeue(value) && !merged.dequeue(value) && queue.empty() && merged.empty();
+    std::cout << "multi producer received " << received << " of " << producers * count << std::endl;
+    ASSERT(ordered, "lost, duplicated or reordered element");
+    ASSERT(drained);
+}
+
 int main()
 {
+    test_multi_producer();
+
     std::thread producerThread(producer);
     std::thread consumerThread(consumer);
 
@@ -1,5 +1,11 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "splog.h"
+#include "splog/LogSink.h"
 
 using namespace lim_webserver;
 
@@ -45,8 +51,73 @@ void test_appender2()
     }
 }
 
+/**
+ * @brief 崩溃后留下预分配的0尾部，追加打开时应从最后一条日志之后续写
+ */
+void test_mmap_recover()
+{
+    std::string file = "/tmp/test_log_mmap_recover.txt";
+    {
+        std::ofstream ofs(file, std::ios::trunc | std::ios::binary);
+        ofs << "before crash\n" << std::string(8192, '\0');
+    }
+    MmapFileSink sink(4096);
+    sink.open(file.c_str(), true);
+    std::string line = "after restart\n";
+    sink.append(line.data(), line.size());
+    sink.close();
+
+    std::ifstream ifs(file, std::ios::binary);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    ASSERT(ss.str() == "before crash\nafter restart\n", "zero tail left in the middle of the log");
+    remove(file.c_str());
+}
+
+/**
+ * @brief 批量刷新的输出地在致命信号到来时，缓冲中的日志由信号处理函数直接写入文件
+ */
+void test_flush_on_signal()
+{
+    std::string file = "/tmp/test_log_flush_on_signal.txt";
+    remove(file.c_str());
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        FileAppender::ptr appender = AppenderFactory::newFileAppender();
+        appender->setFile(file);
+        appender->setName("flush_on_signal");
+        appender->setFormatter("%m%n");
+        appender->setFlushPolicy(FlushPolicy::Batch(1024 * 1024, 0, LogLevel_OFF));
+        Logger::ptr logger = LOG_NAME("flush_on_signal");
+        logger->addAppender(appender);
+        for (int i = 0; i < 100; ++i)
+        {
+            LOG_INFO(logger) << "line " << i;
+        }
+        raise(SIGTERM);
+        _exit(1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ASSERT(WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM);
+
+    std::ifstream ifs(file);
+    std::string line;
+    int lines = 0;
+    while (std::getline(ifs, line))
+    {
+        ++lines;
+    }
+    ASSERT(lines == 100, "buffered lines lost on a fatal signal");
+    remove(file.c_str());
+}
+
 int main(int argc, char *argv[])
 {
+    test_mmap_recover();
+    test_flush_on_signal();
+
     ConsoleAppender::ptr appender =AppenderFactory::GetInstance()->defaultConsoleAppender();
 
     FileAppender::ptr fappender =AppenderFactory::GetInstance()->defaultFileAppender();
@@ -0,0 +1,74 @@
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "splog.h"
+#include "splog/LogArchiver.h"
+
+using namespace lim_webserver;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+static const std::string s_dir = "/tmp/test_log_archiver";
+
+static size_t CountFiles(const std::string &suffix)
+{
+    size_t count = 0;
+    DIR *dir = opendir(s_dir.c_str());
+    while (struct dirent *entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name.compare(0, 4, "app.") == 0 && name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+        {
+            ++count;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+/**
+ * @brief 一次提交多个归档，保留策略不能删除仍在队列中等待压缩的文件
+ */
+void test_retention_skips_queued()
+{
+    system(("rm -rf " + s_dir + " && mkdir -p " + s_dir).c_str());
+    const int files = 8;
+    const size_t file_size = 1024 * 1024;
+    std::vector<ArchiveTask> tasks;
+    for (int i = 0; i < files; ++i)
+    {
+        ArchiveTask task;
+        task.file = s_dir + "/app." + std::to_string(i);
+        task.compression = CompressionType::GZIP;
+        task.dir = s_dir;
+        task.prefix = "app.";
+        task.active = s_dir + "/app";
+        task.max_history = 2;
+        std::ofstream ofs(task.file);
+        ofs << std::string(file_size, 'a' + i);
+        tasks.push_back(task);
+    }
+
+    LogArchiver *archiver = LogArchiver::GetInstance();
+    size_t bytes_in = archiver->getBytesIn();
+    for (auto &task : tasks)
+    {
+        archiver->submit(task);
+    }
+    archiver->wait();
+
+    size_t compressed = archiver->getBytesIn() - bytes_in;
+    LOG_INFO(g_logger) << "compressed " << compressed << " bytes, " << CountFiles(".gz") << " archives kept, removed " << archiver->getRemovedCount();
+    ASSERT(compressed == files * file_size, "a queued archive was removed before it was compressed");
+    ASSERT(CountFiles(".gz") == 2);
+    ASSERT(CountFiles(".0") == 0 && CountFiles(".7") == 0);
+    system(("rm -rf " + s_dir).c_str());
+}
+
+int main(int argc, char *argv[])
+{
+    test_retention_skips_queued();
+    LOG_INFO(g_logger) << "test_log_archiver passed";
+    return 0;
+}
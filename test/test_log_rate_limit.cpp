@@ -0,0 +1,89 @@
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include "splog.h"
+
+using namespace lim_webserver;
+
+static const char *s_file = "/tmp/test_log_rate_limit.txt";
+
+static std::string ReadLog()
+{
+    std::ifstream ifs(s_file);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+static Logger::ptr NewLogger(const std::string &name)
+{
+    Logger::ptr logger = LOG_NAME(name);
+    FileAppender::ptr appender = AppenderFactory::newFileAppender();
+    appender->setFile(s_file);
+    appender->setName(name);
+    appender->setFormatter("%m%n");
+    logger->addAppender(appender);
+    return logger;
+}
+
+/**
+ * @brief 日志流停止后，最后一段被抑制的条数仍由后台汇总输出
+ */
+void test_storm_summary()
+{
+    Logger::ptr logger = NewLogger("rate_limit_ms");
+    for (int i = 0; i < 100; ++i)
+    {
+        LOG_EVERY_MS(logger, LogLevel_INFO, 10000) << "storm " << i;
+    }
+    for (int i = 0; i < 20; ++i)
+    {
+        LOG_FIRST_N(logger, LogLevel_INFO, 5) << "first " << i;
+    }
+    for (int i = 0; i < 30; ++i)
+    {
+        LOG_EVERY_N(logger, LogLevel_INFO, 10) << "every " << i;
+    }
+    // 之后不再写日志，等待后台汇总
+    usleep((LogSuppression::kReportInterval + 500) * 1000);
+
+    std::string content = ReadLog();
+    LOG_INFO(LOG_ROOT()) << "log content:\n"
+                         << content;
+    ASSERT(content.find("storm 0") != std::string::npos);
+    ASSERT(content.find("storm 1") == std::string::npos);
+    ASSERT(content.find("[suppressed 99 messages]") != std::string::npos, "LOG_EVERY_MS summary lost after the storm");
+    ASSERT(content.find("[suppressed 15 messages]") != std::string::npos, "LOG_FIRST_N never reported suppression");
+    // every 10/20随放行带出各自之前的9条，最后9条由汇总输出
+    ASSERT(content.find("[suppressed 9 messages] every 10") != std::string::npos);
+    ASSERT(content.find("[suppressed 9 messages] every 20") != std::string::npos);
+    ASSERT(content.find("[suppressed 9 messages]\n") != std::string::npos, "LOG_EVERY_N tail not reported");
+}
+
+/**
+ * @brief 令牌桶限流的日志器同样汇总被限流的条数
+ */
+void test_rate_limit_summary()
+{
+    Logger::ptr logger = NewLogger("rate_limit_bucket");
+    logger->setRateLimit(10, 10);
+    for (int i = 0; i < 100; ++i)
+    {
+        LOG_INFO(logger) << "bucket " << i;
+    }
+    usleep((LogSuppression::kReportInterval + 500) * 1000);
+
+    std::string content = ReadLog();
+    ASSERT(content.find("bucket 9") != std::string::npos);
+    ASSERT(content.find("messages by rate limit]") != std::string::npos, "rate limit summary lost after the storm");
+}
+
+int main(int argc, char *argv[])
+{
+    remove(s_file);
+    test_storm_summary();
+    test_rate_limit_summary();
+    LOG_INFO(LOG_ROOT()) << "test_log_rate_limit passed";
+    remove(s_file);
+    return 0;
+}
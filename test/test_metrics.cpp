@@ -0,0 +1,69 @@
+#include "base/Metrics.h"
+#include "coroutine.h"
+#include "splog.h"
+
+#include <thread>
+#include <vector>
+
+using namespace lim_webserver;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+void test_counter()
+{
+    MetricCounter *counter = MetricsRegistry::GetInstance()->counter("test_requests_total", "Requests handled by the test", {{"case", "counter"}});
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([counter]()
+                             {
+                                 for (int i = 0; i < 100000; ++i)
+                                 {
+                                     counter->inc();
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    // 重复注册得到同一个对象
+    MetricCounter *same = MetricsRegistry::GetInstance()->counter("test_requests_total", "Requests handled by the test", {{"case", "counter"}});
+    LOG_INFO(g_logger) << "counter=" << counter->value() << " expect=400000 same=" << (same == counter);
+}
+
+void test_histogram()
+{
+    MetricHistogram *histogram =
+        MetricsRegistry::GetInstance()->histogram("test_latency_seconds", "Latency recorded by the test", {}, 1e-6, MetricsRegistry::LatencyBounds());
+    for (uint64_t us = 1; us <= 10000; ++us)
+    {
+        histogram->record(us);
+    }
+    LOG_INFO(g_logger) << "count=" << histogram->count() << " p50=" << histogram->quantile(0.5) << "us p99=" << histogram->quantile(0.99)
+                       << "us max=" << histogram->quantile(1) << "us";
+}
+
+void test_runtime()
+{
+    // 调度器运行一段时间后输出处理器与定时器的指标
+    Scheduler *scheduler = Scheduler::Create();
+    scheduler->setName("test");
+    scheduler->startInNewThread(2);
+    for (int i = 0; i < 100; ++i)
+    {
+        scheduler->createTask([]()
+                              { Processor::CoYield(); });
+    }
+    TimerManager::GetInstance()->addTimer(10, []() {});
+    sleep(1);
+    scheduler->stop();
+    std::cout << MetricsRegistry::GetInstance()->toPrometheus();
+}
+
+int main()
+{
+    test_counter();
+    test_histogram();
+    test_runtime();
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "coroutine.h"
+#include "coroutine/Profiler.h"
+#include "splog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace lim_webserver;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+static volatile uint64_t s_sink = 0;
+
+static void busy_loop(uint64_t n)
+{
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        s_sink += i * i;
+    }
+}
+
+void test_dump()
+{
+    // 几个协程分别挂起在sleep、CoSync与主动hold上，转储应列出各自的挂起原因与调用栈
+    Scheduler *scheduler = Scheduler::Create();
+    scheduler->setName("dump");
+    scheduler->startInNewThread(1);
+    static CoMutex mutex;
+    mutex.lock();
+    scheduler->createTask([]() { sleep(2); });
+    scheduler->createTask([]() { mutex.lock(); mutex.unlock(); });
+    scheduler->createTask([]() { Processor::CoHold(); });
+    usleep(100 * 1000);
+    std::cout << TaskDumper::Dump() << std::endl;
+    mutex.unlock();
+}
+
+void test_dump_concurrent()
+{
+    // 转储期间其他线程仍在不断创建、结束任务，两者都不应被长时间阻塞
+    Scheduler *scheduler = Scheduler::Create();
+    scheduler->setName("churn");
+    scheduler->startInNewThread(2);
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> finished{0};
+    std::vector<std::thread> creators;
+    for (int t = 0; t < 2; ++t)
+    {
+        creators.emplace_back(
+            [&]()
+            {
+                while (running)
+                {
+                    scheduler->createTask([&finished]() { ++finished; });
+                    usleep(10);
+                }
+            });
+    }
+    usleep(50 * 1000);
+    uint64_t before = finished;
+    size_t dumps = 0, lines = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        std::string dump = TaskDumper::Dump();
+        lines += std::count(dump.begin(), dump.end(), '\n');
+        ++dumps;
+    }
+    uint64_t during = finished - before;
+    running = false;
+    for (auto &thread : creators)
+    {
+        thread.join();
+    }
+    LOG_INFO(g_logger) << dumps << " dumps (" << lines << " lines) while " << during << " tasks were created and finished";
+    ASSERT(during > 0);
+}
+
+void test_profile()
+{
+    // 两个协程做不同量的计算，样本应大致按1:3归属到两个任务上
+    Scheduler *scheduler = Scheduler::Create();
+    scheduler->setName("prof");
+    scheduler->startInNewThread(1);
+    SamplingProfiler::GetInstance()->start(999);
+    std::atomic<int> done{0};
+    scheduler->createTask([&done]() { busy_loop(100000000); ++done; });
+    scheduler->createTask([&done]() { busy_loop(300000000); ++done; });
+    while (done < 2)
+    {
+        usleep(10 * 1000);
+    }
+    std::string folded = SamplingProfiler::GetInstance()->stop();
+    std::ofstream("profile.folded") << folded;
+    LOG_INFO(g_logger) << "folded stacks written to profile.folded, dropped=" << SamplingProfiler::GetInstance()->getDropped();
+    std::cout << folded.substr(0, 2000) << std::endl;
+}
+
+int main()
+{
+    test_dump();
+    test_dump_concurrent();
+    test_profile();
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include "base/Metrics.h"
+#include "net/http/ResponseCache.h"
+#include "splog.h"
+
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace lim_webserver;
+using namespace lim_webserver::http;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+static HttpRequest::ptr MakeRequest(const std::string &path)
+{
+    HttpRequest::ptr req(new HttpRequest);
+    req->setPath(path);
+    req->setHeader("Accept-Encoding", "gzip");
+    return req;
+}
+
+static HttpResponse::ptr MakeResponse(const std::string &cache_control, size_t body_size = 100)
+{
+    HttpResponse::ptr rsp(new HttpResponse);
+    rsp->setHeader("Content-Type", "application/json");
+    rsp->setHeader("Cache-Control", cache_control);
+    rsp->setBody(std::string(body_size, 'x'));
+    return rsp;
+}
+
+/**
+ * @brief 指标与缓存实际占用一致
+ */
+static void CheckGauges(ResponseCache &cache, const std::string &name)
+{
+    MetricsRegistry *registry = MetricsRegistry::GetInstance();
+    int64_t bytes = registry->gauge("spnet_http_response_cache_bytes", "Bytes held by the response cache", {{"cache", name}})->value();
+    int64_t entries = registry->gauge("spnet_http_response_cache_entries", "Responses held by the response cache", {{"cache", name}})->value();
+    LOG_INFO(g_logger) << name << " bytes gauge=" << bytes << " size=" << cache.size() << " entries gauge=" << entries << " count=" << cache.count();
+    ASSERT(bytes == (int64_t)cache.size() && entries == (int64_t)cache.count());
+}
+
+void test_make_key()
+{
+    ResponseCache cache("key", 1 << 20);
+    HttpRequest::ptr req = MakeRequest("/a");
+    req->setQuery("id=1");
+    std::string key = cache.makeKey(req);
+    ASSERT(!key.empty() && key.find("/a?id=1") != std::string::npos);
+    // 写法不同但协商出同一编码的请求共用键
+    HttpRequest::ptr same = MakeRequest("/a");
+    same->setQuery("id=1");
+    same->setHeader("Accept-Encoding", "deflate;q=0.5, gzip");
+    ASSERT(cache.makeKey(same) == key);
+    // 不同虚拟主机下的同一路径不共用键
+    HttpRequest::ptr other_host = MakeRequest("/a");
+    other_host->setQuery("id=1");
+    other_host->setHeader("Host", "b.example.com");
+    ASSERT(!cache.makeKey(other_host).empty() && cache.makeKey(other_host) != key);
+
+    HttpRequest::ptr auth = MakeRequest("/a");
+    auth->setHeader("Authorization", "Bearer t");
+    HttpRequest::ptr range = MakeRequest("/a");
+    range->setHeader("Range", "bytes=0-9");
+    HttpRequest::ptr no_cache = MakeRequest("/a");
+    no_cache->setHeader("Cache-Control", "No-Cache");
+    HttpRequest::ptr max_age0 = MakeRequest("/a");
+    max_age0->setHeader("Cache-Control", "max-age=0");
+    HttpRequest::ptr pragma = MakeRequest("/a");
+    pragma->setHeader("Pragma", "no-cache");
+    HttpRequest::ptr post = MakeRequest("/a");
+    post->setMethod(HttpMethod::POST);
+    for (auto &r : {auth, range, no_cache, max_age0, pragma, post})
+    {
+        ASSERT(cache.makeKey(r).empty());
+    }
+    LOG_INFO(g_logger) << "make_key ok";
+}
+
+void test_max_age()
+{
+    ASSERT(ResponseCache::MaxAge(MakeResponse("public, max-age=60")) == 60);
+    ASSERT(ResponseCache::MaxAge(MakeResponse("max-age=60, s-maxage=300")) == 300);
+    ASSERT(ResponseCache::MaxAge(MakeResponse("private, max-age=60")) == 0);
+    ASSERT(ResponseCache::MaxAge(MakeResponse("no-store")) == 0);
+    ASSERT(ResponseCache::MaxAge(MakeResponse("public")) == 0);
+    LOG_INFO(g_logger) << "max_age ok";
+}
+
+void test_vary_and_close()
+{
+    ResponseCache cache("vary", 1 << 20);
+    std::string key = cache.makeKey(MakeRequest("/v"));
+    HttpResponse::ptr cookie_vary = MakeResponse("max-age=60");
+    cookie_vary->setHeader("Vary", "Accept-Encoding, Cookie");
+    ASSERT(!cache.store(key, cookie_vary));
+    HttpResponse::ptr encoding_vary = MakeResponse("max-age=60");
+    encoding_vary->setHeader("Vary", "accept-encoding");
+    ASSERT(cache.store(key, encoding_vary));
+
+    ResponseCache::EntryPtr entry = cache.lookup(key);
+    ASSERT(entry && entry->bytes.find("connection: keep-alive\r\n") != std::string::npos);
+    std::string kept, closed;
+    ResponseCache::Render(*entry, false, entry->stored, kept);
+    ASSERT(kept.size() == entry->bytes.size() + strlen("age: 0\r\n"));
+    ResponseCache::Render(*entry, true, entry->stored, closed);
+    ASSERT(closed.find("connection: close\r\n") != std::string::npos && closed.find("keep-alive") == std::string::npos);
+    ASSERT(closed.size() == kept.size() - strlen("keep-alive") + strlen("close"));
+    ASSERT(closed.substr(closed.find("\r\n\r\n")) == entry->bytes.substr(entry->bytes.find("\r\n\r\n")));
+    CheckGauges(cache, "vary");
+    LOG_INFO(g_logger) << "vary_and_close ok";
+}
+
+void test_expiry()
+{
+    ResponseCache cache("expiry", 1 << 20);
+    std::string key = cache.makeKey(MakeRequest("/e"));
+    ASSERT(cache.store(key, MakeResponse("max-age=1")));
+    ResponseCache::EntryPtr entry = cache.lookup(key);
+    ASSERT(entry);
+    usleep(1100 * 1000);
+    // 命中时的Age为存入后经过的秒数，紧跟状态行
+    std::string bytes;
+    ResponseCache::Render(*entry, false, MetricNowNS(), bytes);
+    LOG_INFO(g_logger) << "aged response:\n" << bytes.substr(0, bytes.find("\r\n\r\n"));
+    ASSERT(bytes.find("\r\nage: 1\r\n") == bytes.find("\r\n"));
+    ASSERT(!cache.lookup(key));
+    ASSERT(cache.count() == 0 && cache.size() == 0);
+    CheckGauges(cache, "expiry");
+    LOG_INFO(g_logger) << "expiry ok";
+}
+
+void test_admission()
+{
+    // 每个分片只放得下3个条目，本线程总是访问同一分片
+    size_t shards = 1;
+    while (shards < std::max(std::thread::hardware_concurrency(), 1u))
+    {
+        shards <<= 1;
+    }
+    ResponseCache cache("admission", shards * 4096);
+    std::vector<std::string> keys;
+    for (const char *path : {"/hot0", "/hot1", "/hot2"})
+    {
+        keys.push_back(cache.makeKey(MakeRequest(path)));
+        ASSERT(cache.store(keys.back(), MakeResponse("max-age=60", 800)));
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        for (auto &key : keys)
+        {
+            ASSERT(cache.lookup(key));
+        }
+    }
+
+    // 只访问过一次的新条目不如现有条目常用，被拒绝
+    std::string cold = cache.makeKey(MakeRequest("/cold"));
+    cache.lookup(cold);
+    ASSERT(!cache.store(cold, MakeResponse("max-age=60", 800)));
+    ASSERT(cache.count() == 3);
+
+    // 访问次数超过现有条目后被接纳，替换其中一个
+    std::string warm = cache.makeKey(MakeRequest("/warm"));
+    for (int i = 0; i < 12; ++i)
+    {
+        cache.lookup(warm);
+    }
+    ASSERT(cache.store(warm, MakeResponse("max-age=60", 800)));
+    ASSERT(cache.lookup(warm) && cache.count() == 3);
+    CheckGauges(cache, "admission");
+    LOG_INFO(g_logger) << "admission ok";
+}
+
+int main()
+{
+    test_make_key();
+    test_max_age();
+    test_vary_and_close();
+    test_expiry();
+    test_admission();
+    LOG_INFO(g_logger) << "test_response_cache passed";
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "coroutine.h"
+#include "net.h"
+#include "net/http/HttpServer.h"
+#include "splog.h"
+
+using namespace lim_webserver;
+using namespace lim_webserver::http;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+/**
+ * @brief 以TLS客户端连接两次，第二次用第一次的票据恢复会话
+ */
+void test_client(Address::ptr addr)
+{
+    SslContext::ptr ctx = SslContext::CreateClient();
+    SslSocketStream::SessionPtr session;
+    for (int i = 0; i < 2; ++i)
+    {
+        Socket::ptr sock = Socket::CreateTCP(addr);
+        if (!sock->connect(addr))
+        {
+            LOG_ERROR(g_logger) << "connect fail";
+            return;
+        }
+        SslSocketStream tls(sock, ctx);
+        tls.setSession(session);
+        if (!tls.handshake())
+        {
+            LOG_ERROR(g_logger) << "handshake fail";
+            return;
+        }
+        std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+        tls.send(request.data(), request.size());
+        std::string response;
+        char buf[4096];
+        int n;
+        while ((n = tls.resv(buf, sizeof(buf))) > 0)
+        {
+            response.append(buf, n);
+        }
+        LOG_INFO(g_logger) << tls.getVersion() << " " << tls.getCipher() << " reused=" << tls.isSessionReused() << " ktls_send=" << tls.isKtlsSend()
+                           << " response:\n"
+                           << response;
+        session = tls.getSession();
+        tls.close();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Scheduler *server_sched = Scheduler::CreateNetScheduler();
+    server_sched->setName("server");
+    server_sched->startInNewThread(1);
+    HttpServer *server = new HttpServer(true, server_sched, server_sched);
+    server->setName("tls");
+    // 传入证书与私钥文件时使用之，否则使用自签名证书
+    if (argc > 3)
+    {
+        server->loadCertificates(argv[2], argv[3]);
+    }
+    else
+    {
+        server->setSslContext(SslContext::CreateSelfSigned());
+    }
+    Address::ptr addr = Address::LookupAnyIPAddress("127.0.0.1:8024");
+    if (!server->bind(addr, true))
+    {
+        return 1;
+    }
+    server->start();
+
+    Scheduler *client_sched = Scheduler::CreateNetScheduler();
+    client_sched->setName("client");
+    client_sched->startInNewThread(1);
+    client_sched->createTask([addr]() { test_client(addr); });
+    // 之后可用 curl -k https://127.0.0.1:8024 访问
+    sleep(argc > 1 ? atoi(argv[1]) : 1);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "base/Configer.h"
+#include "base/Trace.h"
+#include "coroutine.h"
+#include "net.h"
+#include "net/http/HttpServer.h"
+#include "splog.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace lim_webserver;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+/**
+ * @brief 在一条长连接上发送count个请求，slow为true时请求分两次发送，中间停顿20ms
+ */
+static void client(Address::ptr addr, int count, bool slow)
+{
+    Socket::ptr sock = Socket::CreateTCP(addr);
+    if (!sock->connect(addr))
+    {
+        LOG_ERROR(g_logger) << "connect " << addr->toString() << " fail";
+        return;
+    }
+    static const char HEAD[] = "GET /trace HTTP/1.1\r\n";
+    static const char TAIL[] = "Host: localhost\r\nConnection: keep-alive\r\n\r\n";
+    std::string buff(4096, '\0');
+    for (int i = 0; i < count; ++i)
+    {
+        sock->send(HEAD, sizeof(HEAD) - 1);
+        if (slow)
+        {
+            usleep(20 * 1000);
+        }
+        sock->send(TAIL, sizeof(TAIL) - 1);
+        if (sock->recv(&buff[0], buff.size()) <= 0)
+        {
+            LOG_ERROR(g_logger) << "recv fail";
+            return;
+        }
+    }
+    sock->close();
+}
+
+int main()
+{
+    // 开启追踪后，一条连接快速发送5个请求，另一条每个请求中途停顿20ms，只有后者会被导出
+    Configer::Lookup<bool>("trace.enable", false, "")->setValue(true);
+
+    Scheduler *server_sched = Scheduler::CreateNetScheduler();
+    server_sched->setName("server");
+    server_sched->startInNewThread(1);
+    http::HttpServer *server = new http::HttpServer(true, server_sched, server_sched);
+    server->setName("trace");
+    Address::ptr addr = Address::LookupAnyIPAddress("127.0.0.1:8021");
+    if (!server->bind(addr))
+    {
+        return 1;
+    }
+    server->start();
+
+    Scheduler *client_sched = Scheduler::CreateNetScheduler();
+    client_sched->setName("client");
+    client_sched->startInNewThread(1);
+    client_sched->createTask([addr]() { client(addr, 5, false); });
+    client_sched->createTask([addr]() { client(addr, 5, true); });
+    sleep(1);
+
+    std::string json = RequestTrace::ExportChrome(10 * 1000, 100);
+    std::ofstream("trace.json") << json;
+    LOG_INFO(g_logger) << "slow request traces written to trace.json, open it in chrome://tracing or ui.perfetto.dev";
+    std::cout << json.substr(0, 2000) << std::endl;
+    return 0;
+}
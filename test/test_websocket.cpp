@@ -0,0 +1,125 @@
+#include "coroutine.h"
+#include "net.h"
+#include "net/http/WSServer.h"
+#include "splog.h"
+
+using namespace lim_webserver;
+using namespace lim_webserver::http;
+
+static Logger::ptr g_logger = LOG_NAME("test");
+
+void test_mask()
+{
+    // 掩码两次还原，分段处理与整体处理结果一致
+    const uint8_t key[4] = {1, 2, 3, 4};
+    std::string origin;
+    for (int i = 0; i < 1000; ++i)
+    {
+        origin += (char)i;
+    }
+    std::string whole = origin, parts = origin;
+    WSMask(&whole[0], whole.size(), key);
+    WSMask(&parts[0], 333, key);
+    WSMask(&parts[333], parts.size() - 333, key, 333);
+    bool same = whole == parts;
+    WSMask(&whole[0], whole.size(), key);
+    LOG_INFO(g_logger) << "mask parts_equal=" << same << " restored=" << (whole == origin);
+}
+
+void test_echo(Address::ptr addr)
+{
+    WSSession::ptr session = WSSession::Connect(addr, "/echo");
+    if (!session)
+    {
+        LOG_ERROR(g_logger) << "connect fail";
+        return;
+    }
+    session->sendMessage("hello websocket");
+    // 分两片发送一条消息，中间插入一个ping
+    session->sendMessage("fragmented ", WSOpcode::TEXT, false);
+    session->ping("are you there");
+    session->sendMessage("message", WSOpcode::CONTINUE, true);
+    session->sendMessage(std::string(100000, 'b'), WSOpcode::BINARY);
+    for (int i = 0; i < 3; ++i)
+    {
+        WSMessage::ptr msg = session->recvMessage();
+        if (!msg)
+        {
+            LOG_ERROR(g_logger) << "recv fail";
+            return;
+        }
+        LOG_INFO(g_logger) << "echo opcode=" << (int)msg->opcode() << " size=" << msg->data().size() << " data=" << msg->data().substr(0, 32);
+    }
+    session->sendClose();
+    LOG_INFO(g_logger) << "after close recv=" << (session->recvMessage() != nullptr);
+}
+
+void test_short_close(Address::ptr addr)
+{
+    // CLOSE帧的负载只有1字节时服务端应以1002关闭
+    Socket::ptr sock = Socket::CreateTCP(addr);
+    if (!sock->connect(addr))
+    {
+        LOG_ERROR(g_logger) << "connect fail";
+        return;
+    }
+    std::string request = "GET /echo HTTP/1.1\r\nHost: test\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    sock->send(request.data(), request.size());
+    std::string response;
+    char buf[512];
+    while (response.find("\r\n\r\n") == std::string::npos)
+    {
+        int n = sock->recv(buf, sizeof(buf));
+        if (n <= 0)
+        {
+            LOG_ERROR(g_logger) << "handshake fail";
+            return;
+        }
+        response.append(buf, n);
+    }
+    const uint8_t frame[] = {0x88, 0x81, 0x11, 0x22, 0x33, 0x44, 'x' ^ 0x11};
+    sock->send(frame, sizeof(frame));
+    std::string reply = response.substr(response.find("\r\n\r\n") + 4);
+    while (reply.size() < 4)
+    {
+        int n = sock->recv(buf, sizeof(buf));
+        if (n <= 0)
+        {
+            break;
+        }
+        reply.append(buf, n);
+    }
+    uint16_t code = reply.size() >= 4 ? ((uint8_t)reply[2] << 8) | (uint8_t)reply[3] : 0;
+    LOG_INFO(g_logger) << "short close reply code=" << code;
+    ASSERT(reply.size() >= 4 && (uint8_t)reply[0] == 0x88 && code == 1002);
+    sock->close();
+}
+
+int main()
+{
+    test_mask();
+
+    Scheduler *server_sched = Scheduler::CreateNetScheduler();
+    server_sched->setName("server");
+    server_sched->startInNewThread(1);
+    WSServer *server = new WSServer(server_sched, server_sched);
+    server->setName("ws");
+    server->setConnectCallback([](WSSession::ptr session, HttpRequest::ptr req)
+                               { LOG_INFO(g_logger) << "connect " << session->peerAddressString() << " path=" << req->path(); });
+    server->setCloseCallback([](WSSession::ptr session) { LOG_INFO(g_logger) << "close " << session->peerAddressString(); });
+    Address::ptr addr = Address::LookupAnyIPAddress("127.0.0.1:8022");
+    if (!server->bind(addr))
+    {
+        return 1;
+    }
+    server->start();
+
+    Scheduler *client_sched = Scheduler::CreateNetScheduler();
+    client_sched->setName("client");
+    client_sched->startInNewThread(1);
+    client_sched->createTask([addr]() { test_echo(addr); });
+    client_sched->createTask([addr]() { test_short_close(addr); });
+    sleep(1);
+    return 0;
+}